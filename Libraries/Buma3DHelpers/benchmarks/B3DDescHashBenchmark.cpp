@@ -0,0 +1,216 @@
+#include <Buma3DHelpers/B3DDescHash.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <unordered_set>
+#include <vector>
+
+// ビューとサンプラーの記述のハッシュの速度と衝突数を、パックしたキー(util::PackDescKey)と以前のメンバごとの hash_combine で比較します。
+// 記述の集合は、ミップチェーン、配列、キューブマップ、構造化バッファのビューを持つ典型的なシーンを想定しています。
+// パックしたキーのハッシュで64ビットの衝突が発生した場合、0以外の終了コードを返します。
+
+namespace b = buma3d;
+
+namespace /*anonymous*/
+{
+
+constexpr int NUM_REPEATS = 200;
+constexpr int NUM_RUNS    = 5;
+
+#pragma region field-wise hash
+
+// 以前の std::hash の実装です。 各メンバを hash_combine で順に結合します。
+size_t FieldWiseHash(const b::SHADER_RESOURCE_VIEW_DESC& _desc)
+{
+    size_t seed = 0;
+    buma::util::hash_combine(seed, _desc.view);
+    switch (_desc.view.dimension)
+    {
+    case b::VIEW_DIMENSION_BUFFER_TYPED:
+    case b::VIEW_DIMENSION_BUFFER_STRUCTURED:
+    case b::VIEW_DIMENSION_BUFFER_BYTEADDRESS:
+        buma::util::hash_combine(seed, _desc.buffer);
+        break;
+
+    case b::VIEW_DIMENSION_BUFFER_ACCELERATION_STRUCTURE:
+        buma::util::hash_combine(seed, _desc.acceleration_structure.location);
+        break;
+
+    default:
+        buma::util::hash_combine(seed, _desc.texture);
+        break;
+    }
+    buma::util::hash_combine(seed, _desc.flags);
+    return seed;
+}
+
+size_t FieldWiseHash(const b::SAMPLER_DESC& _desc)
+{
+    size_t seed = 0;
+    buma::util::hash_combine(seed, _desc.filter.mode                   );
+    buma::util::hash_combine(seed, _desc.filter.reduction_mode         );
+    buma::util::hash_combine(seed, _desc.filter.max_anisotropy         );
+    buma::util::hash_combine(seed, _desc.filter.comparison_func        );
+    buma::util::hash_combine(seed, _desc.texture.sample.minification   );
+    buma::util::hash_combine(seed, _desc.texture.sample.magnification  );
+    buma::util::hash_combine(seed, _desc.texture.sample.mip            );
+    buma::util::hash_combine(seed, _desc.texture.address.u             );
+    buma::util::hash_combine(seed, _desc.texture.address.v             );
+    buma::util::hash_combine(seed, _desc.texture.address.w             );
+    buma::util::hash_combine(seed, _desc.mip_lod.bias                  );
+    buma::util::hash_combine(seed, _desc.mip_lod.max                   );
+    buma::util::hash_combine(seed, _desc.mip_lod.min                   );
+    buma::util::hash_combine(seed, _desc.border_color                  );
+    return seed;
+}
+
+#pragma endregion field-wise hash
+
+template<typename DescT>
+size_t PackedHash(const DescT& _desc)
+{
+    return std::hash<DescT>{}(_desc);
+}
+
+std::vector<b::SHADER_RESOURCE_VIEW_DESC> CreateShaderResourceViewDescs()
+{
+    std::vector<b::SHADER_RESOURCE_VIEW_DESC> result;
+    for (auto format : { b::RESOURCE_FORMAT_R8G8B8A8_UNORM, b::RESOURCE_FORMAT_R8G8B8A8_UNORM_SRGB })
+    {
+        for (auto dimension : { b::VIEW_DIMENSION_TEXTURE_2D, b::VIEW_DIMENSION_TEXTURE_2D_ARRAY, b::VIEW_DIMENSION_TEXTURE_CUBE })
+        {
+            for (uint32_t mip = 0; mip < 12; mip++)
+            {
+                for (uint32_t num_mips = 1; num_mips <= 12 - mip; num_mips++)
+                {
+                    for (uint32_t slice = 0; slice < 6; slice++)
+                    {
+                        auto&& d = result.emplace_back();
+                        d.view                      = { b::VIEW_TYPE_SHADER_RESOURCE, format, dimension };
+                        d.texture.components        = { b::COMPONENT_SWIZZLE_IDENTITY, b::COMPONENT_SWIZZLE_IDENTITY, b::COMPONENT_SWIZZLE_IDENTITY, b::COMPONENT_SWIZZLE_IDENTITY };
+                        d.texture.subresource_range = { { b::TEXTURE_ASPECT_FLAG_COLOR, mip, slice }, 1, num_mips };
+                    }
+                }
+            }
+        }
+    }
+
+    for (uint64_t first_element = 0; first_element < 4096; first_element += 16)
+    {
+        for (uint32_t stride : { 4u, 16u, 64u })
+        {
+            auto&& d = result.emplace_back();
+            d.view   = { b::VIEW_TYPE_SHADER_RESOURCE, b::RESOURCE_FORMAT_UNKNOWN, b::VIEW_DIMENSION_BUFFER_STRUCTURED };
+            d.buffer = { first_element, 256, stride };
+        }
+    }
+    return result;
+}
+
+std::vector<b::SAMPLER_DESC> CreateSamplerDescs()
+{
+    constexpr b::TEXTURE_ADDRESS_MODE ADDRESS_MODES[] = { b::TEXTURE_ADDRESS_MODE_WRAP, b::TEXTURE_ADDRESS_MODE_MIRROR, b::TEXTURE_ADDRESS_MODE_CLAMP, b::TEXTURE_ADDRESS_MODE_BORDER, b::TEXTURE_ADDRESS_MODE_MIRROR_ONCE };
+
+    std::vector<b::SAMPLER_DESC> result;
+    for (auto mode : { b::SAMPLER_FILTER_MODE_STANDARD, b::SAMPLER_FILTER_MODE_ANISOTROPIC, b::SAMPLER_FILTER_MODE_COMPARISON })
+    {
+        for (uint32_t anisotropy = 1; anisotropy <= 16; anisotropy *= 2)
+        {
+            for (auto u : ADDRESS_MODES)
+            {
+                for (auto v : ADDRESS_MODES)
+                {
+                    for (float bias : { 0.f, -0.5f, 0.5f, 1.f })
+                    {
+                        auto&& d = result.emplace_back();
+                        d.filter.mode           = mode;
+                        d.filter.max_anisotropy = anisotropy;
+                        d.texture.address.u     = u;
+                        d.texture.address.v     = v;
+                        d.texture.address.w     = b::TEXTURE_ADDRESS_MODE_WRAP;
+                        d.mip_lod.bias          = bias;
+                        d.mip_lod.max           = FLT_MAX;
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+struct RESULT
+{
+    size_t num_collisions;        // 64ビットのハッシュの衝突数です。
+    size_t num_bucket_collisions; // 下位16ビット(65536バケットのテーブル)での衝突数です。
+    double ns_per_hash;
+};
+
+template<typename DescT, typename HashFuncT>
+RESULT Run(const std::vector<DescT>& _descs, HashFuncT&& _hash)
+{
+    RESULT result{};
+    std::unordered_set<size_t> hashes;
+    std::unordered_set<size_t> buckets;
+    for (auto& i : _descs)
+    {
+        auto h = _hash(i);
+        hashes.insert(h);
+        buckets.insert(h & 0xffff);
+    }
+    result.num_collisions        = _descs.size() - hashes.size();
+    result.num_bucket_collisions = _descs.size() - buckets.size();
+
+    // 最適化で計算が省略されないよう、結果を累積します。 スケジューリングの影響を除くため、最も速い実行の結果を使用します。
+    size_t sink = 0;
+    result.ns_per_hash = DBL_MAX;
+    for (int run = 0; run < NUM_RUNS; run++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        for (int r = 0; r < NUM_REPEATS; r++)
+        {
+            for (auto& i : _descs)
+                sink += _hash(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        auto ns = std::chrono::duration<double, std::nano>(end - begin).count() / (double(NUM_REPEATS) * _descs.size());
+        result.ns_per_hash = (std::min)(result.ns_per_hash, ns);
+    }
+    if (sink == 1)
+        std::printf(" ");
+
+    return result;
+}
+
+void Print(const char* _name, size_t _num_descs, const RESULT& _result)
+{
+    std::printf("%-24s %6zu descs  collisions(64bit): %5zu  collisions(low 16bit): %5zu  %6.2f ns/hash\n"
+                , _name, _num_descs, _result.num_collisions, _result.num_bucket_collisions, _result.ns_per_hash);
+}
+
+}// namespace /*anonymous*/
+
+int main()
+{
+    auto srvs     = CreateShaderResourceViewDescs();
+    auto samplers = CreateSamplerDescs();
+
+    auto srv_field_wise     = Run(srvs, [](const b::SHADER_RESOURCE_VIEW_DESC& _d) { return FieldWiseHash(_d); });
+    auto srv_packed         = Run(srvs, [](const b::SHADER_RESOURCE_VIEW_DESC& _d) { return PackedHash(_d); });
+    auto sampler_field_wise = Run(samplers, [](const b::SAMPLER_DESC& _d) { return FieldWiseHash(_d); });
+    auto sampler_packed     = Run(samplers, [](const b::SAMPLER_DESC& _d) { return PackedHash(_d); });
+
+    Print("SRV field-wise"    , srvs.size()    , srv_field_wise);
+    Print("SRV packed"        , srvs.size()    , srv_packed);
+    Print("SAMPLER field-wise", samplers.size(), sampler_field_wise);
+    Print("SAMPLER packed"    , samplers.size(), sampler_packed);
+
+    if (srv_packed.num_collisions != 0 || sampler_packed.num_collisions != 0)
+    {
+        std::printf("B3DDescHashBenchmark: packed key hashes collided\n");
+        return 1;
+    }
+    return 0;
+}
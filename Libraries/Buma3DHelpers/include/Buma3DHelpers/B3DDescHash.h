@@ -2,6 +2,16 @@
 
 #include <Buma3D/Buma3D.h>
 #include <Utils/Utils.h>
+#include <Utils/Definitions.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
 
 namespace buma::util
 {
@@ -13,6 +23,315 @@ inline void hash_combine(size_t& _seed, T const& _val)
     _seed ^= std::hash<T>{}(_val)+0x9e3779b97f4a7c15ull + (_seed << 12) + (_seed >> 4);
 }
 
+// 名前を持たないメンバで構成されるPOD(VIEWPORT等)を、バイト列としてハッシュします。
+inline void hash_combine_bytes(size_t& _seed, const void* _data, size_t _size)
+{
+    hash_combine(_seed, std::string_view(static_cast<const char*>(_data), _size));
+}
+
+inline void hash_combine_str(size_t& _seed, const char* _str)
+{
+    hash_combine(_seed, std::string_view(_str ? _str : ""));
+}
+
+// ポインタが指す値をハッシュします。 nullptrと有効な値は区別されます。
+template<typename T>
+inline void hash_combine_ptr(size_t& _seed, const T* _ptr)
+{
+    hash_combine(_seed, _ptr != nullptr);
+    if (_ptr)
+        hash_combine(_seed, *_ptr);
+}
+
+template<typename T>
+inline void hash_combine_array(size_t& _seed, uint32_t _count, const T* _array)
+{
+    hash_combine(_seed, _count);
+    for (uint32_t i = 0; i < _count; i++)
+        hash_combine(_seed, _array[i]);
+}
+
+inline bool equals_str(const char* _a, const char* _b)
+{
+    return std::strcmp(_a ? _a : "", _b ? _b : "") == 0;
+}
+
+template<typename T>
+inline bool equals_ptr(const T* _a, const T* _b)
+{
+    return _a == _b || (_a && _b && *_a == *_b);
+}
+
+template<typename T>
+inline bool equals_array(uint32_t _count, const T* _a, const T* _b)
+{
+    for (uint32_t i = 0; i < _count; i++)
+        if (!(_a[i] == _b[i])) return false;
+    return true;
+}
+
+template<typename T>
+inline bool equals_bytes(const T& _a, const T& _b)
+{
+    return std::memcmp(&_a, &_b, sizeof(T)) == 0;
+}
+
+// 64x64ビットの乗算の上位と下位を畳み込みます。
+inline uint64_t mum64(uint64_t _a, uint64_t _b)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    uint64_t hi;
+    uint64_t lo = _umul128(_a, _b, &hi);
+    return lo ^ hi;
+#elif defined(__SIZEOF_INT128__)
+    auto r = static_cast<unsigned __int128>(_a) * _b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#else
+    uint64_t a_lo = _a & 0xffffffffull, a_hi = _a >> 32;
+    uint64_t b_lo = _b & 0xffffffffull, b_hi = _b >> 32;
+    uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+    uint64_t mid = (ll >> 32) + (lh & 0xffffffffull) + (hl & 0xffffffffull);
+    uint64_t lo = (ll & 0xffffffffull) | (mid << 32);
+    uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return lo ^ hi;
+#endif
+}
+
+// wyhashと同様の、16バイトごとに1回の乗算で混合する64ビットハッシュです。 hash_combine のフィールドごとの連鎖より高速かつ、各ビットが十分に拡散されます。
+inline uint64_t hash_bytes64(const void* _data, size_t _size, uint64_t _seed = 0)
+{
+    constexpr uint64_t P0 = 0xa0761d6478bd642full;
+    constexpr uint64_t P1 = 0xe7037ed1a0b428dbull;
+    constexpr uint64_t P2 = 0x8ebc6af09c88c6e3ull;
+    auto Read = [](const uint8_t* _p, size_t _n) { uint64_t v = 0; std::memcpy(&v, _p, _n); return v; };
+
+    auto p = static_cast<const uint8_t*>(_data);
+    auto h = _seed ^ P0;
+    size_t i = 0;
+    for (; i + 16 <= _size; i += 16)
+        h = mum64(Read(p + i, 8) ^ P1, Read(p + i + 8, 8) ^ h);
+
+    uint64_t a = 0, b = 0;
+    auto rest = _size - i;
+    if (rest > 8)
+    {
+        a = Read(p + i, 8);
+        b = Read(p + i + 8, rest - 8);
+    }
+    else if (rest > 0)
+    {
+        a = Read(p + i, rest);
+    }
+    h = mum64(a ^ P1, b ^ h);
+    return mum64(h ^ P2, static_cast<uint64_t>(_size) ^ P1);
+}
+
+/*
+記述の有効なメンバのみを、パディング無しで連続して格納したキーです。
+    共用体の使用されないメンバやパディングの不定な値は含まれず、残りのビットは0であるため、 memcmp で比較し、バイト列として1度にハッシュできます。
+    4バイト以下のメンバは32ビット、8バイトのメンバは64ビットの境界に格納します。 書き込みが64ビット単位となるため、直後のハッシュの読み取りでストアフォワーディングが失敗しません。
+*/
+template<typename DescT>
+struct PACKED_DESC_KEY
+{
+    static constexpr size_t NUM_WORDS = (sizeof(DescT) + 7) / 8;
+    uint64_t words[NUM_WORDS];
+
+    bool operator==(const PACKED_DESC_KEY& _other) const { return std::memcmp(words, _other.words, sizeof(words)) == 0; }
+    bool operator!=(const PACKED_DESC_KEY& _other) const { return !(*this == _other); }
+    size_t Hash() const { return static_cast<size_t>(hash_bytes64(words, sizeof(words))); }
+};
+
+template<typename DescT>
+class PackedDescKeyWriter
+{
+public:
+    explicit PackedDescKeyWriter(PACKED_DESC_KEY<DescT>& _key)
+        : key           { _key }
+        , index         {}
+        , pending       {}
+        , has_pending   {}
+    {
+    }
+
+    ~PackedDescKeyWriter()
+    {
+        Flush();
+        for (size_t i = index; i < PACKED_DESC_KEY<DescT>::NUM_WORDS; i++)
+            key.words[i] = 0;
+    }
+
+    template<typename T>
+    PackedDescKeyWriter& operator()(T _val)
+    {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+        static_assert(sizeof(T) <= 4 || sizeof(T) == 8);
+        // 比較演算子と同様に、-0.0を0.0と等しく扱います。
+        if constexpr (std::is_floating_point_v<T>)
+            if (_val == T(0)) _val = T(0);
+
+        uint64_t bits = 0;
+        std::memcpy(&bits, &_val, sizeof(T));
+        if constexpr (sizeof(T) == 8)
+        {
+            Flush();
+            Write(bits);
+        }
+        else if (has_pending)
+        {
+            Write(pending | (bits << 32));
+            has_pending = false;
+        }
+        else
+        {
+            pending     = bits;
+            has_pending = true;
+        }
+        return *this;
+    }
+
+private:
+    void Write(uint64_t _word)
+    {
+        BUMA_ASSERT(index < PACKED_DESC_KEY<DescT>::NUM_WORDS);
+        key.words[index++] = _word;
+    }
+    void Flush()
+    {
+        if (has_pending)
+            Write(pending);
+        has_pending = false;
+    }
+
+private:
+    PACKED_DESC_KEY<DescT>& key;
+    size_t                  index;
+    uint64_t                pending;
+    bool                    has_pending;
+
+};
+
+namespace detail
+{
+
+template<typename DescT>
+inline void PackView(PackedDescKeyWriter<DescT>& _w, const buma3d::VIEW_DESC& _view)
+{
+    _w(_view.type)(_view.format)(_view.dimension);
+}
+
+template<typename DescT>
+inline void PackBuffer(PackedDescKeyWriter<DescT>& _w, const buma3d::BUFFER_VIEW& _buffer)
+{
+    _w(_buffer.first_element)(_buffer.num_elements)(_buffer.structure_byte_stride);
+}
+
+template<typename DescT>
+inline void PackTexture(PackedDescKeyWriter<DescT>& _w, const buma3d::TEXTURE_VIEW& _texture)
+{
+    auto&& c = _texture.components;
+    auto&& r = _texture.subresource_range;
+    _w(c.r)(c.g)(c.b)(c.a);
+    _w(r.offset.aspect)(r.offset.mip_slice)(r.offset.array_slice)(r.array_size)(r.mip_levels);
+}
+
+inline bool IsBufferDimension(buma3d::VIEW_DIMENSION _dimension)
+{
+    return _dimension == buma3d::VIEW_DIMENSION_BUFFER_TYPED      ||
+           _dimension == buma3d::VIEW_DIMENSION_BUFFER_STRUCTURED ||
+           _dimension == buma3d::VIEW_DIMENSION_BUFFER_BYTEADDRESS;
+}
+
+inline bool IsTextureDimension(buma3d::VIEW_DIMENSION _dimension)
+{
+    switch (_dimension)
+    {
+    case buma3d::VIEW_DIMENSION_TEXTURE_1D:
+    case buma3d::VIEW_DIMENSION_TEXTURE_1D_ARRAY:
+    case buma3d::VIEW_DIMENSION_TEXTURE_2D:
+    case buma3d::VIEW_DIMENSION_TEXTURE_2D_ARRAY:
+    case buma3d::VIEW_DIMENSION_TEXTURE_3D:
+    case buma3d::VIEW_DIMENSION_TEXTURE_CUBE:
+    case buma3d::VIEW_DIMENSION_TEXTURE_CUBE_ARRAY:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+}// namespace detail
+
+inline PACKED_DESC_KEY<buma3d::SHADER_RESOURCE_VIEW_DESC> PackDescKey(const buma3d::SHADER_RESOURCE_VIEW_DESC& _desc)
+{
+    PACKED_DESC_KEY<buma3d::SHADER_RESOURCE_VIEW_DESC> result;
+    {
+        PackedDescKeyWriter w(result);
+        detail::PackView(w, _desc.view);
+        w(_desc.flags);
+        if (detail::IsBufferDimension(_desc.view.dimension))
+            detail::PackBuffer(w, _desc.buffer);
+        else if (detail::IsTextureDimension(_desc.view.dimension))
+            detail::PackTexture(w, _desc.texture);
+        else if (_desc.view.dimension == buma3d::VIEW_DIMENSION_BUFFER_ACCELERATION_STRUCTURE)
+            w(_desc.acceleration_structure.location);
+    }
+    return result;
+}
+
+inline PACKED_DESC_KEY<buma3d::UNORDERED_ACCESS_VIEW_DESC> PackDescKey(const buma3d::UNORDERED_ACCESS_VIEW_DESC& _desc)
+{
+    PACKED_DESC_KEY<buma3d::UNORDERED_ACCESS_VIEW_DESC> result;
+    {
+        PackedDescKeyWriter w(result);
+        detail::PackView(w, _desc.view);
+        w(_desc.flags)(_desc.counter_offset_in_bytes);
+        if (detail::IsBufferDimension(_desc.view.dimension))
+            detail::PackBuffer(w, _desc.buffer);
+        else if (detail::IsTextureDimension(_desc.view.dimension))
+            detail::PackTexture(w, _desc.texture);
+    }
+    return result;
+}
+
+inline PACKED_DESC_KEY<buma3d::RENDER_TARGET_VIEW_DESC> PackDescKey(const buma3d::RENDER_TARGET_VIEW_DESC& _desc)
+{
+    PACKED_DESC_KEY<buma3d::RENDER_TARGET_VIEW_DESC> result;
+    {
+        PackedDescKeyWriter w(result);
+        detail::PackView(w, _desc.view);
+        w(_desc.flags);
+        detail::PackTexture(w, _desc.texture);
+    }
+    return result;
+}
+
+inline PACKED_DESC_KEY<buma3d::DEPTH_STENCIL_VIEW_DESC> PackDescKey(const buma3d::DEPTH_STENCIL_VIEW_DESC& _desc)
+{
+    PACKED_DESC_KEY<buma3d::DEPTH_STENCIL_VIEW_DESC> result;
+    {
+        PackedDescKeyWriter w(result);
+        detail::PackView(w, _desc.view);
+        w(_desc.flags);
+        detail::PackTexture(w, _desc.texture);
+    }
+    return result;
+}
+
+inline PACKED_DESC_KEY<buma3d::SAMPLER_DESC> PackDescKey(const buma3d::SAMPLER_DESC& _desc)
+{
+    PACKED_DESC_KEY<buma3d::SAMPLER_DESC> result;
+    {
+        PackedDescKeyWriter w(result);
+        w(_desc.filter.mode)(_desc.filter.reduction_mode)(_desc.filter.max_anisotropy)(_desc.filter.comparison_func);
+        w(_desc.texture.sample.minification)(_desc.texture.sample.magnification)(_desc.texture.sample.mip);
+        w(_desc.texture.address.u)(_desc.texture.address.v)(_desc.texture.address.w);
+        w(_desc.mip_lod.bias)(_desc.mip_lod.max)(_desc.mip_lod.min);
+        w(_desc.border_color);
+    }
+    return result;
+}
+
 } // namespace buma::util
 
 
@@ -65,106 +384,199 @@ inline bool operator==(const TEXTURE_VIEW& a, const TEXTURE_VIEW& b)
     return a.components == b.components && a.subresource_range == b.subresource_range;
 }
 
-inline bool operator==(const SHADER_RESOURCE_VIEW_DESC& a, const SHADER_RESOURCE_VIEW_DESC& b)
+// パック後のキーを比較することで、共用体の使用されないメンバやパディングを無視します。
+inline bool operator==(const SHADER_RESOURCE_VIEW_DESC&  a, const SHADER_RESOURCE_VIEW_DESC&  b) { return buma::util::PackDescKey(a) == buma::util::PackDescKey(b); }
+inline bool operator==(const UNORDERED_ACCESS_VIEW_DESC& a, const UNORDERED_ACCESS_VIEW_DESC& b) { return buma::util::PackDescKey(a) == buma::util::PackDescKey(b); }
+inline bool operator==(const RENDER_TARGET_VIEW_DESC&    a, const RENDER_TARGET_VIEW_DESC&    b) { return buma::util::PackDescKey(a) == buma::util::PackDescKey(b); }
+inline bool operator==(const DEPTH_STENCIL_VIEW_DESC&    a, const DEPTH_STENCIL_VIEW_DESC&    b) { return buma::util::PackDescKey(a) == buma::util::PackDescKey(b); }
+inline bool operator==(const SAMPLER_DESC&               a, const SAMPLER_DESC&               b) { return buma::util::PackDescKey(a) == buma::util::PackDescKey(b); }
+
+
+#pragma region pipeline
+
+// パイプラインの記述子の比較とハッシュは、ポインタが指す値を含む記述全体を対象とします。
+// IShaderModule 、 IPipelineLayout 、 IRenderPass はオブジェクトの同一性で比較します。
+
+inline bool operator==(const INPUT_ELEMENT_DESC& a, const INPUT_ELEMENT_DESC& b)
+{
+    return
+        buma::util::equals_str(a.semantic_name, b.semantic_name) &&
+        a.semantic_index      == b.semantic_index      &&
+        a.format              == b.format              &&
+        a.aligned_byte_offset == b.aligned_byte_offset ;
+}
+
+inline bool operator==(const INPUT_SLOT_DESC& a, const INPUT_SLOT_DESC& b)
+{
+    return
+        a.slot_number             == b.slot_number             &&
+        a.stride_in_bytes         == b.stride_in_bytes         &&
+        a.classification          == b.classification          &&
+        a.instance_data_step_rate == b.instance_data_step_rate &&
+        a.num_elements            == b.num_elements            &&
+        buma::util::equals_array(a.num_elements, a.elements, b.elements);
+}
+
+inline bool operator==(const INPUT_LAYOUT_DESC& a, const INPUT_LAYOUT_DESC& b)
 {
-    auto CompareDimension = [](const SHADER_RESOURCE_VIEW_DESC& a, const SHADER_RESOURCE_VIEW_DESC& b)
-    {
-        switch (a.view.dimension)
-        {
-        case buma3d::VIEW_DIMENSION_BUFFER_TYPED:
-        case buma3d::VIEW_DIMENSION_BUFFER_STRUCTURED:
-        case buma3d::VIEW_DIMENSION_BUFFER_BYTEADDRESS:
-            return a.buffer == b.buffer;
-
-        case buma3d::VIEW_DIMENSION_BUFFER_ACCELERATION_STRUCTURE:
-            return a.acceleration_structure.location == b.acceleration_structure.location;
-
-        case buma3d::VIEW_DIMENSION_TEXTURE_1D:
-        case buma3d::VIEW_DIMENSION_TEXTURE_1D_ARRAY:
-        case buma3d::VIEW_DIMENSION_TEXTURE_2D:
-        case buma3d::VIEW_DIMENSION_TEXTURE_2D_ARRAY:
-        case buma3d::VIEW_DIMENSION_TEXTURE_3D:
-        case buma3d::VIEW_DIMENSION_TEXTURE_CUBE:
-        case buma3d::VIEW_DIMENSION_TEXTURE_CUBE_ARRAY:
-            return a.texture == b.texture;
-
-        default:
-            return false;
-        }
-    };
     return
-        a.flags == a.flags &&
-        a.view  == b.view  && CompareDimension(a, b);
+        a.num_input_slots == b.num_input_slots &&
+        buma::util::equals_array(a.num_input_slots, a.input_slots, b.input_slots);
+}
+
+inline bool operator==(const INPUT_ASSEMBLY_STATE_DESC& a, const INPUT_ASSEMBLY_STATE_DESC& b)
+{
+    return a.topology == b.topology;
+}
+
+inline bool operator==(const TESSELLATION_STATE_DESC& a, const TESSELLATION_STATE_DESC& b)
+{
+    return buma::util::equals_bytes(a, b);
 }
 
-inline bool operator==(const UNORDERED_ACCESS_VIEW_DESC& a, const UNORDERED_ACCESS_VIEW_DESC& b)
+inline bool operator==(const VIEWPORT_STATE_DESC& a, const VIEWPORT_STATE_DESC& b)
 {
-    auto CompareDimension = [](const UNORDERED_ACCESS_VIEW_DESC& a, const UNORDERED_ACCESS_VIEW_DESC& b)
+    // 動的ステートの場合 viewports 、 scissor_rects はnullptrです。
+    auto EqualsArray = [](uint32_t _count, const auto* _a, const auto* _b)
     {
-        switch (a.view.dimension)
-        {
-        case buma3d::VIEW_DIMENSION_BUFFER_TYPED:
-        case buma3d::VIEW_DIMENSION_BUFFER_STRUCTURED:
-        case buma3d::VIEW_DIMENSION_BUFFER_BYTEADDRESS:
-            return a.buffer == b.buffer;
-
-        case buma3d::VIEW_DIMENSION_TEXTURE_1D:
-        case buma3d::VIEW_DIMENSION_TEXTURE_1D_ARRAY:
-        case buma3d::VIEW_DIMENSION_TEXTURE_2D:
-        case buma3d::VIEW_DIMENSION_TEXTURE_2D_ARRAY:
-        case buma3d::VIEW_DIMENSION_TEXTURE_3D:
-        case buma3d::VIEW_DIMENSION_TEXTURE_CUBE:
-        case buma3d::VIEW_DIMENSION_TEXTURE_CUBE_ARRAY:
-            return a.texture == b.texture;
-
-        default:
-            return false;
-        }
+        if (!_a || !_b)
+            return _a == _b;
+        return std::memcmp(_a, _b, sizeof(*_a) * _count) == 0;
     };
     return
-        a.counter_offset_in_bytes == a.counter_offset_in_bytes &&
-        a.flags                   == a.flags                   &&
-        a.view                    == b.view                    && CompareDimension(a, b);
+        a.num_viewports     == b.num_viewports     &&
+        a.num_scissor_rects == b.num_scissor_rects &&
+        EqualsArray(a.num_viewports    , a.viewports    , b.viewports)     &&
+        EqualsArray(a.num_scissor_rects, a.scissor_rects, b.scissor_rects) ;
+}
+
+inline bool operator==(const RASTERIZATION_STATE_DESC& a, const RASTERIZATION_STATE_DESC& b)
+{
+    return
+        a.fill_mode                      == b.fill_mode                      &&
+        a.cull_mode                      == b.cull_mode                      &&
+        a.is_front_counter_clockwise     == b.is_front_counter_clockwise     &&
+        a.is_enabled_depth_clip          == b.is_enabled_depth_clip          &&
+        a.is_enabled_depth_bias          == b.is_enabled_depth_bias          &&
+        a.depth_bias_scale               == b.depth_bias_scale               &&
+        a.depth_bias_clamp               == b.depth_bias_clamp               &&
+        a.depth_bias_slope_scale         == b.depth_bias_slope_scale         &&
+        a.is_enabled_conservative_raster == b.is_enabled_conservative_raster &&
+        a.line_rasterization_mode        == b.line_rasterization_mode        &&
+        a.line_width                     == b.line_width                     ;
+}
+
+inline bool operator==(const MULTISAMPLE_STATE_DESC& a, const MULTISAMPLE_STATE_DESC& b)
+{
+    // sample_masks はサンプル数32ごとに1つの要素を持ちます。 sample_position_state.desc はオブジェクトの同一性で比較します。
+    auto num_masks = (a.rasterization_samples + 31) / 32;
+    return
+        a.rasterization_samples            == b.rasterization_samples            &&
+        (a.sample_masks == b.sample_masks || (a.sample_masks && b.sample_masks && buma::util::equals_array(num_masks, a.sample_masks, b.sample_masks))) &&
+        a.is_enabled_alpha_to_coverage     == b.is_enabled_alpha_to_coverage     &&
+        a.is_enabled_sample_rate_shading   == b.is_enabled_sample_rate_shading   &&
+        a.sample_position_state.is_enabled == b.sample_position_state.is_enabled &&
+        a.sample_position_state.desc       == b.sample_position_state.desc       ;
+}
+
+inline bool operator==(const DEPTH_STENCILOP_DESC& a, const DEPTH_STENCILOP_DESC& b)
+{
+    return
+        a.fail_op         == b.fail_op         &&
+        a.depth_fail_op   == b.depth_fail_op   &&
+        a.pass_op         == b.pass_op         &&
+        a.comparison_func == b.comparison_func &&
+        a.compare_mask    == b.compare_mask    &&
+        a.write_mask      == b.write_mask      &&
+        a.reference       == b.reference       ;
+}
+
+inline bool operator==(const DEPTH_STENCIL_STATE_DESC& a, const DEPTH_STENCIL_STATE_DESC& b)
+{
+    return
+        a.is_enabled_depth_test        == b.is_enabled_depth_test        &&
+        a.is_enabled_depth_write       == b.is_enabled_depth_write       &&
+        a.depth_comparison_func        == b.depth_comparison_func        &&
+        a.is_enabled_depth_bounds_test == b.is_enabled_depth_bounds_test &&
+        a.min_depth_bounds             == b.min_depth_bounds             &&
+        a.max_depth_bounds             == b.max_depth_bounds             &&
+        a.is_enabled_stencil_test      == b.is_enabled_stencil_test      &&
+        a.stencil_front_face           == b.stencil_front_face           &&
+        a.stencil_back_face            == b.stencil_back_face            ;
 }
 
-inline bool operator==(const RENDER_TARGET_VIEW_DESC& a, const RENDER_TARGET_VIEW_DESC& b)
+inline bool operator==(const RENDER_TARGET_BLEND_DESC& a, const RENDER_TARGET_BLEND_DESC& b)
 {
     return
-        a.flags   == a.flags &&
-        a.view    == b.view  &&
-        a.texture == b.texture;
+        a.is_enabled_blend == b.is_enabled_blend &&
+        a.src_blend        == b.src_blend        &&
+        a.dst_blend        == b.dst_blend        &&
+        a.blend_op         == b.blend_op         &&
+        a.src_blend_alpha  == b.src_blend_alpha  &&
+        a.dst_blend_alpha  == b.dst_blend_alpha  &&
+        a.blend_op_alpha   == b.blend_op_alpha   &&
+        a.color_write_mask == b.color_write_mask ;
 }
 
-inline bool operator==(const DEPTH_STENCIL_VIEW_DESC& a, const DEPTH_STENCIL_VIEW_DESC& b)
+inline bool operator==(const BLEND_STATE_DESC& a, const BLEND_STATE_DESC& b)
 {
     return
-        a.flags   == a.flags &&
-        a.view    == b.view  &&
-        a.texture == b.texture;
+        a.is_enabled_independent_blend == b.is_enabled_independent_blend &&
+        a.is_enabled_logic_op          == b.is_enabled_logic_op          &&
+        a.logic_op                     == b.logic_op                     &&
+        a.num_attachments              == b.num_attachments              &&
+        buma::util::equals_array(a.num_attachments, a.attachments, b.attachments) &&
+        buma::util::equals_bytes(a.blend_constants, b.blend_constants);
 }
 
-inline bool operator==(const SAMPLER_DESC& a, const SAMPLER_DESC& b)
+inline bool operator==(const DYNAMIC_STATE_DESC& a, const DYNAMIC_STATE_DESC& b)
 {
     return
-        a.filter.mode                   == b.filter.mode                    &&
-        a.filter.reduction_mode         == b.filter.reduction_mode          &&
-        a.filter.max_anisotropy         == b.filter.max_anisotropy          &&
-        a.filter.comparison_func        == b.filter.comparison_func         &&
+        a.num_dynamic_states == b.num_dynamic_states &&
+        buma::util::equals_array(a.num_dynamic_states, a.dynamic_states, b.dynamic_states);
+}
 
-        a.texture.sample.minification   == b.texture.sample.minification    &&
-        a.texture.sample.magnification  == b.texture.sample.magnification   &&
-        a.texture.sample.mip            == b.texture.sample.mip             &&
+inline bool operator==(const PIPELINE_SHADER_STAGE_DESC& a, const PIPELINE_SHADER_STAGE_DESC& b)
+{
+    return
+        a.flags  == b.flags  &&
+        a.stage  == b.stage  &&
+        a.module == b.module &&
+        buma::util::equals_str(a.entry_point_name, b.entry_point_name);
+}
 
-        a.texture.address.u             == b.texture.address.u              &&
-        a.texture.address.v             == b.texture.address.v              &&
-        a.texture.address.w             == b.texture.address.w              &&
+inline bool operator==(const GRAPHICS_PIPELINE_STATE_DESC& a, const GRAPHICS_PIPELINE_STATE_DESC& b)
+{
+    return
+        a.flags             == b.flags             &&
+        a.pipeline_layout   == b.pipeline_layout   &&
+        a.render_pass       == b.render_pass       &&
+        a.subpass           == b.subpass           &&
+        a.node_mask         == b.node_mask         &&
+        a.num_shader_stages == b.num_shader_stages &&
+        a.stream_output     == b.stream_output     &&
+        buma::util::equals_array(a.num_shader_stages, a.shader_stages, b.shader_stages) &&
+        buma::util::equals_ptr(a.input_layout        , b.input_layout)          &&
+        buma::util::equals_ptr(a.input_assembly_state, b.input_assembly_state)  &&
+        buma::util::equals_ptr(a.tessellation_state  , b.tessellation_state)    &&
+        buma::util::equals_ptr(a.viewport_state      , b.viewport_state)        &&
+        buma::util::equals_ptr(a.rasterization_state , b.rasterization_state)   &&
+        buma::util::equals_ptr(a.multisample_state   , b.multisample_state)     &&
+        buma::util::equals_ptr(a.depth_stencil_state , b.depth_stencil_state)   &&
+        buma::util::equals_ptr(a.blend_state         , b.blend_state)           &&
+        buma::util::equals_ptr(a.dynamic_state       , b.dynamic_state)         ;
+}
 
-        a.mip_lod.bias                  == b.mip_lod.bias                   &&
-        a.mip_lod.max                   == b.mip_lod.max                    &&
-        a.mip_lod.min                   == b.mip_lod.min                    &&
-        a.border_color                  == b.border_color                   ;
+inline bool operator==(const COMPUTE_PIPELINE_STATE_DESC& a, const COMPUTE_PIPELINE_STATE_DESC& b)
+{
+    return
+        a.pipeline_layout == b.pipeline_layout &&
+        a.shader_stage    == b.shader_stage    &&
+        a.node_mask       == b.node_mask       ;
 }
 
+#pragma endregion pipeline
+
 }// namespace buma3d
 
 namespace std
@@ -248,140 +660,270 @@ struct hash<buma3d::TEXTURE_VIEW>
     }
 };
 
+template<typename DescT>
+struct hash<buma::util::PACKED_DESC_KEY<DescT>>
+{
+    size_t operator()(const buma::util::PACKED_DESC_KEY<DescT>& _key) const { return _key.Hash(); }
+};
+
+template<> struct hash<buma3d::SHADER_RESOURCE_VIEW_DESC>  { size_t operator()(const buma3d::SHADER_RESOURCE_VIEW_DESC&  _data) const { return buma::util::PackDescKey(_data).Hash(); } };
+template<> struct hash<buma3d::UNORDERED_ACCESS_VIEW_DESC> { size_t operator()(const buma3d::UNORDERED_ACCESS_VIEW_DESC& _data) const { return buma::util::PackDescKey(_data).Hash(); } };
+template<> struct hash<buma3d::RENDER_TARGET_VIEW_DESC>    { size_t operator()(const buma3d::RENDER_TARGET_VIEW_DESC&    _data) const { return buma::util::PackDescKey(_data).Hash(); } };
+template<> struct hash<buma3d::DEPTH_STENCIL_VIEW_DESC>    { size_t operator()(const buma3d::DEPTH_STENCIL_VIEW_DESC&    _data) const { return buma::util::PackDescKey(_data).Hash(); } };
+template<> struct hash<buma3d::SAMPLER_DESC>               { size_t operator()(const buma3d::SAMPLER_DESC&               _data) const { return buma::util::PackDescKey(_data).Hash(); } };
+
+
+#pragma region pipeline
+
 template<>
-struct hash<buma3d::SHADER_RESOURCE_VIEW_DESC>
+struct hash<buma3d::INPUT_ELEMENT_DESC>
 {
-    size_t operator()(const buma3d::SHADER_RESOURCE_VIEW_DESC& _data) const
+    size_t operator()(const buma3d::INPUT_ELEMENT_DESC& _data) const
     {
-        auto HashDimension = [](size_t _seed, const buma3d::SHADER_RESOURCE_VIEW_DESC& _data)
-        {
-            switch (_data.view.dimension)
-            {
-            case buma3d::VIEW_DIMENSION_BUFFER_TYPED:
-            case buma3d::VIEW_DIMENSION_BUFFER_STRUCTURED:
-            case buma3d::VIEW_DIMENSION_BUFFER_BYTEADDRESS:
-                buma::util::hash_combine(_seed, _data.view);
-                break;
-
-            case buma3d::VIEW_DIMENSION_BUFFER_ACCELERATION_STRUCTURE:
-                buma::util::hash_combine(_seed, _data.acceleration_structure.location);
-                break;
-
-            case buma3d::VIEW_DIMENSION_TEXTURE_1D:
-            case buma3d::VIEW_DIMENSION_TEXTURE_1D_ARRAY:
-            case buma3d::VIEW_DIMENSION_TEXTURE_2D:
-            case buma3d::VIEW_DIMENSION_TEXTURE_2D_ARRAY:
-            case buma3d::VIEW_DIMENSION_TEXTURE_3D:
-            case buma3d::VIEW_DIMENSION_TEXTURE_CUBE:
-            case buma3d::VIEW_DIMENSION_TEXTURE_CUBE_ARRAY:
-                buma::util::hash_combine(_seed, _data.texture);
-                break;
-
-            default:
-                break;
-            }
-        };
+        size_t seed = 0;
+        buma::util::hash_combine_str(seed, _data.semantic_name);
+        buma::util::hash_combine(seed, _data.semantic_index     );
+        buma::util::hash_combine(seed, _data.format             );
+        buma::util::hash_combine(seed, _data.aligned_byte_offset);
+        return seed;
+    }
+};
 
+template<>
+struct hash<buma3d::INPUT_SLOT_DESC>
+{
+    size_t operator()(const buma3d::INPUT_SLOT_DESC& _data) const
+    {
         size_t seed = 0;
-        buma::util::hash_combine(seed, _data.view);
-        HashDimension(seed, _data);
-        buma::util::hash_combine(seed, _data.flags);
+        buma::util::hash_combine(seed, _data.slot_number            );
+        buma::util::hash_combine(seed, _data.stride_in_bytes        );
+        buma::util::hash_combine(seed, _data.classification         );
+        buma::util::hash_combine(seed, _data.instance_data_step_rate);
+        buma::util::hash_combine_array(seed, _data.num_elements, _data.elements);
         return seed;
     }
 };
 
 template<>
-struct hash<buma3d::UNORDERED_ACCESS_VIEW_DESC>
+struct hash<buma3d::INPUT_LAYOUT_DESC>
 {
-    size_t operator()(const buma3d::UNORDERED_ACCESS_VIEW_DESC& _data) const
+    size_t operator()(const buma3d::INPUT_LAYOUT_DESC& _data) const
     {
-        auto HashDimension = [](size_t _seed, const buma3d::UNORDERED_ACCESS_VIEW_DESC& _data)
-        {
-            switch (_data.view.dimension)
-            {
-            case buma3d::VIEW_DIMENSION_BUFFER_TYPED:
-            case buma3d::VIEW_DIMENSION_BUFFER_STRUCTURED:
-            case buma3d::VIEW_DIMENSION_BUFFER_BYTEADDRESS:
-                buma::util::hash_combine(_seed, _data.view);
-                break;
-
-            case buma3d::VIEW_DIMENSION_TEXTURE_1D:
-            case buma3d::VIEW_DIMENSION_TEXTURE_1D_ARRAY:
-            case buma3d::VIEW_DIMENSION_TEXTURE_2D:
-            case buma3d::VIEW_DIMENSION_TEXTURE_2D_ARRAY:
-            case buma3d::VIEW_DIMENSION_TEXTURE_3D:
-            case buma3d::VIEW_DIMENSION_TEXTURE_CUBE:
-            case buma3d::VIEW_DIMENSION_TEXTURE_CUBE_ARRAY:
-                buma::util::hash_combine(_seed, _data.texture);
-                break;
-
-            default:
-                break;
-            }
-        };
+        size_t seed = 0;
+        buma::util::hash_combine_array(seed, _data.num_input_slots, _data.input_slots);
+        return seed;
+    }
+};
 
+template<>
+struct hash<buma3d::INPUT_ASSEMBLY_STATE_DESC>
+{
+    size_t operator()(const buma3d::INPUT_ASSEMBLY_STATE_DESC& _data) const
+    {
         size_t seed = 0;
-        buma::util::hash_combine(seed, _data.view);
-        HashDimension(seed, _data);
-        buma::util::hash_combine(seed, _data.counter_offset_in_bytes);
-        buma::util::hash_combine(seed, _data.flags);
+        buma::util::hash_combine(seed, _data.topology);
         return seed;
     }
 };
 
 template<>
-struct hash<buma3d::RENDER_TARGET_VIEW_DESC>
+struct hash<buma3d::TESSELLATION_STATE_DESC>
 {
-    size_t operator()(const buma3d::RENDER_TARGET_VIEW_DESC& _data) const
+    size_t operator()(const buma3d::TESSELLATION_STATE_DESC& _data) const
     {
         size_t seed = 0;
-        buma::util::hash_combine(seed, _data.view);
-        buma::util::hash_combine(seed, _data.texture);
-        buma::util::hash_combine(seed, _data.flags);
+        buma::util::hash_combine_bytes(seed, &_data, sizeof(_data));
         return seed;
     }
 };
 
 template<>
-struct hash<buma3d::DEPTH_STENCIL_VIEW_DESC>
+struct hash<buma3d::VIEWPORT_STATE_DESC>
 {
-    size_t operator()(const buma3d::DEPTH_STENCIL_VIEW_DESC& _data) const
+    size_t operator()(const buma3d::VIEWPORT_STATE_DESC& _data) const
     {
         size_t seed = 0;
-        buma::util::hash_combine(seed, _data.view);
-        buma::util::hash_combine(seed, _data.texture);
-        buma::util::hash_combine(seed, _data.flags);
+        buma::util::hash_combine(seed, _data.num_viewports    );
+        buma::util::hash_combine(seed, _data.num_scissor_rects);
+        if (_data.viewports)
+            buma::util::hash_combine_bytes(seed, _data.viewports, sizeof(*_data.viewports) * _data.num_viewports);
+        if (_data.scissor_rects)
+            buma::util::hash_combine_bytes(seed, _data.scissor_rects, sizeof(*_data.scissor_rects) * _data.num_scissor_rects);
         return seed;
     }
 };
 
 template<>
-struct hash<buma3d::SAMPLER_DESC>
+struct hash<buma3d::RASTERIZATION_STATE_DESC>
 {
-    size_t operator()(const buma3d::SAMPLER_DESC& _data) const
+    size_t operator()(const buma3d::RASTERIZATION_STATE_DESC& _data) const
     {
         size_t seed = 0;
-        buma::util::hash_combine(seed, _data.filter.mode                   );
-        buma::util::hash_combine(seed, _data.filter.reduction_mode         );
-        buma::util::hash_combine(seed, _data.filter.max_anisotropy         );
-        buma::util::hash_combine(seed, _data.filter.comparison_func        );
+        buma::util::hash_combine(seed, _data.fill_mode                     );
+        buma::util::hash_combine(seed, _data.cull_mode                     );
+        buma::util::hash_combine(seed, _data.is_front_counter_clockwise    );
+        buma::util::hash_combine(seed, _data.is_enabled_depth_clip         );
+        buma::util::hash_combine(seed, _data.is_enabled_depth_bias         );
+        buma::util::hash_combine(seed, _data.depth_bias_scale              );
+        buma::util::hash_combine(seed, _data.depth_bias_clamp              );
+        buma::util::hash_combine(seed, _data.depth_bias_slope_scale        );
+        buma::util::hash_combine(seed, _data.is_enabled_conservative_raster);
+        buma::util::hash_combine(seed, _data.line_rasterization_mode       );
+        buma::util::hash_combine(seed, _data.line_width                    );
+        return seed;
+    }
+};
 
-        buma::util::hash_combine(seed, _data.texture.sample.minification   );
-        buma::util::hash_combine(seed, _data.texture.sample.magnification  );
-        buma::util::hash_combine(seed, _data.texture.sample.mip            );
+template<>
+struct hash<buma3d::MULTISAMPLE_STATE_DESC>
+{
+    size_t operator()(const buma3d::MULTISAMPLE_STATE_DESC& _data) const
+    {
+        size_t seed = 0;
+        buma::util::hash_combine(seed, _data.rasterization_samples);
+        if (_data.sample_masks)
+            buma::util::hash_combine_array(seed, (_data.rasterization_samples + 31) / 32, _data.sample_masks);
+        buma::util::hash_combine(seed, _data.is_enabled_alpha_to_coverage    );
+        buma::util::hash_combine(seed, _data.is_enabled_sample_rate_shading  );
+        buma::util::hash_combine(seed, _data.sample_position_state.is_enabled);
+        buma::util::hash_combine(seed, _data.sample_position_state.desc      );
+        return seed;
+    }
+};
+
+template<>
+struct hash<buma3d::DEPTH_STENCILOP_DESC>
+{
+    size_t operator()(const buma3d::DEPTH_STENCILOP_DESC& _data) const
+    {
+        size_t seed = 0;
+        buma::util::hash_combine(seed, _data.fail_op        );
+        buma::util::hash_combine(seed, _data.depth_fail_op  );
+        buma::util::hash_combine(seed, _data.pass_op        );
+        buma::util::hash_combine(seed, _data.comparison_func);
+        buma::util::hash_combine(seed, _data.compare_mask   );
+        buma::util::hash_combine(seed, _data.write_mask     );
+        buma::util::hash_combine(seed, _data.reference      );
+        return seed;
+    }
+};
 
-        buma::util::hash_combine(seed, _data.texture.address.u             );
-        buma::util::hash_combine(seed, _data.texture.address.v             );
-        buma::util::hash_combine(seed, _data.texture.address.w             );
+template<>
+struct hash<buma3d::DEPTH_STENCIL_STATE_DESC>
+{
+    size_t operator()(const buma3d::DEPTH_STENCIL_STATE_DESC& _data) const
+    {
+        size_t seed = 0;
+        buma::util::hash_combine(seed, _data.is_enabled_depth_test       );
+        buma::util::hash_combine(seed, _data.is_enabled_depth_write      );
+        buma::util::hash_combine(seed, _data.depth_comparison_func       );
+        buma::util::hash_combine(seed, _data.is_enabled_depth_bounds_test);
+        buma::util::hash_combine(seed, _data.min_depth_bounds            );
+        buma::util::hash_combine(seed, _data.max_depth_bounds            );
+        buma::util::hash_combine(seed, _data.is_enabled_stencil_test     );
+        buma::util::hash_combine(seed, _data.stencil_front_face          );
+        buma::util::hash_combine(seed, _data.stencil_back_face           );
+        return seed;
+    }
+};
 
-        buma::util::hash_combine(seed, _data.mip_lod.bias                  );
-        buma::util::hash_combine(seed, _data.mip_lod.max                   );
-        buma::util::hash_combine(seed, _data.mip_lod.min                   );
-        buma::util::hash_combine(seed, _data.border_color                  );
+template<>
+struct hash<buma3d::RENDER_TARGET_BLEND_DESC>
+{
+    size_t operator()(const buma3d::RENDER_TARGET_BLEND_DESC& _data) const
+    {
+        size_t seed = 0;
+        buma::util::hash_combine(seed, _data.is_enabled_blend);
+        buma::util::hash_combine(seed, _data.src_blend       );
+        buma::util::hash_combine(seed, _data.dst_blend       );
+        buma::util::hash_combine(seed, _data.blend_op        );
+        buma::util::hash_combine(seed, _data.src_blend_alpha );
+        buma::util::hash_combine(seed, _data.dst_blend_alpha );
+        buma::util::hash_combine(seed, _data.blend_op_alpha  );
+        buma::util::hash_combine(seed, _data.color_write_mask);
+        return seed;
+    }
+};
 
+template<>
+struct hash<buma3d::BLEND_STATE_DESC>
+{
+    size_t operator()(const buma3d::BLEND_STATE_DESC& _data) const
+    {
+        size_t seed = 0;
+        buma::util::hash_combine(seed, _data.is_enabled_independent_blend);
+        buma::util::hash_combine(seed, _data.is_enabled_logic_op         );
+        buma::util::hash_combine(seed, _data.logic_op                    );
+        buma::util::hash_combine_array(seed, _data.num_attachments, _data.attachments);
+        buma::util::hash_combine_bytes(seed, &_data.blend_constants, sizeof(_data.blend_constants));
+        return seed;
+    }
+};
+
+template<>
+struct hash<buma3d::DYNAMIC_STATE_DESC>
+{
+    size_t operator()(const buma3d::DYNAMIC_STATE_DESC& _data) const
+    {
+        size_t seed = 0;
+        buma::util::hash_combine_array(seed, _data.num_dynamic_states, _data.dynamic_states);
+        return seed;
+    }
+};
+
+template<>
+struct hash<buma3d::PIPELINE_SHADER_STAGE_DESC>
+{
+    size_t operator()(const buma3d::PIPELINE_SHADER_STAGE_DESC& _data) const
+    {
+        size_t seed = 0;
+        buma::util::hash_combine(seed, _data.flags );
+        buma::util::hash_combine(seed, _data.stage );
+        buma::util::hash_combine(seed, _data.module);
+        buma::util::hash_combine_str(seed, _data.entry_point_name);
+        return seed;
+    }
+};
+
+template<>
+struct hash<buma3d::GRAPHICS_PIPELINE_STATE_DESC>
+{
+    size_t operator()(const buma3d::GRAPHICS_PIPELINE_STATE_DESC& _data) const
+    {
+        size_t seed = 0;
+        buma::util::hash_combine(seed, _data.flags          );
+        buma::util::hash_combine(seed, _data.pipeline_layout);
+        buma::util::hash_combine(seed, _data.render_pass    );
+        buma::util::hash_combine(seed, _data.subpass        );
+        buma::util::hash_combine(seed, _data.node_mask      );
+        buma::util::hash_combine(seed, _data.stream_output  );
+        buma::util::hash_combine_array(seed, _data.num_shader_stages, _data.shader_stages);
+        buma::util::hash_combine_ptr(seed, _data.input_layout        );
+        buma::util::hash_combine_ptr(seed, _data.input_assembly_state);
+        buma::util::hash_combine_ptr(seed, _data.tessellation_state  );
+        buma::util::hash_combine_ptr(seed, _data.viewport_state      );
+        buma::util::hash_combine_ptr(seed, _data.rasterization_state );
+        buma::util::hash_combine_ptr(seed, _data.multisample_state   );
+        buma::util::hash_combine_ptr(seed, _data.depth_stencil_state );
+        buma::util::hash_combine_ptr(seed, _data.blend_state         );
+        buma::util::hash_combine_ptr(seed, _data.dynamic_state       );
+        return seed;
+    }
+};
+
+template<>
+struct hash<buma3d::COMPUTE_PIPELINE_STATE_DESC>
+{
+    size_t operator()(const buma3d::COMPUTE_PIPELINE_STATE_DESC& _data) const
+    {
+        size_t seed = 0;
+        buma::util::hash_combine(seed, _data.pipeline_layout);
+        buma::util::hash_combine(seed, _data.shader_stage   );
+        buma::util::hash_combine(seed, _data.node_mask      );
         return seed;
     }
 };
 
+#pragma endregion pipeline
 
 }// namespace std
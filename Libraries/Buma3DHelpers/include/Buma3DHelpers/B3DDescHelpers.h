@@ -2695,6 +2695,27 @@ public:
     {
     }
 
+    PipelineShaderStageDescs(const PipelineShaderStageDescs& _c)
+        : num_shader_stages {}
+        , descs             {}
+        , entry_point_names {}
+        , stages            {}
+    {
+        *this = _c;
+    }
+    PipelineShaderStageDescs& operator=(const PipelineShaderStageDescs& _c)
+    {
+        num_shader_stages = _c.num_shader_stages;
+        descs             = _c.descs;
+        entry_point_names = _c.entry_point_names;
+        stages            = _c.stages;
+
+        // 複製元の文字列を指さないよう、エントリポイント名を付け替えます。
+        for (uint32_t i = 0; i < num_shader_stages; i++)
+            descs.data()[i].entry_point_name = entry_point_names.find(descs.data()[i].entry_point_name)->c_str();
+        return *this;
+    }
+
     ~PipelineShaderStageDescs()
     {
     }
@@ -3094,7 +3115,7 @@ public:
         blend_state_desc          = _c.blend_state_desc;
         dynamic_state_desc        = _c.dynamic_state_desc;
         dynamic_states            = _c.dynamic_states;
-        Finalize();
+        return Finalize();
     }
 
     ~PipelineStateDesc()
@@ -0,0 +1,142 @@
+#pragma once
+#include <Buma3D/Buma3D.h>
+#include <Buma3D/Util/Buma3DPtr.h>
+
+#include <Utils/NonCopyable.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace buma
+{
+
+namespace util { class PipelineStateDesc; }
+
+class PipelineStateCache;
+class AsyncPipelineCompiler;
+
+struct ASYNC_PIPELINE_COMPILER_DESC
+{
+    size_t      num_threads;        // バックグラウンドでパイプラインを作成するスレッドの数です。 set 0 to use std::thread::hardware_concurrency()
+    const char* warmup_list_path;   // 省略可能です。 前回のセッションで SaveWarmupList() により記録された、パイプラインが最初に使用された順の名前のリストです。
+};
+
+enum ASYNC_PIPELINE_STATE : uint32_t
+{
+      ASYNC_PIPELINE_STATE_PENDING
+    , ASYNC_PIPELINE_STATE_COMPILING
+    , ASYNC_PIPELINE_STATE_READY
+    , ASYNC_PIPELINE_STATE_FAILED
+};
+
+// AsyncPipelineCompiler::Request() が返す、バックグラウンドで作成されるパイプラインのハンドルです。
+// AsyncPipelineCompiler が破棄された後は使用できません。
+class AsyncPipeline : public util::NonCopyable
+{
+public:
+    ~AsyncPipeline();
+
+    /**
+     * @brief レンダリングパスから呼び出されることを想定しています。 作成済みの場合は状態を1度参照するのみです。
+     * @return 作成済みの場合パイプラインを、それ以外の場合(作成に失敗した場合を含む)はフォールバックを返します。 フォールバックが指定されていない場合nullptrを返すため、呼び出し元は描画をスキップします。
+     *         最初の呼び出しでパイプラインは使用されたものとして記録され、未作成の場合は他の要求より優先して作成されます。
+    */
+    buma3d::IPipelineState* Get(bool* _is_fallback = nullptr);
+
+    ASYNC_PIPELINE_STATE    GetState() const { return state.load(std::memory_order_acquire); }
+    bool                    IsReady()  const { return GetState() == ASYNC_PIPELINE_STATE_READY; }
+    const std::string&      GetName()  const { return name; }
+
+private:
+    friend class AsyncPipelineCompiler;
+    AsyncPipeline();
+
+private:
+    AsyncPipelineCompiler*                                  owner;
+    std::string                                             name;
+    uint64_t                                                priority;       // 小さい値が優先されます。 owner のロック中のみアクセスします。
+    std::atomic<ASYNC_PIPELINE_STATE>                       state;          // READY の場合のみ pipeline を読み取ることができます。
+    std::atomic_bool                                        is_used;
+    buma3d::util::Ptr<buma3d::IPipelineState>               pipeline;
+    buma3d::util::Ptr<buma3d::IPipelineState>               fallback;
+
+    // 作成が完了するまで記述と、記述が参照するオブジェクトを保持します。
+    std::unique_ptr<util::PipelineStateDesc>                desc;
+    buma3d::util::Ptr<buma3d::IPipelineLayout>              pipeline_layout;
+    buma3d::util::Ptr<buma3d::IRenderPass>                  render_pass;
+    std::vector<buma3d::util::Ptr<buma3d::IShaderModule>>   modules;
+
+};
+
+// パイプラインの作成をワーカースレッドで行い、作成が完了するまでの間フォールバックのパイプラインでの描画、または描画のスキップを可能にします。
+// 作成は PipelineStateCache を介して行われるため、同じ記述の要求は1つのパイプラインを共有します。
+// 各パイプラインには名前を付け、最初に使用された順に SaveWarmupList() で記録します。 次のセッションでそのリストを指定すると、
+// リストに含まれるパイプラインが記録された順に優先して作成されるため、起動直後に必要なパイプラインから利用可能になります。
+// 全ての関数はスレッドセーフです。
+class AsyncPipelineCompiler : public util::NonCopyable
+{
+public:
+    AsyncPipelineCompiler(PipelineStateCache& _cache, const ASYNC_PIPELINE_COMPILER_DESC& _desc);
+
+    // 作成を開始していない要求は破棄され、 FAILED となります。
+    ~AsyncPipelineCompiler();
+
+    /**
+     * @brief 結果を待たずにパイプラインの作成を要求します。 _desc は複製されるため、呼び出し後に破棄できます。
+     * @param _name ウォームアップリストでパイプラインを識別する名前です。 セッション間で一意かつ不変である必要があります。
+     * @param _fallback 省略可能です。 作成が完了するまで AsyncPipeline::Get() が返すパイプラインです。
+    */
+    std::shared_ptr<AsyncPipeline> Request(const char* _name, const util::PipelineStateDesc& _desc, buma3d::IPipelineState* _fallback = nullptr);
+
+    /**
+     * @brief _pipeline の作成が完了するまで待機します。 作成が開始されていない場合、呼び出し元のスレッドで作成します。
+    */
+    void Wait(AsyncPipeline& _pipeline);
+
+    // 要求済みの全てのパイプラインの作成が完了するまで待機します。
+    void WaitIdle();
+
+    /**
+     * @brief このセッションで使用されたパイプラインの名前を、最初に使用された順に warmup_list_path へ書き込みます。
+     *        前回のリストに含まれ、このセッションで使用されなかった名前は末尾に維持されます。 使用されたパイプラインが存在しない場合、ファイルは変更されません。
+    */
+    bool SaveWarmupList() const;
+
+    size_t GetNumThreads() const { return workers.size(); }
+
+private:
+    friend class AsyncPipeline;
+
+    void LoadWarmupList();
+    void OnFirstUse(AsyncPipeline& _pipeline);
+    void Compile(AsyncPipeline& _pipeline);
+    void WorkerMain();
+
+private:
+    PipelineStateCache&                                 cache;
+    std::string                                         warmup_list_path;
+    std::vector<std::string>                            warmup_list;        // 前回のセッションで記録された名前です。
+    std::unordered_map<std::string, uint64_t>           warmup_priorities;  // 名前ごとの、 warmup_list 内の順序に基づく優先度です。
+    std::vector<std::string>                            used_names;         // このセッションで最初に使用された順の名前です。
+    std::unordered_set<std::string>                     used_name_set;
+
+    mutable std::mutex                                  mutex;
+    std::condition_variable                             queue_cv;
+    std::condition_variable                             done_cv;
+    std::vector<std::shared_ptr<AsyncPipeline>>         queue;
+    uint64_t                                            num_requests;
+    size_t                                              num_in_flight;
+    bool                                                should_exit;
+    std::vector<std::thread>                            workers;
+
+};
+
+
+}// namespace buma
@@ -4,198 +4,113 @@
 
 #include <Buma3DHelpers/B3DDescHelpers.h>
 
-#include <mutex>
-#include <map>
+#include <atomic>
+#include <thread>
 #include <vector>
-#include <deque>
-#include <tuple>
 
 namespace buma
 {
 
-class dummy_mutex
-{
-public:
-    dummy_mutex(int _Flags = 0) noexcept { BUMA_UNREDERENCED(_Flags); }
-    ~dummy_mutex() noexcept {}
-    dummy_mutex(const dummy_mutex&) = delete;
-    dummy_mutex& operator=(const dummy_mutex&) = delete;
-
-    void            lock() {}
-    _NODISCARD bool try_lock() { return true; }
-    void            unlock() {}
-
-    using native_handle_type = void*;
-    _NODISCARD native_handle_type native_handle() { return nullptr; }
-};
-
-
+// 送信するコマンドリストとフェンスを順序ごとに蓄積し、1つの SUBMIT_DESC にまとめます。
+// Prepend*() 、 Add*() はロックを使用せず、呼び出したスレッド専用のバッファに追加するため、複数のスレッドから同時に呼び出せます。
+// Finalize() は各スレッドのバッファを順序の昇順にマージします。 同じ順序に複数のスレッドから追加した場合、スレッド間の順序はバッファの登録順(不定)です。
+// コマンドリストの順序が重要な場合、スレッド(記録タスク)ごとに異なる順序を使用してください。
+// Has*() 、 Finalize() 、 Reset() は記録中のスレッドと同時に呼び出せません。 全ての記録の完了を待機してから呼び出す必要があります。
+// 各バッファとその配列は Reset() 後も容量を保持して再利用されるため、同じ順序と数のコマンドを送信するフレームではヒープの割り当てが発生しません。
 class CommandListChain
 {
-    using FenceInfo = std::tuple<buma3d::IFence*, uint64_t>;
-    template<template <typename T, typename Al = std::allocator<T>> class Container = std::vector>
     struct SUBMIT
     {
-        Container<FenceInfo>              wait_fences;
-        Container<FenceInfo>              signal_fences;
-        Container<buma3d::ICommandList*>  command_lists;
+        std::vector<buma3d::IFence*>        wait_fences;
+        std::vector<uint64_t>               wait_fence_values;
+        std::vector<buma3d::IFence*>        signal_fences;
+        std::vector<uint64_t>               signal_fence_values;
+        std::vector<buma3d::ICommandList*>  command_lists;
+
+        void Clear();
+        bool HasCommand() const { return !command_lists.empty(); }
+        bool HasSubmission() const { return !command_lists.empty() || !signal_fences.empty() || !wait_fences.empty(); }
+        void Append(const SUBMIT& _submit);
+        void AddSubmitInfo(const buma3d::SUBMIT_INFO& _info);
+        buma3d::SUBMIT_INFO GetAsSubmitInfo() const;
     };
 
-public:
-    CommandListChain()
-        : mutex             {}
-        , prepend_submits   {}
-        , submits           {}
-        , submit_desc       {}
-    {}
-    CommandListChain(const CommandListChain& _c)
-        : mutex             {}
-        , prepend_submits   { _c.prepend_submits }
-        , submits           { _c.submits }
-        , submit_desc       { _c.submit_desc }
-    {}
-    CommandListChain& operator=(const CommandListChain& _c)
+    // 順序ごとのスロットです。 THREAD_BUFFER::slots は order の昇順に並べられ、空になったスロットも削除せずに再利用されます。
+    struct SLOT
     {
-        prepend_submits = _c.prepend_submits;
-        submits         = _c.submits;
-        submit_desc     = _c.submit_desc;
-    }
-
-    ~CommandListChain() {}
+        uint64_t    order;
+        SUBMIT      submit;
+    };
 
-    void Reset()
+    // スレッドごとのバッファです。 所有するスレッドのみが書き込み、チェインが破棄されるまで解放されません。
+    struct THREAD_BUFFER
     {
-        prepend_submits.command_lists.clear();
-        prepend_submits.signal_fences.clear();
-        prepend_submits.wait_fences.clear();
-        for (auto& [i_order, i_si] : submits)
-        {
-            i_si.command_lists.clear();
-            i_si.signal_fences.clear();
-            i_si.wait_fences.clear();
-        }
-        submit_desc.Reset();
-    }
+        std::thread::id     thread_id;
+        THREAD_BUFFER*      next;
+        SUBMIT              prepend_submits;
+        std::vector<SLOT>   slots;
 
-    void PrependCommandList(buma3d::ICommandList* _list)
-    {
-        std::lock_guard lock(mutex);
-        prepend_submits.command_lists.emplace_front(_list);
-    }
-    void PrependSignalFence(buma3d::IFence* _fence, uint64_t _fence_value = 0)
-    {
-        std::lock_guard lock(mutex);
-        prepend_submits.signal_fences.emplace_front(_fence, _fence_value);
-    }
-    void PrependWaitFence(buma3d::IFence* _fence, uint64_t _fence_value = 0)
-    {
-        std::lock_guard lock(mutex);
-        prepend_submits.wait_fences.emplace_front(_fence, _fence_value);
-    }
-    void PrependSubmitInfo(const buma3d::SUBMIT_INFO& _info)
-    {
-        std::lock_guard lock(mutex);
-        for (uint32_t i = 0; i < _info.num_command_lists_to_execute; i++)
-            prepend_submits.command_lists.emplace_back(_info.command_lists_to_execute[i]);
+        SUBMIT&             GetOrAddSlot(uint64_t _order);
+        const SUBMIT*       FindSlot(uint64_t _order) const;
+    };
 
-        for (uint32_t i = 0; i < _info.wait_fence.num_fences; i++)
-            prepend_submits.wait_fences.emplace_back(_info.wait_fence.fences[i], _info.wait_fence.fence_values[i]);
+public:
+    CommandListChain();
+    ~CommandListChain();
 
-        for (uint32_t i = 0; i < _info.signal_fence.num_fences; i++)
-            prepend_submits.signal_fences.emplace_back(_info.signal_fence.fences[i], _info.signal_fence.fence_values[i]);
-    }
+    void Reset();
 
-    void AddCommandList(uint64_t _order, buma3d::ICommandList* _list)
-    {
-        std::lock_guard lock(mutex);
-        submits[_order].command_lists.emplace_back(_list);
-    }
-    void AddSignalFence(uint64_t _order, buma3d::IFence* _fence, uint64_t _fence_value = 0)
-    {
-        std::lock_guard lock(mutex);
-        submits[_order].signal_fences.emplace_back(_fence, _fence_value);
-    }
-    void AddWaitFence(uint64_t _order, buma3d::IFence* _fence, uint64_t _fence_value = 0)
-    {
-        std::lock_guard lock(mutex);
-        submits[_order].wait_fences.emplace_back(_fence, _fence_value);
-    }
-    void AddSubmitInfo(uint64_t _order, const buma3d::SUBMIT_INFO& _info)
-    {
-        std::lock_guard lock(mutex);
-        auto&& s = submits[_order];
-        for (uint32_t i = 0; i < _info.num_command_lists_to_execute; i++)
-            s.command_lists.emplace_back(_info.command_lists_to_execute[i]);
+    void PrependCommandList(buma3d::ICommandList* _list);
+    void PrependSignalFence(buma3d::IFence* _fence, uint64_t _fence_value = 0);
+    void PrependWaitFence(buma3d::IFence* _fence, uint64_t _fence_value = 0);
+    void PrependSubmitInfo(const buma3d::SUBMIT_INFO& _info);
 
-        for (uint32_t i = 0; i < _info.wait_fence.num_fences; i++)
-            s.wait_fences.emplace_back(_info.wait_fence.fences[i], _info.wait_fence.fence_values[i]);
+    void AddCommandList(uint64_t _order, buma3d::ICommandList* _list);
+    void AddSignalFence(uint64_t _order, buma3d::IFence* _fence, uint64_t _fence_value = 0);
+    void AddWaitFence(uint64_t _order, buma3d::IFence* _fence, uint64_t _fence_value = 0);
+    void AddSubmitInfo(uint64_t _order, const buma3d::SUBMIT_INFO& _info);
 
-        for (uint32_t i = 0; i < _info.signal_fence.num_fences; i++)
-            s.signal_fences.emplace_back(_info.signal_fence.fences[i], _info.signal_fence.fence_values[i]);
-    }
+    bool HasPrependedCommand() const;
+    bool HasCommand(uint64_t _in_order) const;
 
-    bool HasPrependedCommand() const
-    {
-        std::lock_guard lock(mutex);
-        return !prepend_submits.command_lists.empty();
-    }
-    bool HasCommand(uint64_t _in_order) const
-    {
-        std::lock_guard lock(mutex);
-        if (auto found = submits.find(_in_order); found == submits.end())
-            return false;
-        else
-            return !found->second.command_lists.empty();
-    }
+    bool HasPrependedSubmission() const;
+    bool HasSubmission(uint64_t _in_order) const;
 
-    bool HasPrependedSubmission() const
-    {
-        std::lock_guard lock(mutex);
-        return !prepend_submits.command_lists.empty() ||
-               !prepend_submits.signal_fences.empty() ||
-               !prepend_submits.wait_fences.empty();
-    }
-    bool HasSubmission(uint64_t _in_order) const
-    {
-        std::lock_guard lock(mutex);
-        if (auto found = submits.find(_in_order); found == submits.end())
-            return false;
-        else
-        {
-            auto&& s = found->second;
-            return !s.command_lists.empty() ||
-                   !s.signal_fences.empty() ||
-                   !s.wait_fences.empty();
-        }
-    }
+    // 全てのスレッドのバッファを順序ごとにマージし、SUBMIT_INFO に変換します。 結果は次の Reset() または追加の呼び出しまで有効です。
+    CommandListChain& Finalize();
+    const buma3d::SUBMIT_DESC& GetSubmitDesc() const { return submit_desc; }
 
-    CommandListChain& Finalize()
+    // _execution_fence のシグナルを最後の順序(UINT64_MAX)に追加し、他の全ての送信の後に独立した SUBMIT_INFO として送信します。
+    // Finalize() した SUBMIT_DESC を _submit(const buma3d::SUBMIT_DESC&) に渡した後、 Reset() します。
+    template<typename SubmitFuncT>
+    void SubmitAndReset(buma3d::IFence* _execution_fence, uint64_t _signal_value, SubmitFuncT&& _submit)
     {
-        auto AddSubmits = [&](auto&& _submits) {
-            auto&& si = submit_desc.AddNewSubmitInfo();
-            for (auto& [fence, val] : _submits.wait_fences)   si.AddWaitFence(fence, val);
-            for (auto& [fence, val] : _submits.signal_fences) si.AddSignalFence(fence, val);
-            for (auto& cmd : _submits.command_lists)          si.AddCommandList(cmd);
-            si.Finalize();
-        };
-        if (HasPrependedSubmission())
-            AddSubmits(prepend_submits);
-        for (auto& [i_order, i_si] : submits)
-            if (HasSubmission(i_order))
-                AddSubmits(i_si);
-        return *this;
-    }
-    buma::util::SubmitDesc& GetSubmitDesc()
-    {
-        return submit_desc;
+        AddSignalFence(UINT64_MAX, _execution_fence, _signal_value);
+        _submit(Finalize().GetSubmitDesc());
+        Reset();
     }
 
 private:
-    //mutable std::mutex              mutex;
-    mutable dummy_mutex             mutex;
-    SUBMIT<std::deque>              prepend_submits;
-    std::map<uint64_t, SUBMIT<>>    submits;
-    util::SubmitDesc                submit_desc;
+    CommandListChain(const CommandListChain&) = delete;
+    CommandListChain& operator=(const CommandListChain&) = delete;
+
+    THREAD_BUFFER& GetThreadBuffer();
+
+    // 複数のスレッドの送信を1つの SUBMIT_INFO にまとめます。 1つのスレッドのみの場合はそのバッファを直接参照します。
+    void AddMergedSubmitInfo(const SUBMIT* const* _submits, size_t _num_submits);
+
+private:
+    const uint64_t                          chain_id;       // スレッドローカルなキャッシュの識別に使用します。 アドレスと異なり再利用されません。
+    std::atomic<THREAD_BUFFER*>             thread_buffers; // 登録されたバッファの連結リストです。 先頭への追加のみが行われます。
+
+    // 以下は Finalize() でのみ使用されます。
+    std::vector<const THREAD_BUFFER*>       finalize_buffers;
+    std::vector<size_t>                     finalize_cursors;
+    std::vector<const SUBMIT*>              finalize_submits;
+    std::vector<SUBMIT>                     merged_submits;
+    uint32_t                                num_merged_submits;
+    std::vector<buma3d::SUBMIT_INFO>        submit_infos;
+    buma3d::SUBMIT_DESC                     submit_desc;
 
 };
 
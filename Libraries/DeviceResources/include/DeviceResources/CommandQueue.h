@@ -25,6 +25,7 @@ public:
     uint64_t               GetFenceValue() const { return fence_value; }
 
     // 送信するコマンドの追加
+    // ロックを使用しないため、複数の記録スレッドから同時に呼び出せます。 詳細は CommandListChain を参照してください。
 
     void PrependCommandList(buma3d::ICommandList* _list)                       { chain.PrependCommandList(_list); }
     void PrependSignalFence(buma3d::IFence* _fence, uint64_t _fence_value = 0) { chain.PrependSignalFence(_fence, _fence_value); }
@@ -61,8 +62,7 @@ public:
     uint64_t SubmitFromDr();
 
 private:
-    //mutable std::mutex                          mutex;
-    mutable dummy_mutex                         mutex;
+    mutable std::mutex                          mutex;          // キューへの送信を保護します。
     DeviceResources&                            dr;
     buma3d::COMMAND_TYPE                        command_type;
     buma3d::util::Ptr<buma3d::ICommandQueue>    command_queue;
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <DeviceResources/ResourceBuffer.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace buma
+{
+
+/**
+ * @brief 定数バッファのCPU側のコピーを保持し、値が変更されたレジスタ(16バイト)のみをマップされた領域へ書き込みます。
+ *        フラッシュもダーティな範囲のみを対象とします。
+ *        フレームごとに別の領域を使用する場合、 _num_instances に領域の数を指定します。 変更は各インスタンスの Flush() で、全てのインスタンスに反映されます。
+ *        オフセットには ShaderTools の GenerateConstantBufferHeader で生成された構造体の FIELD_OFFSETS 、または offsetof を使用できます。
+*/
+class ConstantBufferWriter
+{
+public:
+    /**
+     * @param _buffer ホスト可視ヒープに割り当てられたバッファです。
+     * @param _offset 最初のインスタンスの、バッファの先頭からのオフセットです。
+     * @param _size 定数バッファのサイズです。
+     * @param _instance_stride 各インスタンスの間隔です。 0の場合 _size を使用します。
+    */
+    ConstantBufferWriter(Buffer* _buffer, uint64_t _offset, uint32_t _size, uint32_t _num_instances = 1, uint64_t _instance_stride = 0);
+    ~ConstantBufferWriter();
+
+    /**
+     * @brief CPU側のコピーと比較し、異なるレジスタのみを更新してダーティとしてマークします。
+     * @return 値が変更された場合trueを返します。
+    */
+    bool Write(uint32_t _offset, const void* _data, uint32_t _size);
+
+    template<typename T>
+    bool Write(uint32_t _offset, const T& _value) { return Write(_offset, &_value, static_cast<uint32_t>(sizeof(T))); }
+
+    // 生成された構造体全体を書き込みます。 変更されたレジスタのみがダーティとしてマークされます。
+    template<typename T>
+    bool WriteAll(const T& _cb) { return Write(0, &_cb, static_cast<uint32_t>(sizeof(T))); }
+
+    // 全てのレジスタを、全てのインスタンスでダーティとしてマークします。
+    void MarkAllDirty();
+
+    /**
+     * @brief _instance のダーティなレジスタをマップされた領域へコピーし、コピーした範囲のみをフラッシュします。
+     * @return マップされた領域へ書き込んだバイト数を返します。
+    */
+    uint32_t Flush(uint32_t _instance = 0);
+
+    const void*     GetData()           const { return data.data(); }
+    uint32_t        GetSize()           const { return size; }
+    uint32_t        GetNumInstances()   const { return num_instances; }
+    uint64_t        GetInstanceOffset(uint32_t _instance) const { return offset + instance_stride * _instance; }
+
+private:
+    Buffer*                             buffer;
+    uint64_t                            offset;
+    uint32_t                            size;
+    uint32_t                            num_instances;
+    uint64_t                            instance_stride;
+    uint32_t                            num_registers;
+    uint32_t                            num_dirty_words;    // インスタンスごとのダーティビットの uint64_t の数
+    std::vector<uint8_t>                data;               // CPU側のコピー
+    std::vector<uint64_t>               dirty_bits;         // [num_instances * num_dirty_words] レジスタごとのダーティビット
+    std::vector<buma3d::MAPPED_RANGE>   flush_ranges;
+
+};
+
+
+}// namespace buma
@@ -3,6 +3,7 @@
 #include <Buma3D/Util/Buma3DPtr.h>
 
 #include <memory>
+#include <vector>
 
 namespace buma
 {
@@ -24,6 +25,9 @@ public:
 
     void CopyDataToBuffer(buma3d::IBuffer* _dst_buffer, uint64_t _dst_offset, size_t _src_size, const void* _src_data);
     void CopyDataToTexture(buma3d::ITexture* _dst_texture, uint32_t _mip_slice, uint32_t _array_slice, uint64_t _src_row_pitch, uint64_t _src_texture_height, size_t _src_size, const void* _src_data);
+    // _src_data に _src_slice_pitch 間隔で格納された _array_count 個の配列要素を、1回のステージング割り当てと1つのコピーコマンドでアップロードします。
+    // _dst_texture がボリュームの場合、 _array_count は深度方向のスライス数として扱われ、各スライスは深度のオフセットを持つ領域としてコピーされます。
+    void CopyDataToTexture(buma3d::ITexture* _dst_texture, uint32_t _mip_slice, uint32_t _array_slice, uint32_t _array_count, uint64_t _src_row_pitch, uint64_t _src_slice_pitch, uint64_t _src_texture_height, size_t _src_size, const void* _src_data);
 
     //void CopyBufferToData(BUFFER_ALLOCATION_PART* _dst_result_allocation, uint64_t _src_offset, uint64_t _src_size, buma3d::IBuffer* _src_buffer);              // End()呼び出し後にBUFFER_ALLOCATION_PART::map_data_partから取得します。
     //void CopyTextureToData(BUFFER_ALLOCATION_PART* _dst_result_allocation, buma3d::ITexture* _src_texture, uint32_t _mip_slice = 0, uint32_t _array_slice = 0); // End()呼び出し後にBUFFER_ALLOCATION_PART::map_data_partから取得します。
@@ -58,6 +62,9 @@ private:
     buma3d::util::Ptr<buma3d::IFence>               fence;
     uint64_t                                        fence_val;
     buma3d::SUBMIT_INFO                             submit_info;
+    std::vector<buma3d::BUFFER_TEXTURE_COPY_REGION> copy_regions;
+    std::vector<buma3d::OFFSET3D>                   copy_offsets;
+    std::vector<buma3d::EXTENT3D>                   copy_extents;
     bool                                            resetted;
     bool                                            has_command;
 
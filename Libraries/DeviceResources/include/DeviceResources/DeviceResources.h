@@ -14,6 +14,7 @@ class Buffer;
 class Texture;
 class SwapChain;
 class CommandQueue;
+class PipelineStateCache;
 
 class ResourceHeapProperties;
 class ResourceHeapsAllocator;
@@ -82,6 +83,7 @@ public:
     const buma3d::util::Ptr<buma3d::IDevice>&                   GetDevice()                                     const { return device; }
     const std::vector<CommandQueue*>&                           GetCommandQueues(buma3d::COMMAND_TYPE _type)    const { return cmd_queues[_type]; }
     ResourceHeapsAllocator*                                     GetResourceHeapsAllocator()                     const { return resource_heaps_allocator.get(); }
+    PipelineStateCache*                                         GetPipelineStateCache()                         const { return pipeline_state_cache.get(); }
 
 private:
     bool Init(const DEVICE_RESOURCE_DESC& _desc, const char* _library_dir);
@@ -113,6 +115,7 @@ private:
     //std::vector<std::shared_ptr<buma::GpuTimerPool>>      gpu_timer_pools[buma3d::COMMAND_TYPE_NUM_TYPES];    // [COMMAND_TYPE]
 
     std::unique_ptr<CopyContext>                            copy_context;
+    std::unique_ptr<PipelineStateCache>                     pipeline_state_cache;
 
     uint64_t                                                frame_value;
 
@@ -0,0 +1,114 @@
+#pragma once
+#include <Buma3D/Buma3D.h>
+#include <Buma3D/Util/Buma3DPtr.h>
+
+#include <Utils/NonCopyable.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace buma
+{
+
+class DeviceResources;
+class CommandQueue;
+
+struct PARALLEL_COMMAND_RECORDER_DESC
+{
+    buma3d::COMMAND_LIST_LEVEL  level;          // SECONDARYの場合、記録したリストはプライマリのコマンドリストから実行します。
+    uint32_t                    num_frames;     // 同時に実行中となるフレームの数です。 通常はスワップチェインのバッファ数を指定します。
+    size_t                      num_threads;    // 呼び出し元のスレッドを含む記録スレッドの数です。 set 0 to use std::thread::hardware_concurrency()
+    const char*                 name;           // 省略可能です。 作成するオブジェクトのデバッグ名の接頭辞です。
+};
+
+// 1つのフレームのコマンドを複数のスレッドで並列に記録します。
+// 各スレッドはフレームごとに専用のコマンドアロケータを持ち、ジョブごとにそのアロケータから割り当てたコマンドリストを使用します。
+// アロケータは num_frames 後の BeginFrame() で、そのフレームの送信の完了をキューのフェンス値で待機してからリセットされ、コマンドリストと共に再利用されます。
+// 記録したリストはジョブのインデックス順に返されるため、スレッドの実行順序に関わらず結果は決定的です。
+class ParallelCommandRecorder : public util::NonCopyable
+{
+public:
+    // _job_index のコマンドを記録します。 _list は BeginRecord 済みで、関数から戻った後に EndRecord されます。
+    using RECORD_FUNC = std::function<void(uint32_t _job_index, buma3d::ICommandList* _list)>;
+
+public:
+    ParallelCommandRecorder(DeviceResources& _dr, CommandQueue& _queue, const PARALLEL_COMMAND_RECORDER_DESC& _desc);
+    ~ParallelCommandRecorder();
+
+    /**
+     * @brief 次のフレームの記録を開始します。 同じフレームのアロケータを使用した以前の送信が完了していない場合、待機します。
+    */
+    void BeginFrame();
+
+    /**
+     * @brief _num_jobs 個のジョブを全ての記録スレッドで並列に記録し、完了するまで待機します。 1フレームに複数回呼び出せます。
+     * @param _begin_desc 各コマンドリストの BeginRecord に渡されます。 SECONDARYの場合 inheritance_desc を指定します。
+     * @return ジョブのインデックス順の記録されたコマンドリストを返します。 次の Record() または BeginFrame() まで有効です。
+    */
+    const std::vector<buma3d::ICommandList*>& Record(const buma3d::COMMAND_LIST_BEGIN_DESC& _begin_desc, uint32_t _num_jobs, const RECORD_FUNC& _func);
+
+    /**
+     * @brief PRIMARYのコマンドリストを記録し、ジョブのインデックス順に CommandQueue::AddCommandList(_order, ...) で追加します。
+    */
+    void RecordAndAddCommandLists(uint64_t _order, uint32_t _num_jobs, const RECORD_FUNC& _func);
+
+    /**
+     * @brief このフレームの送信後(DeviceResources::QueueSubmit の後)に呼び出し、アロケータを再利用する前に待機するフェンス値を記録します。
+    */
+    void EndFrame();
+
+    size_t GetNumThreads() const { return num_threads; }
+
+private:
+    // スレッドごと、フレームごとのアロケータとコマンドリストです。 lists は num_used_lists を超えて保持され、次のフレームで再利用されます。
+    struct THREAD_CONTEXT
+    {
+        buma3d::util::Ptr<buma3d::ICommandAllocator>            allocator;
+        std::vector<buma3d::util::Ptr<buma3d::ICommandList>>    lists;
+        uint32_t                                                num_used_lists;
+    };
+
+    struct FRAME
+    {
+        uint64_t                    fence_value;    // このフレームで記録したコマンドの実行が完了するキューのフェンス値です。 0の場合未送信です。
+        std::vector<THREAD_CONTEXT> contexts;       // [num_threads]
+    };
+
+    void                    CreateFrames();
+    buma3d::ICommandList*   AcquireList(size_t _thread_index);
+    void                    RecordJobs(size_t _thread_index);
+    void                    WorkerMain(size_t _thread_index);
+
+private:
+    DeviceResources&                        dr;
+    CommandQueue&                           queue;
+    PARALLEL_COMMAND_RECORDER_DESC          desc;
+    std::string                             name;
+    size_t                                  num_threads;
+    std::vector<FRAME>                      frames;
+    uint32_t                                frame_index;
+
+    // 現在の Record() の状態です。 ワーカーは generation が変化した時点でジョブの処理を開始します。
+    const buma3d::COMMAND_LIST_BEGIN_DESC*  current_begin_desc;
+    const RECORD_FUNC*                      current_func;
+    uint32_t                                current_num_jobs;
+    std::atomic_uint32_t                    next_job;
+    std::vector<buma3d::ICommandList*>      recorded_lists;
+
+    std::vector<std::thread>                workers;
+    std::mutex                              mutex;
+    std::condition_variable                 start_cv;
+    std::condition_variable                 done_cv;
+    uint64_t                                generation;
+    size_t                                  num_running_workers;
+    bool                                    is_exiting;
+
+};
+
+
+}// namespace buma
@@ -0,0 +1,133 @@
+#pragma once
+#include <Buma3D/Buma3D.h>
+#include <Buma3D/Util/Buma3DPtr.h>
+
+#include <Utils/NonCopyable.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace buma
+{
+
+namespace util { class PipelineStateDesc; }
+
+class DeviceResources;
+
+struct PIPELINE_STATE_CACHE_STATISTICS
+{
+    uint64_t num_hits;      // 作成済み、または他のスレッドで作成中のパイプラインを返した回数です。
+    uint64_t num_misses;    // パイプラインを作成した回数です。
+    uint64_t num_entries;
+};
+
+// パイプラインの記述全体をキーとして、作成したパイプラインを保持します。
+// 同じ記述のパイプラインを複数のスレッドから同時に要求した場合、作成は1度のみ行われ、他のスレッドはその完了を待機します。
+// RegisterShaderModule() でバイトコードを登録したシェーダモジュールは、オブジェクトではなくバイトコードで比較されるため、
+// 同じバイトコードから作成し直したモジュール(ホットリロード等)のパイプラインも再利用されます。
+// キャッシュは参照を保持し続けるため、置き換えたモジュールは UnregisterShaderModule() で登録を解除し、 ReleaseUnusedPipelines() で使用されなくなったパイプラインを解放します。
+// NOTE: Buma3DはドライバのパイプラインキャッシュのAPIを公開していないため、キャッシュはプロセス内でのみ有効です。
+class PipelineStateCache : public util::NonCopyable
+{
+public:
+    PipelineStateCache(DeviceResources& _dr);
+    ~PipelineStateCache();
+
+    /**
+     * @brief 以降のキーで _module を、同じバイトコードを持つ最初に登録されたモジュールとして扱います。
+     *        バイトコードは複製され、ハッシュが一致したモジュールとの比較に使用されます。 登録されたモジュールは、 UnregisterShaderModule() または Clear() までキャッシュが参照を保持します。
+    */
+    void RegisterShaderModule(buma3d::IShaderModule* _module, const void* _bytecode, size_t _bytecode_length);
+
+    /**
+     * @brief _module の登録を解除し、参照を解放します。 以降に作成されるパイプラインのキーで _module は置き換えられません。
+     *        _module が同じバイトコードを持つ他の登録されたモジュールの置き換え先である場合、それらの登録が全て解除されるまで参照を保持します。
+     *        作成済みのパイプラインのキーが参照するモジュールは、 ReleaseUnusedPipelines() で解放されるまで保持されます。
+    */
+    void UnregisterShaderModule(buma3d::IShaderModule* _module);
+
+    /**
+     * @brief キャッシュのみが参照しているパイプラインと、そのキーが参照するオブジェクトを解放します。 作成中のパイプラインは解放されません。
+     *        キャッシュは実行中のコマンドリストを追跡しないため、呼び出し元はそれらのパイプラインをGPUが使用していない事を保証する必要があります。
+     * @return 解放したパイプラインの数を返します。
+    */
+    size_t ReleaseUnusedPipelines();
+
+    /**
+     * @param _name 省略可能です。 パイプラインを作成する場合のみ設定される名前です。 返されるパイプラインは同じ記述の全ての要求で共有されるため、呼び出し元で名前を変更しないでください。
+     * @return 記述に一致するパイプラインを返します。 存在しない場合、作成します。 作成に失敗した場合nullptrを返し、失敗はキャッシュされません。
+    */
+    buma3d::util::Ptr<buma3d::IPipelineState> GetOrCreateGraphics(const buma3d::GRAPHICS_PIPELINE_STATE_DESC& _desc, const char* _name = nullptr);
+    buma3d::util::Ptr<buma3d::IPipelineState> GetOrCreateCompute(const buma3d::COMPUTE_PIPELINE_STATE_DESC& _desc, const char* _name = nullptr);
+
+    /**
+     * @brief _desc にコンピュートシェーダが含まれる場合、コンピュートパイプラインを作成します。
+    */
+    buma3d::util::Ptr<buma3d::IPipelineState> GetOrCreate(const util::PipelineStateDesc& _desc, const char* _name = nullptr);
+
+    /**
+     * @brief 全てのパイプラインと登録されたシェーダモジュールの参照を解放します。 作成中のパイプラインが存在しない時に呼び出す必要があります。
+    */
+    void Clear();
+
+    PIPELINE_STATE_CACHE_STATISTICS GetStatistics() const;
+
+private:
+    struct GRAPHICS_KEY;
+    struct COMPUTE_KEY;
+
+    template<typename KEY>
+    struct ENTRY
+    {
+        std::unique_ptr<KEY>                        key;
+        buma3d::util::Ptr<buma3d::IPipelineState>   pipeline;
+        bool                                        is_creating;
+    };
+
+    template<typename KEY>
+    using ENTRY_MAP = std::unordered_map<size_t, std::vector<std::shared_ptr<ENTRY<KEY>>>>;
+
+    template<typename KEY, typename DESC, typename CREATE_FUNC>
+    buma3d::util::Ptr<buma3d::IPipelineState> GetOrCreate(ENTRY_MAP<KEY>& _entries, const DESC& _desc, CREATE_FUNC&& _create);
+
+    template<typename KEY>
+    size_t ReleaseUnusedPipelines(ENTRY_MAP<KEY>& _entries);
+
+    buma3d::IShaderModule* GetCanonicalModule(buma3d::IShaderModule* _module) const;
+
+    // 登録されたモジュールの参照を保持し、解放されたアドレスが他のモジュールに再利用される事を防ぎます。
+    struct REGISTERED_MODULE
+    {
+        buma3d::util::Ptr<buma3d::IShaderModule>   module;
+        buma3d::IShaderModule*                      canonical_module;
+        size_t                                      bytecode_hash;
+    };
+
+    // 異なるバイトコードのハッシュが衝突した場合に区別するため、バイトコードを保持します。
+    // 置き換え先のモジュールは、置き換えられる全てのモジュールの登録が解除されるまで参照を保持します。
+    struct CANONICAL_MODULE
+    {
+        buma3d::util::Ptr<buma3d::IShaderModule>   module;
+        std::vector<uint8_t>                        bytecode;
+        size_t                                      num_registrations;
+    };
+
+private:
+    DeviceResources&                                                    dr;
+    mutable std::mutex                                                  mutex;
+    std::condition_variable                                             created_cv;
+
+    std::unordered_map<buma3d::IShaderModule*, REGISTERED_MODULE>       registered_modules;
+    std::unordered_map<size_t, std::vector<CANONICAL_MODULE>>           canonical_modules;  // バイトコードのハッシュごとの、バイトコードごとに最初に登録されたモジュールです。
+
+    ENTRY_MAP<GRAPHICS_KEY>                                             graphics_entries;
+    ENTRY_MAP<COMPUTE_KEY>                                              compute_entries;
+    PIPELINE_STATE_CACHE_STATISTICS                                     statistics;
+
+};
+
+
+}// namespace buma
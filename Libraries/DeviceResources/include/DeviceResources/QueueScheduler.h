@@ -0,0 +1,127 @@
+#pragma once
+#include <Buma3D/Buma3D.h>
+#include <Buma3D/Util/Buma3DPtr.h>
+
+#include <Utils/NonCopyable.h>
+
+#include <array>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace buma
+{
+
+class DeviceResources;
+class CommandQueue;
+
+// QueueScheduler::AddWork() が返す作業のハンドルです。 次の Schedule() まで有効です。
+using QUEUE_WORK = uint32_t;
+
+struct QUEUE_SCHEDULER_DESC
+{
+    const char* name; // 省略可能です。 作成するオブジェクトのデバッグ名の接頭辞です。
+};
+
+struct QUEUE_SCHEDULER_STATISTICS
+{
+    uint32_t num_works;
+    uint32_t num_waits;         // キュー間の依存関係のために追加した待機の数です。
+    uint32_t num_signals;       // 他のキューから待機されるために追加したシグナルの数です。
+    uint32_t num_elided_waits;  // 同じキュー、または既に待機済みの同期ポイントによって満たされるため省略した依存関係の数です。
+};
+
+// DIRECT、COMPUTE_ONLY、COPY_ONLYのキューに送信する作業とその依存関係を受け取り、キューを跨ぐ依存関係にのみタイムラインフェンスの待機とシグナルを挿入します。
+// 依存関係の無い作業は異なるキューで並行して実行されるため、アップロードやポストプロセスをグラフィックスの作業の裏で実行できます。
+// 各キューはそれぞれタイムラインフェンスを所有し、作業ごとに単調増加する値を割り当てます。 ある値の完了はそのキューのそれ以前の全ての作業の完了を意味するため、
+// 待機したキューが既に(推移的に)知っている値以下の依存関係の待機は省略されます。
+// 同じキューの作業間の依存関係はフェンスを使用せず、送信順とコマンドリスト内のパイプラインバリアによって満たされる事を前提とします。
+// キュー間のリソースの所有権の移動が必要な場合、バリアは作業のコマンドリストに記録する必要があります。
+// AddWork() 等は単一のスレッドから呼び出す必要があります。 コマンドリストの記録自体は事前に並列に行えます。
+class QueueScheduler : public util::NonCopyable
+{
+public:
+    QueueScheduler(DeviceResources& _dr, const QUEUE_SCHEDULER_DESC& _desc);
+    ~QueueScheduler();
+
+    /**
+     * @brief 作業を追加します。 作業は追加順に各キューへ送信されます。
+     * @param _type 作業を実行するキューの種類です。 キューが存在しない場合、COPY_ONLYはCOMPUTE_ONLY、COMPUTE_ONLYはDIRECTのキューで実行されます。
+     * @param _dependencies 完了を待機する作業です。 この作業より前に追加されている必要があります。
+    */
+    QUEUE_WORK AddWork(buma3d::COMMAND_TYPE _type, uint32_t _num_lists, buma3d::ICommandList* const* _lists, uint32_t _num_dependencies = 0, const QUEUE_WORK* _dependencies = nullptr);
+    QUEUE_WORK AddWork(buma3d::COMMAND_TYPE _type, buma3d::ICommandList* _list, std::initializer_list<QUEUE_WORK> _dependencies = {})
+    { return AddWork(_type, 1, &_list, (uint32_t)_dependencies.size(), _dependencies.begin()); }
+
+    /**
+     * @brief スワップチェインのフェンス等、スケジューラの外部のフェンスを作業の開始前に待機、または終了後にシグナルします。
+    */
+    void AddWaitFence  (QUEUE_WORK _work, buma3d::IFence* _fence, uint64_t _fence_value = 0);
+    void AddSignalFence(QUEUE_WORK _work, buma3d::IFence* _fence, uint64_t _fence_value = 0);
+
+    /**
+     * @brief 追加された全ての作業を、必要な待機とシグナルと共に各キューへ追加し、作業をクリアします。
+     *        [_base_order, _base_order + 作業の数) の順序を使用します。 呼び出し後、 GetQueue() の各キューを DeviceResources::QueueSubmit で送信する必要があります。
+    */
+    void Schedule(uint64_t _base_order);
+
+    /**
+     * @brief Schedule() を呼び出し、作業を追加したキューを DeviceResources::QueueSubmit で送信します。
+    */
+    void Submit(uint64_t _base_order = 0);
+
+    /**
+     * @return _type の作業を実行するキューです。 存在しない場合、代わりに使用されるキューを返します。
+    */
+    CommandQueue* GetQueue(buma3d::COMMAND_TYPE _type) const { return queues[_type]; }
+
+    /**
+     * @return 最後の Submit() で送信した、 GetQueue(_type) の送信が完了するタイミングでシグナルされる値です。 CommandQueue::WaitValueComplete で待機できます。
+    */
+    uint64_t GetSubmittedFenceValue(buma3d::COMMAND_TYPE _type) const { return submitted_fence_values[queues[_type]->GetCommandType()]; }
+
+    const QUEUE_SCHEDULER_STATISTICS& GetStatistics() const { return statistics; }
+
+private:
+    // 各キューについて、完了が分かっている各キューのフェンス値です。 [COMMAND_TYPE]
+    using KNOWN_VALUES = std::array<uint64_t, buma3d::COMMAND_TYPE_NUM_TYPES>;
+
+    struct WORK
+    {
+        buma3d::COMMAND_TYPE    queue_type;         // 実際に実行するキューの種類です。
+        uint32_t                first_list;
+        uint32_t                num_lists;
+        uint32_t                first_dependency;
+        uint32_t                num_dependencies;
+        uint64_t                fence_value;        // この作業の完了を表すキューのフェンスの値です。
+        KNOWN_VALUES            known_values;       // この作業の開始時点で完了が分かっている値です。
+        bool                    is_signaled;
+    };
+
+    struct EXTERNAL_FENCE
+    {
+        QUEUE_WORK              work;
+        buma3d::IFence*         fence;
+        uint64_t                fence_value;
+        bool                    is_signal;
+    };
+
+private:
+    DeviceResources&                                    dr;
+    std::string                                         name;
+    CommandQueue*                                       queues[buma3d::COMMAND_TYPE_NUM_TYPES];         // [COMMAND_TYPE] 代替のキューを含みます。
+    buma3d::util::Ptr<buma3d::IFence>                   fences[buma3d::COMMAND_TYPE_NUM_TYPES];         // [COMMAND_TYPE] キューの作業の完了を表すタイムラインフェンスです。
+    uint64_t                                            fence_values[buma3d::COMMAND_TYPE_NUM_TYPES];   // [COMMAND_TYPE] 最後に割り当てた値です。
+    uint64_t                                            submitted_fence_values[buma3d::COMMAND_TYPE_NUM_TYPES];
+
+    std::vector<WORK>                                   works;
+    std::vector<buma3d::ICommandList*>                  lists;
+    std::vector<QUEUE_WORK>                             dependencies;
+    std::vector<EXTERNAL_FENCE>                         external_fences;
+    std::vector<QUEUE_WORK>                             queue_works[buma3d::COMMAND_TYPE_NUM_TYPES];    // [COMMAND_TYPE] Schedule() で使用する、キューごとの作業です。
+    QUEUE_SCHEDULER_STATISTICS                          statistics;
+
+};
+
+
+}// namespace buma
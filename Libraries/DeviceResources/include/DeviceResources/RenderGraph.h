@@ -0,0 +1,191 @@
+#pragma once
+#include <DeviceResources/RenderGraphCompiler.h>
+
+#include <Buma3D/Buma3D.h>
+#include <Buma3D/Util/Buma3DPtr.h>
+
+#include <Buma3DHelpers/B3DDescHelpers.h>
+
+#include <Utils/NonCopyable.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace buma
+{
+
+class DeviceResources;
+class CommandQueue;
+class ParallelCommandRecorder;
+class Buffer;
+class Texture;
+class ResourceStates;
+class RenderGraph;
+
+struct RENDER_GRAPH_DESC
+{
+    uint32_t    num_frames;             // 同時に実行中となるフレームの数です。 通常はスワップチェインのバッファ数を指定します。
+    size_t      num_recording_threads;  // バッチを並列に記録するスレッドの数です。 1の場合呼び出し元のスレッドのみで記録します。 詳細は PARALLEL_COMMAND_RECORDER_DESC::num_threads を参照してください。
+    bool        enable_async_compute;   // コンピュートキューが存在しない場合、 RENDER_GRAPH_QUEUE_ASYNC_COMPUTE のパスはグラフィックスキューで実行されます。
+    const char* name;                   // 省略可能です。 作成するオブジェクトのデバッグ名の接頭辞です。
+};
+
+// パスの実行関数に渡されます。
+class RenderGraphPassContext
+{
+    friend class RenderGraph;
+public:
+    buma3d::ICommandList*   GetCommandList()                            const { return list; }
+    buma3d::IBuffer*        GetBuffer(RENDER_GRAPH_RESOURCE _resource)  const;
+    buma3d::ITexture*       GetTexture(RENDER_GRAPH_RESOURCE _resource) const;
+
+private:
+    RenderGraphPassContext(const RenderGraph& _graph, buma3d::ICommandList* _list) : graph{ _graph }, list{ _list } {}
+
+private:
+    const RenderGraph&      graph;
+    buma3d::ICommandList*   list;
+
+};
+
+// AddPass() から返され、パスがアクセスするリソースを宣言します。
+class RenderGraphPassBuilder
+{
+    friend class RenderGraph;
+public:
+    RenderGraphPassBuilder& Read (RENDER_GRAPH_RESOURCE _resource, buma3d::RESOURCE_STATE _state, buma3d::PIPELINE_STAGE_FLAGS _stages);
+    RenderGraphPassBuilder& Write(RENDER_GRAPH_RESOURCE _resource, buma3d::RESOURCE_STATE _state, buma3d::PIPELINE_STAGE_FLAGS _stages);
+
+    // 出力を持たないパス(表示、リードバック等)がカリングされないようにします。
+    RenderGraphPassBuilder& SetSideEffect();
+
+private:
+    RenderGraphPassBuilder(RenderGraph& _graph, uint32_t _pass) : graph{ _graph }, pass{ _pass } {}
+
+private:
+    RenderGraph&    graph;
+    uint32_t        pass;
+
+};
+
+// パスとリソースの宣言からコンパイルした実行スケジュールに従って、フレームごとにコマンドを記録、送信します。
+// パスの追加、リソースの作成、インポートによってトポロジが変更された場合のみ、 Compile() はカリング、バリアの配置、キューの割り当て、トランジェントリソースのメモリのエイリアシングを再計算します。
+// 状態の遷移はリソース全体を単位として行います。 インポートしたリソースの状態は最初のサブリソースの状態を使用し、実行後に全てのサブリソースに最後の状態を設定します。
+// インポートしたリソースは、グラフィックスキューで最初と最後にアクセスされる必要があります。
+class RenderGraph : public util::NonCopyable
+{
+    friend class RenderGraphPassContext;
+    friend class RenderGraphPassBuilder;
+public:
+    // パスのコマンドを記録します。 num_recording_threads が1より大きい場合、異なるバッチのパスは複数のスレッドから同時に呼び出されます。
+    using EXECUTE_FUNC = std::function<void(const RenderGraphPassContext& _context)>;
+
+public:
+    RenderGraph(DeviceResources& _dr, const RENDER_GRAPH_DESC& _desc);
+    ~RenderGraph();
+
+    // トポロジの変更
+
+    /**
+     * @brief グラフが所有するトランジェントリソースを作成します。 内容はフレーム間で保持されず、生存期間が重ならない他のリソースとメモリを共有する場合があります。
+    */
+    RENDER_GRAPH_RESOURCE CreateTransientResource(const char* _name, const buma3d::RESOURCE_DESC& _desc);
+    RENDER_GRAPH_RESOURCE ImportBuffer(const char* _name, Buffer* _buffer);
+    RENDER_GRAPH_RESOURCE ImportTexture(const char* _name, Texture* _texture);
+
+    RenderGraphPassBuilder AddPass(const char* _name, RENDER_GRAPH_QUEUE _queue, EXECUTE_FUNC _func);
+
+    /**
+     * @brief 全てのパスとリソースを削除します。
+    */
+    void Clear();
+
+    /**
+     * @brief インポートしたリソースを置き換えます。 トポロジは変更されないため、フレームごとに異なるスワップチェインのバッファ等を設定できます。
+    */
+    void SetImportedBuffer(RENDER_GRAPH_RESOURCE _resource, Buffer* _buffer);
+    void SetImportedTexture(RENDER_GRAPH_RESOURCE _resource, Texture* _texture);
+
+    // 実行
+
+    /**
+     * @brief トポロジが変更された場合、グラフをコンパイルしてトランジェントリソースを再作成します。 変更されていない場合は何もしません。
+     *        トランジェントリソースを再作成する場合、GPUの完了を待機します。
+     * @return 宣言が無効な場合falseを返します。
+    */
+    bool Compile();
+
+    /**
+     * @brief 次のフレームを開始します。 同じフレームのコマンドアロケータを使用した以前の送信が完了していない場合、待機します。
+    */
+    void BeginFrame();
+
+    /**
+     * @brief 全てのパスを記録し、各キューに追加します。 キュー間の同期のフェンスは CommandQueue::AddWaitFence/AddSignalFence で追加されます。
+     *        [_base_order, _base_order + GetCompiledGraph().batches.size()) の順序を使用します。
+     *        呼び出し後、使用する全てのキューを DeviceResources::QueueSubmit で送信する必要があります。
+    */
+    void Execute(uint64_t _base_order);
+
+    /**
+     * @brief 全てのキューの送信後に呼び出します。
+    */
+    void EndFrame();
+
+    const COMPILED_RENDER_GRAPH&        GetCompiledGraph()                  const { return compiled; }
+    const RENDER_GRAPH_MEMORY_LAYOUT&   GetMemoryLayout()                   const { return memory_layout; }
+    CommandQueue*                       GetQueue(RENDER_GRAPH_QUEUE _queue) const { return queues[_queue]; }
+
+private:
+    struct RESOURCE
+    {
+        std::string                             name;
+        buma3d::RESOURCE_DESC                   desc;
+        Buffer*                                 imported_buffer;
+        Texture*                                imported_texture;
+        buma3d::util::Ptr<buma3d::IResource>    transient;
+    };
+
+    struct PASS
+    {
+        std::string     name;
+        EXECUTE_FUNC    func;
+    };
+
+    RENDER_GRAPH_RESOURCE   AddResource(const char* _name, const buma3d::RESOURCE_DESC& _desc, Buffer* _imported_buffer, Texture* _imported_texture);
+    void                    CreateTransientResources();
+    void                    DestroyTransientResources();
+    buma3d::IResource*      GetResource(RENDER_GRAPH_RESOURCE _resource) const;
+    ResourceStates&         GetImportedStates(RENDER_GRAPH_RESOURCE _resource) const;
+    void                    RecordBatch(uint32_t _batch, buma3d::ICommandList* _list);
+    void                    RecordBarriers(const RENDER_GRAPH_BARRIER_BATCH& _barriers, util::PipelineBarrierDesc* _desc, buma3d::ICommandList* _list);
+
+private:
+    DeviceResources&                            dr;
+    RENDER_GRAPH_DESC                           desc;
+    std::string                                 name;
+    CommandQueue*                               queues[RENDER_GRAPH_QUEUE_NUM];
+    std::unique_ptr<ParallelCommandRecorder>    recorders[RENDER_GRAPH_QUEUE_NUM];
+
+    std::vector<RESOURCE>                       resources;
+    std::vector<RENDER_GRAPH_RESOURCE_NODE>     resource_nodes;
+    std::vector<PASS>                           passes;
+    std::vector<RENDER_GRAPH_PASS_NODE>         pass_nodes;
+    bool                                        is_dirty;
+
+    RenderGraphCompiler                         compiler;
+    COMPILED_RENDER_GRAPH                       compiled;
+    RENDER_GRAPH_MEMORY_LAYOUT                  memory_layout;
+    std::vector<buma3d::util::Ptr<buma3d::IResourceHeap>> heaps;
+    std::vector<uint32_t>                       queue_batches[RENDER_GRAPH_QUEUE_NUM];  // キューごとのバッチのインデックスです。
+    std::vector<util::PipelineBarrierDesc>      barrier_descs;                          // [batches] バッチは異なるスレッドで記録されるため、バッチごとに保持します。
+
+    buma3d::util::Ptr<buma3d::IFence>           sync_fence;         // キュー間の同期ポイントをシグナルするタイムラインフェンスです。
+    uint64_t                                    sync_fence_value;   // 前回の Execute() で使用した最後の値です。
+
+};
+
+
+}// namespace buma
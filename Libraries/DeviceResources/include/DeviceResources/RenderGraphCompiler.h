@@ -0,0 +1,184 @@
+#pragma once
+#include <Buma3D/Buma3D.h>
+
+#include <string>
+#include <vector>
+
+namespace buma
+{
+
+// レンダーグラフのリソースのハンドルです。 RenderGraph 内のリソースのインデックスです。
+using RENDER_GRAPH_RESOURCE = uint32_t;
+inline constexpr RENDER_GRAPH_RESOURCE RENDER_GRAPH_INVALID_RESOURCE = ~0u;
+
+enum RENDER_GRAPH_QUEUE : uint32_t
+{
+      RENDER_GRAPH_QUEUE_GRAPHICS
+    , RENDER_GRAPH_QUEUE_ASYNC_COMPUTE  // 非同期コンピュートキューが無効な場合、グラフィックスキューで実行されます。
+
+    , RENDER_GRAPH_QUEUE_NUM
+};
+
+#pragma region compile input
+
+struct RENDER_GRAPH_RESOURCE_ACCESS
+{
+    RENDER_GRAPH_RESOURCE           resource;
+    buma3d::RESOURCE_STATE          state;
+    buma3d::PIPELINE_STAGE_FLAGS    stages;
+    bool                            is_write;
+};
+
+struct RENDER_GRAPH_RESOURCE_NODE
+{
+    bool is_imported; // falseの場合、グラフが所有するトランジェントリソースです。 内容はグラフの実行ごとに未定義になります。
+};
+
+struct RENDER_GRAPH_PASS_NODE
+{
+    RENDER_GRAPH_QUEUE                          queue;
+    bool                                        has_side_effect;    // 出力を持たない場合もカリングされません。 (表示、リードバック等)
+    std::vector<RENDER_GRAPH_RESOURCE_ACCESS>   accesses;
+};
+
+struct RENDER_GRAPH_COMPILE_DESC
+{
+    uint32_t                            num_resources;
+    const RENDER_GRAPH_RESOURCE_NODE*   resources;
+    uint32_t                            num_passes;
+    const RENDER_GRAPH_PASS_NODE*       passes;         // 宣言順です。 リソースへのアクセスはこの順序で解決されます。
+    bool                                enable_async_compute;
+};
+
+#pragma endregion compile input
+
+#pragma region compile output
+
+struct RENDER_GRAPH_BARRIER
+{
+    RENDER_GRAPH_RESOURCE   resource;
+    buma3d::RESOURCE_STATE  src_state;
+    buma3d::RESOURCE_STATE  dst_state;
+    RENDER_GRAPH_QUEUE      src_queue;
+    RENDER_GRAPH_QUEUE      dst_queue;          // src_queue と異なる場合、所有権の移動です。 解放と取得の2つのバリアが両方のキューで発行されます。
+    bool                    is_initial_import;  // インポートされたリソースの最初のバリアです。 src_state、src_stages は実行時のリソースの状態から取得します。
+    bool                    is_write;           // dst_state でのアクセスが書き込みを含みます。 状態が同じでも、書き込みの前後にはメモリの依存関係のためにバリアが必要です。
+};
+
+// 1つの CMD_PIPELINE_BARRIER にまとめられるバリアの範囲です。
+struct RENDER_GRAPH_BARRIER_BATCH
+{
+    uint32_t                        first_barrier;  // COMPILED_RENDER_GRAPH::barriers のインデックスです。
+    uint32_t                        num_barriers;
+    buma3d::PIPELINE_STAGE_FLAGS    src_stages;
+    buma3d::PIPELINE_STAGE_FLAGS    dst_stages;
+};
+
+struct RENDER_GRAPH_COMPILED_PASS
+{
+    uint32_t                    pass;           // RENDER_GRAPH_COMPILE_DESC::passes のインデックスです。
+    RENDER_GRAPH_QUEUE          queue;
+    RENDER_GRAPH_BARRIER_BATCH  pre_barriers;   // パスの実行前に記録します。
+    RENDER_GRAPH_BARRIER_BATCH  post_barriers;  // パスの実行後に記録します。 他のキューへの所有権の解放のみを含みます。
+};
+
+// 1つのキューで連続して実行され、1つのコマンドリストに記録されるパスの集合です。
+// 他のキューとの同期は、バッチの開始前の待機と終了後のシグナルでのみ行われます。
+struct RENDER_GRAPH_BATCH
+{
+    RENDER_GRAPH_QUEUE      queue;
+    std::vector<uint32_t>   passes;             // COMPILED_RENDER_GRAPH::passes のインデックスです。
+    std::vector<uint32_t>   wait_sync_points;   // 開始前に待機する同期ポイントです。
+    uint32_t                signal_sync_point;  // 終了後にシグナルする同期ポイントです。 シグナルしない場合 ~0u です。
+};
+
+struct RENDER_GRAPH_RESOURCE_LIFETIME
+{
+    bool                            is_alive;       // カリングされていないパスからアクセスされます。
+    bool                            is_async;       // 非同期コンピュートキューからアクセスされます。 メモリのエイリアシングの対象外です。
+    uint32_t                        first_pass;     // COMPILED_RENDER_GRAPH::passes のインデックスです。
+    uint32_t                        last_pass;
+    buma3d::RESOURCE_STATE          final_state;    // グラフの実行後の状態です。
+    buma3d::PIPELINE_STAGE_FLAGS    final_stages;
+    bool                            final_is_written; // 最後のアクセスが書き込みを含みます。
+};
+
+struct COMPILED_RENDER_GRAPH
+{
+    std::vector<RENDER_GRAPH_COMPILED_PASS>     passes;         // 実行順です。 カリングされたパスは含みません。
+    std::vector<RENDER_GRAPH_BARRIER>           barriers;
+    std::vector<RENDER_GRAPH_BATCH>             batches;        // 送信順です。
+    uint32_t                                    num_sync_points;
+    std::vector<RENDER_GRAPH_RESOURCE_LIFETIME> lifetimes;      // [num_resources]
+    std::vector<bool>                           is_culled;      // [num_passes]
+
+    void Clear();
+};
+
+#pragma endregion compile output
+
+#pragma region memory aliasing
+
+struct RENDER_GRAPH_MEMORY_REQUIREMENTS
+{
+    uint64_t size_in_bytes;
+    uint64_t alignment;
+    uint32_t heap_type_bits;    // 同じ値を持つリソースのみがエイリアシングされます。
+};
+
+struct RENDER_GRAPH_MEMORY_PLACEMENT
+{
+    uint32_t heap;              // RENDER_GRAPH_MEMORY_LAYOUT::heaps のインデックスです。 配置されないリソースは ~0u です。
+    uint64_t offset;
+};
+
+struct RENDER_GRAPH_MEMORY_HEAP
+{
+    uint32_t heap_type_bits;
+    uint64_t size_in_bytes;
+    uint64_t alignment;
+};
+
+struct RENDER_GRAPH_MEMORY_LAYOUT
+{
+    std::vector<RENDER_GRAPH_MEMORY_HEAP>       heaps;
+    std::vector<RENDER_GRAPH_MEMORY_PLACEMENT>  placements; // [num_resources]
+    uint64_t                                    total_size_in_bytes;
+    uint64_t                                    unaliased_size_in_bytes; // エイリアシングしない場合の合計サイズです。
+};
+
+#pragma endregion memory aliasing
+
+// レンダーグラフのパスとリソースの宣言から、実行スケジュールを作成します。
+// GPUのオブジェクトを一切使用しないため、CPUのみで結果を検証できます。
+class RenderGraphCompiler
+{
+public:
+    /**
+     * @brief パスのカリング、キューの割り当て、バリアの配置とマージ、キュー間の同期ポイントの作成、トランジェントリソースの生存期間の計算を行います。
+     * @return 宣言が無効な場合falseを返し、 GetErrorMessage() に理由を設定します。
+    */
+    bool Compile(const RENDER_GRAPH_COMPILE_DESC& _desc, COMPILED_RENDER_GRAPH* _dst);
+
+    /**
+     * @brief 生存期間が重ならない生存中のトランジェントリソースに、同じヒープの範囲を割り当てます。
+     *        メモリを共有するリソースの最初のバリアは、以前にそのメモリを使用したリソースの最後のアクセスを待機するよう _compiled が更新されます。
+     *        ヒープは全てのフレームで共有されるため、前のフレームでそのメモリを最後に使用したリソース(自身を含む)の最後のアクセスも待機します。
+     *        この待機は同じキューでのみ有効です。 非同期コンピュートキューでアクセスされるリソースについて、前のフレームの他のキューでのアクセスとの同期は呼び出し元が保証する必要があります。
+     * @param _requirements [num_resources] インポートされたリソース、カリングされたリソースの要素は無視されます。
+    */
+    void AssignMemory(const RENDER_GRAPH_COMPILE_DESC& _desc, const RENDER_GRAPH_MEMORY_REQUIREMENTS* _requirements, COMPILED_RENDER_GRAPH* _compiled, RENDER_GRAPH_MEMORY_LAYOUT* _dst);
+
+    const std::string& GetErrorMessage() const { return error_message; }
+
+private:
+    void CullPasses(const RENDER_GRAPH_COMPILE_DESC& _desc, COMPILED_RENDER_GRAPH* _dst);
+    bool PlaceBarriers(const RENDER_GRAPH_COMPILE_DESC& _desc, COMPILED_RENDER_GRAPH* _dst);
+
+private:
+    std::string error_message;
+
+};
+
+
+}// namespace buma
@@ -2,6 +2,7 @@
 
 #include <DeviceResources/DeviceResources.h>
 
+#include <DeviceResources/ResourceStateTracker.h>
 #include <DeviceResources/private/ResourceViewCache.h>
 
 namespace buma
@@ -33,6 +34,10 @@ public:
     const char*                  GetName()                  { return resource->GetName(); }
     const buma3d::RESOURCE_DESC& GetDesc() const            { return resource->GetDesc(); }
 
+    // ResourceStateTracker で追跡される、サブリソースごとの現在の状態です。
+    ResourceStates&              GetStates()                { return states; }
+    const ResourceStates&        GetStates() const          { return states; }
+
 protected:
     bool CreateResource(const buma3d::RESOURCE_DESC& _desc, buma3d::RESOURCE_HEAP_PROPERTY_FLAGS _heap_flags, buma3d::RESOURCE_HEAP_PROPERTY_FLAGS _deny_heap_flags);
     bool AllocateHeap(buma3d::RESOURCE_HEAP_PROPERTY_FLAGS _heap_flags, buma3d::RESOURCE_HEAP_PROPERTY_FLAGS _deny_heap_flags);
@@ -43,6 +48,7 @@ protected:
     RESOURCE_CREATE_TYPE                    create_type;
     buma3d::util::Ptr<buma3d::IResource>    resource;
     RESOURCE_HEAP_ALLOCATION*               heap_allocation;
+    ResourceStates                          states;
 
 };
 
@@ -8,6 +8,9 @@ namespace buma
 class Buffer : public ResourceBase
 {
 public:
+    // ホスト非コヒーレントなヒープのフラッシュ、無効化範囲のアライメント(nonCoherentAtomSizeの上限)です。 ヒープの先頭からのオフセットに適用されます。
+    static constexpr uint64_t FLUSH_ALIGNMENT = 256;
+
     Buffer(DeviceResources& _dr, RESOURCE_CREATE_TYPE _create_type
            , const buma3d::RESOURCE_DESC& _desc, buma3d::RESOURCE_HEAP_PROPERTY_FLAGS _heap_flags, buma3d::RESOURCE_HEAP_PROPERTY_FLAGS  _deny_heap_flags);
     ~Buffer();
@@ -20,7 +23,13 @@ public:
     */
     void*                               GetMppedData();
     const buma3d::MAPPED_RANGE*         GetMppedRange() const;
+    /**
+     * @brief マップされた範囲をフラッシュ、無効化します。
+     * @param _range このバッファの先頭からのオフセットとサイズです。 nullptrの場合バッファ全体を対象とします。
+     *               ヒープの先頭からのオフセットに変換した後、 FLUSH_ALIGNMENT に拡張されます。 複数のスレッドから同時に呼び出せます。
+    */
     void                                Flush(const buma3d::MAPPED_RANGE* _range = nullptr);
+    void                                Flush(uint32_t _num_ranges, const buma3d::MAPPED_RANGE* _ranges);
     void                                Invalidate(const buma3d::MAPPED_RANGE* _range = nullptr);
 
     template<typename T>
@@ -29,9 +38,19 @@ public:
     buma3d::IShaderResourceView* GetSRV(const buma3d::SHADER_RESOURCE_VIEW_DESC& _desc);
     buma3d::IUnorderedAccessView* GetUAV(const buma3d::UNORDERED_ACCESS_VIEW_DESC& _desc);
 
+    /**
+     * @brief _tracker に、次のフラッシュまでにこのバッファを _state へ遷移するよう要求します。
+    */
+    void RequestState(ResourceStateTracker& _tracker, const SUBRESOURCE_STATE& _state) { _tracker.RequestBufferState(static_cast<buma3d::IBuffer*>(resource.Get()), &states, _state); }
+
+private:
+    // このバッファの先頭からの範囲を、 FLUSH_ALIGNMENT に拡張したヒープの先頭からの範囲に変換します。
+    buma3d::MAPPED_RANGE ToHeapRange(const buma3d::MAPPED_RANGE& _range) const;
+
 private:
     void*                                       mapped_data;
-    buma3d::MAPPED_RANGE                        mapped_range;
+    buma3d::MAPPED_RANGE                        mapped_range;       // このバッファの、ヒープの先頭からの範囲
+    buma3d::MAPPED_RANGE                        heap_mapped_range;  // ヒープ全体のマップされた範囲
     ShaderResourceViewCache<buma3d::IBuffer>    srvs;
     UnorderedAccessViewCache<buma3d::IBuffer>   uavs;
 
@@ -0,0 +1,144 @@
+#pragma once
+#include <Buma3D/Buma3D.h>
+
+#include <Buma3DHelpers/B3DDescHelpers.h>
+
+#include <Utils/NonCopyable.h>
+
+#include <vector>
+
+namespace buma
+{
+
+struct SUBRESOURCE_STATE
+{
+    buma3d::RESOURCE_STATE          state;
+    buma3d::PIPELINE_STAGE_FLAGS    stages; // この状態でリソースにアクセスするパイプラインステージです。 次の遷移の src_stages になります。
+    bool                            is_write; // この状態でリソースに書き込みます。 書き込みを含むアクセスの間には、状態が同じでもバリアが発行されます。
+
+    bool operator==(const SUBRESOURCE_STATE& _c) const { return state == _c.state && stages == _c.stages && is_write == _c.is_write; }
+    bool operator!=(const SUBRESOURCE_STATE& _c) const { return !(*this == _c); }
+};
+
+// Buffer/Texture が保持する、サブリソースごとの現在の状態です。
+// ResourceStateTracker で要求された状態は pending に記録され、フラッシュ時に current へ反映されます。
+// リソースへのアクセスは一切行わないため、リソースの記述のみから作成できます。
+class ResourceStates : public util::NonCopyable
+{
+    friend class ResourceStateTracker;
+public:
+    ResourceStates();
+    ~ResourceStates();
+
+    /**
+     * @brief 全てのサブリソースを _initial_state で初期化します。 バッファの場合は全ての数に1を指定します。
+     * @param _is_depth_stencil 深度とステンシルのアスペクトを別々に追跡します。
+    */
+    void Init(uint32_t _mip_levels, uint32_t _array_size, bool _is_depth_stencil, const SUBRESOURCE_STATE& _initial_state);
+    void Init(const buma3d::RESOURCE_DESC& _desc, const SUBRESOURCE_STATE& _initial_state);
+
+    /**
+     * @brief 外部(スワップチェインの表示など)で変更された状態を、バリアを発行せずに全てのサブリソースへ設定します。 保留中の要求が存在しない状態で呼び出す必要があります。
+    */
+    void Reset(const SUBRESOURCE_STATE& _state);
+
+    uint32_t                    GetMipLevels()        const { return mip_levels; }
+    uint32_t                    GetArraySize()        const { return array_size; }
+    uint32_t                    GetNumAspects()       const { return num_aspects; }
+    uint32_t                    GetNumSubresources()  const { return (uint32_t)current.size(); }
+    bool                        HasPendingState()     const { return is_pending; }
+    const SUBRESOURCE_STATE&    Get(uint32_t _aspect_index, uint32_t _mip_slice, uint32_t _array_slice) const { return current[GetIndex(_aspect_index, _mip_slice, _array_slice)]; }
+
+private:
+    uint32_t GetIndex(uint32_t _aspect_index, uint32_t _mip_slice, uint32_t _array_slice) const { return (_aspect_index * array_size + _array_slice) * mip_levels + _mip_slice; }
+
+private:
+    uint32_t                        mip_levels;
+    uint32_t                        array_size;
+    uint32_t                        num_aspects;
+    buma3d::TEXTURE_ASPECT_FLAGS    aspects[2];
+    std::vector<SUBRESOURCE_STATE>  current;        // [aspect][array][mip]
+    std::vector<SUBRESOURCE_STATE>  pending;        // [aspect][array][mip] is_pending の間のみ有効です。 要求されていないサブリソースの stages は PIPELINE_STAGE_FLAG_NONE です。
+    bool                            is_pending;     // ResourceStateTracker の保留リストに登録されています。
+
+};
+
+// リソースの状態の要求をフラッシュまで蓄積し、最小限のバリアを1つの CMD_PIPELINE_BARRIER にまとめて発行します。
+// 同じサブリソースへの複数の要求は最初の状態から最後の状態への1つの遷移にまとめられ、状態が変化しない遷移は前後のアクセスがどちらも読み取りの場合のみ省略されます。
+// 同じ遷移を持つ隣接したサブリソースは1つの SUBRESOURCE_RANGE に結合されます。
+// 要求した状態に依存するコマンドを記録する前に Flush() を呼び出す必要があります。
+// 1つのリソースは同時に1つのトラッカーでのみ状態を要求できます。 トラッカーはリソースのメソッドを呼び出さないため、CPUのみで状態遷移を検証できます。
+class ResourceStateTracker : public util::NonCopyable
+{
+public:
+    ResourceStateTracker();
+    ~ResourceStateTracker();
+
+    /**
+     * @brief バッファの状態を要求します。
+    */
+    void RequestBufferState(buma3d::IBuffer* _buffer, ResourceStates* _states, const SUBRESOURCE_STATE& _state);
+
+    /**
+     * @brief テクスチャの _range の状態を要求します。 _range の mip_levels、array_size はリソースの残りの数に切り詰められます。
+    */
+    void RequestTextureState(buma3d::ITexture* _texture, ResourceStates* _states, const buma3d::SUBRESOURCE_RANGE& _range, const SUBRESOURCE_STATE& _state);
+
+    /**
+     * @brief テクスチャの全てのサブリソースの状態を要求します。
+    */
+    void RequestTextureState(buma3d::ITexture* _texture, ResourceStates* _states, const SUBRESOURCE_STATE& _state);
+
+    bool HasPendingBarriers() const { return !pending_resources.empty(); }
+
+    /**
+     * @brief 保留中の要求を解決し、リソースの状態を更新します。
+     * @return 発行するバリアが存在しない場合nullptrを返します。 次の Flush() または Discard() まで有効です。
+    */
+    const buma3d::CMD_PIPELINE_BARRIER* Flush();
+
+    /**
+     * @brief 保留中の要求を解決し、必要な場合 _list にバリアを記録します。
+     * @return バリアを記録した場合trueを返します。
+    */
+    bool Flush(buma3d::ICommandList* _list);
+
+    /**
+     * @brief 保留中の要求を破棄します。 リソースの状態は変更されません。
+    */
+    void Discard();
+
+private:
+    struct PENDING_RESOURCE
+    {
+        buma3d::IBuffer*    buffer;     // バッファの場合のみ有効です。
+        buma3d::ITexture*   texture;    // テクスチャの場合のみ有効です。
+        ResourceStates*     states;
+    };
+
+    // 同じ遷移を持つサブリソースの範囲です。 テクスチャごと、遷移ごとに1つのバリアとして発行されます。
+    struct TRANSITION
+    {
+        buma3d::RESOURCE_STATE                  src_state;
+        buma3d::RESOURCE_STATE                  dst_state;
+        std::vector<buma3d::SUBRESOURCE_RANGE>  ranges;
+    };
+
+    void        RegisterPending(buma3d::IBuffer* _buffer, buma3d::ITexture* _texture, ResourceStates* _states);
+    static bool NeedsBarrier(const SUBRESOURCE_STATE& _current, const SUBRESOURCE_STATE& _pending);
+    void        AddBufferBarrier(buma3d::IBuffer* _buffer, ResourceStates* _states);
+    void        AddTextureBarriers(buma3d::ITexture* _texture, ResourceStates* _states);
+    TRANSITION& GetOrAddTransition(buma3d::RESOURCE_STATE _src_state, buma3d::RESOURCE_STATE _dst_state);
+
+private:
+    std::vector<PENDING_RESOURCE>   pending_resources;
+    std::vector<TRANSITION>         transitions;        // AddTextureBarriers の一時バッファです。 num_transitions を超えた要素は再利用のため保持されます。
+    size_t                          num_transitions;
+    buma3d::PIPELINE_STAGE_FLAGS    src_stages;
+    buma3d::PIPELINE_STAGE_FLAGS    dst_stages;
+    util::PipelineBarrierDesc       barrier_desc;
+
+};
+
+
+}// namespace buma
@@ -23,6 +23,15 @@ public:
     buma3d::IRenderTargetView*      GetRTV(const buma3d::RENDER_TARGET_VIEW_DESC& _desc);
     buma3d::IDepthStencilView*      GetDSV(const buma3d::DEPTH_STENCIL_VIEW_DESC& _desc);
 
+    /**
+     * @brief _tracker に、次のフラッシュまでにこのテクスチャを _state へ遷移するよう要求します。
+    */
+    void RequestState(ResourceStateTracker& _tracker, const SUBRESOURCE_STATE& _state)                                           { _tracker.RequestTextureState(GetB3DTextureRaw(), &states, _state); }
+    void RequestState(ResourceStateTracker& _tracker, const buma3d::SUBRESOURCE_RANGE& _range, const SUBRESOURCE_STATE& _state)  { _tracker.RequestTextureState(GetB3DTextureRaw(), &states, _range, _state); }
+
+private:
+    buma3d::ITexture* GetB3DTextureRaw() const { return static_cast<buma3d::ITexture*>(resource.Get()); }
+
 public:
     ShaderResourceViewCache<buma3d::ITexture>   srvs;
     UnorderedAccessViewCache<buma3d::ITexture>  uavs;
@@ -8,13 +8,192 @@
 #include <Buma3DHelpers/Buma3DHelpers.h>
 #include <Buma3DHelpers/B3DDescHash.h>
 
+#include <atomic>
 #include <memory>
-#include <unordered_map>
 #include <mutex>
+#include <vector>
 
 namespace buma
 {
 
+// ビューの記述をパックしたキー(util::PACKED_DESC_KEY)をキーとする、読み取りにロックを必要としないオープンアドレス法のハッシュテーブルです。
+// ウォームアップ後の検索はほぼ全てヒットするため、ミスした場合のみ mutex を取得してビューを作成、追加します。
+// テーブルの使用率が1/2を超えた場合、2倍のテーブルを作成して公開します。 古いテーブルは読み取り中のスレッドが参照している可能性があるため、 Clear() まで破棄しません。
+// Clear() は他のスレッドが GetOrCreate() を呼び出していない時に呼び出す必要があります。
+template<typename DescT, typename ViewT>
+class ViewCacheTable
+{
+public:
+    ViewCacheTable()
+        : mutex     {}
+        , id        { NewId() }
+        , table     {}
+        , tables    {}
+        , nodes     {}
+    {
+    }
+
+    ~ViewCacheTable()
+    {
+        Clear();
+    }
+
+    DECLARE_NON_COPYABLE(ViewCacheTable);
+
+    // _create は mutex の取得中に呼び出され、作成したビューの参照を返します。 nullptrを返した場合、キャッシュされません。
+    template<typename CreateFuncT>
+    ViewT* GetOrCreate(const DescT& _desc, CreateFuncT&& _create)
+    {
+        // キーは1度だけパックし、以降の比較は全て memcmp で行います。
+        auto key = util::PackDescKey(_desc);
+
+        // 記録中のコマンドリストは同じビューを連続して要求する事が多いため、スレッドごとに直前のビューを保持します。
+        auto&& front = GetFrontCache();
+        auto current_id = id.load(std::memory_order_relaxed);
+        for (auto& i : front.entries)
+        {
+            if (i.id == current_id && i.key == key)
+                return i.view;
+        }
+
+        auto hash = key.Hash();
+        auto result = Find(table.load(std::memory_order_acquire), hash, key);
+        if (!result)
+            result = Insert(hash, key, _desc, _create);
+
+        if (result)
+        {
+            front.entries[front.next] = { current_id, key, result };
+            front.next = (front.next + 1) % NUM_FRONT_CACHE_ENTRIES;
+        }
+        return result;
+    }
+
+    void Clear()
+    {
+        std::lock_guard lock(mutex);
+        for (auto& i : nodes)
+        {
+            BUMA_ASSERT(i->view->GetRefCount() == 1);
+            util::SafeRelease(i->view);
+        }
+        nodes.clear();
+        table.store(nullptr, std::memory_order_release);
+        tables.clear();
+
+        // スレッドごとのキャッシュに残っている、解放したビューを無効にします。
+        id.store(NewId(), std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr size_t NUM_FRONT_CACHE_ENTRIES = 4;
+    static constexpr size_t INITIAL_TABLE_SIZE      = 8;
+
+    using KEY = util::PACKED_DESC_KEY<DescT>;
+
+    struct NODE
+    {
+        size_t  hash;
+        KEY     key;
+        ViewT*  view;
+    };
+
+    struct TABLE
+    {
+        size_t                                  mask;
+        std::unique_ptr<std::atomic<NODE*>[]>   slots;
+    };
+
+    struct FRONT_CACHE_ENTRY
+    {
+        uint64_t    id; // 破棄、またはクリアされたテーブルのエントリと区別するための、テーブルごとに一意な値です。
+        KEY         key;
+        ViewT*      view;
+    };
+
+    struct FRONT_CACHE
+    {
+        FRONT_CACHE_ENTRY   entries[NUM_FRONT_CACHE_ENTRIES];
+        size_t              next;
+    };
+
+    static uint64_t NewId()
+    {
+        static std::atomic_uint64_t next_id{};
+        return ++next_id;
+    }
+
+    static FRONT_CACHE& GetFrontCache()
+    {
+        static thread_local FRONT_CACHE front{};
+        return front;
+    }
+
+    static ViewT* Find(const TABLE* _table, size_t _hash, const KEY& _key)
+    {
+        if (!_table)
+            return nullptr;
+
+        // 使用率は1/2以下であるため、空のスロットで必ず終了します。
+        for (size_t i = _hash & _table->mask;; i = (i + 1) & _table->mask)
+        {
+            auto node = _table->slots[i].load(std::memory_order_acquire);
+            if (!node)
+                return nullptr;
+            if (node->hash == _hash && node->key == _key)
+                return node->view;
+        }
+    }
+
+    static void Place(TABLE* _table, NODE* _node)
+    {
+        auto i = _node->hash & _table->mask;
+        while (_table->slots[i].load(std::memory_order_relaxed))
+            i = (i + 1) & _table->mask;
+        _table->slots[i].store(_node, std::memory_order_release);
+    }
+
+    template<typename CreateFuncT>
+    ViewT* Insert(size_t _hash, const KEY& _key, const DescT& _desc, CreateFuncT& _create)
+    {
+        std::lock_guard lock(mutex);
+
+        // ロックの取得までに他のスレッドが追加している可能性があります。
+        auto current = table.load(std::memory_order_relaxed);
+        if (auto result = Find(current, _hash, _key))
+            return result;
+
+        auto view = _create(_desc);
+        if (!view)
+            return nullptr;
+
+        auto node = nodes.emplace_back(std::make_unique<NODE>(NODE{ _hash, _key, view })).get();
+        if (current && nodes.size() * 2 <= current->mask + 1)
+        {
+            Place(current, node);
+            return view;
+        }
+
+        // 全てのノードを配置してから公開するため、読み取り中のスレッドが構築中のテーブルを参照することはありません。
+        auto size = current ? (current->mask + 1) * 2 : INITIAL_TABLE_SIZE;
+        auto&& new_table = tables.emplace_back(std::make_unique<TABLE>());
+        new_table->mask  = size - 1;
+        new_table->slots = std::make_unique<std::atomic<NODE*>[]>(size);
+        for (auto& i : nodes)
+            Place(new_table.get(), i.get());
+        table.store(new_table.get(), std::memory_order_release);
+        return view;
+    }
+
+private:
+    std::mutex                          mutex;  // 追加とクリアのみで取得します。
+    std::atomic_uint64_t                id;
+    std::atomic<TABLE*>                 table;
+    std::vector<std::unique_ptr<TABLE>> tables; // 作成した全てのテーブルです。 最後の要素が table です。
+    std::vector<std::unique_ptr<NODE>>  nodes;
+
+};
+
 class SamplerViewCache
 {
 public:
@@ -33,30 +212,22 @@ public:
 
     buma3d::ISamplerView* GetOrCreate(const buma3d::SAMPLER_DESC& _desc)
     {
-        std::lock_guard lock(mutex);
-        auto&& result = views_cache[_desc];
-        if (result)
+        return views_cache.GetOrCreate(_desc, [this](const buma3d::SAMPLER_DESC& _d)
+        {
+            buma3d::ISamplerView* result{};
+            auto bmr = device->CreateSampler(_d, &result);
+            BMR_ASSERT(bmr);
             return result;
-
-        auto bmr = device->CreateSampler(_desc, &result);
-        BMR_ASSERT(bmr);
-        return result;
+        });
     }
     void ClearCache()
     {
-        std::lock_guard lock(mutex);
-        for (auto& [key, i] : views_cache)
-        {
-            BUMA_ASSERT(i->GetRefCount() == 1);
-            util::SafeRelease(i);
-        }
-        views_cache.clear();
+        views_cache.Clear();
     }
 
 private:
-    std::mutex mutex; // FIXME: SamplerViewCache::mutex
     buma3d::IDevice* device;
-    std::unordered_map<buma3d::SAMPLER_DESC, buma3d::ISamplerView*> views_cache;
+    ViewCacheTable<buma3d::SAMPLER_DESC, buma3d::ISamplerView> views_cache;
 
 };
 
@@ -65,8 +236,7 @@ class ResourceViewCache
 {
 public:
     ResourceViewCache()
-        : mutex{}
-        , device{}
+        : device{}
         , resource{}
         , views_cache{}
     {
@@ -85,39 +255,31 @@ public:
         resource = _resource;
         device = resource->GetDevice();
     }
-    
+
     ViewT* GetOrCreate(const DescT& _desc)
     {
-        std::lock_guard lock(mutex);
-        auto&& result = views_cache[_desc];
-        if (result)
+        return views_cache.GetOrCreate(_desc, [this](const DescT& _d)
+        {
+            ViewT* result{};
+            buma3d::BMRESULT bmr;
+            if constexpr (std::is_same_v<decltype(Method), decltype(&buma3d::IDevice::CreateUnorderedAccessView)>)
+                bmr = (device->*Method)(resource, nullptr, _d, &result);
+            else
+                bmr = (device->*Method)(resource, _d, &result);
+            BMR_ASSERT(bmr);
             return result;
-
-        buma3d::BMRESULT bmr;
-        if constexpr (std::is_same_v<decltype(Method), decltype(&buma3d::IDevice::CreateUnorderedAccessView)>)
-            bmr = (device->*Method)(resource, nullptr, _desc, &result);
-        else
-            bmr = (device->*Method)(resource, _desc, &result);
-        BMR_ASSERT(bmr);
-        return result;
+        });
     }
 
     void ClearCache()
     {
-        std::lock_guard lock(mutex);
-        for (auto& [key,i] : views_cache)
-        {
-            BUMA_ASSERT(i->GetRefCount() == 1);
-            util::SafeRelease(i);
-        }
-        views_cache.clear();
+        views_cache.Clear();
     }
 
 private:
-    std::mutex mutex; // FIXME: ResourceViewCache::mutex
     buma3d::IDevice* device;
     ResourceT* resource;
-    std::unordered_map<DescT, ViewT*> views_cache;
+    ViewCacheTable<DescT, ViewT> views_cache;
 
 };
 
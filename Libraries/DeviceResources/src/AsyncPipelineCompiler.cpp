@@ -0,0 +1,265 @@
+#include <DeviceResources/AsyncPipelineCompiler.h>
+#include <DeviceResources/PipelineStateCache.h>
+
+#include <Buma3DHelpers/B3DDescHelpers.h>
+
+#include <Utils/Utils.h>
+#include <Utils/Logger.h>
+
+#include <algorithm>
+#include <fstream>
+
+namespace buma
+{
+
+AsyncPipeline::AsyncPipeline()
+    : owner             {}
+    , name              {}
+    , priority          {}
+    , state             { ASYNC_PIPELINE_STATE_PENDING }
+    , is_used           {}
+    , pipeline          {}
+    , fallback          {}
+    , desc              {}
+    , pipeline_layout   {}
+    , render_pass       {}
+    , modules           {}
+{
+}
+
+AsyncPipeline::~AsyncPipeline()
+{
+}
+
+buma3d::IPipelineState* AsyncPipeline::Get(bool* _is_fallback)
+{
+    auto s = state.load(std::memory_order_acquire);
+    if (!is_used.load(std::memory_order_relaxed) && !is_used.exchange(true, std::memory_order_relaxed))
+        owner->OnFirstUse(*this);
+
+    if (s == ASYNC_PIPELINE_STATE_READY)
+    {
+        if (_is_fallback)
+            *_is_fallback = false;
+        return pipeline.Get();
+    }
+
+    if (_is_fallback)
+        *_is_fallback = true;
+    return fallback.Get();
+}
+
+AsyncPipelineCompiler::AsyncPipelineCompiler(PipelineStateCache& _cache, const ASYNC_PIPELINE_COMPILER_DESC& _desc)
+    : cache             { _cache }
+    , warmup_list_path  { _desc.warmup_list_path ? _desc.warmup_list_path : "" }
+    , warmup_list       {}
+    , warmup_priorities {}
+    , used_names        {}
+    , used_name_set     {}
+    , mutex             {}
+    , queue_cv          {}
+    , done_cv           {}
+    , queue             {}
+    , num_requests      {}
+    , num_in_flight     {}
+    , should_exit       {}
+    , workers           {}
+{
+    LoadWarmupList();
+
+    auto num_threads = _desc.num_threads != 0 ? _desc.num_threads : static_cast<size_t>(std::thread::hardware_concurrency());
+    num_threads = (std::max)(num_threads, size_t(1));
+    workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++)
+        workers.emplace_back([this]() { WorkerMain(); });
+}
+
+AsyncPipelineCompiler::~AsyncPipelineCompiler()
+{
+    {
+        std::lock_guard lock(mutex);
+        should_exit = true;
+    }
+    queue_cv.notify_all();
+    for (auto& i : workers)
+        i.join();
+
+    // ハンドルが残っている場合でも、フォールバックを返し続けるようにします。
+    for (auto& i : queue)
+        i->state.store(ASYNC_PIPELINE_STATE_FAILED, std::memory_order_release);
+    queue.clear();
+}
+
+void AsyncPipelineCompiler::LoadWarmupList()
+{
+    if (warmup_list_path.empty())
+        return;
+
+    std::ifstream ifs(warmup_list_path, std::ios::in);
+    if (!ifs)
+        return;
+
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || warmup_priorities.find(line) != warmup_priorities.end())
+            continue;
+
+        // 優先度0は、使用された未作成のパイプラインのために予約します。
+        warmup_priorities[line] = warmup_list.size() + 1;
+        warmup_list.push_back(line);
+    }
+    BUMA_LOGI("Loaded pipeline warmup list {} ({} entries)", warmup_list_path.c_str(), warmup_list.size());
+}
+
+bool AsyncPipelineCompiler::SaveWarmupList() const
+{
+    if (warmup_list_path.empty())
+        return false;
+
+    std::lock_guard lock(mutex);
+
+    // 使用されたパイプラインが存在しない場合、前回のリストは変更されないため書き込みません。
+    if (used_names.empty())
+        return true;
+
+    std::ofstream ofs(warmup_list_path, std::ios::out | std::ios::trunc);
+    if (!ofs)
+    {
+        BUMA_LOGE("Failed to write pipeline warmup list {}", warmup_list_path.c_str());
+        return false;
+    }
+
+    for (auto& i : used_names)
+        ofs << i << '\n';
+    for (auto& i : warmup_list)
+    {
+        if (used_name_set.find(i) == used_name_set.end())
+            ofs << i << '\n';
+    }
+    return !ofs.fail();
+}
+
+std::shared_ptr<AsyncPipeline> AsyncPipelineCompiler::Request(const char* _name, const util::PipelineStateDesc& _desc, buma3d::IPipelineState* _fallback)
+{
+    BUMA_ASSERT(_name);
+    std::shared_ptr<AsyncPipeline> result(new AsyncPipeline());
+    result->owner    = this;
+    result->name     = _name;
+    result->fallback = _fallback;
+    result->desc     = std::make_unique<util::PipelineStateDesc>(_desc);
+
+    // 作成が完了するまで、呼び出し元が記述のオブジェクトを解放しても有効であるよう参照を保持します。
+    auto&& gpso = result->desc->GetAsGraphics();
+    result->pipeline_layout = gpso.pipeline_layout;
+    result->render_pass     = gpso.render_pass;
+    for (uint32_t i = 0; i < gpso.num_shader_stages; i++)
+        result->modules.emplace_back() = gpso.shader_stages[i].module;
+
+    {
+        std::lock_guard lock(mutex);
+        auto it = warmup_priorities.find(result->name);
+        result->priority = it != warmup_priorities.end() ? it->second : warmup_list.size() + 1 + num_requests;
+        num_requests++;
+        queue.push_back(result);
+    }
+    queue_cv.notify_one();
+
+    return result;
+}
+
+void AsyncPipelineCompiler::OnFirstUse(AsyncPipeline& _pipeline)
+{
+    std::lock_guard lock(mutex);
+    if (used_name_set.insert(_pipeline.name).second)
+        used_names.push_back(_pipeline.name);
+
+    // 描画に必要とされているため、待機中の他の要求より先に作成します。
+    if (_pipeline.state.load(std::memory_order_relaxed) == ASYNC_PIPELINE_STATE_PENDING)
+        _pipeline.priority = 0;
+}
+
+void AsyncPipelineCompiler::Wait(AsyncPipeline& _pipeline)
+{
+    std::unique_lock lock(mutex);
+    auto it = std::find_if(queue.begin(), queue.end(), [&](const std::shared_ptr<AsyncPipeline>& _p) { return _p.get() == &_pipeline; });
+    if (it != queue.end())
+    {
+        // ワーカーを待たず、呼び出し元のスレッドで作成します。
+        auto p = *it;
+        queue.erase(it);
+        p->state.store(ASYNC_PIPELINE_STATE_COMPILING, std::memory_order_relaxed);
+        num_in_flight++;
+        lock.unlock();
+
+        Compile(*p);
+
+        lock.lock();
+        num_in_flight--;
+        done_cv.notify_all();
+        return;
+    }
+
+    done_cv.wait(lock, [&]() {
+        auto s = _pipeline.state.load(std::memory_order_acquire);
+        return s == ASYNC_PIPELINE_STATE_READY || s == ASYNC_PIPELINE_STATE_FAILED;
+    });
+}
+
+void AsyncPipelineCompiler::WaitIdle()
+{
+    std::unique_lock lock(mutex);
+    done_cv.wait(lock, [this]() { return queue.empty() && num_in_flight == 0; });
+}
+
+void AsyncPipelineCompiler::Compile(AsyncPipeline& _pipeline)
+{
+    // 同じ記述の要求はキャッシュされた1つのパイプラインを共有するため、名前はキャッシュが作成する場合のみ設定されます。
+    auto result = cache.GetOrCreate(*_pipeline.desc, _pipeline.name.c_str());
+    if (result)
+    {
+        _pipeline.pipeline = result;
+        _pipeline.state.store(ASYNC_PIPELINE_STATE_READY, std::memory_order_release);
+    }
+    else
+    {
+        BUMA_LOGE("AsyncPipelineCompiler: failed to create pipeline {}", _pipeline.name.c_str());
+        _pipeline.state.store(ASYNC_PIPELINE_STATE_FAILED, std::memory_order_release);
+    }
+
+    // 作成したパイプラインはキャッシュが参照を保持するため、記述は不要になります。
+    _pipeline.desc.reset();
+    _pipeline.pipeline_layout.Reset();
+    _pipeline.render_pass.Reset();
+    _pipeline.modules.clear();
+}
+
+void AsyncPipelineCompiler::WorkerMain()
+{
+    std::unique_lock lock(mutex);
+    while (true)
+    {
+        queue_cv.wait(lock, [this]() { return should_exit || !queue.empty(); });
+        if (should_exit)
+            break;
+
+        // 要求は少数であるため、最も優先度の高い要求を線形に探索します。
+        auto it = std::min_element(queue.begin(), queue.end(), [](const std::shared_ptr<AsyncPipeline>& _a, const std::shared_ptr<AsyncPipeline>& _b) { return _a->priority < _b->priority; });
+        auto p = *it;
+        queue.erase(it);
+        p->state.store(ASYNC_PIPELINE_STATE_COMPILING, std::memory_order_relaxed);
+        num_in_flight++;
+        lock.unlock();
+
+        Compile(*p);
+
+        lock.lock();
+        num_in_flight--;
+        done_cv.notify_all();
+    }
+}
+
+
+}// namespace buma
@@ -0,0 +1,318 @@
+#include <DeviceResources/CommandListChain.h>
+
+#include <algorithm>
+
+namespace buma
+{
+
+namespace /*anonymous*/
+{
+
+std::atomic_uint64_t g_next_chain_id = 1;
+
+
+}// namespace /*anonymous*/
+
+#pragma region SUBMIT
+
+void CommandListChain::SUBMIT::Clear()
+{
+    wait_fences.clear();
+    wait_fence_values.clear();
+    signal_fences.clear();
+    signal_fence_values.clear();
+    command_lists.clear();
+}
+
+void CommandListChain::SUBMIT::Append(const SUBMIT& _submit)
+{
+    wait_fences        .insert(wait_fences        .end(), _submit.wait_fences        .begin(), _submit.wait_fences        .end());
+    wait_fence_values  .insert(wait_fence_values  .end(), _submit.wait_fence_values  .begin(), _submit.wait_fence_values  .end());
+    signal_fences      .insert(signal_fences      .end(), _submit.signal_fences      .begin(), _submit.signal_fences      .end());
+    signal_fence_values.insert(signal_fence_values.end(), _submit.signal_fence_values.begin(), _submit.signal_fence_values.end());
+    command_lists      .insert(command_lists      .end(), _submit.command_lists      .begin(), _submit.command_lists      .end());
+}
+
+void CommandListChain::SUBMIT::AddSubmitInfo(const buma3d::SUBMIT_INFO& _info)
+{
+    command_lists      .insert(command_lists      .end(), _info.command_lists_to_execute , _info.command_lists_to_execute  + _info.num_command_lists_to_execute);
+    wait_fences        .insert(wait_fences        .end(), _info.wait_fence.fences        , _info.wait_fence.fences         + _info.wait_fence.num_fences);
+    wait_fence_values  .insert(wait_fence_values  .end(), _info.wait_fence.fence_values  , _info.wait_fence.fence_values   + _info.wait_fence.num_fences);
+    signal_fences      .insert(signal_fences      .end(), _info.signal_fence.fences      , _info.signal_fence.fences       + _info.signal_fence.num_fences);
+    signal_fence_values.insert(signal_fence_values.end(), _info.signal_fence.fence_values, _info.signal_fence.fence_values + _info.signal_fence.num_fences);
+}
+
+buma3d::SUBMIT_INFO CommandListChain::SUBMIT::GetAsSubmitInfo() const
+{
+    buma3d::SUBMIT_INFO info{};
+    info.wait_fence.num_fences          = (uint32_t)wait_fences.size();
+    info.wait_fence.fences              = wait_fences.data();
+    info.wait_fence.fence_values        = wait_fence_values.data();
+    info.num_command_lists_to_execute   = (uint32_t)command_lists.size();
+    info.command_lists_to_execute       = command_lists.data();
+    info.signal_fence.num_fences        = (uint32_t)signal_fences.size();
+    info.signal_fence.fences            = signal_fences.data();
+    info.signal_fence.fence_values      = signal_fence_values.data();
+    return info;
+}
+
+#pragma endregion SUBMIT
+
+#pragma region THREAD_BUFFER
+
+CommandListChain::SUBMIT& CommandListChain::THREAD_BUFFER::GetOrAddSlot(uint64_t _order)
+{
+    // スロットの数は送信の順序の種類数(通常は数個)であるため、線形探索します。
+    auto it = slots.begin();
+    while (it != slots.end() && it->order < _order)
+        ++it;
+    if (it == slots.end() || it->order != _order)
+        it = slots.insert(it, SLOT{ _order, {} });
+    return it->submit;
+}
+
+const CommandListChain::SUBMIT* CommandListChain::THREAD_BUFFER::FindSlot(uint64_t _order) const
+{
+    for (auto& i : slots)
+    {
+        if (i.order == _order)
+            return &i.submit;
+    }
+    return nullptr;
+}
+
+#pragma endregion THREAD_BUFFER
+
+CommandListChain::CommandListChain()
+    : chain_id              { g_next_chain_id.fetch_add(1, std::memory_order_relaxed) }
+    , thread_buffers        { nullptr }
+    , finalize_buffers      {}
+    , finalize_cursors      {}
+    , finalize_submits      {}
+    , merged_submits        {}
+    , num_merged_submits    {}
+    , submit_infos          {}
+    , submit_desc           {}
+{
+}
+
+CommandListChain::~CommandListChain()
+{
+    auto b = thread_buffers.exchange(nullptr, std::memory_order_acquire);
+    while (b)
+    {
+        auto next = b->next;
+        delete b;
+        b = next;
+    }
+}
+
+CommandListChain::THREAD_BUFFER& CommandListChain::GetThreadBuffer()
+{
+    // 直前に使用したチェインのバッファをキャッシュし、連続した追加ではリストを探索しません。
+    struct CACHE
+    {
+        uint64_t        chain_id;
+        THREAD_BUFFER*  buffer;
+    };
+    thread_local CACHE cache{};
+    if (cache.chain_id == chain_id)
+        return *cache.buffer;
+
+    auto id = std::this_thread::get_id();
+    for (auto b = thread_buffers.load(std::memory_order_acquire); b; b = b->next)
+    {
+        if (b->thread_id == id)
+        {
+            cache = { chain_id, b };
+            return *b;
+        }
+    }
+
+    // このスレッドから初めて追加される場合のみ、バッファを作成してリストの先頭に追加します。
+    auto b = new THREAD_BUFFER{ id, thread_buffers.load(std::memory_order_relaxed), {}, {} };
+    while (!thread_buffers.compare_exchange_weak(b->next, b, std::memory_order_release, std::memory_order_relaxed));
+    cache = { chain_id, b };
+    return *b;
+}
+
+void CommandListChain::Reset()
+{
+    for (auto b = thread_buffers.load(std::memory_order_acquire); b; b = b->next)
+    {
+        b->prepend_submits.Clear();
+        for (auto& i : b->slots)
+            i.submit.Clear();
+    }
+    submit_infos.clear();
+    submit_desc = {};
+}
+
+void CommandListChain::PrependCommandList(buma3d::ICommandList* _list)
+{
+    auto&& s = GetThreadBuffer().prepend_submits;
+    s.command_lists.insert(s.command_lists.begin(), _list);
+}
+
+void CommandListChain::PrependSignalFence(buma3d::IFence* _fence, uint64_t _fence_value)
+{
+    auto&& s = GetThreadBuffer().prepend_submits;
+    s.signal_fences      .insert(s.signal_fences      .begin(), _fence);
+    s.signal_fence_values.insert(s.signal_fence_values.begin(), _fence_value);
+}
+
+void CommandListChain::PrependWaitFence(buma3d::IFence* _fence, uint64_t _fence_value)
+{
+    auto&& s = GetThreadBuffer().prepend_submits;
+    s.wait_fences      .insert(s.wait_fences      .begin(), _fence);
+    s.wait_fence_values.insert(s.wait_fence_values.begin(), _fence_value);
+}
+
+void CommandListChain::PrependSubmitInfo(const buma3d::SUBMIT_INFO& _info)
+{
+    GetThreadBuffer().prepend_submits.AddSubmitInfo(_info);
+}
+
+void CommandListChain::AddCommandList(uint64_t _order, buma3d::ICommandList* _list)
+{
+    GetThreadBuffer().GetOrAddSlot(_order).command_lists.emplace_back(_list);
+}
+
+void CommandListChain::AddSignalFence(uint64_t _order, buma3d::IFence* _fence, uint64_t _fence_value)
+{
+    auto&& s = GetThreadBuffer().GetOrAddSlot(_order);
+    s.signal_fences.emplace_back(_fence);
+    s.signal_fence_values.emplace_back(_fence_value);
+}
+
+void CommandListChain::AddWaitFence(uint64_t _order, buma3d::IFence* _fence, uint64_t _fence_value)
+{
+    auto&& s = GetThreadBuffer().GetOrAddSlot(_order);
+    s.wait_fences.emplace_back(_fence);
+    s.wait_fence_values.emplace_back(_fence_value);
+}
+
+void CommandListChain::AddSubmitInfo(uint64_t _order, const buma3d::SUBMIT_INFO& _info)
+{
+    GetThreadBuffer().GetOrAddSlot(_order).AddSubmitInfo(_info);
+}
+
+bool CommandListChain::HasPrependedCommand() const
+{
+    for (auto b = thread_buffers.load(std::memory_order_acquire); b; b = b->next)
+    {
+        if (b->prepend_submits.HasCommand())
+            return true;
+    }
+    return false;
+}
+
+bool CommandListChain::HasCommand(uint64_t _in_order) const
+{
+    for (auto b = thread_buffers.load(std::memory_order_acquire); b; b = b->next)
+    {
+        if (auto s = b->FindSlot(_in_order); s && s->HasCommand())
+            return true;
+    }
+    return false;
+}
+
+bool CommandListChain::HasPrependedSubmission() const
+{
+    for (auto b = thread_buffers.load(std::memory_order_acquire); b; b = b->next)
+    {
+        if (b->prepend_submits.HasSubmission())
+            return true;
+    }
+    return false;
+}
+
+bool CommandListChain::HasSubmission(uint64_t _in_order) const
+{
+    for (auto b = thread_buffers.load(std::memory_order_acquire); b; b = b->next)
+    {
+        if (auto s = b->FindSlot(_in_order); s && s->HasSubmission())
+            return true;
+    }
+    return false;
+}
+
+CommandListChain& CommandListChain::Finalize()
+{
+    // リストは新しいバッファが先頭であるため、逆順にして登録順にマージします。
+    finalize_buffers.clear();
+    for (auto b = thread_buffers.load(std::memory_order_acquire); b; b = b->next)
+        finalize_buffers.emplace_back(b);
+    std::reverse(finalize_buffers.begin(), finalize_buffers.end());
+
+    submit_infos.clear();
+    num_merged_submits = 0;
+
+    finalize_submits.clear();
+    for (auto b : finalize_buffers)
+    {
+        if (b->prepend_submits.HasSubmission())
+            finalize_submits.emplace_back(&b->prepend_submits);
+    }
+    AddMergedSubmitInfo(finalize_submits.data(), finalize_submits.size());
+
+    // 各バッファのスロットは順序の昇順であるため、最小の順序を持つスロットから順にマージします。
+    finalize_cursors.assign(finalize_buffers.size(), 0);
+    while (true)
+    {
+        uint64_t order    = UINT64_MAX;
+        bool     has_slot = false;
+        for (size_t i = 0; i < finalize_buffers.size(); i++)
+        {
+            auto&& slots = finalize_buffers[i]->slots;
+            if (finalize_cursors[i] < slots.size() && (!has_slot || slots[finalize_cursors[i]].order < order))
+            {
+                order    = slots[finalize_cursors[i]].order;
+                has_slot = true;
+            }
+        }
+        if (!has_slot)
+            break;
+
+        finalize_submits.clear();
+        for (size_t i = 0; i < finalize_buffers.size(); i++)
+        {
+            auto&& slots = finalize_buffers[i]->slots;
+            if (finalize_cursors[i] < slots.size() && slots[finalize_cursors[i]].order == order)
+            {
+                auto&& s = slots[finalize_cursors[i]++].submit;
+                if (s.HasSubmission())
+                    finalize_submits.emplace_back(&s);
+            }
+        }
+        AddMergedSubmitInfo(finalize_submits.data(), finalize_submits.size());
+    }
+
+    submit_desc.num_submit_infos    = (uint32_t)submit_infos.size();
+    submit_desc.submit_infos        = submit_infos.data();
+    submit_desc.signal_fence_to_cpu = nullptr;
+    return *this;
+}
+
+void CommandListChain::AddMergedSubmitInfo(const SUBMIT* const* _submits, size_t _num_submits)
+{
+    if (_num_submits == 0)
+        return;
+
+    if (_num_submits == 1)
+    {
+        submit_infos.emplace_back(_submits[0]->GetAsSubmitInfo());
+        return;
+    }
+
+    if (num_merged_submits == merged_submits.size())
+        merged_submits.emplace_back();
+    auto&& merged = merged_submits[num_merged_submits++];
+    merged.Clear();
+    for (size_t i = 0; i < _num_submits; i++)
+        merged.Append(*_submits[i]);
+    submit_infos.emplace_back(merged.GetAsSubmitInfo());
+}
+
+
+}// namespace buma
@@ -42,11 +42,15 @@ uint64_t CommandQueue::Submit(util::SubmitDesc& _custom_submission)
 
 void CommandQueue::SubmitWait(buma3d::IFence* _fence, uint64_t _value)
 {
+    std::lock_guard lock(mutex);
+
     command_queue->SubmitWait({ buma3d::FENCE_SUBMISSION{ 1, &_fence, &_value } });
 }
 
 void CommandQueue::SubmitSignal(buma3d::IFence* _fence, uint64_t _value, buma3d::IFence* _fence_to_cpu)
 {
+    std::lock_guard lock(mutex);
+
     command_queue->SubmitSignal({ buma3d::FENCE_SUBMISSION{ 1, &_fence, &_value }, _fence_to_cpu });
 }
 
@@ -60,14 +64,11 @@ uint64_t CommandQueue::SubmitFromDr()
 {
     std::lock_guard lock(mutex);
 
-    auto&& submit_desc = chain.Finalize().GetSubmitDesc();
-
-    submit_desc.AddNewSubmitInfo().AddSignalFence(execution_fence.Get(), fence_value + 1).Finalize();
-
-    auto bmr = command_queue->Submit(submit_desc.Finalize().Get());
-    BMR_ASSERT(bmr);
-
-    chain.Reset();
+    chain.SubmitAndReset(execution_fence.Get(), fence_value + 1, [this](const buma3d::SUBMIT_DESC& _desc)
+    {
+        auto bmr = command_queue->Submit(_desc);
+        BMR_ASSERT(bmr);
+    });
     fence_value++;
     return fence_value;
 }
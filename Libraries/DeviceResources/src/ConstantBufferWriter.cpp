@@ -0,0 +1,117 @@
+#include <DeviceResources/ConstantBufferWriter.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace buma
+{
+
+namespace /*anonymous*/
+{
+
+constexpr uint32_t REGISTER_SIZE = 16;
+
+}// namespace /*anonymous*/
+
+
+ConstantBufferWriter::ConstantBufferWriter(Buffer* _buffer, uint64_t _offset, uint32_t _size, uint32_t _num_instances, uint64_t _instance_stride)
+    : buffer            { _buffer }
+    , offset            { _offset }
+    , size              { _size }
+    , num_instances     { _num_instances }
+    , instance_stride   { _instance_stride ? _instance_stride : _size }
+    , num_registers     { (_size + REGISTER_SIZE - 1) / REGISTER_SIZE }
+    , num_dirty_words   { (num_registers + 63) / 64 }
+    , data              ( _size )
+    , dirty_bits        {}
+    , flush_ranges      {}
+{
+    BUMA_ASSERT(buffer->GetMppedData() && "ConstantBufferWriter requires a host visible buffer");
+    BUMA_ASSERT(GetInstanceOffset(num_instances - 1) + size <= buffer->GetMppedRange()->size);
+    dirty_bits.resize(size_t(num_instances) * num_dirty_words);
+    MarkAllDirty();
+}
+
+ConstantBufferWriter::~ConstantBufferWriter()
+{
+}
+
+bool ConstantBufferWriter::Write(uint32_t _offset, const void* _data, uint32_t _size)
+{
+    BUMA_ASSERT(_offset + _size <= size);
+    auto src     = static_cast<const uint8_t*>(_data);
+    bool changed = false;
+
+    // レジスタごとに比較し、変更されたレジスタのみを更新します。
+    auto end = _offset + _size;
+    for (auto i = _offset; i < end;)
+    {
+        auto reg      = i / REGISTER_SIZE;
+        auto reg_end  = std::min(end, (reg + 1) * REGISTER_SIZE);
+        auto length   = reg_end - i;
+        if (std::memcmp(data.data() + i, src + (i - _offset), length) != 0)
+        {
+            std::memcpy(data.data() + i, src + (i - _offset), length);
+            for (uint32_t inst = 0; inst < num_instances; inst++)
+                dirty_bits[size_t(inst) * num_dirty_words + reg / 64] |= 1ull << (reg % 64);
+            changed = true;
+        }
+        i = reg_end;
+    }
+    return changed;
+}
+
+void ConstantBufferWriter::MarkAllDirty()
+{
+    std::fill(dirty_bits.begin(), dirty_bits.end(), 0);
+    for (uint32_t inst = 0; inst < num_instances; inst++)
+    {
+        auto bits = dirty_bits.data() + size_t(inst) * num_dirty_words;
+        for (uint32_t reg = 0; reg < num_registers; reg++)
+            bits[reg / 64] |= 1ull << (reg % 64);
+    }
+}
+
+uint32_t ConstantBufferWriter::Flush(uint32_t _instance)
+{
+    BUMA_ASSERT(_instance < num_instances);
+    auto bits        = dirty_bits.data() + size_t(_instance) * num_dirty_words;
+    auto dst_offset  = GetInstanceOffset(_instance);
+    auto dst         = static_cast<uint8_t*>(buffer->GetMppedData()) + dst_offset;
+
+    uint32_t written = 0;
+    flush_ranges.clear();
+    for (uint32_t reg = 0; reg < num_registers;)
+    {
+        if (!(bits[reg / 64] & (1ull << (reg % 64))))
+        {
+            reg++;
+            continue;
+        }
+
+        // 連続するダーティなレジスタを1度にコピーします。
+        auto first = reg;
+        while (reg < num_registers && (bits[reg / 64] & (1ull << (reg % 64))))
+            reg++;
+
+        auto begin = first * REGISTER_SIZE;
+        auto end   = std::min(reg * REGISTER_SIZE, size);
+        std::memcpy(dst + begin, data.data() + begin, end - begin);
+        written += end - begin;
+
+        // フラッシュ範囲のアライメントは Buffer::Flush() がヒープの先頭からのオフセットで行います。 ここでは近接する範囲のみを結合します。
+        auto flush_begin = dst_offset + begin;
+        auto flush_end   = dst_offset + end;
+        if (!flush_ranges.empty() && flush_ranges.back().offset + flush_ranges.back().size + Buffer::FLUSH_ALIGNMENT >= flush_begin)
+            flush_ranges.back().size = flush_end - flush_ranges.back().offset;
+        else
+            flush_ranges.push_back({ flush_begin, flush_end - flush_begin });
+    }
+    std::fill(bits, bits + num_dirty_words, 0);
+
+    buffer->Flush((uint32_t)flush_ranges.size(), flush_ranges.data());
+    return written;
+}
+
+
+}// namespace buma
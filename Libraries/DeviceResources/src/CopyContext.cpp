@@ -20,6 +20,9 @@ CopyContext::CopyContext(DeviceResources& _dr, buma3d::COMMAND_TYPE _type)
     , fence           {}
     , fence_val       {}
     , submit_info     {}
+    , copy_regions    {}
+    , copy_offsets    {}
+    , copy_extents    {}
     , resetted        {}
     , has_command     {}
 {
@@ -141,27 +144,59 @@ void CopyContext::CopyDataToBuffer(buma3d::IBuffer* _dst_buffer, uint64_t _dst_o
 
 void CopyContext::CopyDataToTexture(buma3d::ITexture* _dst_texture, uint32_t _mip_slice, uint32_t _array_slice, uint64_t _src_row_pitch, uint64_t _src_texture_height, size_t _src_size, const void* _src_data)
 {
-    auto al = upload_buffer->AllocateBufferPart(_src_size, dr.GetDeviceAdapterLimits().buffer_copy_offset_alignment);
-    memcpy(al.map_data_part, _src_data, _src_size);
+    CopyDataToTexture(_dst_texture, _mip_slice, _array_slice, 1, _src_row_pitch, _src_size, _src_texture_height, _src_size, _src_data);
+}
+
+void CopyContext::CopyDataToTexture(buma3d::ITexture* _dst_texture, uint32_t _mip_slice, uint32_t _array_slice, uint32_t _array_count, uint64_t _src_row_pitch, uint64_t _src_slice_pitch, uint64_t _src_texture_height, size_t _src_size, const void* _src_data)
+{
+    // ボリュームは配列を持たないため、 _array_count 個のスライスは深度のオフセットで指定します。
+    auto&& tex_desc  = _dst_texture->GetDesc().texture;
+    bool   is_volume = tex_desc.dimension == buma3d::TEXTURE_DIMENSION_3D;
+    BUMA_ASSERT(!is_volume || _array_slice == 0);
 
-    buma3d::BUFFER_TEXTURE_COPY_REGION copy_region{};
-    copy_region.buffer_layout.offset            = al.data_offset;
-    copy_region.buffer_layout.row_pitch         = _src_row_pitch;
-    copy_region.buffer_layout.texture_height    = (uint32_t)_src_texture_height;
+    // スライスが隙間なく格納されている場合、ボリュームは1つの領域でコピーできます。 それ以外の場合、スライスごとに領域を作成します。
+    bool     is_packed_volume = is_volume && _src_slice_pitch == _src_row_pitch * _src_texture_height;
+    uint32_t num_regions      = is_packed_volume ? 1 : _array_count;
 
-    copy_region.texture_subresource.offset.aspect      = buma3d::TEXTURE_ASPECT_FLAG_COLOR;
-    copy_region.texture_subresource.offset.mip_slice   = _mip_slice;
-    copy_region.texture_subresource.offset.array_slice = _array_slice;
-    copy_region.texture_subresource.array_count        = 1;
+    // 各領域のオフセットがbuffer_copy_offset_alignmentに揃うよう、_src_slice_pitch はこのアライメントの倍数である必要があります。
+    auto alignment = dr.GetDeviceAdapterLimits().buffer_copy_offset_alignment;
+    BUMA_ASSERT(num_regions == 1 || _src_slice_pitch % alignment == 0);
 
-    copy_region.texture_offset = nullptr;
-    copy_region.texture_extent = nullptr;
+    auto al = upload_buffer->AllocateBufferPart(_src_size, alignment);
+    memcpy(al.map_data_part, _src_data, _src_size);
+
+    if (is_volume)
+    {
+        auto extent = util::CalcMipExtents(_mip_slice, tex_desc.extent);
+        BUMA_ASSERT(_array_count <= extent.z);
+        copy_offsets.resize(num_regions);
+        copy_extents.assign(num_regions, buma3d::EXTENT3D{ extent.x, extent.y, is_packed_volume ? _array_count : 1 });
+        for (uint32_t i = 0; i < num_regions; i++)
+            copy_offsets[i] = { 0, 0, (int32_t)i };
+    }
+
+    copy_regions.resize(num_regions);
+    for (uint32_t i = 0; i < num_regions; i++)
+    {
+        auto&& copy_region = copy_regions[i];
+        copy_region.buffer_layout.offset            = al.data_offset + _src_slice_pitch * i;
+        copy_region.buffer_layout.row_pitch         = _src_row_pitch;
+        copy_region.buffer_layout.texture_height    = (uint32_t)_src_texture_height;
+
+        copy_region.texture_subresource.offset.aspect      = buma3d::TEXTURE_ASPECT_FLAG_COLOR;
+        copy_region.texture_subresource.offset.mip_slice   = _mip_slice;
+        copy_region.texture_subresource.offset.array_slice = is_volume ? _array_slice : _array_slice + i;
+        copy_region.texture_subresource.array_count        = 1;
+
+        copy_region.texture_offset = is_volume ? &copy_offsets[i] : nullptr;
+        copy_region.texture_extent = is_volume ? &copy_extents[i] : nullptr;
+    }
 
     buma3d::CMD_COPY_BUFFER_TO_TEXTURE copy{};
     copy.src_buffer  = al.parent_resouce;
     copy.dst_texture = _dst_texture;
-    copy.num_regions = 1;
-    copy.regions     = &copy_region;
+    copy.num_regions = num_regions;
+    copy.regions     = copy_regions.data();
 
     list->CopyBufferToTexture(copy);
     has_command = true;
@@ -4,6 +4,7 @@
 #include <DeviceResources/SwapChain.h>
 #include <DeviceResources/CopyContext.h>
 #include <DeviceResources/CommandQueue.h>
+#include <DeviceResources/PipelineStateCache.h>
 
 #include "./ResourceHeapAllocator.h"
 #include "./ResourceHeapProperties.h"
@@ -130,6 +131,7 @@ DeviceResources::DeviceResources(const DEVICE_RESOURCE_DESC& _desc, const char*
     , resource_heap_props      {}
 //  , gpu_timer_pools          {}
     , copy_context             {}
+    , pipeline_state_cache     {}
     , frame_value              {}
 {
     Init(_desc, _library_dir);
@@ -140,6 +142,7 @@ DeviceResources::~DeviceResources()
     BUMA_LOGI("Deinitialize DeviceResources");
     WaitForGpu();
     copy_context.reset();
+    pipeline_state_cache.reset();
     resource_heaps_allocator.reset();
     resource_heap_props.reset();
     UninitB3D();
@@ -164,6 +167,8 @@ bool DeviceResources::Init(const DEVICE_RESOURCE_DESC& _desc, const char* _libra
     auto copy_context_type = buma3d::COMMAND_TYPE_DIRECT;
     copy_context = std::make_unique<CopyContext>(*this, copy_context_type);
 
+    pipeline_state_cache = std::make_unique<PipelineStateCache>(*this);
+
     return true;
 }
 
@@ -0,0 +1,215 @@
+#include <DeviceResources/ParallelCommandRecorder.h>
+#include <DeviceResources/DeviceResources.h>
+#include <DeviceResources/CommandQueue.h>
+
+#include <Buma3DHelpers/Buma3DHelpers.h>
+#include <Buma3DHelpers/B3DInit.h>
+
+#include <algorithm>
+#include <string>
+
+namespace buma
+{
+
+ParallelCommandRecorder::ParallelCommandRecorder(DeviceResources& _dr, CommandQueue& _queue, const PARALLEL_COMMAND_RECORDER_DESC& _desc)
+    : dr                    { _dr }
+    , queue                 { _queue }
+    , desc                  { _desc }
+    , name                  { _desc.name ? _desc.name : "ParallelCommandRecorder" }
+    , num_threads           {}
+    , frames                {}
+    , frame_index           {}
+    , current_begin_desc    {}
+    , current_func          {}
+    , current_num_jobs      {}
+    , next_job              {}
+    , recorded_lists        {}
+    , workers               {}
+    , mutex                 {}
+    , start_cv              {}
+    , done_cv               {}
+    , generation            {}
+    , num_running_workers   {}
+    , is_exiting            {}
+{
+    desc.name   = nullptr;
+    num_threads = desc.num_threads != 0 ? desc.num_threads : static_cast<size_t>(std::thread::hardware_concurrency());
+    num_threads = (std::max)(num_threads, size_t(1));
+    BUMA_ASSERT(desc.num_frames != 0);
+
+    CreateFrames();
+
+    // 呼び出し元のスレッドがインデックス0を使用します。
+    workers.reserve(num_threads - 1);
+    for (size_t i = 1; i < num_threads; i++)
+        workers.emplace_back([this, i]() { WorkerMain(i); });
+}
+
+ParallelCommandRecorder::~ParallelCommandRecorder()
+{
+    {
+        std::lock_guard lock(mutex);
+        is_exiting = true;
+    }
+    start_cv.notify_all();
+    for (auto& i : workers)
+        i.join();
+
+    // 実行中のコマンドリストを解放しないよう、送信済みの全てのフレームの完了を待機します。
+    for (auto& i : frames)
+    {
+        if (i.fence_value != 0)
+            queue.WaitValueComplete(i.fence_value);
+    }
+}
+
+void ParallelCommandRecorder::CreateFrames()
+{
+    auto&& d = dr.GetDevice();
+    frames.resize(desc.num_frames);
+    for (uint32_t i_frame = 0; i_frame < desc.num_frames; i_frame++)
+    {
+        auto&& f = frames[i_frame];
+        f.fence_value = 0;
+        f.contexts.resize(num_threads);
+        for (size_t i_thread = 0; i_thread < num_threads; i_thread++)
+        {
+            auto&& c = f.contexts[i_thread];
+            auto bmr = d->CreateCommandAllocator(buma3d::init::CommandAllocatorDesc(queue.GetCommandType(), desc.level, buma3d::COMMAND_ALLOCATOR_FLAG_TRANSIENT), &c.allocator);
+            BMR_ASSERT(bmr);
+            c.allocator->SetName((name + "::allocator " + std::to_string(i_frame) + "-" + std::to_string(i_thread)).c_str());
+            c.num_used_lists = 0;
+        }
+    }
+    frame_index = desc.num_frames - 1;
+}
+
+void ParallelCommandRecorder::BeginFrame()
+{
+    frame_index = (frame_index + 1) % desc.num_frames;
+    auto&& f = frames[frame_index];
+
+    // このフレームのアロケータで記録したコマンドの実行完了を待機します。 num_frames が同時に実行中のフレーム数以上であれば、通常は待機しません。
+    if (f.fence_value != 0)
+        queue.WaitValueComplete(f.fence_value);
+    f.fence_value = 0;
+
+    for (auto& i : f.contexts)
+    {
+        auto bmr = i.allocator->Reset(buma3d::COMMAND_ALLOCATOR_RESET_FLAG_NONE);
+        BMR_ASSERT(bmr);
+        i.num_used_lists = 0;
+    }
+    recorded_lists.clear();
+}
+
+void ParallelCommandRecorder::EndFrame()
+{
+    // QueueSubmit 後の値は、このフレームの全ての送信を含みます。
+    frames[frame_index].fence_value = queue.GetFenceValue();
+}
+
+buma3d::ICommandList* ParallelCommandRecorder::AcquireList(size_t _thread_index)
+{
+    auto&& c = frames[frame_index].contexts[_thread_index];
+    if (c.num_used_lists == c.lists.size())
+    {
+        // コマンドリストは、このスレッドのみが使用するアロケータから割り当てます。
+        auto&& l = c.lists.emplace_back();
+        auto bmr = dr.GetDevice()->AllocateCommandList(buma3d::init::CommandListDesc(c.allocator.Get(), buma3d::B3D_DEFAULT_NODE_MASK), &l);
+        BMR_ASSERT(bmr);
+        l->SetName((name + "::list " + std::to_string(frame_index) + "-" + std::to_string(_thread_index) + "-" + std::to_string(c.num_used_lists)).c_str());
+    }
+    return c.lists[c.num_used_lists++].Get();
+}
+
+void ParallelCommandRecorder::RecordJobs(size_t _thread_index)
+{
+    for (uint32_t i = next_job++; i < current_num_jobs; i = next_job++)
+    {
+        auto l = AcquireList(_thread_index);
+        auto bmr = l->BeginRecord(*current_begin_desc);
+        BMR_ASSERT(bmr);
+
+        (*current_func)(i, l);
+
+        bmr = l->EndRecord();
+        BMR_ASSERT(bmr);
+        recorded_lists[i] = l;
+    }
+}
+
+const std::vector<buma3d::ICommandList*>& ParallelCommandRecorder::Record(const buma3d::COMMAND_LIST_BEGIN_DESC& _begin_desc, uint32_t _num_jobs, const RECORD_FUNC& _func)
+{
+    recorded_lists.assign(_num_jobs, nullptr);
+    if (_num_jobs == 0)
+        return recorded_lists;
+
+    current_begin_desc = &_begin_desc;
+    current_func       = &_func;
+    current_num_jobs   = _num_jobs;
+    next_job           = 0;
+
+    // ジョブが1つの場合は呼び出し元のスレッドのみで記録します。
+    auto use_workers = _num_jobs > 1 && !workers.empty();
+    if (use_workers)
+    {
+        {
+            std::lock_guard lock(mutex);
+            num_running_workers = workers.size();
+            generation++;
+        }
+        start_cv.notify_all();
+    }
+
+    RecordJobs(0);
+
+    if (use_workers)
+    {
+        std::unique_lock lock(mutex);
+        done_cv.wait(lock, [this]() { return num_running_workers == 0; });
+    }
+
+    current_begin_desc = nullptr;
+    current_func       = nullptr;
+    return recorded_lists;
+}
+
+void ParallelCommandRecorder::RecordAndAddCommandLists(uint64_t _order, uint32_t _num_jobs, const RECORD_FUNC& _func)
+{
+    BUMA_ASSERT(desc.level == buma3d::COMMAND_LIST_LEVEL_PRIMARY);
+
+    buma3d::COMMAND_LIST_BEGIN_DESC begin{};
+    begin.flags             = buma3d::COMMAND_LIST_BEGIN_FLAG_ONE_TIME_SUBMIT;
+    begin.inheritance_desc  = nullptr;
+
+    // 記録はスレッド間で並列ですが、キューへの追加はこのスレッドからインデックス順に行うため、送信順序は決定的です。
+    for (auto i : Record(begin, _num_jobs, _func))
+        queue.AddCommandList(_order, i);
+}
+
+void ParallelCommandRecorder::WorkerMain(size_t _thread_index)
+{
+    uint64_t last_generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock lock(mutex);
+            start_cv.wait(lock, [&]() { return is_exiting || generation != last_generation; });
+            if (is_exiting)
+                return;
+            last_generation = generation;
+        }
+
+        RecordJobs(_thread_index);
+
+        {
+            std::lock_guard lock(mutex);
+            if (--num_running_workers == 0)
+                done_cv.notify_one();
+        }
+    }
+}
+
+
+}// namespace buma
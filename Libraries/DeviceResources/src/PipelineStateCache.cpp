@@ -0,0 +1,367 @@
+#include <DeviceResources/PipelineStateCache.h>
+#include <DeviceResources/DeviceResources.h>
+
+#include <Buma3DHelpers/Buma3DHelpers.h>
+#include <Buma3DHelpers/B3DDescHash.h>
+#include <Buma3DHelpers/B3DDescHelpers.h>
+
+#include <Utils/Utils.h>
+#include <Utils/Logger.h>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+namespace buma
+{
+
+// 要求された記述の、ポインタが指す値を全て複製したキーです。 オブジェクトの参照を保持し、アドレスの再利用による誤った一致を防ぎます。
+struct PipelineStateCache::GRAPHICS_KEY
+{
+    explicit GRAPHICS_KEY(const buma3d::GRAPHICS_PIPELINE_STATE_DESC& _desc)
+        : desc{ _desc }
+    {
+        pipeline_layout = _desc.pipeline_layout;
+        render_pass     = _desc.render_pass;
+
+        // 文字列のポインタが無効にならないよう、必要な数を事前に確保します。
+        size_t num_strings = _desc.num_shader_stages;
+        if (_desc.input_layout)
+        {
+            for (uint32_t i = 0; i < _desc.input_layout->num_input_slots; i++)
+                num_strings += _desc.input_layout->input_slots[i].num_elements;
+        }
+        strings.reserve(num_strings);
+        auto CopyStr = [this](const char* _str) { return strings.emplace_back(_str ? _str : "").c_str(); };
+
+        shader_stages.assign(_desc.shader_stages, _desc.shader_stages + _desc.num_shader_stages);
+        for (auto& i : shader_stages)
+        {
+            modules.emplace_back() = i.module;
+            i.entry_point_name = CopyStr(i.entry_point_name);
+        }
+        desc.shader_stages = shader_stages.data();
+
+        if (_desc.input_layout)
+        {
+            input_layout = *_desc.input_layout;
+            input_slots.assign(input_layout.input_slots, input_layout.input_slots + input_layout.num_input_slots);
+            size_t num_elements = 0;
+            for (auto& i : input_slots)
+                num_elements += i.num_elements;
+            input_elements.reserve(num_elements);
+            for (auto& i : input_slots)
+            {
+                auto first = input_elements.size();
+                input_elements.insert(input_elements.end(), i.elements, i.elements + i.num_elements);
+                i.elements = input_elements.data() + first;
+            }
+            for (auto& i : input_elements)
+                i.semantic_name = CopyStr(i.semantic_name);
+            input_layout.input_slots = input_slots.data();
+            desc.input_layout = &input_layout;
+        }
+
+        if (_desc.input_assembly_state) { input_assembly_state = *_desc.input_assembly_state; desc.input_assembly_state = &input_assembly_state; }
+        if (_desc.tessellation_state)   { tessellation_state   = *_desc.tessellation_state;   desc.tessellation_state   = &tessellation_state;   }
+        if (_desc.rasterization_state)  { rasterization_state  = *_desc.rasterization_state;  desc.rasterization_state  = &rasterization_state;  }
+        if (_desc.depth_stencil_state)  { depth_stencil_state  = *_desc.depth_stencil_state;  desc.depth_stencil_state  = &depth_stencil_state;  }
+
+        if (_desc.viewport_state)
+        {
+            viewport_state = *_desc.viewport_state;
+            if (viewport_state.viewports)
+            {
+                viewports.assign(viewport_state.viewports, viewport_state.viewports + viewport_state.num_viewports);
+                viewport_state.viewports = viewports.data();
+            }
+            if (viewport_state.scissor_rects)
+            {
+                scissor_rects.assign(viewport_state.scissor_rects, viewport_state.scissor_rects + viewport_state.num_scissor_rects);
+                viewport_state.scissor_rects = scissor_rects.data();
+            }
+            desc.viewport_state = &viewport_state;
+        }
+
+        if (_desc.multisample_state)
+        {
+            multisample_state = *_desc.multisample_state;
+            if (multisample_state.sample_masks)
+            {
+                sample_masks.assign(multisample_state.sample_masks, multisample_state.sample_masks + (multisample_state.rasterization_samples + 31) / 32);
+                multisample_state.sample_masks = sample_masks.data();
+            }
+            desc.multisample_state = &multisample_state;
+        }
+
+        if (_desc.blend_state)
+        {
+            blend_state = *_desc.blend_state;
+            attachments.assign(blend_state.attachments, blend_state.attachments + blend_state.num_attachments);
+            blend_state.attachments = attachments.data();
+            desc.blend_state = &blend_state;
+        }
+
+        if (_desc.dynamic_state)
+        {
+            dynamic_state = *_desc.dynamic_state;
+            dynamic_states.assign(dynamic_state.dynamic_states, dynamic_state.dynamic_states + dynamic_state.num_dynamic_states);
+            dynamic_state.dynamic_states = dynamic_states.data();
+            desc.dynamic_state = &dynamic_state;
+        }
+    }
+
+    buma3d::GRAPHICS_PIPELINE_STATE_DESC                    desc;
+    std::vector<buma3d::PIPELINE_SHADER_STAGE_DESC>         shader_stages;
+    std::vector<std::string>                                strings;
+    buma3d::INPUT_LAYOUT_DESC                               input_layout;
+    std::vector<buma3d::INPUT_SLOT_DESC>                    input_slots;
+    std::vector<buma3d::INPUT_ELEMENT_DESC>                 input_elements;
+    buma3d::INPUT_ASSEMBLY_STATE_DESC                       input_assembly_state;
+    buma3d::TESSELLATION_STATE_DESC                         tessellation_state;
+    buma3d::VIEWPORT_STATE_DESC                             viewport_state;
+    std::vector<buma3d::VIEWPORT>                           viewports;
+    std::vector<buma3d::SCISSOR_RECT>                       scissor_rects;
+    buma3d::RASTERIZATION_STATE_DESC                        rasterization_state;
+    buma3d::MULTISAMPLE_STATE_DESC                          multisample_state;
+    std::vector<buma3d::SampleMask>                         sample_masks;
+    buma3d::DEPTH_STENCIL_STATE_DESC                        depth_stencil_state;
+    buma3d::BLEND_STATE_DESC                                blend_state;
+    std::vector<buma3d::RENDER_TARGET_BLEND_DESC>           attachments;
+    buma3d::DYNAMIC_STATE_DESC                              dynamic_state;
+    std::vector<buma3d::DYNAMIC_STATE>                      dynamic_states;
+
+    buma3d::util::Ptr<buma3d::IPipelineLayout>              pipeline_layout;
+    buma3d::util::Ptr<buma3d::IRenderPass>                  render_pass;
+    std::vector<buma3d::util::Ptr<buma3d::IShaderModule>>   modules;
+};
+
+struct PipelineStateCache::COMPUTE_KEY
+{
+    explicit COMPUTE_KEY(const buma3d::COMPUTE_PIPELINE_STATE_DESC& _desc)
+        : desc              { _desc }
+        , entry_point_name  { _desc.shader_stage.entry_point_name ? _desc.shader_stage.entry_point_name : "" }
+    {
+        desc.shader_stage.entry_point_name = entry_point_name.c_str();
+        pipeline_layout = _desc.pipeline_layout;
+        module          = _desc.shader_stage.module;
+    }
+
+    buma3d::COMPUTE_PIPELINE_STATE_DESC         desc;
+    std::string                                 entry_point_name;
+    buma3d::util::Ptr<buma3d::IPipelineLayout>  pipeline_layout;
+    buma3d::util::Ptr<buma3d::IShaderModule>    module;
+};
+
+PipelineStateCache::PipelineStateCache(DeviceResources& _dr)
+    : dr                    { _dr }
+    , mutex                 {}
+    , created_cv            {}
+    , registered_modules    {}
+    , canonical_modules     {}
+    , graphics_entries      {}
+    , compute_entries       {}
+    , statistics            {}
+{
+}
+
+PipelineStateCache::~PipelineStateCache()
+{
+    Clear();
+}
+
+void PipelineStateCache::RegisterShaderModule(buma3d::IShaderModule* _module, const void* _bytecode, size_t _bytecode_length)
+{
+    size_t hash = 0;
+    util::hash_combine_bytes(hash, _bytecode, _bytecode_length);
+    util::hash_combine(hash, _bytecode_length);
+
+    std::lock_guard lock(mutex);
+    if (registered_modules.find(_module) != registered_modules.end())
+        return;
+
+    // ハッシュが一致した場合も、バイトコードが一致するモジュールのみを同一とみなします。
+    auto bytecode = static_cast<const uint8_t*>(_bytecode);
+    auto&& bucket = canonical_modules[hash];
+    auto it = std::find_if(bucket.begin(), bucket.end(), [&](const CANONICAL_MODULE& _c) {
+        return _c.bytecode.size() == _bytecode_length && std::equal(_c.bytecode.begin(), _c.bytecode.end(), bytecode);
+    });
+    if (it == bucket.end())
+        it = bucket.insert(bucket.end(), CANONICAL_MODULE{ _module, std::vector<uint8_t>(bytecode, bytecode + _bytecode_length), 0 });
+    it->num_registrations++;
+
+    auto&& r = registered_modules[_module];
+    r.module           = _module;
+    r.canonical_module = it->module.Get();
+    r.bytecode_hash    = hash;
+}
+
+void PipelineStateCache::UnregisterShaderModule(buma3d::IShaderModule* _module)
+{
+    std::lock_guard lock(mutex);
+    auto it = registered_modules.find(_module);
+    if (it == registered_modules.end())
+        return;
+
+    auto&& bucket = canonical_modules[it->second.bytecode_hash];
+    auto c = std::find_if(bucket.begin(), bucket.end(), [&](const CANONICAL_MODULE& _c) { return _c.module.Get() == it->second.canonical_module; });
+    BUMA_ASSERT(c != bucket.end());
+    if (--c->num_registrations == 0)
+    {
+        bucket.erase(c);
+        if (bucket.empty())
+            canonical_modules.erase(it->second.bytecode_hash);
+    }
+    registered_modules.erase(it);
+}
+
+buma3d::IShaderModule* PipelineStateCache::GetCanonicalModule(buma3d::IShaderModule* _module) const
+{
+    auto it = registered_modules.find(_module);
+    return it == registered_modules.end() ? _module : it->second.canonical_module;
+}
+
+template<typename KEY, typename DESC, typename CREATE_FUNC>
+buma3d::util::Ptr<buma3d::IPipelineState> PipelineStateCache::GetOrCreate(ENTRY_MAP<KEY>& _entries, const DESC& _desc, CREATE_FUNC&& _create)
+{
+    std::unique_lock lock(mutex);
+
+    auto hash = std::hash<DESC>{}(_desc);
+    auto&& bucket = _entries[hash];
+    auto it = std::find_if(bucket.begin(), bucket.end(), [&](const std::shared_ptr<ENTRY<KEY>>& _e) { return _e->key->desc == _desc; });
+    if (it != bucket.end())
+    {
+        // 他のスレッドで作成中の場合、完了を待機します。
+        auto entry = *it;
+        statistics.num_hits++;
+        created_cv.wait(lock, [&]() { return !entry->is_creating; });
+        return entry->pipeline;
+    }
+
+    auto entry = std::make_shared<ENTRY<KEY>>();
+    entry->key          = std::make_unique<KEY>(_desc);
+    entry->is_creating  = true;
+    bucket.push_back(entry);
+    statistics.num_misses++;
+    statistics.num_entries++;
+
+    // 作成中はロックを解放し、異なるパイプラインの作成と検索を並行して行えるようにします。
+    lock.unlock();
+    auto pipeline = _create(entry->key->desc);
+    lock.lock();
+
+    entry->pipeline    = pipeline;
+    entry->is_creating = false;
+    if (!pipeline)
+    {
+        auto&& b = _entries[hash];
+        b.erase(std::find(b.begin(), b.end(), entry));
+        statistics.num_entries--;
+    }
+    created_cv.notify_all();
+
+    return pipeline;
+}
+
+buma3d::util::Ptr<buma3d::IPipelineState> PipelineStateCache::GetOrCreateGraphics(const buma3d::GRAPHICS_PIPELINE_STATE_DESC& _desc, const char* _name)
+{
+    // 登録されたモジュールを置き換えた記述で検索します。 複製は作成する場合のみ行います。
+    std::vector<buma3d::PIPELINE_SHADER_STAGE_DESC> stages(_desc.shader_stages, _desc.shader_stages + _desc.num_shader_stages);
+    {
+        std::lock_guard lock(mutex);
+        for (auto& i : stages)
+            i.module = GetCanonicalModule(i.module);
+    }
+    auto desc = _desc;
+    desc.shader_stages = stages.data();
+
+    return GetOrCreate(graphics_entries, desc, [this, _name](const buma3d::GRAPHICS_PIPELINE_STATE_DESC& _d) {
+        buma3d::util::Ptr<buma3d::IPipelineState> result;
+        auto bmr = dr.GetDevice()->CreateGraphicsPipelineState(_d, &result);
+        if (util::IsFailed(bmr))
+        {
+            BUMA_LOGE("Failed to create graphics pipeline state {}", _name ? _name : "");
+            return buma3d::util::Ptr<buma3d::IPipelineState>();
+        }
+        // 他のスレッドに公開される前に設定します。
+        if (_name)
+            result->SetName(_name);
+        return result;
+    });
+}
+
+buma3d::util::Ptr<buma3d::IPipelineState> PipelineStateCache::GetOrCreateCompute(const buma3d::COMPUTE_PIPELINE_STATE_DESC& _desc, const char* _name)
+{
+    auto desc = _desc;
+    {
+        std::lock_guard lock(mutex);
+        desc.shader_stage.module = GetCanonicalModule(desc.shader_stage.module);
+    }
+
+    return GetOrCreate(compute_entries, desc, [this, _name](const buma3d::COMPUTE_PIPELINE_STATE_DESC& _d) {
+        buma3d::util::Ptr<buma3d::IPipelineState> result;
+        auto bmr = dr.GetDevice()->CreateComputePipelineState(_d, &result);
+        if (util::IsFailed(bmr))
+        {
+            BUMA_LOGE("Failed to create compute pipeline state {}", _name ? _name : "");
+            return buma3d::util::Ptr<buma3d::IPipelineState>();
+        }
+        if (_name)
+            result->SetName(_name);
+        return result;
+    });
+}
+
+buma3d::util::Ptr<buma3d::IPipelineState> PipelineStateCache::GetOrCreate(const util::PipelineStateDesc& _desc, const char* _name)
+{
+    auto&& gpso = _desc.GetAsGraphics();
+    auto is_compute = std::any_of(gpso.shader_stages, gpso.shader_stages + gpso.num_shader_stages
+                                  , [](const buma3d::PIPELINE_SHADER_STAGE_DESC& _s) { return _s.stage == buma3d::SHADER_STAGE_FLAG_COMPUTE; });
+    return is_compute ? GetOrCreateCompute(_desc.GetAsCompute(), _name) : GetOrCreateGraphics(gpso, _name);
+}
+
+template<typename KEY>
+size_t PipelineStateCache::ReleaseUnusedPipelines(ENTRY_MAP<KEY>& _entries)
+{
+    size_t num_released = 0;
+    for (auto it = _entries.begin(); it != _entries.end();)
+    {
+        // 作成中のエントリは、作成したスレッドと待機中のスレッドが参照しています。
+        auto&& bucket = it->second;
+        auto end = std::remove_if(bucket.begin(), bucket.end(), [](const std::shared_ptr<ENTRY<KEY>>& _e) {
+            return !_e->is_creating && _e->pipeline->GetRefCount() == 1;
+        });
+        num_released += static_cast<size_t>(std::distance(end, bucket.end()));
+        bucket.erase(end, bucket.end());
+        it = bucket.empty() ? _entries.erase(it) : std::next(it);
+    }
+    return num_released;
+}
+
+size_t PipelineStateCache::ReleaseUnusedPipelines()
+{
+    std::lock_guard lock(mutex);
+    auto num_released = ReleaseUnusedPipelines(graphics_entries) + ReleaseUnusedPipelines(compute_entries);
+    statistics.num_entries -= num_released;
+    return num_released;
+}
+
+void PipelineStateCache::Clear()
+{
+    std::lock_guard lock(mutex);
+    graphics_entries.clear();
+    compute_entries.clear();
+    registered_modules.clear();
+    canonical_modules.clear();
+    statistics.num_entries = 0;
+}
+
+PIPELINE_STATE_CACHE_STATISTICS PipelineStateCache::GetStatistics() const
+{
+    std::lock_guard lock(mutex);
+    return statistics;
+}
+
+
+}// namespace buma
@@ -0,0 +1,191 @@
+#include <DeviceResources/QueueScheduler.h>
+#include <DeviceResources/DeviceResources.h>
+#include <DeviceResources/CommandQueue.h>
+
+#include <Buma3DHelpers/Buma3DHelpers.h>
+#include <Buma3DHelpers/B3DInit.h>
+
+#include <Utils/Utils.h>
+#include <Utils/Logger.h>
+
+#include <algorithm>
+
+namespace buma
+{
+
+QueueScheduler::QueueScheduler(DeviceResources& _dr, const QUEUE_SCHEDULER_DESC& _desc)
+    : dr                        { _dr }
+    , name                      { _desc.name ? _desc.name : "QueueScheduler" }
+    , queues                    {}
+    , fences                    {}
+    , fence_values              {}
+    , submitted_fence_values    {}
+    , works                     {}
+    , lists                     {}
+    , dependencies              {}
+    , external_fences           {}
+    , queue_works               {}
+    , statistics                {}
+{
+    // 存在しないキューの作業は、より多くの機能を持つキューで実行します。
+    static constexpr buma3d::COMMAND_TYPE TYPES[] = { buma3d::COMMAND_TYPE_DIRECT, buma3d::COMMAND_TYPE_COMPUTE_ONLY, buma3d::COMMAND_TYPE_COPY_ONLY };
+    CommandQueue* fallback = nullptr;
+    for (auto type : TYPES)
+    {
+        auto&& q = dr.GetCommandQueues(type);
+        queues[type] = q.empty() ? fallback : q[0];
+        fallback = queues[type];
+        BUMA_ASSERT(queues[type]);
+
+        if (!q.empty())
+        {
+            auto bmr = dr.GetDevice()->CreateFence(buma3d::init::TimelineFenceDesc(), &fences[type]);
+            BMR_ASSERT(bmr);
+            fences[type]->SetName((name + "::fences[" + std::to_string(type) + "]").c_str());
+        }
+    }
+}
+
+QueueScheduler::~QueueScheduler()
+{
+    // フェンスを解放する前に、フェンスを使用する送信の完了を待機します。
+    dr.WaitForGpu();
+}
+
+QUEUE_WORK QueueScheduler::AddWork(buma3d::COMMAND_TYPE _type, uint32_t _num_lists, buma3d::ICommandList* const* _lists, uint32_t _num_dependencies, const QUEUE_WORK* _dependencies)
+{
+    auto result = (QUEUE_WORK)works.size();
+    auto queue_type = queues[_type]->GetCommandType();
+
+    auto&& w = works.emplace_back();
+    w.queue_type        = queue_type;
+    w.first_list        = (uint32_t)lists.size();
+    w.num_lists         = _num_lists;
+    w.first_dependency  = (uint32_t)dependencies.size();
+    w.num_dependencies  = _num_dependencies;
+    w.fence_value       = ++fence_values[queue_type];
+    w.known_values      = {};
+    w.is_signaled       = false;
+
+    lists.insert(lists.end(), _lists, _lists + _num_lists);
+    for (uint32_t i = 0; i < _num_dependencies; i++)
+    {
+        BUMA_ASSERT(_dependencies[i] < result && "dependencies must be added before the work");
+        dependencies.push_back(_dependencies[i]);
+    }
+    return result;
+}
+
+void QueueScheduler::AddWaitFence(QUEUE_WORK _work, buma3d::IFence* _fence, uint64_t _fence_value)
+{
+    BUMA_ASSERT(_work < works.size());
+    external_fences.push_back({ _work, _fence, _fence_value, false });
+}
+
+void QueueScheduler::AddSignalFence(QUEUE_WORK _work, buma3d::IFence* _fence, uint64_t _fence_value)
+{
+    BUMA_ASSERT(_work < works.size());
+    external_fences.push_back({ _work, _fence, _fence_value, true });
+}
+
+void QueueScheduler::Schedule(uint64_t _base_order)
+{
+    statistics = {};
+    statistics.num_works = (uint32_t)works.size();
+
+    // 各キューの直前の作業の開始時点で完了が分かっている値です。 同じキューの作業は送信順に実行されるため、後続の作業に引き継がれます。
+    KNOWN_VALUES queue_known_values[buma3d::COMMAND_TYPE_NUM_TYPES]{};
+    KNOWN_VALUES wait_values{};
+
+    // 各キューの作業のフェンス値は連続するため、値から作業を求められます。
+    for (auto& i : queue_works)
+        i.clear();
+    for (QUEUE_WORK i = 0; i < (QUEUE_WORK)works.size(); i++)
+        queue_works[works[i].queue_type].push_back(i);
+
+    for (QUEUE_WORK i_work = 0; i_work < (QUEUE_WORK)works.size(); i_work++)
+    {
+        auto&& w = works[i_work];
+        auto&& known = queue_known_values[w.queue_type];
+        auto&& q = *queues[w.queue_type];
+        auto order = _base_order + i_work;
+
+        // 依存する作業のキューごとに、待機する必要がある最大の値を求めます。
+        wait_values.fill(0);
+        for (uint32_t i = 0; i < w.num_dependencies; i++)
+        {
+            auto&& d = works[dependencies[w.first_dependency + i]];
+            if (d.queue_type == w.queue_type || known[d.queue_type] >= d.fence_value)
+            {
+                statistics.num_elided_waits++;
+                continue;
+            }
+            if (wait_values[d.queue_type] != 0)
+                statistics.num_elided_waits++;
+            wait_values[d.queue_type] = (std::max)(wait_values[d.queue_type], d.fence_value);
+        }
+
+        for (uint32_t i_type = 0; i_type < buma3d::COMMAND_TYPE_NUM_TYPES; i_type++)
+        {
+            auto value = wait_values[i_type];
+            if (value == 0)
+                continue;
+
+            // 待機する値をシグナルする作業にシグナルを追加します。 順序ごとに SUBMIT_INFO が作成されるため、既に追加した順序にも追加できます。
+            auto&& qw = queue_works[i_type];
+            auto signal_work = qw[value - works[qw[0]].fence_value];
+            auto&& s = works[signal_work];
+            if (!s.is_signaled)
+            {
+                s.is_signaled = true;
+                queues[i_type]->AddSignalFence(_base_order + signal_work, fences[i_type].Get(), value);
+                statistics.num_signals++;
+            }
+            q.AddWaitFence(order, fences[i_type].Get(), value);
+            statistics.num_waits++;
+
+            // 待機した作業が知っている値も、推移的に完了が分かります。
+            for (uint32_t i = 0; i < buma3d::COMMAND_TYPE_NUM_TYPES; i++)
+                known[i] = (std::max)(known[i], s.known_values[i]);
+            known[i_type] = (std::max)(known[i_type], value);
+        }
+
+        w.known_values = known;
+        known[w.queue_type] = w.fence_value;
+
+        for (uint32_t i = 0; i < w.num_lists; i++)
+            q.AddCommandList(order, lists[w.first_list + i]);
+    }
+
+    for (auto& i : external_fences)
+    {
+        auto&& q = *queues[works[i.work].queue_type];
+        if (i.is_signal)
+            q.AddSignalFence(_base_order + i.work, i.fence, i.fence_value);
+        else
+            q.AddWaitFence(_base_order + i.work, i.fence, i.fence_value);
+    }
+
+    works.clear();
+    lists.clear();
+    dependencies.clear();
+    external_fences.clear();
+}
+
+void QueueScheduler::Submit(uint64_t _base_order)
+{
+    bool is_used[buma3d::COMMAND_TYPE_NUM_TYPES]{};
+    for (auto& i : works)
+        is_used[i.queue_type] = true;
+
+    Schedule(_base_order);
+
+    for (uint32_t i = 0; i < buma3d::COMMAND_TYPE_NUM_TYPES; i++)
+    {
+        if (is_used[i])
+            submitted_fence_values[i] = dr.QueueSubmit(*queues[i]);
+    }
+}
+
+
+}// namespace buma
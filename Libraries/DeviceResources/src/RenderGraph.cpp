@@ -0,0 +1,427 @@
+#include <DeviceResources/RenderGraph.h>
+#include <DeviceResources/DeviceResources.h>
+#include <DeviceResources/CommandQueue.h>
+#include <DeviceResources/ParallelCommandRecorder.h>
+#include <DeviceResources/ResourceBuffer.h>
+#include <DeviceResources/ResourceTexture.h>
+
+#include "./ResourceHeapProperties.h"
+
+#include <Buma3DHelpers/Buma3DHelpers.h>
+#include <Buma3DHelpers/B3DInit.h>
+#include <Buma3DHelpers/FormatUtils.h>
+
+#include <Utils/Utils.h>
+#include <Utils/Logger.h>
+
+namespace buma
+{
+
+namespace /*anonymous*/
+{
+
+buma3d::TEXTURE_ASPECT_FLAGS GetAspectFlags(buma3d::RESOURCE_FORMAT _format)
+{
+    if (util::IsDepthOnlyFormat(_format))
+        return buma3d::TEXTURE_ASPECT_FLAG_DEPTH;
+    if (util::IsDepthStencilFormat(_format))
+        return buma3d::TEXTURE_ASPECT_FLAG_DEPTH | buma3d::TEXTURE_ASPECT_FLAG_STENCIL;
+    return buma3d::TEXTURE_ASPECT_FLAG_COLOR;
+}
+
+
+}// namespace /*anonymous*/
+
+#pragma region RenderGraphPassContext
+
+buma3d::IBuffer* RenderGraphPassContext::GetBuffer(RENDER_GRAPH_RESOURCE _resource) const
+{
+    return static_cast<buma3d::IBuffer*>(graph.GetResource(_resource));
+}
+
+buma3d::ITexture* RenderGraphPassContext::GetTexture(RENDER_GRAPH_RESOURCE _resource) const
+{
+    return static_cast<buma3d::ITexture*>(graph.GetResource(_resource));
+}
+
+#pragma endregion RenderGraphPassContext
+
+#pragma region RenderGraphPassBuilder
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::Read(RENDER_GRAPH_RESOURCE _resource, buma3d::RESOURCE_STATE _state, buma3d::PIPELINE_STAGE_FLAGS _stages)
+{
+    graph.pass_nodes[pass].accesses.push_back({ _resource, _state, _stages, false });
+    return *this;
+}
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::Write(RENDER_GRAPH_RESOURCE _resource, buma3d::RESOURCE_STATE _state, buma3d::PIPELINE_STAGE_FLAGS _stages)
+{
+    graph.pass_nodes[pass].accesses.push_back({ _resource, _state, _stages, true });
+    return *this;
+}
+
+RenderGraphPassBuilder& RenderGraphPassBuilder::SetSideEffect()
+{
+    graph.pass_nodes[pass].has_side_effect = true;
+    return *this;
+}
+
+#pragma endregion RenderGraphPassBuilder
+
+RenderGraph::RenderGraph(DeviceResources& _dr, const RENDER_GRAPH_DESC& _desc)
+    : dr                { _dr }
+    , desc              { _desc }
+    , name              { _desc.name ? _desc.name : "RenderGraph" }
+    , queues            {}
+    , recorders         {}
+    , resources         {}
+    , resource_nodes    {}
+    , passes            {}
+    , pass_nodes        {}
+    , is_dirty          { true }
+    , compiler          {}
+    , compiled          {}
+    , memory_layout     {}
+    , heaps             {}
+    , queue_batches     {}
+    , barrier_descs     {}
+    , sync_fence        {}
+    , sync_fence_value  {}
+{
+    desc.name = nullptr;
+
+    queues[RENDER_GRAPH_QUEUE_GRAPHICS] = dr.GetCommandQueues(buma3d::COMMAND_TYPE_DIRECT)[0];
+    auto&& compute_queues = dr.GetCommandQueues(buma3d::COMMAND_TYPE_COMPUTE_ONLY);
+    queues[RENDER_GRAPH_QUEUE_ASYNC_COMPUTE] = desc.enable_async_compute && !compute_queues.empty() ? compute_queues[0] : nullptr;
+
+    for (uint32_t i = 0; i < RENDER_GRAPH_QUEUE_NUM; i++)
+    {
+        if (!queues[i])
+            continue;
+        auto recorder_name = name + (i == RENDER_GRAPH_QUEUE_GRAPHICS ? "::graphics" : "::async_compute");
+        PARALLEL_COMMAND_RECORDER_DESC rd{};
+        rd.level        = buma3d::COMMAND_LIST_LEVEL_PRIMARY;
+        rd.num_frames   = desc.num_frames;
+        rd.num_threads  = desc.num_recording_threads;
+        rd.name         = recorder_name.c_str();
+        recorders[i] = std::make_unique<ParallelCommandRecorder>(dr, *queues[i], rd);
+    }
+
+    auto bmr = dr.GetDevice()->CreateFence(buma3d::init::TimelineFenceDesc(), &sync_fence);
+    BMR_ASSERT(bmr);
+    sync_fence->SetName((name + "::sync_fence").c_str());
+}
+
+RenderGraph::~RenderGraph()
+{
+    // レコーダーは破棄時に送信済みのフレームの完了を待機します。
+    for (auto& i : recorders)
+        i.reset();
+    DestroyTransientResources();
+}
+
+RENDER_GRAPH_RESOURCE RenderGraph::AddResource(const char* _name, const buma3d::RESOURCE_DESC& _desc, Buffer* _imported_buffer, Texture* _imported_texture)
+{
+    auto result = (RENDER_GRAPH_RESOURCE)resources.size();
+    resources.push_back({ _name ? _name : "", _desc, _imported_buffer, _imported_texture, {} });
+    resource_nodes.push_back({ _imported_buffer || _imported_texture });
+    is_dirty = true;
+    return result;
+}
+
+RENDER_GRAPH_RESOURCE RenderGraph::CreateTransientResource(const char* _name, const buma3d::RESOURCE_DESC& _desc)
+{
+    return AddResource(_name, _desc, nullptr, nullptr);
+}
+
+RENDER_GRAPH_RESOURCE RenderGraph::ImportBuffer(const char* _name, Buffer* _buffer)
+{
+    return AddResource(_name, _buffer->GetDesc(), _buffer, nullptr);
+}
+
+RENDER_GRAPH_RESOURCE RenderGraph::ImportTexture(const char* _name, Texture* _texture)
+{
+    return AddResource(_name, _texture->GetDesc(), nullptr, _texture);
+}
+
+void RenderGraph::SetImportedBuffer(RENDER_GRAPH_RESOURCE _resource, Buffer* _buffer)
+{
+    BUMA_ASSERT(resources[_resource].imported_buffer);
+    resources[_resource].imported_buffer = _buffer;
+    resources[_resource].desc            = _buffer->GetDesc();
+}
+
+void RenderGraph::SetImportedTexture(RENDER_GRAPH_RESOURCE _resource, Texture* _texture)
+{
+    BUMA_ASSERT(resources[_resource].imported_texture);
+    resources[_resource].imported_texture = _texture;
+    resources[_resource].desc             = _texture->GetDesc();
+}
+
+RenderGraphPassBuilder RenderGraph::AddPass(const char* _name, RENDER_GRAPH_QUEUE _queue, EXECUTE_FUNC _func)
+{
+    auto result = (uint32_t)passes.size();
+    passes.push_back({ _name ? _name : "", std::move(_func) });
+    pass_nodes.push_back({ _queue, false, {} });
+    is_dirty = true;
+    return RenderGraphPassBuilder(*this, result);
+}
+
+void RenderGraph::Clear()
+{
+    resources.clear();
+    resource_nodes.clear();
+    passes.clear();
+    pass_nodes.clear();
+    is_dirty = true;
+}
+
+bool RenderGraph::Compile()
+{
+    if (!is_dirty)
+        return true;
+
+    RENDER_GRAPH_COMPILE_DESC cd{};
+    cd.num_resources        = (uint32_t)resource_nodes.size();
+    cd.resources            = resource_nodes.data();
+    cd.num_passes           = (uint32_t)pass_nodes.size();
+    cd.passes               = pass_nodes.data();
+    cd.enable_async_compute = queues[RENDER_GRAPH_QUEUE_ASYNC_COMPUTE] != nullptr;
+    if (!compiler.Compile(cd, &compiled))
+    {
+        BUMA_LOGE("{}: failed to compile: {}", name, compiler.GetErrorMessage());
+        return false;
+    }
+
+    // 以前のトランジェントリソースはGPUで使用中の可能性があります。
+    dr.WaitForGpu();
+    DestroyTransientResources();
+    CreateTransientResources();
+
+    for (auto& i : queue_batches)
+        i.clear();
+    for (uint32_t i = 0; i < (uint32_t)compiled.batches.size(); i++)
+        queue_batches[compiled.batches[i].queue].push_back(i);
+    barrier_descs.resize(compiled.batches.size());
+
+    BUMA_LOGI("{}: compiled {} of {} passes into {} batches, transient memory {} bytes (unaliased {} bytes)"
+              , name, compiled.passes.size(), passes.size(), compiled.batches.size(), memory_layout.total_size_in_bytes, memory_layout.unaliased_size_in_bytes);
+
+    is_dirty = false;
+    return true;
+}
+
+void RenderGraph::CreateTransientResources()
+{
+    auto&& d = dr.GetDevice();
+    auto device_local_heap_bits = dr.GetResourceHeapProperties()->FindCompatibleHeaps(buma3d::RESOURCE_HEAP_PROPERTY_FLAG_DEVICE_LOCAL
+                                                                                      , buma3d::RESOURCE_HEAP_PROPERTY_FLAG_ACCESS_GENERIC_MEMORY_READ_FIXED | buma3d::RESOURCE_HEAP_PROPERTY_FLAG_ACCESS_COPY_DST_FIXED);
+
+    // 生存中のトランジェントリソースのみを作成し、メモリの要件からエイリアシングを計算します。
+    std::vector<RENDER_GRAPH_MEMORY_REQUIREMENTS> requirements(resources.size(), RENDER_GRAPH_MEMORY_REQUIREMENTS{});
+    for (uint32_t i = 0; i < (uint32_t)resources.size(); i++)
+    {
+        auto&& r = resources[i];
+        if (resource_nodes[i].is_imported || !compiled.lifetimes[i].is_alive)
+            continue;
+
+        auto bmr = d->CreatePlacedResource(r.desc, &r.transient);
+        BMR_ASSERT(bmr);
+        r.transient->SetName((name + "::" + r.name).c_str());
+
+        buma3d::RESOURCE_ALLOCATION_INFO        info{};
+        buma3d::RESOURCE_HEAP_ALLOCATION_INFO   heap_info{};
+        bmr = d->GetResourceAllocationInfo(1, r.transient.GetAddressOf(), &info, &heap_info);
+        BMR_ASSERT(bmr);
+        requirements[i] = { heap_info.total_size_in_bytes, heap_info.required_alignment, heap_info.heap_type_bits & device_local_heap_bits };
+        BUMA_ASSERT(requirements[i].heap_type_bits != 0);
+    }
+
+    RENDER_GRAPH_COMPILE_DESC cd{};
+    cd.num_resources = (uint32_t)resource_nodes.size();
+    cd.resources     = resource_nodes.data();
+    cd.num_passes    = (uint32_t)pass_nodes.size();
+    cd.passes        = pass_nodes.data();
+    compiler.AssignMemory(cd, requirements.data(), &compiled, &memory_layout);
+
+    for (auto& i : memory_layout.heaps)
+    {
+        buma3d::RESOURCE_HEAP_DESC heap_desc{};
+        heap_desc.heap_index            = (uint32_t)util::GetFirstBitIndex(i.heap_type_bits);
+        heap_desc.size_in_bytes         = i.size_in_bytes;
+        heap_desc.alignment             = i.alignment;
+        heap_desc.flags                 = buma3d::RESOURCE_HEAP_FLAG_NONE;
+        heap_desc.creation_node_mask    = buma3d::B3D_DEFAULT_NODE_MASK;
+        heap_desc.visible_node_mask     = buma3d::B3D_DEFAULT_NODE_MASK;
+        auto bmr = d->CreateResourceHeap(heap_desc, &heaps.emplace_back());
+        BMR_ASSERT(bmr);
+        heaps.back()->SetName((name + "::heap " + std::to_string(heaps.size() - 1)).c_str());
+    }
+
+    std::vector<buma3d::BIND_RESOURCE_HEAP_INFO> bind_infos;
+    for (uint32_t i = 0; i < (uint32_t)resources.size(); i++)
+    {
+        if (!resources[i].transient)
+            continue;
+        auto&& placement = memory_layout.placements[i];
+        auto&& bi = bind_infos.emplace_back();
+        bi.src_heap            = heaps[placement.heap].Get();
+        bi.src_heap_offset     = placement.offset;
+        bi.num_bind_node_masks = 0;
+        bi.bind_node_masks     = nullptr;
+        bi.dst_resource        = resources[i].transient.Get();
+    }
+    if (!bind_infos.empty())
+    {
+        auto bmr = d->BindResourceHeaps((uint32_t)bind_infos.size(), bind_infos.data());
+        BMR_ASSERT(bmr);
+    }
+}
+
+void RenderGraph::DestroyTransientResources()
+{
+    for (auto& i : resources)
+        i.transient.Reset();
+    heaps.clear();
+}
+
+buma3d::IResource* RenderGraph::GetResource(RENDER_GRAPH_RESOURCE _resource) const
+{
+    auto&& r = resources[_resource];
+    if (r.imported_buffer)
+        return r.imported_buffer->GetB3DResource().Get();
+    if (r.imported_texture)
+        return r.imported_texture->GetB3DResource().Get();
+    return r.transient.Get();
+}
+
+ResourceStates& RenderGraph::GetImportedStates(RENDER_GRAPH_RESOURCE _resource) const
+{
+    auto&& r = resources[_resource];
+    return r.imported_buffer ? r.imported_buffer->GetStates() : r.imported_texture->GetStates();
+}
+
+void RenderGraph::BeginFrame()
+{
+    for (auto& i : recorders)
+    {
+        if (i)
+            i->BeginFrame();
+    }
+}
+
+void RenderGraph::Execute(uint64_t _base_order)
+{
+    BUMA_ASSERT(!is_dirty && "RenderGraph::Compile() must be called after the topology is changed");
+
+    buma3d::COMMAND_LIST_BEGIN_DESC begin{};
+    begin.flags             = buma3d::COMMAND_LIST_BEGIN_FLAG_ONE_TIME_SUBMIT;
+    begin.inheritance_desc  = nullptr;
+
+    // 同期ポイントの値はフレームごとに num_sync_points ずつ増加します。
+    auto sync_base = sync_fence_value + 1;
+    for (uint32_t i_queue = 0; i_queue < RENDER_GRAPH_QUEUE_NUM; i_queue++)
+    {
+        auto&& batches = queue_batches[i_queue];
+        if (batches.empty())
+            continue;
+
+        auto&& lists = recorders[i_queue]->Record(begin, (uint32_t)batches.size(), [&](uint32_t _job_index, buma3d::ICommandList* _list) {
+            RecordBatch(batches[_job_index], _list);
+        });
+
+        // 待機、コマンドリスト、シグナルは同じ順序の1つの SUBMIT_INFO にまとめられます。
+        auto&& queue = *queues[i_queue];
+        for (size_t i = 0; i < batches.size(); i++)
+        {
+            auto&& b = compiled.batches[batches[i]];
+            auto order = _base_order + batches[i];
+            for (auto w : b.wait_sync_points)
+                queue.AddWaitFence(order, sync_fence.Get(), sync_base + w);
+            queue.AddCommandList(order, lists[i]);
+            if (b.signal_sync_point != ~0u)
+                queue.AddSignalFence(order, sync_fence.Get(), sync_base + b.signal_sync_point);
+        }
+    }
+    sync_fence_value += compiled.num_sync_points;
+
+    // 記録したバリアの後の状態をインポートしたリソースに反映します。
+    for (uint32_t i = 0; i < (uint32_t)resources.size(); i++)
+    {
+        auto&& l = compiled.lifetimes[i];
+        if (resource_nodes[i].is_imported && l.is_alive)
+            GetImportedStates(i).Reset({ l.final_state, l.final_stages, l.final_is_written });
+    }
+}
+
+void RenderGraph::EndFrame()
+{
+    for (auto& i : recorders)
+    {
+        if (i)
+            i->EndFrame();
+    }
+}
+
+void RenderGraph::RecordBatch(uint32_t _batch, buma3d::ICommandList* _list)
+{
+    auto&& bd = barrier_descs[_batch];
+    for (auto i : compiled.batches[_batch].passes)
+    {
+        auto&& cp = compiled.passes[i];
+        RecordBarriers(cp.pre_barriers, &bd, _list);
+        passes[cp.pass].func(RenderGraphPassContext(*this, _list));
+        RecordBarriers(cp.post_barriers, &bd, _list);
+    }
+}
+
+void RenderGraph::RecordBarriers(const RENDER_GRAPH_BARRIER_BATCH& _barriers, util::PipelineBarrierDesc* _desc, buma3d::ICommandList* _list)
+{
+    if (_barriers.num_barriers == 0)
+        return;
+
+    _desc->Reset();
+    auto src_stages = _barriers.src_stages;
+    for (uint32_t i = 0; i < _barriers.num_barriers; i++)
+    {
+        auto&& b = compiled.barriers[_barriers.first_barrier + i];
+        auto&& r = resources[b.resource];
+
+        auto src_state = b.src_state;
+        if (b.is_initial_import)
+        {
+            // インポートしたリソースは実行時の状態から遷移します。 状態が同じ場合も、以前のアクセスの完了を待機します。
+            // 以前のアクセスとこのパスのいずれかが書き込みを含む場合、メモリの依存関係のためにバリアを発行します。
+            auto&& s = GetImportedStates(b.resource).Get(0, 0, 0);
+            src_state   = s.state;
+            src_stages |= s.stages;
+            if (src_state == b.dst_state && !s.is_write && !b.is_write)
+                continue;
+        }
+
+        auto flags    = buma3d::RESOURCE_BARRIER_FLAG_NONE;
+        auto src_type = queues[b.src_queue]->GetCommandType();
+        auto dst_type = queues[b.dst_queue]->GetCommandType();
+        if (b.src_queue != b.dst_queue)
+            flags = buma3d::RESOURCE_BARRIER_FLAG_OWNERSHIP_TRANSFER;
+
+        if (r.desc.dimension == buma3d::RESOURCE_DIMENSION_BUFFER)
+        {
+            _desc->AddBufferBarrier(static_cast<buma3d::IBuffer*>(GetResource(b.resource)), src_state, b.dst_state, flags, src_type, dst_type);
+        }
+        else
+        {
+            auto&& t = r.desc.texture;
+            _desc->AddNewTextureBarrierRange(src_state, b.dst_state, flags, src_type, dst_type)
+                .Reset()
+                .SetTexture(static_cast<buma3d::ITexture*>(GetResource(b.resource)))
+                .AddSubresRange(GetAspectFlags(t.format_desc.format), 0, 0, t.array_size, t.mip_levels)
+                .Finalize();
+        }
+    }
+
+    _list->PipelineBarrier(_desc->SetPipelineStageFalgs(src_stages, _barriers.dst_stages).Finalize().Get());
+}
+
+
+}// namespace buma
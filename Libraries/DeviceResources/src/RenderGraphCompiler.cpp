@@ -0,0 +1,369 @@
+#include <DeviceResources/RenderGraphCompiler.h>
+
+#include <Utils/Utils.h>
+
+#include <algorithm>
+#include <functional>
+
+namespace buma
+{
+
+namespace /*anonymous*/
+{
+
+inline constexpr uint32_t INVALID_INDEX = ~0u;
+
+// PlaceBarriers で追跡する、直前のアクセスの状態です。
+struct RESOURCE_TRACK
+{
+    bool                            is_accessed;
+    buma3d::RESOURCE_STATE          state;
+    buma3d::PIPELINE_STAGE_FLAGS    stages;     // state でアクセスした全てのパスのステージです。
+    RENDER_GRAPH_QUEUE              queue;
+    uint32_t                        last_pass;  // 最後にアクセスしたコンパイル済みパスのインデックスです。
+    bool                            is_written; // state への遷移後に書き込まれています。
+};
+
+struct BARRIER_LIST
+{
+    std::vector<RENDER_GRAPH_BARRIER>   barriers;
+    buma3d::PIPELINE_STAGE_FLAGS        src_stages;
+    buma3d::PIPELINE_STAGE_FLAGS        dst_stages;
+};
+
+RENDER_GRAPH_BARRIER_BATCH FlattenBarriers(const BARRIER_LIST& _list, std::vector<RENDER_GRAPH_BARRIER>* _dst)
+{
+    RENDER_GRAPH_BARRIER_BATCH result{};
+    result.first_barrier = (uint32_t)_dst->size();
+    result.num_barriers  = (uint32_t)_list.barriers.size();
+    result.src_stages    = _list.src_stages;
+    result.dst_stages    = _list.dst_stages;
+    _dst->insert(_dst->end(), _list.barriers.begin(), _list.barriers.end());
+    return result;
+}
+
+
+}// namespace /*anonymous*/
+
+void COMPILED_RENDER_GRAPH::Clear()
+{
+    passes.clear();
+    barriers.clear();
+    batches.clear();
+    num_sync_points = 0;
+    lifetimes.clear();
+    is_culled.clear();
+}
+
+bool RenderGraphCompiler::Compile(const RENDER_GRAPH_COMPILE_DESC& _desc, COMPILED_RENDER_GRAPH* _dst)
+{
+    error_message.clear();
+    _dst->Clear();
+
+    for (uint32_t i = 0; i < _desc.num_passes; i++)
+    {
+        for (auto& a : _desc.passes[i].accesses)
+        {
+            if (a.resource >= _desc.num_resources)
+            {
+                error_message = "pass " + std::to_string(i) + " accesses an invalid resource";
+                return false;
+            }
+        }
+    }
+
+    CullPasses(_desc, _dst);
+    return PlaceBarriers(_desc, _dst);
+}
+
+void RenderGraphCompiler::CullPasses(const RENDER_GRAPH_COMPILE_DESC& _desc, COMPILED_RENDER_GRAPH* _dst)
+{
+    // 出力(副作用を持つパス、インポートされたリソースへの書き込み)から逆順に、読み取られるリソースを書き込むパスのみを残します。
+    std::vector<bool> is_needed(_desc.num_resources, false);
+    _dst->is_culled.assign(_desc.num_passes, true);
+    for (uint32_t i = _desc.num_passes; i-- > 0;)
+    {
+        auto&& p = _desc.passes[i];
+        bool is_alive = p.has_side_effect;
+        for (auto& a : p.accesses)
+        {
+            if (a.is_write && (_desc.resources[a.resource].is_imported || is_needed[a.resource]))
+                is_alive = true;
+        }
+        if (!is_alive)
+            continue;
+
+        _dst->is_culled[i] = false;
+        for (auto& a : p.accesses)
+        {
+            if (!a.is_write)
+                is_needed[a.resource] = true;
+        }
+    }
+}
+
+bool RenderGraphCompiler::PlaceBarriers(const RENDER_GRAPH_COMPILE_DESC& _desc, COMPILED_RENDER_GRAPH* _dst)
+{
+    std::vector<RESOURCE_TRACK>     tracks(_desc.num_resources, RESOURCE_TRACK{});
+    std::vector<BARRIER_LIST>       pre_barriers;
+    std::vector<BARRIER_LIST>       post_barriers;
+    std::vector<uint32_t>           pass_batches;   // [compiled pass] 所属するバッチのインデックスです。
+
+    _dst->lifetimes.assign(_desc.num_resources, RENDER_GRAPH_RESOURCE_LIFETIME{});
+
+    uint32_t open_batches[RENDER_GRAPH_QUEUE_NUM];
+    uint32_t waited_batches[RENDER_GRAPH_QUEUE_NUM][RENDER_GRAPH_QUEUE_NUM]; // [dst queue][src queue] 待機済みの最後のバッチです。
+    std::fill(std::begin(open_batches), std::end(open_batches), INVALID_INDEX);
+    for (auto& i : waited_batches)
+        std::fill(std::begin(i), std::end(i), INVALID_INDEX);
+
+    std::vector<RENDER_GRAPH_RESOURCE_ACCESS>   accesses;
+    std::vector<uint32_t>                       wait_batches;
+    std::vector<uint32_t>                       new_waits;
+    for (uint32_t i_pass = 0; i_pass < _desc.num_passes; i_pass++)
+    {
+        if (_dst->is_culled[i_pass])
+            continue;
+
+        auto&& p = _desc.passes[i_pass];
+        auto queue = (p.queue == RENDER_GRAPH_QUEUE_ASYNC_COMPUTE && _desc.enable_async_compute) ? RENDER_GRAPH_QUEUE_ASYNC_COMPUTE : RENDER_GRAPH_QUEUE_GRAPHICS;
+        auto cp = (uint32_t)_dst->passes.size();
+        _dst->passes.push_back({ i_pass, queue, {}, {} });
+        auto&& pre = pre_barriers.emplace_back();
+        post_barriers.emplace_back();
+
+        // 同じリソースへの複数のアクセスを1つにまとめます。 同じパス内では同じ状態である必要があります。
+        accesses.clear();
+        for (auto& a : p.accesses)
+        {
+            auto it = std::find_if(accesses.begin(), accesses.end(), [&a](const RENDER_GRAPH_RESOURCE_ACCESS& _b) { return _b.resource == a.resource; });
+            if (it == accesses.end())
+            {
+                accesses.push_back(a);
+                continue;
+            }
+            if (it->state != a.state)
+            {
+                error_message = "pass " + std::to_string(i_pass) + " accesses the same resource in different states";
+                return false;
+            }
+            it->stages   |= a.stages;
+            it->is_write |= a.is_write;
+        }
+
+        wait_batches.clear();
+        for (auto& a : accesses)
+        {
+            auto&& t = tracks[a.resource];
+            auto&& l = _dst->lifetimes[a.resource];
+            auto is_imported = _desc.resources[a.resource].is_imported;
+
+            if (!t.is_accessed)
+            {
+                // インポートされたリソースはグラフィックスキューで取得、解放されます。
+                if (is_imported && queue != RENDER_GRAPH_QUEUE_GRAPHICS)
+                {
+                    error_message = "imported resource " + std::to_string(a.resource) + " must be first accessed on the graphics queue";
+                    return false;
+                }
+
+                // トランジェントリソースの以前の内容は破棄されるため、未定義の状態から遷移します。
+                pre.barriers.push_back({ a.resource, buma3d::RESOURCE_STATE_UNDEFINED, a.state, queue, queue, is_imported, a.is_write });
+                pre.src_stages |= is_imported ? buma3d::PIPELINE_STAGE_FLAG_NONE : buma3d::PIPELINE_STAGE_FLAG_TOP_OF_PIPE;
+                pre.dst_stages |= a.stages;
+
+                l.is_alive   = true;
+                l.first_pass = cp;
+            }
+            else if (t.queue != queue)
+            {
+                // キュー間の所有権の移動です。 直前のキューで最後のアクセスの後に解放し、このパスの前に取得します。
+                RENDER_GRAPH_BARRIER b{ a.resource, t.state, a.state, t.queue, queue, false, a.is_write };
+                auto&& release = post_barriers[t.last_pass];
+                release.barriers.push_back(b);
+                release.src_stages |= t.stages;
+                release.dst_stages |= buma3d::PIPELINE_STAGE_FLAG_TOP_OF_PIPE;
+
+                pre.barriers.push_back(b);
+                pre.src_stages |= buma3d::PIPELINE_STAGE_FLAG_TOP_OF_PIPE;
+                pre.dst_stages |= a.stages;
+
+                wait_batches.push_back(pass_batches[t.last_pass]);
+            }
+            else if (t.state != a.state || t.is_written || a.is_write)
+            {
+                // 書き込みを含む場合、状態が同じでもメモリの依存関係のためにバリアが必要です。
+                pre.barriers.push_back({ a.resource, t.state, a.state, queue, queue, false, a.is_write });
+                pre.src_stages |= t.stages;
+                pre.dst_stages |= a.stages;
+            }
+            else
+            {
+                // 同じ状態での読み取りが連続する場合、バリアは不要です。 次の遷移で待機するステージを追加します。
+                t.stages   |= a.stages;
+                t.last_pass = cp;
+                l.last_pass = cp;
+                continue;
+            }
+
+            t.is_accessed = true;
+            t.state       = a.state;
+            t.stages      = a.stages;
+            t.queue       = queue;
+            t.last_pass   = cp;
+            t.is_written  = a.is_write;
+            l.last_pass   = cp;
+            l.is_async   |= queue == RENDER_GRAPH_QUEUE_ASYNC_COMPUTE;
+        }
+
+        // 他のキューのバッチを待機する場合、新しいバッチを開始します。 同じキューで既に待機したバッチ以前のバッチは、キューの実行順序により完了済みであるため待機しません。
+        auto&& waited = waited_batches[queue];
+        std::sort(wait_batches.begin(), wait_batches.end(), std::greater<uint32_t>());
+        new_waits.clear();
+        for (auto b : wait_batches)
+        {
+            auto src_queue = _dst->batches[b].queue;
+            if (waited[src_queue] != INVALID_INDEX && waited[src_queue] >= b)
+                continue;
+            waited[src_queue] = b;
+            new_waits.push_back(b);
+        }
+        if (!new_waits.empty() || open_batches[queue] == INVALID_INDEX)
+        {
+            open_batches[queue] = (uint32_t)_dst->batches.size();
+            _dst->batches.push_back({ queue, {}, {}, INVALID_INDEX });
+        }
+
+        auto batch_index = open_batches[queue];
+        for (auto b : new_waits)
+        {
+            // シグナルするバッチは閉じ、以降のパスを含めません。 含めた場合、以降のパスが待機するバッチとの循環が発生する可能性があります。
+            auto&& src = _dst->batches[b];
+            if (src.signal_sync_point == INVALID_INDEX)
+                src.signal_sync_point = _dst->num_sync_points++;
+            if (open_batches[src.queue] == b)
+                open_batches[src.queue] = INVALID_INDEX;
+            _dst->batches[batch_index].wait_sync_points.push_back(src.signal_sync_point);
+        }
+        _dst->batches[batch_index].passes.push_back(cp);
+        pass_batches.push_back(batch_index);
+    }
+
+    // インポートされたリソースはグラフィックスキューで解放されます。
+    for (uint32_t i = 0; i < _desc.num_resources; i++)
+    {
+        auto&& t = tracks[i];
+        auto&& l = _dst->lifetimes[i];
+        if (!t.is_accessed)
+            continue;
+        if (_desc.resources[i].is_imported && t.queue != RENDER_GRAPH_QUEUE_GRAPHICS)
+        {
+            error_message = "imported resource " + std::to_string(i) + " must be last accessed on the graphics queue";
+            return false;
+        }
+        l.final_state      = t.state;
+        l.final_stages     = t.stages;
+        l.final_is_written = t.is_written;
+    }
+
+    for (size_t i = 0; i < _dst->passes.size(); i++)
+    {
+        _dst->passes[i].pre_barriers  = FlattenBarriers(pre_barriers[i], &_dst->barriers);
+        _dst->passes[i].post_barriers = FlattenBarriers(post_barriers[i], &_dst->barriers);
+    }
+    return true;
+}
+
+void RenderGraphCompiler::AssignMemory(const RENDER_GRAPH_COMPILE_DESC& _desc, const RENDER_GRAPH_MEMORY_REQUIREMENTS* _requirements, COMPILED_RENDER_GRAPH* _compiled, RENDER_GRAPH_MEMORY_LAYOUT* _dst)
+{
+    auto&& lifetimes = _compiled->lifetimes;
+    _dst->heaps.clear();
+    _dst->placements.assign(_desc.num_resources, RENDER_GRAPH_MEMORY_PLACEMENT{ INVALID_INDEX, 0 });
+    _dst->total_size_in_bytes     = 0;
+    _dst->unaliased_size_in_bytes = 0;
+
+    std::vector<uint32_t> resources;
+    for (uint32_t i = 0; i < _desc.num_resources; i++)
+    {
+        if (!_desc.resources[i].is_imported && lifetimes[i].is_alive)
+        {
+            resources.push_back(i);
+            _dst->unaliased_size_in_bytes += _requirements[i].size_in_bytes;
+        }
+    }
+
+    // 大きいリソースから順に、生存期間が重なるリソースと重ならない最小のオフセットに配置します。
+    std::stable_sort(resources.begin(), resources.end(), [_requirements](uint32_t _a, uint32_t _b) {
+        return _requirements[_a].size_in_bytes > _requirements[_b].size_in_bytes;
+    });
+
+    auto is_overlapped = [&lifetimes](uint32_t _a, uint32_t _b) {
+        auto&& a = lifetimes[_a];
+        auto&& b = lifetimes[_b];
+        // 非同期コンピュートキューのパスは他のキューのパスと並行して実行されるため、順序から生存期間を判断できません。
+        if (a.is_async || b.is_async)
+            return true;
+        return a.first_pass <= b.last_pass && b.first_pass <= a.last_pass;
+    };
+
+    std::vector<std::vector<uint32_t>>  heap_resources;
+    std::vector<uint32_t>               conflicts;
+    for (auto r : resources)
+    {
+        auto&& req = _requirements[r];
+        auto it = std::find_if(_dst->heaps.begin(), _dst->heaps.end(), [&req](const RENDER_GRAPH_MEMORY_HEAP& _h) { return _h.heap_type_bits == req.heap_type_bits; });
+        if (it == _dst->heaps.end())
+        {
+            _dst->heaps.push_back({ req.heap_type_bits, 0, req.alignment });
+            heap_resources.emplace_back();
+            it = _dst->heaps.end() - 1;
+        }
+        auto heap_index = (uint32_t)std::distance(_dst->heaps.begin(), it);
+        auto&& placed = heap_resources[heap_index];
+
+        conflicts.clear();
+        for (auto i : placed)
+        {
+            if (is_overlapped(r, i))
+                conflicts.push_back(i);
+        }
+        std::sort(conflicts.begin(), conflicts.end(), [_dst](uint32_t _a, uint32_t _b) { return _dst->placements[_a].offset < _dst->placements[_b].offset; });
+
+        uint64_t offset = 0;
+        for (auto i : conflicts)
+        {
+            auto&& c = _dst->placements[i];
+            if (util::AlignUp(offset, req.alignment) + req.size_in_bytes <= c.offset)
+                break;
+            offset = (std::max)(offset, c.offset + _requirements[i].size_in_bytes);
+        }
+        offset = util::AlignUp(offset, req.alignment);
+
+        _dst->placements[r] = { heap_index, offset };
+        it->size_in_bytes   = (std::max)(it->size_in_bytes, offset + req.size_in_bytes);
+        it->alignment       = (std::max)(it->alignment, req.alignment);
+        placed.push_back(r);
+    }
+
+    for (auto& i : _dst->heaps)
+        _dst->total_size_in_bytes += i.size_in_bytes;
+
+    // メモリを再利用するリソースは、以前のリソースへのアクセスの完了を待機してから未定義の状態から遷移します。
+    // ヒープはフレーム間で共有されるため、このフレームで後にアクセスされるリソースと自身も、前のフレームでのそのメモリの以前の使用者として待機します。
+    for (auto&& placed : heap_resources)
+    {
+        for (auto r : placed)
+        {
+            auto&& rp = _dst->placements[r];
+            for (auto i : placed)
+            {
+                auto&& ip = _dst->placements[i];
+                if (ip.offset < rp.offset + _requirements[r].size_in_bytes && rp.offset < ip.offset + _requirements[i].size_in_bytes)
+                    _compiled->passes[lifetimes[r].first_pass].pre_barriers.src_stages |= lifetimes[i].final_stages;
+            }
+        }
+    }
+}
+
+
+}// namespace buma
@@ -15,6 +15,7 @@ ResourceBase::ResourceBase(DeviceResources& _dr, RESOURCE_CREATE_TYPE _create_ty
     , create_type     { _create_type }
     , resource        {}
     , heap_allocation {}
+    , states          {}
 {
 }
 
@@ -86,6 +87,9 @@ bool ResourceBase::CreateResource(const buma3d::RESOURCE_DESC& _desc, buma3d::RE
         break;
     }
 
+    // 作成直後のリソースの内容は未定義です。
+    states.Init(_desc, { buma3d::RESOURCE_STATE_UNDEFINED, buma3d::PIPELINE_STAGE_FLAG_TOP_OF_PIPE });
+
     return true;
 }
 
@@ -4,6 +4,8 @@
 
 #include <Buma3DHelpers/B3DInit.h>
 
+#include <algorithm>
+
 namespace buma
 {
 
@@ -12,6 +14,7 @@ Buffer::Buffer(DeviceResources& _dr, RESOURCE_CREATE_TYPE _create_type
     : ResourceBase(_dr, _create_type)
     , mapped_data{}
     , mapped_range{}
+    , heap_mapped_range{}
     , srvs{}
     , uavs{}
 {
@@ -21,6 +24,7 @@ Buffer::Buffer(DeviceResources& _dr, RESOURCE_CREATE_TYPE _create_type
     {
         auto bmr = resource->GetHeap()->GetMappedData(&mapped_range, &mapped_data);
         BMR_ASSERT(bmr);
+        heap_mapped_range = mapped_range;
 
         if (heap_allocation)
         {
@@ -48,12 +52,57 @@ const buma3d::MAPPED_RANGE* Buffer::GetMppedRange() const
     return (mapped_data ? &mapped_range : nullptr);
 }
 
+buma3d::MAPPED_RANGE Buffer::ToHeapRange(const buma3d::MAPPED_RANGE& _range) const
+{
+    // サブ割り当てされたバッファの先頭はアライメントされているとは限らないため、ヒープの先頭からのオフセットでアライメントします。
+    // アライメントに拡張した結果がヒープのマップされた範囲を超える場合、その範囲に切り詰めます。
+    auto heap_end = heap_mapped_range.offset + heap_mapped_range.size;
+    auto begin    = (std::max)(util::AlignDown(mapped_range.offset + _range.offset, FLUSH_ALIGNMENT), heap_mapped_range.offset);
+    auto end      = (std::min)(util::AlignUp(mapped_range.offset + _range.offset + _range.size, FLUSH_ALIGNMENT), heap_end);
+    return { begin, end - begin };
+}
+
 void Buffer::Flush(const buma3d::MAPPED_RANGE* _range)
 {
     if (!mapped_data)
         return;
 
-    auto bmr = resource->GetHeap()->FlushMappedRanges(1, &mapped_range);
+    buma3d::MAPPED_RANGE range = { 0, mapped_range.size };
+    Flush(1, _range ? _range : &range);
+}
+
+void Buffer::Flush(uint32_t _num_ranges, const buma3d::MAPPED_RANGE* _ranges)
+{
+    if (!mapped_data || _num_ranges == 0)
+        return;
+
+    // 複数のスレッドから同時に呼び出せるよう、変換した範囲はスタック上の配列に保持し、満杯になるごとにフラッシュします。
+    // アライメントにより重なった連続する範囲は結合します。
+    constexpr uint32_t MAX_RANGES = 16;
+    buma3d::MAPPED_RANGE heap_ranges[MAX_RANGES];
+    uint32_t num_heap_ranges = 0;
+    for (uint32_t i = 0; i < _num_ranges; i++)
+    {
+        auto range = ToHeapRange(_ranges[i]);
+        if (num_heap_ranges != 0)
+        {
+            auto&& back = heap_ranges[num_heap_ranges - 1];
+            if (back.offset <= range.offset && range.offset <= back.offset + back.size)
+            {
+                back.size = (std::max)(back.offset + back.size, range.offset + range.size) - back.offset;
+                continue;
+            }
+        }
+        if (num_heap_ranges == MAX_RANGES)
+        {
+            auto bmr = resource->GetHeap()->FlushMappedRanges(num_heap_ranges, heap_ranges);
+            BMR_ASSERT(bmr);
+            num_heap_ranges = 0;
+        }
+        heap_ranges[num_heap_ranges++] = range;
+    }
+
+    auto bmr = resource->GetHeap()->FlushMappedRanges(num_heap_ranges, heap_ranges);
     BMR_ASSERT(bmr);
 }
 
@@ -62,7 +111,8 @@ void Buffer::Invalidate(const buma3d::MAPPED_RANGE* _range)
     if (!mapped_data)
         return;
 
-    auto bmr = resource->GetHeap()->InvalidateMappedRanges(1, &mapped_range);
+    auto range = ToHeapRange(_range ? *_range : buma3d::MAPPED_RANGE{ 0, mapped_range.size });
+    auto bmr = resource->GetHeap()->InvalidateMappedRanges(1, &range);
     BMR_ASSERT(bmr);
 }
 
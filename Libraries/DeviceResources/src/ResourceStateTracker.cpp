@@ -0,0 +1,279 @@
+#include <DeviceResources/ResourceStateTracker.h>
+
+#include <Buma3DHelpers/FormatUtils.h>
+
+#include <Utils/Utils.h>
+
+#include <algorithm>
+
+namespace buma
+{
+
+#pragma region ResourceStates
+
+ResourceStates::ResourceStates()
+    : mip_levels    {}
+    , array_size    {}
+    , num_aspects   {}
+    , aspects       {}
+    , current       {}
+    , pending       {}
+    , is_pending    {}
+{
+}
+
+ResourceStates::~ResourceStates()
+{
+    BUMA_ASSERT(!is_pending && "ResourceStateTracker has pending state of this resource");
+}
+
+void ResourceStates::Init(uint32_t _mip_levels, uint32_t _array_size, bool _is_depth_stencil, const SUBRESOURCE_STATE& _initial_state)
+{
+    BUMA_ASSERT(!is_pending);
+    mip_levels  = (std::max)(_mip_levels, 1u);
+    array_size  = (std::max)(_array_size, 1u);
+    num_aspects = _is_depth_stencil ? 2 : 1;
+    aspects[0]  = _is_depth_stencil ? buma3d::TEXTURE_ASPECT_FLAG_DEPTH : buma3d::TEXTURE_ASPECT_FLAG_COLOR;
+    aspects[1]  = _is_depth_stencil ? buma3d::TEXTURE_ASPECT_FLAG_STENCIL : buma3d::TEXTURE_ASPECT_FLAG_NONE;
+    current.assign(num_aspects * array_size * mip_levels, _initial_state);
+    pending.resize(current.size());
+}
+
+void ResourceStates::Init(const buma3d::RESOURCE_DESC& _desc, const SUBRESOURCE_STATE& _initial_state)
+{
+    if (_desc.dimension == buma3d::RESOURCE_DIMENSION_BUFFER)
+    {
+        Init(1, 1, false, _initial_state);
+        return;
+    }
+
+    // 深度のみのフォーマットは深度アスペクトのみを追跡します。
+    auto&& t = _desc.texture;
+    auto is_depth_stencil = util::IsDepthStencilFormat(t.format_desc.format) && !util::IsDepthOnlyFormat(t.format_desc.format);
+    Init(t.mip_levels, t.array_size, is_depth_stencil, _initial_state);
+    if (util::IsDepthOnlyFormat(t.format_desc.format))
+        aspects[0] = buma3d::TEXTURE_ASPECT_FLAG_DEPTH;
+}
+
+void ResourceStates::Reset(const SUBRESOURCE_STATE& _state)
+{
+    BUMA_ASSERT(!is_pending);
+    std::fill(current.begin(), current.end(), _state);
+}
+
+#pragma endregion ResourceStates
+
+ResourceStateTracker::ResourceStateTracker()
+    : pending_resources { }
+    , transitions       { }
+    , num_transitions   { }
+    , src_stages        { }
+    , dst_stages        { }
+    , barrier_desc      { }
+{
+}
+
+ResourceStateTracker::~ResourceStateTracker()
+{
+    Discard();
+}
+
+void ResourceStateTracker::RegisterPending(buma3d::IBuffer* _buffer, buma3d::ITexture* _texture, ResourceStates* _states)
+{
+    if (_states->is_pending)
+        return;
+
+    // 要求されたサブリソースのみ遷移させるため、 stages が PIPELINE_STAGE_FLAG_NONE の要素は要求されていないものとして扱います。
+    std::fill(_states->pending.begin(), _states->pending.end(), SUBRESOURCE_STATE{});
+    _states->is_pending = true;
+    pending_resources.push_back({ _buffer, _texture, _states });
+}
+
+void ResourceStateTracker::RequestBufferState(buma3d::IBuffer* _buffer, ResourceStates* _states, const SUBRESOURCE_STATE& _state)
+{
+    BUMA_ASSERT(_states->GetNumSubresources() == 1);
+    BUMA_ASSERT(_state.stages != buma3d::PIPELINE_STAGE_FLAG_NONE);
+    RegisterPending(_buffer, nullptr, _states);
+    _states->pending[0] = _state;
+}
+
+void ResourceStateTracker::RequestTextureState(buma3d::ITexture* _texture, ResourceStates* _states, const buma3d::SUBRESOURCE_RANGE& _range, const SUBRESOURCE_STATE& _state)
+{
+    BUMA_ASSERT(_state.stages != buma3d::PIPELINE_STAGE_FLAG_NONE);
+    BUMA_ASSERT(_range.offset.mip_slice < _states->mip_levels && _range.offset.array_slice < _states->array_size);
+    RegisterPending(nullptr, _texture, _states);
+
+    // B3D_USE_REMAINING_MIP_LEVELS 等の値は残りの数に切り詰められます。
+    auto mip_end   = _range.offset.mip_slice   + (std::min)(_range.mip_levels, _states->mip_levels - _range.offset.mip_slice);
+    auto array_end = _range.offset.array_slice + (std::min)(_range.array_size, _states->array_size - _range.offset.array_slice);
+    for (uint32_t i_aspect = 0; i_aspect < _states->num_aspects; i_aspect++)
+    {
+        if (!(_range.offset.aspect & _states->aspects[i_aspect]))
+            continue;
+        for (uint32_t i_array = _range.offset.array_slice; i_array < array_end; i_array++)
+        {
+            auto s = _states->pending.data() + _states->GetIndex(i_aspect, 0, i_array);
+            std::fill(s + _range.offset.mip_slice, s + mip_end, _state);
+        }
+    }
+}
+
+void ResourceStateTracker::RequestTextureState(buma3d::ITexture* _texture, ResourceStates* _states, const SUBRESOURCE_STATE& _state)
+{
+    BUMA_ASSERT(_state.stages != buma3d::PIPELINE_STAGE_FLAG_NONE);
+    RegisterPending(nullptr, _texture, _states);
+    std::fill(_states->pending.begin(), _states->pending.end(), _state);
+}
+
+const buma3d::CMD_PIPELINE_BARRIER* ResourceStateTracker::Flush()
+{
+    barrier_desc.Reset();
+    src_stages = buma3d::PIPELINE_STAGE_FLAG_NONE;
+    dst_stages = buma3d::PIPELINE_STAGE_FLAG_NONE;
+
+    for (auto& i : pending_resources)
+    {
+        if (i.buffer)
+            AddBufferBarrier(i.buffer, i.states);
+        else
+            AddTextureBarriers(i.texture, i.states);
+        i.states->is_pending = false;
+    }
+    pending_resources.clear();
+
+    auto&& barrier = barrier_desc.Get();
+    if (barrier.num_buffer_barriers == 0 && barrier.num_texture_barriers == 0)
+        return nullptr;
+
+    return &barrier_desc.SetPipelineStageFalgs(src_stages, dst_stages).Finalize().Get();
+}
+
+bool ResourceStateTracker::Flush(buma3d::ICommandList* _list)
+{
+    auto barrier = Flush();
+    if (!barrier)
+        return false;
+
+    _list->PipelineBarrier(*barrier);
+    return true;
+}
+
+void ResourceStateTracker::Discard()
+{
+    for (auto& i : pending_resources)
+        i.states->is_pending = false;
+    pending_resources.clear();
+}
+
+bool ResourceStateTracker::NeedsBarrier(const SUBRESOURCE_STATE& _current, const SUBRESOURCE_STATE& _pending)
+{
+    // 書き込みを含む場合、状態が同じでもメモリの依存関係のためにバリアが必要です。
+    return _pending.stages != buma3d::PIPELINE_STAGE_FLAG_NONE
+        && (_current.state != _pending.state || _current.is_write || _pending.is_write);
+}
+
+void ResourceStateTracker::AddBufferBarrier(buma3d::IBuffer* _buffer, ResourceStates* _states)
+{
+    auto&& c = _states->current[0];
+    auto&& p = _states->pending[0];
+    if (!NeedsBarrier(c, p))
+    {
+        // 同じ状態での読み取りが連続する場合、バリアは不要です。 次の遷移で待機するよう、アクセスするステージを追加します。
+        c.stages |= p.stages;
+        return;
+    }
+
+    barrier_desc.AddBufferBarrier(_buffer, c.state, p.state);
+    src_stages |= c.stages;
+    dst_stages |= p.stages;
+    c = p;
+}
+
+ResourceStateTracker::TRANSITION& ResourceStateTracker::GetOrAddTransition(buma3d::RESOURCE_STATE _src_state, buma3d::RESOURCE_STATE _dst_state)
+{
+    // 1つのテクスチャ内の遷移の種類は通常少数であるため、線形探索します。
+    for (size_t i = 0; i < num_transitions; i++)
+    {
+        auto&& t = transitions[i];
+        if (t.src_state == _src_state && t.dst_state == _dst_state)
+            return t;
+    }
+
+    if (num_transitions == transitions.size())
+        transitions.emplace_back();
+    auto&& t = transitions[num_transitions++];
+    t.src_state = _src_state;
+    t.dst_state = _dst_state;
+    t.ranges.clear();
+    return t;
+}
+
+void ResourceStateTracker::AddTextureBarriers(buma3d::ITexture* _texture, ResourceStates* _states)
+{
+    num_transitions = 0;
+
+    auto&& s = *_states;
+    for (uint32_t i_aspect = 0; i_aspect < s.num_aspects; i_aspect++)
+    {
+        for (uint32_t i_array = 0; i_array < s.array_size; i_array++)
+        {
+            auto c = s.current.data() + s.GetIndex(i_aspect, 0, i_array);
+            auto p = s.pending.data() + s.GetIndex(i_aspect, 0, i_array);
+
+            // 同じ遷移を持つ連続したミップレベルを1つの範囲にまとめます。
+            uint32_t i_mip = 0;
+            while (i_mip < s.mip_levels)
+            {
+                if (!NeedsBarrier(c[i_mip], p[i_mip]))
+                {
+                    c[i_mip].stages |= p[i_mip].stages;
+                    i_mip++;
+                    continue;
+                }
+
+                auto src = c[i_mip].state;
+                auto dst = p[i_mip].state;
+                auto mip_begin = i_mip;
+                for (; i_mip < s.mip_levels && c[i_mip].state == src && p[i_mip].state == dst && NeedsBarrier(c[i_mip], p[i_mip]); i_mip++)
+                {
+                    src_stages |= c[i_mip].stages;
+                    dst_stages |= p[i_mip].stages;
+                    c[i_mip] = p[i_mip];
+                }
+                auto mip_count = i_mip - mip_begin;
+
+                // 前の配列スライスに同じミップの範囲が存在する場合、配列方向に結合します。
+                auto&& t = GetOrAddTransition(src, dst);
+                auto it = std::find_if(t.ranges.rbegin(), t.ranges.rend(), [&](const buma3d::SUBRESOURCE_RANGE& _r) {
+                    return _r.offset.aspect == s.aspects[i_aspect] && _r.offset.mip_slice == mip_begin && _r.mip_levels == mip_count
+                        && _r.offset.array_slice + _r.array_size == i_array;
+                });
+                if (it != t.ranges.rend())
+                {
+                    it->array_size++;
+                }
+                else
+                {
+                    auto&& r = t.ranges.emplace_back();
+                    r.offset.aspect      = s.aspects[i_aspect];
+                    r.offset.mip_slice   = mip_begin;
+                    r.offset.array_slice = i_array;
+                    r.mip_levels         = mip_count;
+                    r.array_size         = 1;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < num_transitions; i++)
+    {
+        auto&& t = transitions[i];
+        auto&& range = barrier_desc.AddNewTextureBarrierRange(t.src_state, t.dst_state).Reset().SetTexture(_texture);
+        for (auto& r : t.ranges)
+            range.AddSubresRange(r.offset.aspect, r.offset.mip_slice, r.offset.array_slice, r.array_size, r.mip_levels);
+        range.Finalize();
+    }
+}
+
+
+}// namespace buma
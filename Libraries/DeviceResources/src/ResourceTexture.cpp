@@ -28,6 +28,7 @@ Texture::Texture(DeviceResources& _dr, buma3d::ITexture* _swapchain_texture)
     , dsvs{}
 {
     resource = _swapchain_texture;
+    states.Init(GetDesc(), { buma3d::RESOURCE_STATE_UNDEFINED, buma3d::PIPELINE_STAGE_FLAG_TOP_OF_PIPE });
     srvs.Init(GetB3DTexture().Get());
     uavs.Init(GetB3DTexture().Get());
     rtvs.Init(GetB3DTexture().Get());
@@ -0,0 +1,239 @@
+#include <DeviceResources/CommandListChain.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+// CommandListChain の送信が、順序と数が変化しないフレームでヒープの割り当てを行わない事を検証します。
+// 全ての割り当てを数えるため、グローバルな operator new を置き換えます。
+
+namespace /*anonymous*/
+{
+
+std::atomic_size_t g_num_allocations{};
+
+void* CountedAlloc(size_t _size)
+{
+    g_num_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto p = std::malloc(_size ? _size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+}// namespace /*anonymous*/
+
+void* operator new(size_t _size)                { return CountedAlloc(_size); }
+void* operator new[](size_t _size)              { return CountedAlloc(_size); }
+void  operator delete(void* _p) noexcept        { std::free(_p); }
+void  operator delete[](void* _p) noexcept      { std::free(_p); }
+void  operator delete(void* _p, size_t) noexcept    { std::free(_p); }
+void  operator delete[](void* _p, size_t) noexcept  { std::free(_p); }
+
+namespace b = buma3d;
+
+#define CHECK(x)                                                                \
+    do {                                                                        \
+        if (!(x)) {                                                             \
+            std::printf("%s(%d): CHECK failed: %s\n", __FILE__, __LINE__, #x);  \
+            num_failures++;                                                     \
+        }                                                                       \
+    } while (false)
+
+namespace /*anonymous*/
+{
+
+int num_failures = 0;
+
+// チェインはオブジェクトのポインタを記録するのみであるため、識別可能なアドレスを持つ偽のオブジェクトを使用します。
+template<typename T>
+T* FakeObject(uintptr_t _id)
+{
+    return reinterpret_cast<T*>(_id * 0x100);
+}
+
+// CommandQueue::SubmitFromDr() と同じ CommandListChain::SubmitAndReset() でチェインを送信し、 ICommandQueue::Submit() の代わりに送信の内容を集計するキューです。
+class MockQueue
+{
+public:
+    MockQueue()
+        : num_submit_infos  {}
+        , num_command_lists {}
+        , num_signal_fences {}
+        , num_wait_fences   {}
+        , chain             {}
+        , execution_fence   { FakeObject<b::IFence>(1000) }
+        , fence_value       {}
+    {
+    }
+
+    buma::CommandListChain& GetChain() { return chain; }
+
+    uint64_t SubmitFromDr()
+    {
+        chain.SubmitAndReset(execution_fence, fence_value + 1, [this](const b::SUBMIT_DESC& _desc) { Submit(_desc); });
+        return ++fence_value;
+    }
+
+    b::IFence*  GetExecutionFence() const { return execution_fence; }
+    uint64_t    GetFenceValue()     const { return fence_value; }
+
+    // 最後の送信の集計です。
+    uint32_t num_submit_infos;
+    uint32_t num_command_lists;
+    uint32_t num_signal_fences;
+    uint32_t num_wait_fences;
+
+private:
+    void Submit(const b::SUBMIT_DESC& _desc)
+    {
+        num_submit_infos  = _desc.num_submit_infos;
+        num_command_lists = 0;
+        num_signal_fences = 0;
+        num_wait_fences   = 0;
+        for (uint32_t i = 0; i < _desc.num_submit_infos; i++)
+        {
+            auto&& info = _desc.submit_infos[i];
+            num_command_lists += info.num_command_lists_to_execute;
+            num_signal_fences += info.signal_fence.num_fences;
+            num_wait_fences   += info.wait_fence.num_fences;
+        }
+
+        // 実行フェンスのシグナルは独立した最後の SUBMIT_INFO です。
+        CHECK(_desc.num_submit_infos != 0);
+        if (_desc.num_submit_infos != 0)
+        {
+            auto&& last = _desc.submit_infos[_desc.num_submit_infos - 1];
+            CHECK(last.num_command_lists_to_execute == 0 && last.signal_fence.num_fences == 1);
+            CHECK(last.signal_fence.fences[0] == execution_fence && last.signal_fence.fence_values[0] == fence_value + 1);
+        }
+    }
+
+private:
+    buma::CommandListChain  chain;
+    b::IFence*              execution_fence;
+    uint64_t                fence_value;
+
+};
+
+void RecordSingleThreadFrame(MockQueue& _queue, uint64_t _frame)
+{
+    auto&& chain = _queue.GetChain();
+    chain.PrependWaitFence(FakeObject<b::IFence>(1), _frame);
+    chain.PrependCommandList(FakeObject<b::ICommandList>(1));
+    chain.AddCommandList(0, FakeObject<b::ICommandList>(2));
+    chain.AddCommandList(0, FakeObject<b::ICommandList>(3));
+    chain.AddSignalFence(0, FakeObject<b::IFence>(2), _frame);
+    chain.AddWaitFence(1, FakeObject<b::IFence>(2), _frame);
+    chain.AddCommandList(1, FakeObject<b::ICommandList>(4));
+}
+
+void TestSingleThread()
+{
+    MockQueue queue;
+
+    // 最初のフレームでスロットとその配列を確保します。
+    RecordSingleThreadFrame(queue, 0);
+    queue.SubmitFromDr();
+
+    auto num_allocations = g_num_allocations.load();
+    for (uint64_t i = 1; i < 100; i++)
+    {
+        RecordSingleThreadFrame(queue, i);
+        queue.SubmitFromDr();
+    }
+    auto num_steady_allocations = g_num_allocations.load() - num_allocations;
+    std::printf("single thread: %zu allocation(s) in 99 steady frames\n", num_steady_allocations);
+    CHECK(num_steady_allocations == 0);
+
+    CHECK(queue.num_submit_infos  == 4);
+    CHECK(queue.num_command_lists == 4);
+    CHECK(queue.num_signal_fences == 2);
+    CHECK(queue.num_wait_fences   == 2);
+    CHECK(queue.GetFenceValue()   == 100);
+}
+
+void TestMultiThread()
+{
+    constexpr uint32_t NUM_THREADS = 4;
+    constexpr uint64_t NUM_FRAMES  = 100;
+    constexpr uint64_t NUM_WARMUP  = 2;
+
+    MockQueue queue;
+    auto&& chain = queue.GetChain();
+
+    // スレッドの作成は割り当てを伴うため、スレッドはフレーム間で維持し、アトミック変数のみで同期します。
+    std::atomic_uint64_t frame_to_record{ UINT64_MAX };
+    std::atomic_uint32_t num_recorded{};
+    std::atomic_bool     should_exit{};
+    std::vector<std::thread> workers;
+    workers.reserve(NUM_THREADS);
+    for (uint32_t t = 0; t < NUM_THREADS; t++)
+    {
+        workers.emplace_back([&, t]()
+        {
+            uint64_t recorded = UINT64_MAX;
+            while (!should_exit.load(std::memory_order_acquire))
+            {
+                auto frame = frame_to_record.load(std::memory_order_acquire);
+                if (frame == recorded)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                // 各スレッドは自身の順序と、全てのスレッドで共有する順序に追加します。
+                chain.AddCommandList(t, FakeObject<b::ICommandList>(10 + t));
+                chain.AddCommandList(t, FakeObject<b::ICommandList>(20 + t));
+                chain.AddSignalFence(NUM_THREADS, FakeObject<b::IFence>(10 + t), frame);
+                recorded = frame;
+                num_recorded.fetch_add(1, std::memory_order_acq_rel);
+            }
+        });
+    }
+
+    size_t num_allocations = 0;
+    for (uint64_t i = 0; i < NUM_FRAMES; i++)
+    {
+        if (i == NUM_WARMUP)
+            num_allocations = g_num_allocations.load();
+
+        num_recorded.store(0, std::memory_order_relaxed);
+        frame_to_record.store(i, std::memory_order_release);
+        while (num_recorded.load(std::memory_order_acquire) != NUM_THREADS)
+            std::this_thread::yield();
+
+        queue.SubmitFromDr();
+    }
+    auto num_steady_allocations = g_num_allocations.load() - num_allocations;
+
+    should_exit.store(true, std::memory_order_release);
+    for (auto& i : workers)
+        i.join();
+
+    std::printf("%u threads: %zu allocation(s) in %llu steady frames\n", NUM_THREADS, num_steady_allocations, (unsigned long long)(NUM_FRAMES - NUM_WARMUP));
+    CHECK(num_steady_allocations == 0);
+
+    CHECK(queue.num_submit_infos  == NUM_THREADS + 2);
+    CHECK(queue.num_command_lists == NUM_THREADS * 2);
+    CHECK(queue.num_signal_fences == NUM_THREADS + 1);
+}
+
+}// namespace /*anonymous*/
+
+int main()
+{
+    TestSingleThread();
+    TestMultiThread();
+
+    if (num_failures != 0)
+    {
+        std::printf("CommandListChainAllocTest: %d check(s) failed\n", num_failures);
+        return 1;
+    }
+    std::printf("CommandListChainAllocTest: all checks passed\n");
+    return 0;
+}
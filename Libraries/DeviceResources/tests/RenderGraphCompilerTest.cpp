@@ -0,0 +1,261 @@
+#include <DeviceResources/RenderGraphCompiler.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// RenderGraphCompiler はGPUのオブジェクトを使用しないため、パスとリソースの宣言のみからコンパイル結果を検証します。
+
+namespace b = buma3d;
+
+#define CHECK(x)                                                                \
+    do {                                                                        \
+        if (!(x)) {                                                             \
+            std::printf("%s(%d): CHECK failed: %s\n", __FILE__, __LINE__, #x);  \
+            num_failures++;                                                     \
+        }                                                                       \
+    } while (false)
+
+namespace /*anonymous*/
+{
+
+int num_failures = 0;
+
+constexpr auto GRAPHICS = buma::RENDER_GRAPH_QUEUE_GRAPHICS;
+constexpr auto ASYNC    = buma::RENDER_GRAPH_QUEUE_ASYNC_COMPUTE;
+
+buma::RENDER_GRAPH_RESOURCE_ACCESS Read(buma::RENDER_GRAPH_RESOURCE _resource, b::RESOURCE_STATE _state, b::PIPELINE_STAGE_FLAGS _stages)
+{
+    return { _resource, _state, _stages, false };
+}
+
+buma::RENDER_GRAPH_RESOURCE_ACCESS Write(buma::RENDER_GRAPH_RESOURCE _resource, b::RESOURCE_STATE _state, b::PIPELINE_STAGE_FLAGS _stages)
+{
+    return { _resource, _state, _stages, true };
+}
+
+struct GRAPH
+{
+    std::vector<buma::RENDER_GRAPH_RESOURCE_NODE>   resources;
+    std::vector<buma::RENDER_GRAPH_PASS_NODE>       passes;
+
+    buma::RENDER_GRAPH_COMPILE_DESC GetDesc(bool _enable_async_compute) const
+    {
+        return { (uint32_t)resources.size(), resources.data(), (uint32_t)passes.size(), passes.data(), _enable_async_compute };
+    }
+};
+
+// コンパイル済みパス _pass の前のバリアから、 _resource のバリアを探します。
+const buma::RENDER_GRAPH_BARRIER* FindBarrier(const buma::COMPILED_RENDER_GRAPH& _compiled, const buma::RENDER_GRAPH_BARRIER_BATCH& _batch, buma::RENDER_GRAPH_RESOURCE _resource)
+{
+    for (uint32_t i = 0; i < _batch.num_barriers; i++)
+    {
+        auto&& barrier = _compiled.barriers[_batch.first_barrier + i];
+        if (barrier.resource == _resource)
+            return &barrier;
+    }
+    return nullptr;
+}
+
+void TestCulling()
+{
+    // 0: インポート、 1: 読み取られる、 2: 読み取られない
+    GRAPH g;
+    g.resources = { { true }, { false }, { false } };
+    g.passes = {
+          { GRAPHICS, false, { Write(1, b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COPY_RESOLVE) } }
+        , { GRAPHICS, false, { Write(2, b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COPY_RESOLVE) } }
+        , { GRAPHICS, false, { Read(1, b::RESOURCE_STATE_SHADER_READ, b::PIPELINE_STAGE_FLAG_PIXEL_SHADER), Write(0, b::RESOURCE_STATE_COLOR_ATTACHMENT_WRITE, b::PIPELINE_STAGE_FLAG_COLOR_ATTACHMENT_OUTPUT) } }
+        , { GRAPHICS, true , {} } // 出力を持たないが、副作用を持つパスです。
+        , { GRAPHICS, false, {} }
+    };
+
+    buma::RenderGraphCompiler compiler;
+    buma::COMPILED_RENDER_GRAPH compiled;
+    CHECK(compiler.Compile(g.GetDesc(false), &compiled));
+    CHECK((compiled.is_culled == std::vector<bool>{ false, true, false, false, true }));
+    CHECK(compiled.passes.size() == 3);
+    if (compiled.passes.size() == 3)
+        CHECK(compiled.passes[0].pass == 0 && compiled.passes[1].pass == 2 && compiled.passes[2].pass == 3);
+    CHECK(compiled.lifetimes[1].is_alive && !compiled.lifetimes[2].is_alive);
+    CHECK(compiled.lifetimes[1].first_pass == 0 && compiled.lifetimes[1].last_pass == 1);
+}
+
+void TestSameStateBarriers()
+{
+    // 0, 1: インポート、 2: トランジェント
+    GRAPH g;
+    g.resources = { { true }, { true }, { false } };
+    g.passes = {
+          { GRAPHICS, false, { Write(2, b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COPY_RESOLVE) } }
+        , { GRAPHICS, false, { Write(2, b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COPY_RESOLVE) } }
+        , { GRAPHICS, false, { Read(2, b::RESOURCE_STATE_SHADER_READ, b::PIPELINE_STAGE_FLAG_PIXEL_SHADER), Write(0, b::RESOURCE_STATE_COLOR_ATTACHMENT_WRITE, b::PIPELINE_STAGE_FLAG_COLOR_ATTACHMENT_OUTPUT) } }
+        , { GRAPHICS, false, { Read(2, b::RESOURCE_STATE_SHADER_READ, b::PIPELINE_STAGE_FLAG_COMPUTE_SHADER), Write(1, b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COPY_RESOLVE) } }
+    };
+
+    buma::RenderGraphCompiler compiler;
+    buma::COMPILED_RENDER_GRAPH compiled;
+    CHECK(compiler.Compile(g.GetDesc(false), &compiled));
+    CHECK(compiled.passes.size() == 4);
+    if (compiled.passes.size() != 4)
+        return;
+
+    // トランジェントリソースは未定義の状態から遷移します。
+    auto barrier = FindBarrier(compiled, compiled.passes[0].pre_barriers, 2);
+    CHECK(barrier && barrier->src_state == b::RESOURCE_STATE_UNDEFINED && barrier->is_write && !barrier->is_initial_import);
+    CHECK(compiled.passes[0].pre_barriers.src_stages == b::PIPELINE_STAGE_FLAG_TOP_OF_PIPE);
+
+    // 書き込み -> 同じ状態での書き込み
+    barrier = FindBarrier(compiled, compiled.passes[1].pre_barriers, 2);
+    CHECK(barrier && barrier->src_state == b::RESOURCE_STATE_COPY_DST_WRITE && barrier->dst_state == b::RESOURCE_STATE_COPY_DST_WRITE && barrier->is_write);
+    CHECK(compiled.passes[1].pre_barriers.src_stages == b::PIPELINE_STAGE_FLAG_COPY_RESOLVE);
+
+    // インポートしたリソースの最初のバリアは、実行時に状態と書き込みを確認するため常に配置されます。
+    barrier = FindBarrier(compiled, compiled.passes[2].pre_barriers, 0);
+    CHECK(barrier && barrier->is_initial_import && barrier->is_write);
+
+    // 同じ状態での読み取りが連続する場合、バリアは不要です。 最後の状態は両方のステージを含みます。
+    CHECK(FindBarrier(compiled, compiled.passes[3].pre_barriers, 2) == nullptr);
+    CHECK(compiled.lifetimes[2].final_state == b::RESOURCE_STATE_SHADER_READ && !compiled.lifetimes[2].final_is_written);
+    CHECK(compiled.lifetimes[2].final_stages == (b::PIPELINE_STAGE_FLAG_PIXEL_SHADER | b::PIPELINE_STAGE_FLAG_COMPUTE_SHADER));
+    CHECK(compiled.lifetimes[1].final_is_written);
+}
+
+void TestCrossQueue()
+{
+    // 0: インポート、 1: グラフィックスで書き込み、非同期コンピュートで読み取り、 2: 非同期コンピュートで書き込み、グラフィックスで読み取り
+    GRAPH g;
+    g.resources = { { true }, { false }, { false } };
+    g.passes = {
+          { GRAPHICS, false, { Write(1, b::RESOURCE_STATE_COLOR_ATTACHMENT_WRITE, b::PIPELINE_STAGE_FLAG_COLOR_ATTACHMENT_OUTPUT) } }
+        , { ASYNC   , false, { Read(1, b::RESOURCE_STATE_SHADER_READ, b::PIPELINE_STAGE_FLAG_COMPUTE_SHADER), Write(2, b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COMPUTE_SHADER) } }
+        , { GRAPHICS, false, { Read(2, b::RESOURCE_STATE_SHADER_READ, b::PIPELINE_STAGE_FLAG_PIXEL_SHADER), Write(0, b::RESOURCE_STATE_COLOR_ATTACHMENT_WRITE, b::PIPELINE_STAGE_FLAG_COLOR_ATTACHMENT_OUTPUT) } }
+    };
+
+    buma::RenderGraphCompiler compiler;
+    buma::COMPILED_RENDER_GRAPH compiled;
+    CHECK(compiler.Compile(g.GetDesc(true), &compiled));
+    CHECK(compiled.passes.size() == 3);
+    if (compiled.passes.size() != 3)
+        return;
+    CHECK(compiled.passes[1].queue == ASYNC);
+
+    // 所有権の移動は、直前のキューでの解放とこのキューでの取得の2つのバリアです。
+    auto release = FindBarrier(compiled, compiled.passes[0].post_barriers, 1);
+    auto acquire = FindBarrier(compiled, compiled.passes[1].pre_barriers, 1);
+    CHECK(release && release->src_queue == GRAPHICS && release->dst_queue == ASYNC);
+    CHECK(acquire && acquire->src_queue == GRAPHICS && acquire->dst_queue == ASYNC);
+    CHECK(acquire && acquire->src_state == b::RESOURCE_STATE_COLOR_ATTACHMENT_WRITE && acquire->dst_state == b::RESOURCE_STATE_SHADER_READ);
+    CHECK(compiled.passes[0].post_barriers.src_stages == b::PIPELINE_STAGE_FLAG_COLOR_ATTACHMENT_OUTPUT);
+
+    release = FindBarrier(compiled, compiled.passes[1].post_barriers, 2);
+    acquire = FindBarrier(compiled, compiled.passes[2].pre_barriers, 2);
+    CHECK(release && release->src_queue == ASYNC && release->dst_queue == GRAPHICS);
+    CHECK(acquire && acquire->src_queue == ASYNC && acquire->dst_queue == GRAPHICS);
+
+    // グラフィックス(シグナル0) -> 非同期コンピュート(待機0、シグナル1) -> グラフィックス(待機1)
+    CHECK(compiled.num_sync_points == 2);
+    CHECK(compiled.batches.size() == 3);
+    if (compiled.batches.size() == 3)
+    {
+        auto&& b0 = compiled.batches[0];
+        auto&& b1 = compiled.batches[1];
+        auto&& b2 = compiled.batches[2];
+        CHECK(b0.queue == GRAPHICS && b0.passes == std::vector<uint32_t>{ 0 } && b0.wait_sync_points.empty() && b0.signal_sync_point == 0);
+        CHECK(b1.queue == ASYNC    && b1.passes == std::vector<uint32_t>{ 1 } && b1.wait_sync_points == std::vector<uint32_t>{ 0 } && b1.signal_sync_point == 1);
+        CHECK(b2.queue == GRAPHICS && b2.passes == std::vector<uint32_t>{ 2 } && b2.wait_sync_points == std::vector<uint32_t>{ 1 } && b2.signal_sync_point == ~0u);
+    }
+    CHECK(compiled.lifetimes[1].is_async && compiled.lifetimes[2].is_async);
+
+    // 非同期コンピュートが無効な場合、全てのパスはグラフィックスキューの1つのバッチで実行されます。
+    CHECK(compiler.Compile(g.GetDesc(false), &compiled));
+    CHECK(compiled.num_sync_points == 0 && compiled.batches.size() == 1);
+    for (auto& i : compiled.barriers)
+        CHECK(i.src_queue == GRAPHICS && i.dst_queue == GRAPHICS);
+    CHECK(!compiled.lifetimes[1].is_async);
+}
+
+void TestAssignMemory()
+{
+    // 0: インポート、 1 -> 2 -> 3 の順に生存期間が連続するトランジェントリソースです。 1と3の生存期間は重なりません。
+    GRAPH g;
+    g.resources = { { true }, { false }, { false }, { false } };
+    g.passes = {
+          { GRAPHICS, false, { Write(1, b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COPY_RESOLVE) } }
+        , { GRAPHICS, false, { Read(1, b::RESOURCE_STATE_SHADER_READ, b::PIPELINE_STAGE_FLAG_PIXEL_SHADER), Write(2, b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COPY_RESOLVE) } }
+        , { GRAPHICS, false, { Read(2, b::RESOURCE_STATE_SHADER_READ, b::PIPELINE_STAGE_FLAG_PIXEL_SHADER), Write(3, b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COPY_RESOLVE) } }
+        , { GRAPHICS, false, { Read(3, b::RESOURCE_STATE_SHADER_READ, b::PIPELINE_STAGE_FLAG_COMPUTE_SHADER), Write(0, b::RESOURCE_STATE_COLOR_ATTACHMENT_WRITE, b::PIPELINE_STAGE_FLAG_COLOR_ATTACHMENT_OUTPUT) } }
+    };
+    std::vector<buma::RENDER_GRAPH_MEMORY_REQUIREMENTS> requirements = { { 0, 0, 0 }, { 1000, 256, 1 }, { 1000, 256, 1 }, { 1000, 256, 1 } };
+
+    buma::RenderGraphCompiler compiler;
+    buma::COMPILED_RENDER_GRAPH compiled;
+    buma::RENDER_GRAPH_MEMORY_LAYOUT layout;
+    auto desc = g.GetDesc(false);
+    CHECK(compiler.Compile(desc, &compiled));
+    compiler.AssignMemory(desc, requirements.data(), &compiled, &layout);
+
+    CHECK(layout.heaps.size() == 1);
+    CHECK(layout.placements[0].heap == ~0u);
+    auto&& p1 = layout.placements[1];
+    auto&& p2 = layout.placements[2];
+    auto&& p3 = layout.placements[3];
+    CHECK(p1.heap == 0 && p2.heap == 0 && p3.heap == 0);
+
+    // 生存期間が重なるリソースのメモリは重ならず、重ならないリソースはメモリを共有します。
+    CHECK(p1.offset % 256 == 0 && p2.offset % 256 == 0 && p3.offset % 256 == 0);
+    CHECK(p1.offset + 1000 <= p2.offset || p2.offset + 1000 <= p1.offset);
+    CHECK(p2.offset + 1000 <= p3.offset || p3.offset + 1000 <= p2.offset);
+    CHECK(p1.offset == p3.offset);
+    CHECK(layout.unaliased_size_in_bytes == 3000);
+    CHECK(layout.total_size_in_bytes == 2024 && layout.heaps[0].size_in_bytes == 2024);
+
+    // 3は同じフレームで1の最後のアクセスを待機し、1は前のフレームでの3の最後のアクセスを待機します。
+    CHECK(compiled.passes[2].pre_barriers.src_stages & b::PIPELINE_STAGE_FLAG_PIXEL_SHADER);
+    CHECK(compiled.passes[0].pre_barriers.src_stages & b::PIPELINE_STAGE_FLAG_COMPUTE_SHADER);
+
+    // 異なるヒープの種類のリソースはエイリアシングされません。
+    requirements[3].heap_type_bits = 2;
+    CHECK(compiler.Compile(desc, &compiled));
+    compiler.AssignMemory(desc, requirements.data(), &compiled, &layout);
+    CHECK(layout.heaps.size() == 2 && layout.placements[3].heap != layout.placements[1].heap);
+    CHECK(layout.total_size_in_bytes == 2024 + 1000);
+}
+
+void TestErrors()
+{
+    GRAPH g;
+    g.resources = { { true }, { false } };
+    g.passes = { { GRAPHICS, false, { Write(2, b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COPY_RESOLVE) } } };
+
+    buma::RenderGraphCompiler compiler;
+    buma::COMPILED_RENDER_GRAPH compiled;
+    CHECK(!compiler.Compile(g.GetDesc(false), &compiled) && !compiler.GetErrorMessage().empty());
+
+    g.passes = { { GRAPHICS, false, { Write(0, b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COPY_RESOLVE), Read(0, b::RESOURCE_STATE_SHADER_READ, b::PIPELINE_STAGE_FLAG_PIXEL_SHADER) } } };
+    CHECK(!compiler.Compile(g.GetDesc(false), &compiled) && !compiler.GetErrorMessage().empty());
+
+    // インポートしたリソースはグラフィックスキューで取得する必要があります。
+    g.passes = { { ASYNC, false, { Write(0, b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COMPUTE_SHADER) } } };
+    CHECK(!compiler.Compile(g.GetDesc(true), &compiled) && !compiler.GetErrorMessage().empty());
+    CHECK(compiler.Compile(g.GetDesc(false), &compiled) && compiler.GetErrorMessage().empty());
+}
+
+}// namespace /*anonymous*/
+
+int main()
+{
+    TestCulling();
+    TestSameStateBarriers();
+    TestCrossQueue();
+    TestAssignMemory();
+    TestErrors();
+
+    if (num_failures != 0)
+    {
+        std::printf("RenderGraphCompilerTest: %d check(s) failed\n", num_failures);
+        return 1;
+    }
+    std::printf("RenderGraphCompilerTest: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,210 @@
+#include <DeviceResources/ResourceStateTracker.h>
+
+#include <cstdint>
+#include <cstdio>
+
+// ResourceStateTracker はリソースのメソッドを呼び出さないため、デバイスを作成せずにCPUのみでバリアの発行を検証します。
+
+namespace b = buma3d;
+
+#define CHECK(x)                                                                \
+    do {                                                                        \
+        if (!(x)) {                                                             \
+            std::printf("%s(%d): CHECK failed: %s\n", __FILE__, __LINE__, #x);  \
+            num_failures++;                                                     \
+        }                                                                       \
+    } while (false)
+
+namespace /*anonymous*/
+{
+
+int num_failures = 0;
+
+// トラッカーはリソースのポインタを記録するのみであるため、識別可能なアドレスを持つ偽のリソースを使用します。
+template<typename T>
+T* FakeResource(uintptr_t _id)
+{
+    return reinterpret_cast<T*>(_id * 0x100);
+}
+
+constexpr buma::SUBRESOURCE_STATE INITIAL_STATE = { b::RESOURCE_STATE_UNDEFINED     , b::PIPELINE_STAGE_FLAG_TOP_OF_PIPE    , false };
+constexpr buma::SUBRESOURCE_STATE COPY_DST      = { b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_COPY_RESOLVE   , true  };
+constexpr buma::SUBRESOURCE_STATE COPY_SRC      = { b::RESOURCE_STATE_COPY_SRC_READ , b::PIPELINE_STAGE_FLAG_COPY_RESOLVE   , false };
+constexpr buma::SUBRESOURCE_STATE SHADER_READ   = { b::RESOURCE_STATE_SHADER_READ   , b::PIPELINE_STAGE_FLAG_PIXEL_SHADER   , false };
+
+void TestBufferTransition()
+{
+    auto buffer = FakeResource<b::IBuffer>(1);
+    buma::ResourceStates states;
+    states.Init(1, 1, false, INITIAL_STATE);
+
+    buma::ResourceStateTracker tracker;
+    tracker.RequestBufferState(buffer, &states, COPY_DST);
+    auto barrier = tracker.Flush();
+    CHECK(barrier && barrier->num_buffer_barriers == 1 && barrier->num_texture_barriers == 0);
+    if (barrier && barrier->num_buffer_barriers == 1)
+    {
+        CHECK(barrier->buffer_barriers[0].buffer    == buffer);
+        CHECK(barrier->buffer_barriers[0].src_state == b::RESOURCE_STATE_UNDEFINED);
+        CHECK(barrier->buffer_barriers[0].dst_state == b::RESOURCE_STATE_COPY_DST_WRITE);
+        CHECK(barrier->src_stages == b::PIPELINE_STAGE_FLAG_TOP_OF_PIPE);
+        CHECK(barrier->dst_stages == b::PIPELINE_STAGE_FLAG_COPY_RESOLVE);
+    }
+    CHECK(states.Get(0, 0, 0) == COPY_DST);
+    CHECK(!tracker.HasPendingBarriers() && !states.HasPendingState());
+}
+
+void TestSameStateReads()
+{
+    // 同じ状態での読み取りが連続する場合、バリアは発行されず、アクセスするステージが追加されます。
+    auto buffer = FakeResource<b::IBuffer>(1);
+    buma::ResourceStates states;
+    states.Init(1, 1, false, SHADER_READ);
+
+    buma::ResourceStateTracker tracker;
+    tracker.RequestBufferState(buffer, &states, { b::RESOURCE_STATE_SHADER_READ, b::PIPELINE_STAGE_FLAG_COPY_RESOLVE, false });
+    CHECK(tracker.Flush() == nullptr);
+    CHECK(states.Get(0, 0, 0).stages == (b::PIPELINE_STAGE_FLAG_PIXEL_SHADER | b::PIPELINE_STAGE_FLAG_COPY_RESOLVE));
+}
+
+void TestSameStateWrites()
+{
+    // 同じ状態でも、書き込みの前後にはバリアが必要です。
+    auto buffer = FakeResource<b::IBuffer>(1);
+    buma::ResourceStates states;
+    states.Init(1, 1, false, INITIAL_STATE);
+
+    buma::ResourceStateTracker tracker;
+    tracker.RequestBufferState(buffer, &states, COPY_DST);
+    tracker.Flush();
+
+    // 書き込み -> 書き込み
+    tracker.RequestBufferState(buffer, &states, COPY_DST);
+    auto barrier = tracker.Flush();
+    CHECK(barrier && barrier->num_buffer_barriers == 1);
+    if (barrier && barrier->num_buffer_barriers == 1)
+    {
+        CHECK(barrier->buffer_barriers[0].src_state == b::RESOURCE_STATE_COPY_DST_WRITE);
+        CHECK(barrier->buffer_barriers[0].dst_state == b::RESOURCE_STATE_COPY_DST_WRITE);
+        CHECK(barrier->src_stages == b::PIPELINE_STAGE_FLAG_COPY_RESOLVE);
+        CHECK(barrier->dst_stages == b::PIPELINE_STAGE_FLAG_COPY_RESOLVE);
+    }
+
+    // 書き込み -> 同じ状態での読み取り
+    buma::SUBRESOURCE_STATE read = { b::RESOURCE_STATE_COPY_DST_WRITE, b::PIPELINE_STAGE_FLAG_PIXEL_SHADER, false };
+    tracker.RequestBufferState(buffer, &states, read);
+    barrier = tracker.Flush();
+    CHECK(barrier && barrier->num_buffer_barriers == 1);
+    CHECK(states.Get(0, 0, 0) == read);
+
+    // 読み取り -> 同じ状態での書き込み
+    tracker.RequestBufferState(buffer, &states, COPY_DST);
+    barrier = tracker.Flush();
+    CHECK(barrier && barrier->num_buffer_barriers == 1);
+    if (barrier)
+        CHECK(barrier->src_stages == b::PIPELINE_STAGE_FLAG_PIXEL_SHADER);
+
+    // 書き込み後の状態は、最初の読み取りの前にバリアを必要とします。
+    tracker.RequestBufferState(buffer, &states, read);
+    CHECK(tracker.Flush() != nullptr);
+    tracker.RequestBufferState(buffer, &states, read);
+    CHECK(tracker.Flush() == nullptr);
+}
+
+void TestCollapsedRequests()
+{
+    // フラッシュまでの要求は最初の状態から最後の状態への1つの遷移にまとめられます。
+    auto buffer = FakeResource<b::IBuffer>(1);
+    buma::ResourceStates states;
+    states.Init(1, 1, false, COPY_SRC);
+
+    buma::ResourceStateTracker tracker;
+    tracker.RequestBufferState(buffer, &states, SHADER_READ);
+    tracker.RequestBufferState(buffer, &states, COPY_SRC);
+    CHECK(tracker.Flush() == nullptr);
+
+    tracker.RequestBufferState(buffer, &states, SHADER_READ);
+    tracker.Discard();
+    CHECK(!states.HasPendingState());
+    CHECK(states.Get(0, 0, 0) == COPY_SRC);
+}
+
+void TestTextureRanges()
+{
+    auto texture = FakeResource<b::ITexture>(2);
+    buma::ResourceStates states;
+    states.Init(3, 4, false, INITIAL_STATE);
+
+    buma::ResourceStateTracker tracker;
+    tracker.RequestTextureState(texture, &states, COPY_DST);
+    auto barrier = tracker.Flush();
+    CHECK(barrier && barrier->num_texture_barriers == 1);
+    if (barrier && barrier->num_texture_barriers == 1)
+    {
+        // 全てのサブリソースは1つの範囲に結合されます。
+        auto&& range = *barrier->texture_barriers[0].barrier_range;
+        CHECK(range.texture == texture);
+        CHECK(range.num_subresource_ranges == 1);
+        CHECK(range.subresource_ranges[0].mip_levels == 3 && range.subresource_ranges[0].array_size == 4);
+    }
+
+    // 配列スライス1から3のミップ1、2を読み取り、全ての配列スライスのミップ0に書き込みます。 残りのサブリソースにはバリアを発行しません。
+    tracker.RequestTextureState(texture, &states, { { b::TEXTURE_ASPECT_FLAG_COLOR, 1, 1 }, 3, b::B3D_USE_REMAINING_MIP_LEVELS }, SHADER_READ);
+    tracker.RequestTextureState(texture, &states, { { b::TEXTURE_ASPECT_FLAG_COLOR, 0, 0 }, ~0u, 1 }, COPY_DST);
+    barrier = tracker.Flush();
+    CHECK(barrier && barrier->num_texture_barriers == 2);
+    uint32_t num_ranges = 0;
+    for (uint32_t i = 0; barrier && i < barrier->num_texture_barriers; i++)
+    {
+        auto&& tb    = barrier->texture_barriers[i];
+        auto&& range = *tb.barrier_range;
+        CHECK(tb.src_state == b::RESOURCE_STATE_COPY_DST_WRITE);
+        CHECK(range.num_subresource_ranges == 1);
+        auto&& r = range.subresource_ranges[0];
+        if (tb.dst_state == b::RESOURCE_STATE_SHADER_READ)
+            CHECK(r.offset.mip_slice == 1 && r.mip_levels == 2 && r.offset.array_slice == 1 && r.array_size == 3);
+        else
+            CHECK(tb.dst_state == b::RESOURCE_STATE_COPY_DST_WRITE && r.offset.mip_slice == 0 && r.mip_levels == 1 && r.offset.array_slice == 0 && r.array_size == 4);
+        num_ranges += range.num_subresource_ranges;
+    }
+    CHECK(num_ranges == 2);
+    CHECK(states.Get(0, 1, 0) == COPY_DST);
+    CHECK(states.Get(0, 2, 3) == SHADER_READ);
+}
+
+void TestDepthStencilAspects()
+{
+    auto texture = FakeResource<b::ITexture>(3);
+    buma::ResourceStates states;
+    states.Init(1, 1, true, INITIAL_STATE);
+    CHECK(states.GetNumAspects() == 2 && states.GetNumSubresources() == 2);
+
+    buma::ResourceStateTracker tracker;
+    tracker.RequestTextureState(texture, &states, { { b::TEXTURE_ASPECT_FLAG_STENCIL, 0, 0 }, 1, 1 }, SHADER_READ);
+    auto barrier = tracker.Flush();
+    CHECK(barrier && barrier->num_texture_barriers == 1);
+    if (barrier && barrier->num_texture_barriers == 1)
+        CHECK(barrier->texture_barriers[0].barrier_range->subresource_ranges[0].offset.aspect == b::TEXTURE_ASPECT_FLAG_STENCIL);
+    CHECK(states.Get(0, 0, 0) == INITIAL_STATE);
+    CHECK(states.Get(1, 0, 0) == SHADER_READ);
+}
+
+}// namespace /*anonymous*/
+
+int main()
+{
+    TestBufferTransition();
+    TestSameStateReads();
+    TestSameStateWrites();
+    TestCollapsedRequests();
+    TestTextureRanges();
+    TestDepthStencilAspects();
+
+    if (num_failures != 0)
+    {
+        std::printf("ResourceStateTrackerTest: %d check(s) failed\n", num_failures);
+        return 1;
+    }
+    std::printf("ResourceStateTrackerTest: all checks passed\n");
+    return 0;
+}
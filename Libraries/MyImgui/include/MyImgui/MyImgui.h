@@ -40,6 +40,11 @@ struct MYIMGUI_CREATE_DESC
     int                         config_flags;  // ImGuiConfigFlags
     buma3d::RESOURCE_FORMAT     framebuffer_format;
     MYIMGUI_CREATE_FLAGS        flags;
+
+    // フォントファイルのデータです。 nullptrの場合 "Assets/font/NotoSansJP-Regular.otf" から読み込みます。
+    // データはコピーされないため、MyImGuiが破棄されるまで有効である必要があります。
+    const void*                 font_data;
+    size_t                      font_data_size;
 };
 
 class MyImGui
@@ -264,7 +264,17 @@ bool MyImGui::MyImGuiImpl::BuildTextureAtlas()
 {
     auto&& io = ImGui::GetIO();
 
-    ImFont* font = io.Fonts->AddFontFromFileTTF("Assets/font/NotoSansJP-Regular.otf", 16.0f, NULL, io.Fonts->GetGlyphRangesJapanese());
+    ImFont* font{};
+    if (desc.font_data)
+    {
+        ImFontConfig font_cfg{};
+        font_cfg.FontDataOwnedByAtlas = false;
+        font = io.Fonts->AddFontFromMemoryTTF(const_cast<void*>(desc.font_data), (int)desc.font_data_size, 16.0f, &font_cfg, io.Fonts->GetGlyphRangesJapanese());
+    }
+    else
+    {
+        font = io.Fonts->AddFontFromFileTTF("Assets/font/NotoSansJP-Regular.otf", 16.0f, NULL, io.Fonts->GetGlyphRangesJapanese());
+    }
     IM_ASSERT(font != NULL);
 
     // アライメントのためにpixel_dataのデータをmemにコピー
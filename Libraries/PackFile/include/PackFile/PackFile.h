@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace buma
+{
+namespace util
+{
+class MappedFile;
+}
+
+namespace pack
+{
+
+/*
+パックファイルのレイアウト:
+    PACK_FILE_HEADER
+    エントリデータ (各エントリは PACK_FILE_HEADER::data_alignment にアライメントされます)
+    文字列テーブル (正規化されたパス、null終端)
+    PACK_FILE_ENTRY[num_entries] (path_hash の昇順)
+*/
+
+constexpr uint32_t PACK_FILE_MAGIC   = 0x4B504D42; // "BMPK"
+constexpr uint32_t PACK_FILE_VERSION = 1;
+
+enum PACK_COMPRESSION : uint32_t
+{
+      PACK_COMPRESSION_NONE
+    , PACK_COMPRESSION_DEFLATE // zlib (stb)
+};
+
+struct PACK_FILE_HEADER
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_entries;
+    uint32_t data_alignment;
+    uint64_t index_offset;
+    uint64_t string_table_offset;
+    uint64_t string_table_size;
+};
+static_assert(sizeof(PACK_FILE_HEADER) == 40);
+
+struct PACK_FILE_ENTRY
+{
+    uint64_t path_hash;
+    uint64_t data_offset;
+    uint64_t stored_size;   // ファイル内のサイズ
+    uint64_t original_size; // 展開後のサイズ
+    uint32_t path_offset;   // 文字列テーブル内のオフセット
+    uint32_t path_length;
+    uint32_t compression;   // PACK_COMPRESSION
+    uint32_t reserved;
+};
+static_assert(sizeof(PACK_FILE_ENTRY) == 48);
+
+// 区切り文字を'/'に統一し、先頭の"./"を取り除き、ASCII文字を小文字に変換します。
+std::string NormalizePath(const char* _path);
+
+// 正規化済みのパスのFNV-1aハッシュです。
+uint64_t HashPath(const char* _normalized_path, size_t _length);
+
+class PackFileReader
+{
+public:
+    ~PackFileReader();
+
+    static std::unique_ptr<PackFileReader> Open(const char* _filename);
+
+    // パスを正規化してエントリを検索します。 見つからない場合nullptrを返します。
+    const PACK_FILE_ENTRY*  Find(const char* _path) const;
+    bool                    Contains(const char* _path) const { return Find(_path) != nullptr; }
+
+    // 非圧縮のエントリの場合、マップされたデータを直接返します。 圧縮されている場合nullptrを返します。
+    const void*             GetMappedData(const PACK_FILE_ENTRY* _entry) const;
+
+    // エントリを展開して _dst にコピーします。
+    bool                    Read(const PACK_FILE_ENTRY* _entry, std::vector<uint8_t>* _dst) const;
+    bool                    Read(const char* _path, std::vector<uint8_t>* _dst) const;
+
+    const char*             GetPath(const PACK_FILE_ENTRY* _entry) const;
+    uint32_t                GetNumEntries() const;
+    const PACK_FILE_ENTRY*  GetEntries() const { return entries; }
+
+private:
+    PackFileReader();
+    bool Init(const char* _filename);
+    void BuildBuckets();
+
+private:
+    std::unique_ptr<util::MappedFile>   file;
+    const PACK_FILE_HEADER*             header;
+    const PACK_FILE_ENTRY*              entries;
+    const char*                         string_table;
+
+    // ハッシュ上位 bucket_bits ビットから、エントリ範囲の開始インデックスを引くテーブルです。
+    std::vector<uint32_t>               buckets;
+    uint32_t                            bucket_bits;
+
+};
+
+struct PACK_FILE_WRITER_DESC
+{
+    size_t  data_alignment;         // set 0 to use 16
+    bool    enable_compression;
+    int     compression_level;      // zlib quality (stb), set 0 to use 8
+    float   min_compression_ratio;  // 圧縮後のサイズ/元のサイズ がこの値を上回る場合、非圧縮で格納します。 set 0 to use 0.9
+};
+
+class PackFileWriter
+{
+public:
+    PackFileWriter(const PACK_FILE_WRITER_DESC& _desc);
+    ~PackFileWriter();
+
+    bool AddFile(const char* _path_in_pack, const char* _filename);
+    bool AddData(const char* _path_in_pack, const void* _data, size_t _size_in_bytes);
+
+    bool Write(const char* _output_filename);
+
+private:
+    struct ENTRY_DATA
+    {
+        std::string             path;
+        uint64_t                hash;
+        PACK_COMPRESSION        compression;
+        uint64_t                original_size;
+        std::vector<uint8_t>    data;
+    };
+
+private:
+    PACK_FILE_WRITER_DESC   desc;
+    std::vector<ENTRY_DATA> entries;
+
+};
+
+
+}// namespace pack
+}// namespace buma
@@ -0,0 +1,359 @@
+#include <PackFile/PackFile.h>
+#include "./PackFileCompression.h"
+
+#include <Utils/MappedFile.h>
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+namespace buma
+{
+namespace pack
+{
+
+namespace /*anonymous*/
+{
+
+constexpr size_t DEFAULT_DATA_ALIGNMENT     = 16;
+constexpr int    DEFAULT_COMPRESSION_LEVEL  = 8;
+constexpr float  DEFAULT_COMPRESSION_RATIO  = 0.9f;
+constexpr uint32_t MAX_BUCKET_BITS          = 16;
+
+inline uint64_t AlignUp(uint64_t _val, uint64_t _alignment)
+{
+    return (_val + (_alignment - 1)) & ~(_alignment - 1);
+}
+
+inline bool IsPow2(size_t _val)
+{
+    return _val != 0 && (_val & (_val - 1)) == 0;
+}
+
+inline uint32_t GetBucketIndex(uint64_t _hash, uint32_t _bucket_bits)
+{
+    return _bucket_bits == 0 ? 0 : static_cast<uint32_t>(_hash >> (64 - _bucket_bits));
+}
+
+
+}// namespace /*anonymous*/
+
+std::string NormalizePath(const char* _path)
+{
+    std::string result(_path);
+    for (auto& i : result)
+    {
+        if (i == '\\')
+            i = '/';
+        else if (i >= 'A' && i <= 'Z')
+            i = static_cast<char>(i - 'A' + 'a');
+    }
+
+    while (result.compare(0, 2, "./") == 0)
+        result.erase(0, 2);
+
+    return result;
+}
+
+uint64_t HashPath(const char* _normalized_path, size_t _length)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < _length; i++)
+    {
+        hash ^= static_cast<uint8_t>(_normalized_path[i]);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+#pragma region PackFileReader
+
+PackFileReader::PackFileReader()
+    : file          {}
+    , header        {}
+    , entries       {}
+    , string_table  {}
+    , buckets       {}
+    , bucket_bits   {}
+{
+}
+
+PackFileReader::~PackFileReader()
+{
+}
+
+std::unique_ptr<PackFileReader> PackFileReader::Open(const char* _filename)
+{
+    std::unique_ptr<PackFileReader> result(new PackFileReader());
+    if (!result->Init(_filename))
+        return nullptr;
+
+    return result;
+}
+
+bool PackFileReader::Init(const char* _filename)
+{
+    file = util::MappedFile::Open(_filename);
+    if (!file)
+        return false;
+
+    auto data = file->GetData();
+    auto size = file->GetSize();
+    if (size < sizeof(PACK_FILE_HEADER))
+        return false;
+
+    header = reinterpret_cast<const PACK_FILE_HEADER*>(data);
+    if (header->magic != PACK_FILE_MAGIC || header->version != PACK_FILE_VERSION)
+        return false;
+
+    auto index_size = static_cast<uint64_t>(header->num_entries) * sizeof(PACK_FILE_ENTRY);
+    if (header->index_offset > size || index_size > size - header->index_offset)
+        return false;
+    if (header->string_table_offset > size || header->string_table_size > size - header->string_table_offset)
+        return false;
+
+    entries      = reinterpret_cast<const PACK_FILE_ENTRY*>(data + header->index_offset);
+    string_table = reinterpret_cast<const char*>(data + header->string_table_offset);
+
+    for (uint32_t i = 0; i < header->num_entries; i++)
+    {
+        auto&& e = entries[i];
+        if (e.data_offset > size || e.stored_size > size - e.data_offset)
+            return false;
+        // 非圧縮のエントリは original_size をそのまま読み取るため、格納されたサイズと一致する必要があります。
+        if (e.compression == PACK_COMPRESSION_NONE && e.original_size != e.stored_size)
+            return false;
+        if (static_cast<uint64_t>(e.path_offset) + e.path_length >= header->string_table_size)
+            return false;
+        if (i != 0 && entries[i - 1].path_hash > e.path_hash)
+            return false;
+    }
+
+    BuildBuckets();
+    return true;
+}
+
+void PackFileReader::BuildBuckets()
+{
+    // エントリ数程度のバケットを用意し、平均O(1)で検索できるようにします。
+    bucket_bits = 0;
+    while (bucket_bits < MAX_BUCKET_BITS && (1u << bucket_bits) < header->num_entries)
+        bucket_bits++;
+
+    auto num_buckets = 1u << bucket_bits;
+    buckets.resize(num_buckets + 1);
+
+    uint32_t entry_index = 0;
+    for (uint32_t b = 0; b < num_buckets; b++)
+    {
+        while (entry_index < header->num_entries && GetBucketIndex(entries[entry_index].path_hash, bucket_bits) < b)
+            entry_index++;
+        buckets[b] = entry_index;
+    }
+    buckets[num_buckets] = header->num_entries;
+}
+
+const PACK_FILE_ENTRY* PackFileReader::Find(const char* _path) const
+{
+    auto path = NormalizePath(_path);
+    auto hash = HashPath(path.c_str(), path.size());
+
+    auto b = GetBucketIndex(hash, bucket_bits);
+    for (uint32_t i = buckets[b], end = buckets[b + 1]; i < end; i++)
+    {
+        auto&& e = entries[i];
+        if (e.path_hash < hash)
+            continue;
+        if (e.path_hash > hash)
+            break;
+
+        if (e.path_length == path.size() && std::memcmp(string_table + e.path_offset, path.c_str(), path.size()) == 0)
+            return &e;
+    }
+
+    return nullptr;
+}
+
+const void* PackFileReader::GetMappedData(const PACK_FILE_ENTRY* _entry) const
+{
+    if (!_entry || _entry->compression != PACK_COMPRESSION_NONE)
+        return nullptr;
+
+    return file->GetData() + _entry->data_offset;
+}
+
+bool PackFileReader::Read(const PACK_FILE_ENTRY* _entry, std::vector<uint8_t>* _dst) const
+{
+    if (!_entry)
+        return false;
+
+    auto src = file->GetData() + _entry->data_offset;
+    _dst->resize(static_cast<size_t>(_entry->original_size));
+    switch (_entry->compression)
+    {
+    case PACK_COMPRESSION_NONE:
+        std::memcpy(_dst->data(), src, _dst->size());
+        return true;
+
+    case PACK_COMPRESSION_DEFLATE:
+        return DecompressDeflate(src, static_cast<size_t>(_entry->stored_size), _dst->data(), _dst->size());
+
+    default:
+        return false;
+    }
+}
+
+bool PackFileReader::Read(const char* _path, std::vector<uint8_t>* _dst) const
+{
+    return Read(Find(_path), _dst);
+}
+
+const char* PackFileReader::GetPath(const PACK_FILE_ENTRY* _entry) const
+{
+    return string_table + _entry->path_offset;
+}
+
+uint32_t PackFileReader::GetNumEntries() const
+{
+    return header->num_entries;
+}
+
+#pragma endregion PackFileReader
+
+#pragma region PackFileWriter
+
+PackFileWriter::PackFileWriter(const PACK_FILE_WRITER_DESC& _desc)
+    : desc      { _desc }
+    , entries   {}
+{
+    if (desc.data_alignment == 0)
+        desc.data_alignment = DEFAULT_DATA_ALIGNMENT;
+    if (desc.compression_level == 0)
+        desc.compression_level = DEFAULT_COMPRESSION_LEVEL;
+    if (desc.min_compression_ratio == 0.f)
+        desc.min_compression_ratio = DEFAULT_COMPRESSION_RATIO;
+}
+
+PackFileWriter::~PackFileWriter()
+{
+}
+
+bool PackFileWriter::AddFile(const char* _path_in_pack, const char* _filename)
+{
+    std::ifstream ifs(_filename, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!ifs.is_open())
+        return false;
+
+    std::vector<uint8_t> data(static_cast<size_t>(ifs.tellg()));
+    ifs.seekg(0, std::ios::beg);
+    ifs.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (ifs.fail())
+        return false;
+
+    return AddData(_path_in_pack, data.data(), data.size());
+}
+
+bool PackFileWriter::AddData(const char* _path_in_pack, const void* _data, size_t _size_in_bytes)
+{
+    auto&& e = entries.emplace_back();
+    e.path          = NormalizePath(_path_in_pack);
+    e.hash          = HashPath(e.path.c_str(), e.path.size());
+    e.compression   = PACK_COMPRESSION_NONE;
+    e.original_size = _size_in_bytes;
+
+    auto src = static_cast<const uint8_t*>(_data);
+    if (desc.enable_compression && _size_in_bytes != 0)
+    {
+        std::vector<uint8_t> compressed;
+        if (CompressDeflate(src, _size_in_bytes, desc.compression_level, &compressed) &&
+            static_cast<float>(compressed.size()) <= static_cast<float>(_size_in_bytes) * desc.min_compression_ratio)
+        {
+            e.compression = PACK_COMPRESSION_DEFLATE;
+            e.data        = std::move(compressed);
+            return true;
+        }
+    }
+
+    e.data.assign(src, src + _size_in_bytes);
+    return true;
+}
+
+bool PackFileWriter::Write(const char* _output_filename)
+{
+    if (!IsPow2(desc.data_alignment))
+        return false;
+
+    std::sort(entries.begin(), entries.end(), [](const ENTRY_DATA& _a, const ENTRY_DATA& _b) { return _a.hash < _b.hash; });
+    for (size_t i = 1; i < entries.size(); i++)
+    {
+        // 同一パスの重複、またはハッシュの衝突は許可しません。
+        if (entries[i - 1].hash == entries[i].hash)
+            return false;
+    }
+
+    std::ofstream ofs(_output_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open())
+        return false;
+
+    PACK_FILE_HEADER header{};
+    header.magic          = PACK_FILE_MAGIC;
+    header.version        = PACK_FILE_VERSION;
+    header.num_entries    = static_cast<uint32_t>(entries.size());
+    header.data_alignment = static_cast<uint32_t>(desc.data_alignment);
+
+    std::vector<PACK_FILE_ENTRY> index(entries.size());
+    std::string                  string_table;
+
+    const char zeros[256]{};
+    auto WritePadding = [&](uint64_t _offset, uint64_t _aligned_offset)
+    {
+        for (auto remain = _aligned_offset - _offset; remain != 0;)
+        {
+            auto n = (std::min)(remain, static_cast<uint64_t>(sizeof(zeros)));
+            ofs.write(zeros, static_cast<std::streamsize>(n));
+            remain -= n;
+        }
+    };
+
+    uint64_t offset = sizeof(PACK_FILE_HEADER);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        auto&& e = entries[i];
+        auto aligned_offset = AlignUp(offset, desc.data_alignment);
+        WritePadding(offset, aligned_offset);
+        ofs.write(reinterpret_cast<const char*>(e.data.data()), static_cast<std::streamsize>(e.data.size()));
+
+        auto&& ie = index[i];
+        ie.path_hash     = e.hash;
+        ie.data_offset   = aligned_offset;
+        ie.stored_size   = e.data.size();
+        ie.original_size = e.original_size;
+        ie.path_offset   = static_cast<uint32_t>(string_table.size());
+        ie.path_length   = static_cast<uint32_t>(e.path.size());
+        ie.compression   = e.compression;
+
+        string_table.append(e.path.c_str(), e.path.size() + 1);
+        offset = aligned_offset + e.data.size();
+    }
+
+    header.string_table_offset = offset;
+    header.string_table_size   = string_table.size();
+    ofs.write(string_table.data(), static_cast<std::streamsize>(string_table.size()));
+    offset += string_table.size();
+
+    header.index_offset = AlignUp(offset, alignof(PACK_FILE_ENTRY));
+    WritePadding(offset, header.index_offset);
+    ofs.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(PACK_FILE_ENTRY)));
+
+    ofs.seekp(0, std::ios::beg);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    return !ofs.fail();
+}
+
+#pragma endregion PackFileWriter
+
+
+}// namespace pack
+}// namespace buma
@@ -0,0 +1,52 @@
+#include "./PackFileCompression.h"
+
+// TextureLoads等の他のライブラリと実装が重複しないように、stbの関数は全てこの翻訳単位内のstaticとして定義します。
+#define STB_IMAGE_STATIC
+#define STBI_ONLY_PNG
+#define STBI_NO_STDIO
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#define STB_IMAGE_WRITE_STATIC
+#define STBI_WRITE_NO_STDIO
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+namespace buma
+{
+namespace pack
+{
+
+bool CompressDeflate(const uint8_t* _src, size_t _src_size, int _level, std::vector<uint8_t>* _dst)
+{
+    if (_src_size > static_cast<size_t>(INT_MAX))
+        return false;
+
+    int out_len = 0;
+    auto out = stbi_zlib_compress(const_cast<uint8_t*>(_src), static_cast<int>(_src_size), &out_len, _level);
+    if (!out)
+        return false;
+
+    _dst->resize(static_cast<size_t>(out_len));
+    std::memcpy(_dst->data(), out, static_cast<size_t>(out_len));
+    STBIW_FREE(out);
+    return true;
+}
+
+bool DecompressDeflate(const uint8_t* _src, size_t _src_size, uint8_t* _dst, size_t _dst_size)
+{
+    if (_src_size > static_cast<size_t>(INT_MAX) || _dst_size > static_cast<size_t>(INT_MAX))
+        return false;
+
+    auto result = stbi_zlib_decode_buffer(reinterpret_cast<char*>(_dst), static_cast<int>(_dst_size)
+                                          , reinterpret_cast<const char*>(_src), static_cast<int>(_src_size));
+    return result == static_cast<int>(_dst_size);
+}
+
+
+}// namespace pack
+}// namespace buma
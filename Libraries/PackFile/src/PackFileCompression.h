@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace buma
+{
+namespace pack
+{
+
+bool CompressDeflate(const uint8_t* _src, size_t _src_size, int _level, std::vector<uint8_t>* _dst);
+bool DecompressDeflate(const uint8_t* _src, size_t _src_size, uint8_t* _dst, size_t _dst_size);
+
+
+}// namespace pack
+}// namespace buma
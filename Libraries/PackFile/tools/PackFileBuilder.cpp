@@ -0,0 +1,122 @@
+#include <PackFile/PackFile.h>
+
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <algorithm>
+
+namespace /*anonymous*/
+{
+
+void PrintUsage()
+{
+    std::cout <<
+R"(Usage: PackFileBuilder <output> <root directory> [options]
+    <root directory> 以下の全てのファイルを、<root directory> からの相対パスをキーとして <output> に格納します。
+
+--compress
+    各エントリをzlibで圧縮します。 圧縮率が低いエントリは非圧縮で格納されます。
+
+--alignment <alignment>
+    各エントリのデータのアライメントを指定します。 2の累乗である必要があります。 デフォルトは 16 です。
+
+--extension <extension>
+    指定した拡張子のファイルのみを格納します。 複数回指定できます。 (例: --extension .hlsl --extension .png)
+)";
+}
+
+// 文字列全体が2の累乗の整数である場合のみ成功します。
+bool ParseAlignment(const char* _str, size_t* _alignment)
+{
+    std::string_view str = _str;
+    uint32_t value = 0;
+    auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (ec != std::errc() || ptr != str.data() + str.size())
+        return false;
+
+    if (value == 0 || (value & (value - 1)) != 0)
+        return false;
+
+    *_alignment = value;
+    return true;
+}
+
+
+}// namespace /*anonymous*/
+
+int main(int _argc, char* _argv[])
+{
+    namespace fs = std::filesystem;
+
+    if (_argc < 3)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    fs::path output = _argv[1];
+    fs::path root   = _argv[2];
+
+    buma::pack::PACK_FILE_WRITER_DESC desc{};
+    std::vector<std::string> extensions;
+    for (int i = 3; i < _argc; i++)
+    {
+        std::string arg = _argv[i];
+             if (arg == "--compress")                   desc.enable_compression = true;
+        else if (arg == "--extension" && i + 1 < _argc) extensions.emplace_back(_argv[++i]);
+        else if (arg == "--alignment" && i + 1 < _argc)
+        {
+            if (!ParseAlignment(_argv[++i], &desc.data_alignment))
+            {
+                std::cerr << "invalid alignment: " << _argv[i] << std::endl;
+                PrintUsage();
+                return 1;
+            }
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (!fs::is_directory(root))
+    {
+        std::cerr << root.string() << " is not a directory" << std::endl;
+        return 1;
+    }
+
+    buma::pack::PackFileWriter writer(desc);
+    size_t num_files = 0;
+    for (auto&& i : fs::recursive_directory_iterator(root))
+    {
+        if (!i.is_regular_file())
+            continue;
+
+        if (fs::exists(output) && fs::equivalent(i.path(), output))
+            continue;
+
+        if (!extensions.empty() && std::find(extensions.begin(), extensions.end(), i.path().extension().string()) == extensions.end())
+            continue;
+
+        auto key = fs::relative(i.path(), root).generic_string();
+        if (!writer.AddFile(key.c_str(), i.path().string().c_str()))
+        {
+            std::cerr << "failed to add " << i.path().string() << std::endl;
+            return 1;
+        }
+        num_files++;
+    }
+
+    if (!writer.Write(output.string().c_str()))
+    {
+        std::cerr << "failed to write " << output.string() << std::endl;
+        return 1;
+    }
+
+    std::cout << "packed " << num_files << " files into " << output.string() << std::endl;
+    return 0;
+}
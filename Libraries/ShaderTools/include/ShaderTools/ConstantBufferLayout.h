@@ -0,0 +1,30 @@
+#pragma once
+
+#include <ShaderTools/ShaderReflectionData.h>
+
+#include <cstdint>
+#include <string>
+
+namespace buma
+{
+namespace shader
+{
+
+struct CONSTANT_BUFFER_HEADER_DESC
+{
+    uint32_t                                num_reflections;
+    const ShaderReflectionData* const*      reflections;        // 同じ名前の定数バッファは1度だけ出力されます。 パイプラインの全ステージを指定できます。
+    const char*                             namespace_name;     // 省略可能です。 nullptrの場合名前空間で囲いません。
+    const char*                             source_name;        // 省略可能です。 生成元としてコメントに出力されます。
+};
+
+// 定数バッファ(cbuffer)のレイアウトから、HLSLのパッキング規則に従ってパディングされたC++の構造体を定義するヘッダを生成します。
+// 各構造体は sizeof が定数バッファのサイズと一致するため、マップされた領域へそのままコピーできます。
+// 各変数のオフセットとサイズは FIELD_OFFSETS 、 FIELD_SIZES (FIELD 列挙型でインデックス) として出力され、変更されたフィールドのみの書き込みに使用できます。
+// 16バイト境界に配置される要素を持つ配列等、C++の型で表現できない変数はバイト配列として出力されます。
+// 同じ名前の定数バッファのサイズが異なる場合falseを返します。
+bool GenerateConstantBufferHeader(const CONSTANT_BUFFER_HEADER_DESC& _desc, std::string* _dst);
+
+
+}// namespace shader
+}// namespace buma
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace buma
+{
+namespace shader
+{
+
+// インクルードファイルの内容のメモリ上のキャッシュです。
+// ShaderLoader::CompileBatch はバッチ毎に作成して全てのワーカーで共有するため、同じファイルはバッチ内で一度だけ読み込まれます。
+// バッチを跨いで共有する場合、ファイルの変更は Invalidate() が呼び出されるまで反映されません。
+// 全ての関数はスレッドセーフです。
+class IncludeCache
+{
+public:
+    struct FILE
+    {
+        std::string content;
+        uint64_t    content_hash;   // SHADER_DEPENDENCY::content_hash と同じハッシュです。
+    };
+
+public:
+    IncludeCache();
+    ~IncludeCache();
+
+    // _path は正規化されたUTF-8のパスです。 ファイルが存在しない場合nullptrを返します。
+    // 返された内容はキャッシュから削除された後も、参照が存在する間有効です。
+    std::shared_ptr<const FILE> Load(const std::string& _path);
+
+    void Invalidate(const std::string& _path);
+    void Clear();
+
+    // IncludeHandler が受け取ったパスを、キャッシュと依存関係のキーとして使用する形式に変換します。
+    static std::string NormalizePath(const std::string& _path);
+
+private:
+    IncludeCache(const IncludeCache&) = delete;
+    IncludeCache& operator=(const IncludeCache&) = delete;
+
+private:
+    std::mutex                                                      mutex;
+    std::unordered_map<std::string, std::shared_ptr<const FILE>>    files;
+
+};
+
+
+}// namespace shader
+}// namespace buma
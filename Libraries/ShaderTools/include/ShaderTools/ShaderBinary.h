@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+namespace buma
+{
+namespace util
+{
+class MappedFile;
+}
+
+namespace shader
+{
+
+// コンパイル済みシェーダ(DXIL/SPIR-V)のバイナリです。
+// ファイルはメモリにマップされ、GetData() はマップされた領域を直接参照するため、読み込み時にコピーは発生しません。
+// マップできない場合は一度の読み込みで内部のバッファに格納します。
+// 返されるポインタは SHADER_MODULE_DESC::bytecode にそのまま指定できます。 このオブジェクトが破棄されるまで有効です。
+class ShaderBinary
+{
+public:
+    ~ShaderBinary();
+
+    // ファイルが存在しない、または空の場合nullptrを返します。
+    static std::unique_ptr<ShaderBinary> Open(const char* _filename);
+
+    // 呼び出し元のバイトコードの所有権を受け取ります。
+    static std::unique_ptr<ShaderBinary> Create(std::vector<uint8_t>&& _bytecode);
+
+    const uint8_t*  GetData()   const { return data; }
+    size_t          GetSize()   const { return size; }
+    bool            IsMapped()  const { return file != nullptr; }
+
+private:
+    ShaderBinary();
+    ShaderBinary(const ShaderBinary&) = delete;
+    ShaderBinary& operator=(const ShaderBinary&) = delete;
+
+    bool Init(const char* _filename);
+
+private:
+    std::unique_ptr<util::MappedFile>   file;
+    std::vector<uint8_t>                storage;    // マップできない場合、または Create() で作成された場合に使用します。
+    const uint8_t*                      data;
+    size_t                              size;
+
+};
+
+
+}// namespace shader
+}// namespace buma
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace buma
+{
+namespace shader
+{
+
+class ShaderBinary;
+
+/*
+キャッシュディレクトリのレイアウト:
+    index.bin           SHADER_CACHE_INDEX_HEADER とエントリの配列
+    <blob hash>.bin     コンパイル済みバイナリ (DXIL/SPIR-V) 内容のハッシュをファイル名とするため、同一の出力は共有されます。
+    <blob hash>.refl    バイナリのリフレクションデータ (ShaderReflectionData) 作成された場合のみ存在します。
+*/
+
+constexpr uint32_t SHADER_CACHE_MAGIC   = 0x43485342; // "BSHC"
+constexpr uint32_t SHADER_CACHE_VERSION = 1;
+
+struct SHADER_CACHE_INDEX_HEADER
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t num_entries;
+};
+static_assert(sizeof(SHADER_CACHE_INDEX_HEADER) == 16);
+
+// コンパイル時に IncludeHandler が読み込んだファイルと、その内容のハッシュです。
+struct SHADER_DEPENDENCY
+{
+    std::string path; // UTF-8
+    uint64_t    content_hash;
+};
+
+// コンパイル済みシェーダの永続キャッシュです。
+// キーはソース、エントリポイント、ステージ、ターゲット、定義、オプションから計算され、
+// エントリは記録された全てのインクルードファイルの内容が変更されていない場合にのみヒットします。
+// 全ての関数はスレッドセーフです。
+class ShaderCache
+{
+public:
+    ~ShaderCache();
+
+    // ディレクトリが存在しない場合は作成します。 インデックスが破損している場合は空のキャッシュとして開きます。
+    static std::unique_ptr<ShaderCache> Open(const char* _cache_dir);
+
+    // _dependencies が指定された場合、エントリに記録された依存ファイルを返します。
+    bool Find(uint64_t _key, std::vector<uint8_t>* _dst, std::vector<SHADER_DEPENDENCY>* _dependencies = nullptr);
+    bool Store(uint64_t _key, const std::vector<SHADER_DEPENDENCY>& _dependencies, const std::vector<uint8_t>& _blob);
+
+    // コンパイル済みバイナリに対応するリフレクションデータ(ShaderReflectionData)を、バイナリの内容のハッシュをキーとして保存します。
+    // OpenReflection はファイルをメモリにマップして返します。 存在しない場合nullptrを返します。
+    bool                            StoreReflection(const std::vector<uint8_t>& _blob, const std::vector<uint8_t>& _reflection);
+    std::unique_ptr<ShaderBinary>   OpenReflection(const std::vector<uint8_t>& _blob) const;
+
+    // インデックスを書き込みます。 デストラクタからも呼び出されます。
+    bool Flush();
+    void Clear();
+
+    const std::string&  GetDirectory()  const { return dir; }
+    size_t              GetNumEntries() const;
+
+    // キーと依存ファイルの内容に使用する64ビットFNV-1aハッシュです。
+    static uint64_t Hash(const void* _data, size_t _size, uint64_t _seed = 0xcbf29ce484222325ull);
+
+private:
+    struct ENTRY
+    {
+        uint64_t                        blob_hash;
+        uint64_t                        blob_size;
+        std::vector<SHADER_DEPENDENCY>  dependencies;
+    };
+
+    explicit ShaderCache(const char* _cache_dir);
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    bool LoadIndex();
+    bool IsUpToDate(const ENTRY& _entry) const;
+    std::string GetBlobPath(uint64_t _blob_hash, const char* _extension = "bin") const;
+    static bool WriteFileAtomic(const std::string& _path, const std::vector<uint8_t>& _data, uint64_t _temp_suffix);
+
+private:
+    std::string                         dir;
+    mutable std::mutex                  mutex;
+    std::unordered_map<uint64_t, ENTRY> entries;
+    bool                                is_dirty;
+
+};
+
+
+}// namespace shader
+}// namespace buma
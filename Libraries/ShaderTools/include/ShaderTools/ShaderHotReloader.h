@@ -0,0 +1,92 @@
+#pragma once
+
+#include <ShaderTools/ShaderLoader.h>
+#include <ShaderTools/IncludeCache.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <filesystem>
+#include <unordered_map>
+
+namespace buma
+{
+namespace shader
+{
+
+using SHADER_HOT_RELOAD_ID = uint32_t;
+
+struct SHADER_HOT_RELOAD_RESULT
+{
+    SHADER_HOT_RELOAD_ID    id;
+    SHADER_COMPILE_RESULT   result;     // 失敗した場合も返されます。 diagnostics にエラーが格納されます。
+};
+
+// 登録されたシェーダのソースとインクルードファイルを監視し、変更されたファイルに依存するシェーダのみをバックグラウンドで再コンパイルします。
+// ファイルの監視は更新日時のポーリングで行い、内容のハッシュが変化していない場合(保存し直しただけの場合等)は無視されます。
+// 依存関係(ファイル -> シェーダの逆引き)は再コンパイル毎に結果の依存ファイルで更新されるため、インクルードの追加、削除も反映されます。
+// 全ての関数はスレッドセーフです。
+class ShaderHotReloader
+{
+public:
+    ~ShaderHotReloader();
+
+    static std::unique_ptr<ShaderHotReloader> Create(COMPILE_TARGET _target, uint32_t _poll_interval_ms = 250);
+
+    // _desc.filename は必須です。 記述はコピーされます。
+    // _dependencies には最初のコンパイル結果の SHADER_COMPILE_RESULT::dependencies を指定します。 登録までに変更されたファイルも検出されます。
+    SHADER_HOT_RELOAD_ID Register(const LOAD_SHADER_DESC& _desc, const std::vector<SHADER_DEPENDENCY>& _dependencies);
+    void                 Unregister(SHADER_HOT_RELOAD_ID _id);
+
+    // 前回の呼び出し以降に完了した再コンパイルの結果を取り出します。 結果が存在しない場合falseを返します。
+    bool PopResults(std::vector<SHADER_HOT_RELOAD_RESULT>* _results);
+
+private:
+    struct SHADER
+    {
+        SHADER_HOT_RELOAD_ID        id;
+        LoadShaderDescStorage       desc;
+        std::vector<std::string>    files;      // ソース自体を含む、依存する全てのファイル (正規化されたパス)
+    };
+
+    struct WATCHED_FILE
+    {
+        std::filesystem::file_time_type     last_write_time;
+        uint64_t                            content_hash;
+        std::vector<SHADER_HOT_RELOAD_ID>   shaders;            // このファイルに依存するシェーダ
+    };
+
+    ShaderHotReloader(COMPILE_TARGET _target, uint32_t _poll_interval_ms);
+    ShaderHotReloader(const ShaderHotReloader&) = delete;
+    ShaderHotReloader& operator=(const ShaderHotReloader&) = delete;
+
+    void LinkFiles(SHADER& _shader, const std::vector<SHADER_DEPENDENCY>& _dependencies, uint64_t _source_hash);
+    void UnlinkFiles(SHADER& _shader);
+    void DetectChangedFiles(std::vector<std::string>* _changed_files);
+    void Recompile(const std::vector<std::string>& _changed_files);
+    void WorkerMain();
+
+private:
+    COMPILE_TARGET                                                      target;
+    uint32_t                                                            poll_interval_ms;
+    IncludeCache                                                        include_cache;  // 変更されたファイルのみ読み込み直されます。
+
+    std::mutex                                                          mutex;
+    SHADER_HOT_RELOAD_ID                                                next_id;
+    std::unordered_map<SHADER_HOT_RELOAD_ID, std::shared_ptr<SHADER>>   shaders;
+    std::unordered_map<std::string, WATCHED_FILE>                       files;
+    std::vector<SHADER_HOT_RELOAD_RESULT>                               results;
+
+    std::condition_variable                                             exit_cv;
+    bool                                                                should_exit;
+    std::thread                                                         worker;
+
+};
+
+
+}// namespace shader
+}// namespace buma
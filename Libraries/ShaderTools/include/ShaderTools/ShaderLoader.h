@@ -1,5 +1,10 @@
 #pragma once
 
+#include <ShaderTools/ShaderCache.h>
+#include <ShaderTools/IncludeCache.h>
+
+#include <cstdint>
+#include <string>
 #include <vector>
 
 namespace buma
@@ -78,6 +83,32 @@ struct LOAD_SHADER_DESC
     SHADER_STAGE                    stage;
     std::vector<SHADER_DEFINES>     defines;
     OPTIONS                         options;
+    ShaderCache*                    cache;          // nullptrの場合キャッシュを使用しません。 ヒットした場合コンパイラは呼び出されません。
+};
+
+// LOAD_SHADER_DESC が参照する文字列とレジスタシフトのコピーを所有します。
+// バックグラウンドでのコンパイル等、呼び出し元の寿命を超えて記述を保持する場合に使用します。 Get() が返す記述はこのオブジェクトのメンバを指すため、コピーできません。
+class LoadShaderDescStorage
+{
+public:
+    LoadShaderDescStorage();
+    explicit LoadShaderDescStorage(const LOAD_SHADER_DESC& _desc);
+    ~LoadShaderDescStorage() {}
+
+    void Assign(const LOAD_SHADER_DESC& _desc);
+    const LOAD_SHADER_DESC& Get() const { return desc; }
+
+private:
+    LoadShaderDescStorage(const LoadShaderDescStorage&) = delete;
+    LoadShaderDescStorage& operator=(const LoadShaderDescStorage&) = delete;
+
+private:
+    std::string                 filename;
+    std::string                 entry_point;
+    std::vector<std::string>    define_strings;
+    std::vector<REGISTER_SHIFT> register_shifts;
+    LOAD_SHADER_DESC            desc;
+
 };
 
 struct MODULE_DESC
@@ -106,6 +137,24 @@ enum COMPILE_TARGET
     , COMPILE_TARGET_VULKAN
 };
 
+struct SHADER_COMPILE_RESULT
+{
+    bool                            succeeded;
+    bool                            is_cache_hit;
+    std::vector<uint8_t>            bytecode;
+    std::string                     diagnostics;    // コンパイラが出力したエラーと警告
+    std::vector<SHADER_DEPENDENCY>  dependencies;   // 直接的、間接的にインクルードされた全てのファイル (正規化されたパス、重複なし) キャッシュヒット時はキャッシュに記録されたもの
+};
+
+struct COMPILE_BATCH_DESC
+{
+    size_t                  num_shaders;
+    const LOAD_SHADER_DESC* descs;
+    const char* const*      sources;        // 省略可能です。 nullptr、または要素がnullptrの場合 LOAD_SHADER_DESC::filename から読み込まれます。
+    size_t                  num_threads;    // set 0 to use std::thread::hardware_concurrency()
+    IncludeCache*           include_cache;  // 省略可能です。 nullptrの場合バッチ内でのみ使用するキャッシュを作成します。 ソースファイル自体もこのキャッシュから読み込まれます。
+};
+
 class ShaderLoader
 {
 public:
@@ -119,6 +168,11 @@ public:
     static void LoadShaderFromHLSL(COMPILE_TARGET _type, const LOAD_SHADER_DESC& _desc, std::vector<uint8_t>* _dst);
     static void LoadShaderFromHLSL(COMPILE_TARGET _type, const LOAD_SHADER_DESC& _desc, const char* _src, std::vector<uint8_t>* _dst);
     static void LinkLibrary(COMPILE_TARGET _type, const LIBRARY_LINK_DESC& _desc, std::vector<uint8_t>* _dst);
+
+    // _desc.num_shaders 個のシェーダをワーカースレッドに分配してコンパイルし、_results[i] に各結果を格納します。
+    // ソースとキーが同一の要求は1度だけコンパイルされます。 各ワーカーはそれぞれのコンパイラインスタンスを使用します。
+    void CompileBatch(const COMPILE_BATCH_DESC& _desc, SHADER_COMPILE_RESULT* _results);
+    static void CompileBatch(COMPILE_TARGET _type, const COMPILE_BATCH_DESC& _desc, SHADER_COMPILE_RESULT* _results);
     static bool LinkSupport();
 
 private:
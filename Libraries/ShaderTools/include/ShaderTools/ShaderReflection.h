@@ -15,6 +15,7 @@ namespace shader
 {
 
 struct SIGNATURE_PARAMETER_DESC;
+class ShaderReflectionData;
 std::unique_ptr<util::InputLayoutDesc> CreateInputLayoutDesc(const std::vector<std::shared_ptr<SIGNATURE_PARAMETER_DESC>>& _descs);
 
 #pragma region definitions
@@ -671,6 +672,13 @@ public:
 
     bool ReflectFromBlob(const std::vector<uint8_t>& _blob);
 
+    // シリアライズされたリフレクションデータから作成します。 DXCは使用されません。
+    bool ReflectFromData(const ShaderReflectionData& _data);
+
+    // DXCのリフレクションから、メモリにマップして参照可能な ShaderReflectionData の形式にシリアライズします。
+    // ReflectFromBlob と異なり、定数バッファの変数と型も含まれます。
+    static bool SerializeFromBlob(const std::vector<uint8_t>& _blob, std::vector<uint8_t>* _dst);
+
     const SHADER_DESC&             GetShaderDesc()                     const { return *shader_desc; }
     const ShaderDescData&          GetShaderDescData()                 const { return *shader_desc_data; }
     const std::array<uint32_t, 3>& GetThreadGroupSizes()               const { return thread_group_sizes; }
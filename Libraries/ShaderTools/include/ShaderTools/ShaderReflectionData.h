@@ -0,0 +1,281 @@
+#pragma once
+
+#include <ShaderTools/ShaderReflection.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+namespace buma
+{
+namespace shader
+{
+
+class ShaderBinary;
+class ShaderCache;
+
+/*
+リフレクションデータのレイアウト:
+    SHADER_REFLECTION_DATA_HEADER   セクションのオフセットと要素数、シェーダ全体の情報
+    各セクション                     ポインタを含まない固定サイズの要素の配列 (8バイト境界に配置)
+
+文字列は STRINGS セクション内のオフセット、他の要素の参照はセクション内のインデックスで表現されるため、
+ファイルをメモリにマップしてそのまま参照できます。
+*/
+
+constexpr uint32_t SHADER_REFLECTION_DATA_MAGIC   = 0x46455242; // "BREF"
+constexpr uint32_t SHADER_REFLECTION_DATA_VERSION = 1;
+constexpr uint32_t REFLECTION_NULL_INDEX          = ~0u;
+
+enum REFLECTION_SECTION : uint32_t
+{
+      REFLECTION_SECTION_STRINGS                    // char, NULL終端の文字列を連結したもの
+    , REFLECTION_SECTION_CONSTANT_BUFFERS           // REFLECTION_BUFFER_DESC
+    , REFLECTION_SECTION_VARIABLES                  // REFLECTION_VARIABLE_DESC
+    , REFLECTION_SECTION_TYPES                      // REFLECTION_TYPE_DESC
+    , REFLECTION_SECTION_TYPE_MEMBERS               // REFLECTION_TYPE_MEMBER
+    , REFLECTION_SECTION_INPUT_BINDINGS             // REFLECTION_INPUT_BIND_DESC
+    , REFLECTION_SECTION_INPUT_PARAMETERS           // REFLECTION_SIGNATURE_PARAMETER_DESC
+    , REFLECTION_SECTION_OUTPUT_PARAMETERS          // REFLECTION_SIGNATURE_PARAMETER_DESC
+    , REFLECTION_SECTION_PATCH_CONSTANT_PARAMETERS  // REFLECTION_SIGNATURE_PARAMETER_DESC
+    , REFLECTION_SECTION_DEFAULT_VALUES             // uint8_t
+
+    , REFLECTION_SECTION_NUM_SECTIONS
+};
+
+struct REFLECTION_SECTION_DESC
+{
+    uint32_t offset;    // データの先頭からのバイトオフセット
+    uint32_t count;     // 要素数
+};
+
+// SHADER_DESC と ShaderReflection の各値です。
+struct REFLECTION_SHADER_DESC
+{
+    SHADER_REQUIRE_FLAGS                require_flags;
+    uint32_t                            version;
+    uint32_t                            creator;                        // 文字列のオフセット
+    uint32_t                            flags;
+    uint32_t                            constant_buffers;
+    uint32_t                            bound_resources;
+    uint32_t                            input_parameters;
+    uint32_t                            output_parameters;
+    uint32_t                            instruction_count;
+    uint32_t                            temp_register_count;
+    uint32_t                            temp_array_count;
+    uint32_t                            def_count;
+    uint32_t                            dcl_count;
+    uint32_t                            texture_normal_instructions;
+    uint32_t                            texture_load_instructions;
+    uint32_t                            texture_comp_instructions;
+    uint32_t                            texture_bias_instructions;
+    uint32_t                            texture_gradient_instructions;
+    uint32_t                            float_instruction_count;
+    uint32_t                            int_instruction_count;
+    uint32_t                            uint_instruction_count;
+    uint32_t                            static_flow_control_count;
+    uint32_t                            dynamic_flow_control_count;
+    uint32_t                            macro_instruction_count;
+    uint32_t                            array_instruction_count;
+    uint32_t                            cut_instruction_count;
+    uint32_t                            emit_instruction_count;
+    PRIMITIVE_TOPOLOGY                  gs_output_topology;
+    uint32_t                            gs_max_output_vertex_count;
+    PRIMITIVE_TYPE                      input_primitive;
+    uint32_t                            patch_constant_parameters;
+    uint32_t                            gs_instance_count;
+    uint32_t                            control_points;
+    TESSELLATOR_OUTPUT_PRIMITIVE        hs_output_primitive;
+    TESSELLATOR_PARTITIONING            hs_partitioning;
+    TESSELLATOR_DOMAIN                  tessellator_domain;
+    uint32_t                            barrier_instructions;
+    uint32_t                            interlocked_instructions;
+    uint32_t                            texture_store_instructions;
+
+    uint32_t                            thread_group_sizes[3];
+    uint32_t                            thread_group_total_size;
+    uint32_t                            mov_instruction_count;
+    uint32_t                            movc_instruction_count;
+    uint32_t                            conversion_instruction_count;
+    uint32_t                            bitwise_instruction_count;
+    PRIMITIVE_TYPE                      gs_input_primitive;
+    uint32_t                            is_sample_frequency_shader;
+    uint32_t                            num_interface_slots;
+    FEATURE_LEVEL                       feature_level;
+};
+
+struct SHADER_REFLECTION_DATA_HEADER
+{
+    uint32_t                            magic;
+    uint32_t                            version;
+    uint32_t                            total_size;
+    uint32_t                            reserved;
+    REFLECTION_SECTION_DESC             sections[REFLECTION_SECTION_NUM_SECTIONS];
+    REFLECTION_SHADER_DESC              shader_desc;
+};
+
+struct REFLECTION_BUFFER_DESC
+{
+    uint32_t                            name;                           // 文字列のオフセット
+    CBUFFER_TYPE                        cb_type;
+    uint32_t                            size_of_cb;
+    uint32_t                            buffer_desc_flags;
+    uint32_t                            first_variable;                 // VARIABLES セクションのインデックス
+    uint32_t                            num_variables;
+};
+
+struct REFLECTION_VARIABLE_DESC
+{
+    uint32_t                            name;                           // 文字列のオフセット
+    uint32_t                            start_offset;
+    uint32_t                            variable_size;
+    SHADER_VARIABLE_FLAGS               variable_flags;
+    uint32_t                            start_texture;
+    uint32_t                            texture_size;
+    uint32_t                            start_sampler;
+    uint32_t                            sampler_size;
+    uint32_t                            type;                           // TYPES セクションのインデックス
+    uint32_t                            default_value;                  // DEFAULT_VALUES セクションのオフセット、デフォルト値が無い場合 REFLECTION_NULL_INDEX (サイズは variable_size)
+};
+
+struct REFLECTION_TYPE_DESC
+{
+    SHADER_VARIABLE_CLASS               variable_class;
+    SHADER_VARIABLE_TYPE                variable_type;
+    uint32_t                            num_rows;
+    uint32_t                            num_columns;
+    uint32_t                            num_elements;
+    uint32_t                            num_members;
+    uint32_t                            structure_offset;
+    uint32_t                            type_name;                      // 文字列のオフセット
+    uint32_t                            first_member;                   // TYPE_MEMBERS セクションのインデックス
+    uint32_t                            sub_type;                       // TYPES セクションのインデックス、または REFLECTION_NULL_INDEX
+    uint32_t                            base_class;                     // TYPES セクションのインデックス、または REFLECTION_NULL_INDEX
+};
+
+struct REFLECTION_TYPE_MEMBER
+{
+    uint32_t                            name;                           // 文字列のオフセット
+    uint32_t                            type;                           // TYPES セクションのインデックス
+};
+
+struct REFLECTION_INPUT_BIND_DESC
+{
+    uint32_t                            name;                           // 文字列のオフセット
+    SHADER_INPUT_TYPE                   shader_input_type;
+    uint32_t                            start_bind_point;
+    uint32_t                            bind_count;
+    SHADER_INPUT_FLAGS                  binding_flags;
+    RESOURCE_RETURN_TYPE                return_type;
+    SRV_DIMENSION                       dimension;
+    uint32_t                            num_samples;
+    uint32_t                            register_space;
+    uint32_t                            range_id;
+};
+
+struct REFLECTION_SIGNATURE_PARAMETER_DESC
+{
+    uint32_t                            semantic_name;                  // 文字列のオフセット
+    uint32_t                            semantic_index;
+    uint32_t                            num_register;
+    SYSTEM_VALUE_NAME                   system_value_type;
+    REGISTER_COMPONENT_TYPE             component_type;
+    uint32_t                            stream_index;
+    MIN_PRECISION                       min_precision;
+    uint8_t                             mask;
+    uint8_t                             read_write_mask;
+    uint8_t                             reserved[2];
+};
+
+static_assert(sizeof(REFLECTION_SHADER_DESC)                == 208);
+static_assert(sizeof(SHADER_REFLECTION_DATA_HEADER)         == 16 + 8 * REFLECTION_SECTION_NUM_SECTIONS + sizeof(REFLECTION_SHADER_DESC));
+static_assert(sizeof(REFLECTION_BUFFER_DESC)                == 24);
+static_assert(sizeof(REFLECTION_VARIABLE_DESC)              == 40);
+static_assert(sizeof(REFLECTION_TYPE_DESC)                  == 44);
+static_assert(sizeof(REFLECTION_TYPE_MEMBER)                == 8);
+static_assert(sizeof(REFLECTION_INPUT_BIND_DESC)            == 40);
+static_assert(sizeof(REFLECTION_SIGNATURE_PARAMETER_DESC)   == 32);
+
+template <typename T>
+struct REFLECTION_ARRAY
+{
+    const T*    data;
+    uint32_t    count;
+
+    const T*    begin()                     const { return data; }
+    const T*    end()                       const { return data + count; }
+    uint32_t    size()                      const { return count; }
+    bool        empty()                     const { return count == 0; }
+    const T&    operator[](uint32_t _index) const { return data[_index]; }
+};
+
+// シリアライズされたリフレクションデータの読み取り専用のビューです。
+// データは Init() で一度だけ検証され、以降のアクセスでは割り当てと検証が行われません。
+// ShaderReflection と異なり、定数バッファの変数と型(構造体のメンバーを含む)も参照できます。
+class ShaderReflectionData
+{
+public:
+    ShaderReflectionData();
+    ~ShaderReflectionData();
+
+    // DXILのバイトコードからリフレクションデータを取得します。 シリアライズには ShaderReflection::SerializeFromBlob を使用します。
+    // _cache が指定された場合、バイトコードと共に保存されたデータをメモリにマップして使用し、存在しない場合は作成して保存します。
+    static std::unique_ptr<ShaderReflectionData> Reflect(const std::vector<uint8_t>& _bytecode, ShaderCache* _cache = nullptr);
+
+    // シリアライズされたデータの所有権を受け取ります。 データが不正な場合nullptrを返します。
+    static std::unique_ptr<ShaderReflectionData> Create(std::unique_ptr<ShaderBinary> _data);
+
+    // _data を参照します。 _data はこのオブジェクトが破棄されるまで有効である必要があります。
+    bool Init(const void* _data, size_t _size);
+
+    const void*                                             GetData()                       const { return data; }
+    size_t                                                  GetSize()                       const { return size; }
+
+    const REFLECTION_SHADER_DESC&                           GetShaderDesc()                 const { return header->shader_desc; }
+    REFLECTION_ARRAY<REFLECTION_BUFFER_DESC>                GetConstantBuffers()            const { return GetSection<REFLECTION_BUFFER_DESC>(REFLECTION_SECTION_CONSTANT_BUFFERS); }
+    REFLECTION_ARRAY<REFLECTION_VARIABLE_DESC>              GetVariables()                  const { return GetSection<REFLECTION_VARIABLE_DESC>(REFLECTION_SECTION_VARIABLES); }
+    REFLECTION_ARRAY<REFLECTION_TYPE_DESC>                  GetTypes()                      const { return GetSection<REFLECTION_TYPE_DESC>(REFLECTION_SECTION_TYPES); }
+    REFLECTION_ARRAY<REFLECTION_TYPE_MEMBER>                GetTypeMembers()                const { return GetSection<REFLECTION_TYPE_MEMBER>(REFLECTION_SECTION_TYPE_MEMBERS); }
+    REFLECTION_ARRAY<REFLECTION_INPUT_BIND_DESC>            GetInputBindings()              const { return GetSection<REFLECTION_INPUT_BIND_DESC>(REFLECTION_SECTION_INPUT_BINDINGS); }
+    REFLECTION_ARRAY<REFLECTION_SIGNATURE_PARAMETER_DESC>   GetInputParameters()            const { return GetSection<REFLECTION_SIGNATURE_PARAMETER_DESC>(REFLECTION_SECTION_INPUT_PARAMETERS); }
+    REFLECTION_ARRAY<REFLECTION_SIGNATURE_PARAMETER_DESC>   GetOutputParameters()           const { return GetSection<REFLECTION_SIGNATURE_PARAMETER_DESC>(REFLECTION_SECTION_OUTPUT_PARAMETERS); }
+    REFLECTION_ARRAY<REFLECTION_SIGNATURE_PARAMETER_DESC>   GetPatchConstantParameters()    const { return GetSection<REFLECTION_SIGNATURE_PARAMETER_DESC>(REFLECTION_SECTION_PATCH_CONSTANT_PARAMETERS); }
+
+    const char*                                             GetString(uint32_t _offset)     const { return strings + _offset; }
+
+    // 定数バッファの変数、構造体のメンバーの範囲です。
+    REFLECTION_ARRAY<REFLECTION_VARIABLE_DESC>              GetVariables(const REFLECTION_BUFFER_DESC& _cb)     const { return { GetVariables().data + _cb.first_variable, _cb.num_variables }; }
+    REFLECTION_ARRAY<REFLECTION_TYPE_MEMBER>                GetMembers(const REFLECTION_TYPE_DESC& _type)       const { return { GetTypeMembers().data + _type.first_member, _type.num_members }; }
+    const REFLECTION_TYPE_DESC&                             GetType(uint32_t _index)                            const { return GetTypes().data[_index]; }
+    const void*                                             GetDefaultValue(const REFLECTION_VARIABLE_DESC& _variable) const;
+
+    // 名前で検索します。 見つからない場合nullptrを返します。
+    const REFLECTION_BUFFER_DESC*                           FindConstantBuffer(const char* _name) const;
+    const REFLECTION_INPUT_BIND_DESC*                       FindInputBinding(const char* _name) const;
+
+private:
+    ShaderReflectionData(const ShaderReflectionData&) = delete;
+    ShaderReflectionData& operator=(const ShaderReflectionData&) = delete;
+
+    template <typename T>
+    REFLECTION_ARRAY<T> GetSection(REFLECTION_SECTION _section) const
+    {
+        auto&& s = header->sections[_section];
+        return { reinterpret_cast<const T*>(static_cast<const uint8_t*>(data) + s.offset), s.count };
+    }
+
+    bool Validate() const;
+
+private:
+    std::unique_ptr<ShaderBinary>           storage;
+    const void*                             data;
+    size_t                                  size;
+    const SHADER_REFLECTION_DATA_HEADER*    header;
+    const char*                             strings;
+
+};
+
+
+}// namespace shader
+}// namespace buma
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <ShaderTools/ShaderLoader.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+namespace buma
+{
+namespace shader
+{
+
+/*
+シェーダバリアントのキーは、各キーワードの値を連続したビットフィールドに詰めたビットマスクです。
+    キーワード i は ceil(log2(num_values)) ビットを使用し、宣言順に下位ビットから割り当てられます。
+    例: { USE_NORMAL_MAP(2値), LIGHT_COUNT(4値) } の場合 bit0 = USE_NORMAL_MAP, bit1-2 = LIGHT_COUNT
+*/
+using SHADER_VARIANT_KEY = uint32_t;
+
+// ルックアップテーブルは 2^(キーの総ビット数) 個のスロットを持ちます。
+constexpr uint32_t MAX_SHADER_VARIANT_KEY_BITS = 16;
+
+struct SHADER_KEYWORD_DESC
+{
+    const char*         name;           // マクロ名
+    uint32_t            num_values;     // 2以上を指定します。
+    const char* const*  value_names;    // 省略可能です。 指定された場合マクロは value_names[value] 、nullptrの場合は値の数値として定義されます。
+};
+
+struct SHADER_VARIANTS_DESC
+{
+    COMPILE_TARGET              target;
+    LOAD_SHADER_DESC            base_desc;      // 全てのバリアントに共通の記述です。 defines にはキーワードの定義が追加されます。
+    const char*                 source;         // 省略可能です。 nullptrの場合 base_desc.filename から読み込まれます。
+    uint32_t                    num_keywords;
+    const SHADER_KEYWORD_DESC*  keywords;
+    SHADER_VARIANT_KEY          fallback_key;   // Create() 内で同期的にコンパイルされ、未完了のバリアントの代わりに返されます。
+    size_t                      num_threads;    // バックグラウンドコンパイルのスレッド数です。 set 0 to use std::thread::hardware_concurrency()
+};
+
+struct SHADER_VARIANT
+{
+    SHADER_VARIANT_KEY      key;
+    std::vector<uint8_t>    bytecode;
+    std::string             diagnostics;
+};
+
+// 1つのシェーダのキーワードの組み合わせ毎のバリアントを管理します。
+// バリアントは最初に要求された時点でバックグラウンドのスレッドでコンパイルされ、完了するまではフォールバックのバリアントが返されます。
+// 全ての関数はスレッドセーフです。
+class ShaderVariants
+{
+public:
+    ~ShaderVariants();
+
+    // キーの総ビット数が MAX_SHADER_VARIANT_KEY_BITS を超える場合、またはフォールバックのコンパイルに失敗した場合nullptrを返します。
+    static std::unique_ptr<ShaderVariants> Create(const SHADER_VARIANTS_DESC& _desc);
+
+    // 見つからない場合 UINT32_MAX を返します。
+    uint32_t            FindKeyword(const char* _name) const;
+    SHADER_VARIANT_KEY  SetKeywordValue(SHADER_VARIANT_KEY _key, uint32_t _keyword_index, uint32_t _value) const;
+    uint32_t            GetKeywordValue(SHADER_VARIANT_KEY _key, uint32_t _keyword_index) const;
+    uint32_t            GetNumKeyBits() const { return num_key_bits; }
+
+    // レンダリングパスから呼び出されることを想定しています。 コンパイル済みの場合はテーブルを1度参照するのみです。
+    // 未コンパイルの場合はバックグラウンドのコンパイルを要求し、フォールバックを返します。 コンパイルに失敗したバリアントもフォールバックで置き換えられます。
+    // _is_fallback は省略可能です。 返されたポインタはこのオブジェクトが破棄されるまで有効です。
+    const SHADER_VARIANT* GetVariant(SHADER_VARIANT_KEY _key, bool* _is_fallback = nullptr);
+
+    // 結果を待たずにコンパイルを要求します。 ロード中に使用されるバリアントを事前に準備する場合に使用します。
+    void Request(SHADER_VARIANT_KEY _key);
+
+    // 要求済みの全てのバリアントのコンパイルが完了するまで待機します。
+    void WaitIdle();
+
+private:
+    enum VARIANT_STATE : uint32_t
+    {
+          VARIANT_STATE_NONE
+        , VARIANT_STATE_QUEUED
+        , VARIANT_STATE_READY
+        , VARIANT_STATE_FAILED
+    };
+
+    struct VARIANT_SLOT
+    {
+        std::atomic<VARIANT_STATE>      state { VARIANT_STATE_NONE }; // READY の場合のみ variant を読み取ることができます。
+        std::unique_ptr<SHADER_VARIANT> variant;
+    };
+
+    struct KEYWORD
+    {
+        std::string                 name;
+        std::vector<std::string>    values;         // マクロとして定義される値
+        uint32_t                    bit_offset;
+        uint32_t                    bit_count;
+    };
+
+    ShaderVariants();
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    bool Init(const SHADER_VARIANTS_DESC& _desc);
+    bool IsValidKey(SHADER_VARIANT_KEY _key) const;
+    void PrepareVariantDesc(SHADER_VARIANT_KEY _key, LOAD_SHADER_DESC* _desc) const;
+    void CompileVariants(const std::vector<SHADER_VARIANT_KEY>& _keys);
+    void WorkerMain();
+
+private:
+    COMPILE_TARGET                  target;
+    LoadShaderDescStorage           base_desc;
+    std::string                     name;           // ログに使用します。
+    std::string                     source;
+    bool                            has_source;
+    std::vector<KEYWORD>            keywords;
+    uint32_t                        num_key_bits;
+    size_t                          num_threads;
+
+    std::unique_ptr<VARIANT_SLOT[]> slots;          // SHADER_VARIANT_KEY をインデックスとするルックアップテーブル
+    const SHADER_VARIANT*           fallback;
+
+    std::mutex                      queue_mutex;
+    std::condition_variable         queue_cv;
+    std::condition_variable         idle_cv;
+    std::vector<SHADER_VARIANT_KEY> queue;
+    size_t                          num_in_flight;
+    bool                            should_exit;
+    std::thread                     worker;
+
+};
+
+
+}// namespace shader
+}// namespace buma
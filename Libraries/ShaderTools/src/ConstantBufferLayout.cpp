@@ -0,0 +1,332 @@
+#include <ShaderTools/ConstantBufferLayout.h>
+
+#include <Utils/Logger.h>
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+
+namespace buma
+{
+namespace shader
+{
+
+namespace /*anonymous*/
+{
+
+constexpr uint32_t REGISTER_SIZE = 16; // 定数バッファの1レジスタ(float4)のサイズ
+
+inline uint32_t AlignUp(uint32_t _value, uint32_t _alignment)
+{
+    return (_value + _alignment - 1) / _alignment * _alignment;
+}
+
+std::string ToIdentifier(const char* _name)
+{
+    std::string result = _name;
+    for (auto& c : result)
+    {
+        if (!std::isalnum(static_cast<unsigned char>(c)))
+            c = '_';
+    }
+    if (result.empty() || std::isdigit(static_cast<unsigned char>(result[0])))
+        result.insert(result.begin(), '_');
+    return result;
+}
+
+// C++の型が存在しないスカラー型の場合nullptrを返します。
+const char* GetScalarTypeName(SHADER_VARIABLE_TYPE _type, uint32_t* _size)
+{
+    *_size = 4;
+    switch (_type)
+    {
+    case SHADER_VARIABLE_TYPE_BOOL       : return "uint32_t"; // HLSLのboolは4バイトです。
+    case SHADER_VARIABLE_TYPE_INT        : return "int32_t";
+    case SHADER_VARIABLE_TYPE_UINT       : return "uint32_t";
+    case SHADER_VARIABLE_TYPE_FLOAT      : return "float";
+    case SHADER_VARIABLE_TYPE_MIN16FLOAT : return "float";    // 16ビット型が有効でない場合、最小精度型は32ビットで格納されます。
+    case SHADER_VARIABLE_TYPE_MIN16INT   : return "int32_t";
+    case SHADER_VARIABLE_TYPE_MIN16UINT  : return "uint32_t";
+    case SHADER_VARIABLE_TYPE_DOUBLE     : *_size = 8; return "double";
+    default:
+        *_size = 0;
+        return nullptr;
+    }
+}
+
+struct FIELD_DECL
+{
+    std::string type;   // 空の場合、バイト配列として出力します。
+    std::string dims;   // 名前に続く配列の次元
+};
+
+class ConstantBufferHeaderWriter
+{
+public:
+    ConstantBufferHeaderWriter(std::string* _dst)
+        : out           { *_dst }
+        , reflection    {}
+        , structs       {}
+    {}
+
+    void Begin(const CONSTANT_BUFFER_HEADER_DESC& _desc)
+    {
+        out += "#pragma once\n\n";
+        out += "// このファイルは自動生成されました。 直接編集しないでください。\n";
+        if (_desc.source_name)
+            out += std::string("// source: ") + _desc.source_name + "\n";
+        out += "\n#include <cstdint>\n#include <cstddef>\n\n";
+        if (_desc.namespace_name)
+            out += std::string("namespace ") + _desc.namespace_name + "\n{\n\n";
+    }
+
+    void End(const CONSTANT_BUFFER_HEADER_DESC& _desc)
+    {
+        if (_desc.namespace_name)
+            out += std::string("\n}// namespace ") + _desc.namespace_name + "\n";
+    }
+
+    void WriteConstantBuffer(const ShaderReflectionData& _reflection, const REFLECTION_BUFFER_DESC& _cb)
+    {
+        reflection = &_reflection;
+        auto name = ToIdentifier(reflection->GetString(_cb.name));
+
+        // 構造体型の変数は先に型を定義します。
+        for (auto&& i : reflection->GetVariables(_cb))
+            WriteStructDefinitions(i.type);
+
+        std::string comment = std::string("// cbuffer ") + reflection->GetString(_cb.name);
+        if (auto bind = reflection->FindInputBinding(reflection->GetString(_cb.name)))
+            comment += " : register(b" + std::to_string(bind->start_bind_point) + ", space" + std::to_string(bind->register_space) + ")";
+        out += comment + "\n";
+
+        std::vector<std::string> fields;
+        std::string              offsets;
+        std::string              sizes;
+        std::string              asserts;
+        out += "struct " + name + "\n{\n";
+        uint32_t offset = 0;
+        for (auto&& i : reflection->GetVariables(_cb))
+        {
+            auto field = ToIdentifier(reflection->GetString(i.name));
+            WriteField(i.type, field, i.start_offset, &offset);
+            fields.emplace_back(field);
+            offsets += (offsets.empty() ? " " : ", ") + std::to_string(i.start_offset);
+            sizes   += (sizes  .empty() ? " " : ", ") + std::to_string(i.variable_size);
+            asserts += "static_assert(offsetof(" + name + ", " + field + ") == " + std::to_string(i.start_offset) + ");\n";
+        }
+        WritePadding(_cb.size_of_cb, &offset);
+
+        if (!fields.empty())
+        {
+            out += "\n    enum FIELD\n    {\n";
+            for (size_t i = 0; i < fields.size(); i++)
+                out += std::string(i == 0 ? "          " : "        , ") + "FIELD_" + fields[i] + "\n";
+            out += "\n        , NUM_FIELDS\n    };\n";
+            out += "    static constexpr uint32_t FIELD_OFFSETS[NUM_FIELDS] = {" + offsets + " };\n";
+            out += "    static constexpr uint32_t FIELD_SIZES  [NUM_FIELDS] = {" + sizes   + " };\n";
+        }
+        out += "};\n";
+        out += "static_assert(sizeof(" + name + ") == " + std::to_string(_cb.size_of_cb) + ");\n";
+        out += asserts + "\n";
+    }
+
+private:
+    uint32_t GetElementSize(const REFLECTION_TYPE_DESC& _type) const
+    {
+        uint32_t scalar_size = 0;
+        switch (_type.variable_class)
+        {
+        case SHADER_VARIABLE_CLASS_SCALAR:
+        case SHADER_VARIABLE_CLASS_VECTOR:
+            GetScalarTypeName(_type.variable_type, &scalar_size);
+            return _type.num_columns * (scalar_size ? scalar_size : 4);
+
+        case SHADER_VARIABLE_CLASS_MATRIX_ROWS:
+        case SHADER_VARIABLE_CLASS_MATRIX_COLUMNS:
+        {
+            // 行優先の場合は各行、列優先の場合は各列がレジスタに配置されます。
+            bool rows = _type.variable_class == SHADER_VARIABLE_CLASS_MATRIX_ROWS;
+            GetScalarTypeName(_type.variable_type, &scalar_size);
+            auto num_registers  = rows ? _type.num_rows    : _type.num_columns;
+            auto num_components = rows ? _type.num_columns : _type.num_rows;
+            return (num_registers - 1) * REGISTER_SIZE + num_components * (scalar_size ? scalar_size : 4);
+        }
+
+        case SHADER_VARIABLE_CLASS_STRUCT:
+        {
+            uint32_t size = 0;
+            for (auto&& i : reflection->GetMembers(_type))
+            {
+                auto&& member = reflection->GetType(i.type);
+                size = std::max(size, member.structure_offset + GetTypeSize(member));
+            }
+            return size;
+        }
+
+        default:
+            return 0;
+        }
+    }
+
+    uint32_t GetTypeSize(const REFLECTION_TYPE_DESC& _type) const
+    {
+        auto element_size = GetElementSize(_type);
+        if (_type.num_elements == 0)
+            return element_size;
+
+        // 配列の各要素は16バイト境界に配置されます。
+        return (_type.num_elements - 1) * AlignUp(element_size, REGISTER_SIZE) + element_size;
+    }
+
+    FIELD_DECL GetFieldDecl(const REFLECTION_TYPE_DESC& _type) const
+    {
+        FIELD_DECL decl{};
+        uint32_t scalar_size = 0;
+        switch (_type.variable_class)
+        {
+        case SHADER_VARIABLE_CLASS_SCALAR:
+        case SHADER_VARIABLE_CLASS_VECTOR:
+            if (auto scalar = GetScalarTypeName(_type.variable_type, &scalar_size))
+            {
+                decl.type = scalar;
+                if (_type.variable_class == SHADER_VARIABLE_CLASS_VECTOR)
+                    decl.dims = "[" + std::to_string(_type.num_columns) + "]";
+            }
+            break;
+
+        case SHADER_VARIABLE_CLASS_MATRIX_ROWS:
+        case SHADER_VARIABLE_CLASS_MATRIX_COLUMNS:
+            if (auto scalar = GetScalarTypeName(_type.variable_type, &scalar_size))
+            {
+                bool rows = _type.variable_class == SHADER_VARIABLE_CLASS_MATRIX_ROWS;
+                auto num_registers  = rows ? _type.num_rows    : _type.num_columns;
+                auto num_components = rows ? _type.num_columns : _type.num_rows;
+                // レジスタ間にパディングが入る行列はバイト配列として出力します。
+                if (num_registers == 1)
+                    decl.dims = "[" + std::to_string(num_components) + "]";
+                else if (num_components * scalar_size == REGISTER_SIZE)
+                    decl.dims = "[" + std::to_string(num_registers) + "][" + std::to_string(num_components) + "]";
+                else
+                    break;
+                decl.type = scalar;
+            }
+            break;
+
+        case SHADER_VARIABLE_CLASS_STRUCT:
+            decl.type = ToIdentifier(reflection->GetString(_type.type_name));
+            break;
+
+        default:
+            break;
+        }
+
+        if (decl.type.empty() || _type.num_elements == 0)
+            return decl;
+
+        // 要素間にパディングが入る配列はバイト配列として出力します。
+        if (GetElementSize(_type) % REGISTER_SIZE != 0)
+            return {};
+
+        decl.dims = "[" + std::to_string(_type.num_elements) + "]" + decl.dims;
+        return decl;
+    }
+
+    void WritePadding(uint32_t _next_offset, uint32_t* _offset, const char* _indent = "    ")
+    {
+        if (_next_offset <= *_offset)
+            return;
+
+        out += std::string(_indent) + "uint8_t _pad" + std::to_string(*_offset) + "[" + std::to_string(_next_offset - *_offset) + "];\n";
+        *_offset = _next_offset;
+    }
+
+    void WriteField(uint32_t _type, const std::string& _name, uint32_t _field_offset, uint32_t* _offset, const char* _indent = "    ")
+    {
+        auto&& type = reflection->GetType(_type);
+        auto   size = GetTypeSize(type);
+        auto   decl = GetFieldDecl(type);
+        WritePadding(_field_offset, _offset, _indent);
+
+        std::string line = _indent;
+        if (decl.type.empty())
+            line += "uint8_t " + _name + "[" + std::to_string(size) + "];";
+        else
+            line += decl.type + " " + _name + decl.dims + ";";
+
+        if (line.size() < 48)
+            line.resize(48, ' ');
+        out += line + " // " + reflection->GetString(type.type_name) + (type.num_elements ? "[" + std::to_string(type.num_elements) + "]" : "")
+            + ", offset: " + std::to_string(_field_offset) + ", size: " + std::to_string(size) + "\n";
+
+        *_offset = _field_offset + size;
+    }
+
+    void WriteStructDefinitions(uint32_t _type)
+    {
+        auto&& type = reflection->GetType(_type);
+        if (type.variable_class != SHADER_VARIABLE_CLASS_STRUCT)
+            return;
+
+        auto name = ToIdentifier(reflection->GetString(type.type_name));
+        if (!structs.insert(name).second)
+            return;
+
+        for (auto&& i : reflection->GetMembers(type))
+            WriteStructDefinitions(i.type);
+
+        out += "struct " + name + "\n{\n";
+        uint32_t offset = 0;
+        for (auto&& i : reflection->GetMembers(type))
+            WriteField(i.type, ToIdentifier(reflection->GetString(i.name)), reflection->GetType(i.type).structure_offset, &offset);
+        out += "};\n";
+        out += "static_assert(sizeof(" + name + ") == " + std::to_string(GetElementSize(type)) + ");\n\n";
+    }
+
+private:
+    std::string&                out;
+    const ShaderReflectionData* reflection;
+    std::set<std::string>       structs;    // 定義済みの構造体の名前
+
+};
+
+
+}// namespace /*anonymous*/
+
+
+bool GenerateConstantBufferHeader(const CONSTANT_BUFFER_HEADER_DESC& _desc, std::string* _dst)
+{
+    std::map<std::string, uint32_t> written; // 出力済みの定数バッファの名前とサイズ
+    ConstantBufferHeaderWriter writer(_dst);
+    writer.Begin(_desc);
+    for (uint32_t i = 0; i < _desc.num_reflections; i++)
+    {
+        auto&& reflection = *_desc.reflections[i];
+        for (auto&& cb : reflection.GetConstantBuffers())
+        {
+            if (cb.cb_type != CBUFFER_TYPE_CBUFFER || cb.num_variables == 0)
+                continue;
+
+            auto [it, inserted] = written.emplace(reflection.GetString(cb.name), cb.size_of_cb);
+            if (!inserted)
+            {
+                if (it->second != cb.size_of_cb)
+                {
+                    BUMA_LOGE("GenerateConstantBufferHeader: cbuffer {} has different sizes between shaders ({} and {})", it->first, it->second, cb.size_of_cb);
+                    return false;
+                }
+                continue;
+            }
+            writer.WriteConstantBuffer(reflection, cb);
+        }
+    }
+    writer.End(_desc);
+    return true;
+}
+
+
+}// namespace shader
+}// namespace buma
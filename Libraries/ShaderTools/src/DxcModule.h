@@ -0,0 +1,110 @@
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dlfcn.h>
+#endif // _WIN32
+
+// NOTE: Windows以外では、dxcapi.h がインクルードする WinAdapter.h が HRESULT や IUnknown 等を定義します。 d3d12shader.h より先にインクルードしてください。
+#include <dxcapi.h>
+
+#include <utility>
+
+namespace buma
+{
+namespace shader
+{
+
+// Microsoft::WRL::ComPtr の代替です。 WRLはWindowsでのみ利用可能なため、ShaderTools 内ではこちらを使用します。
+template <typename T>
+class ComPtr
+{
+public:
+    ComPtr()                        : ptr{}                 {}
+    ComPtr(T* _ptr)                 : ptr{ _ptr }           { InternalAddRef(); }
+    ComPtr(const ComPtr& _other)    : ptr{ _other.ptr }     { InternalAddRef(); }
+    ComPtr(ComPtr&& _other) noexcept: ptr{ _other.ptr }     { _other.ptr = nullptr; }
+    ~ComPtr()                                               { InternalRelease(); }
+
+    ComPtr& operator=(T* _ptr)                  { ComPtr(_ptr).Swap(*this);             return *this; }
+    ComPtr& operator=(const ComPtr& _other)     { ComPtr(_other).Swap(*this);           return *this; }
+    ComPtr& operator=(ComPtr&& _other) noexcept { ComPtr(std::move(_other)).Swap(*this); return *this; }
+
+    T*  Get()           const { return ptr; }
+    T*  operator->()    const { return ptr; }
+    explicit operator bool() const { return ptr != nullptr; }
+
+    // WRLと同様に、保持している参照を解放してからアドレスを返します。 IID_PPV_ARGS での出力先として使用します。
+    T** operator&()     { InternalRelease(); return &ptr; }
+
+    void Reset()                { InternalRelease(); }
+    void Swap(ComPtr& _other)   { std::swap(ptr, _other.ptr); }
+
+private:
+    void InternalAddRef()
+    {
+        if (ptr)
+            ptr->AddRef();
+    }
+
+    void InternalRelease()
+    {
+        if (auto p = ptr)
+        {
+            ptr = nullptr;
+            p->Release();
+        }
+    }
+
+private:
+    T* ptr;
+
+};
+
+// dxcompiler の共有ライブラリです。 最初に使用された時点で一度だけ読み込まれ、作成されたオブジェクトが参照している可能性があるためプロセス終了まで解放されません。
+class DxcModule
+{
+public:
+    static const DxcModule& Get()
+    {
+        static const DxcModule instance;
+        return instance;
+    }
+
+    bool IsValid() const { return DxcCreateInstance != nullptr; }
+
+    HRESULT CreateInstance(REFCLSID _clsid, REFIID _iid, void** _ppv) const
+    {
+        if (!DxcCreateInstance)
+            return E_FAIL;
+        return DxcCreateInstance(_clsid, _iid, _ppv);
+    }
+
+private:
+    DxcModule()
+        : DxcCreateInstance{}
+    {
+#if defined(_WIN32)
+        auto dxc = LoadLibraryA("dxcompiler.dll");
+        if (dxc)
+            DxcCreateInstance = (DxcCreateInstanceProc)GetProcAddress(dxc, "DxcCreateInstance");
+#else
+    #if defined(__APPLE__)
+        auto dxc = dlopen("libdxcompiler.dylib", RTLD_LAZY | RTLD_LOCAL);
+    #else
+        auto dxc = dlopen("libdxcompiler.so", RTLD_LAZY | RTLD_LOCAL);
+    #endif
+        if (dxc)
+            DxcCreateInstance = (DxcCreateInstanceProc)dlsym(dxc, "DxcCreateInstance");
+#endif // _WIN32
+    }
+
+private:
+    DxcCreateInstanceProc DxcCreateInstance;
+
+};
+
+
+}// namespace shader
+}// namespace buma
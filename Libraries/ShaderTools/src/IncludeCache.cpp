@@ -0,0 +1,59 @@
+#include <ShaderTools/IncludeCache.h>
+#include "./ShaderSource.h"
+
+#include <filesystem>
+
+namespace buma
+{
+namespace shader
+{
+
+IncludeCache::IncludeCache()
+    : mutex {}
+    , files {}
+{
+}
+
+IncludeCache::~IncludeCache()
+{
+}
+
+std::shared_ptr<const IncludeCache::FILE> IncludeCache::Load(const std::string& _path)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = files.find(_path);
+        if (it != files.end())
+            return it->second;
+    }
+
+    // 読み込み中はロックを保持しません。 複数のワーカーが同時に読み込んだ場合は最初に格納された内容を使用します。
+    auto file = std::make_shared<FILE>();
+    if (!ReadSourceFile(std::filesystem::u8path(_path), &file->content))
+        return nullptr;
+    file->content_hash = HashSource(file->content);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return files.emplace(_path, std::move(file)).first->second;
+}
+
+void IncludeCache::Invalidate(const std::string& _path)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    files.erase(_path);
+}
+
+void IncludeCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    files.clear();
+}
+
+std::string IncludeCache::NormalizePath(const std::string& _path)
+{
+    return std::filesystem::u8path(_path).lexically_normal().u8string();
+}
+
+
+}// namespace shader
+}// namespace buma
@@ -0,0 +1,78 @@
+#include <ShaderTools/ShaderBinary.h>
+
+#include <Utils/MappedFile.h>
+
+#include <fstream>
+#include <filesystem>
+
+namespace buma
+{
+namespace shader
+{
+
+ShaderBinary::ShaderBinary()
+    : file      {}
+    , storage   {}
+    , data      {}
+    , size      {}
+{
+}
+
+ShaderBinary::~ShaderBinary()
+{
+}
+
+std::unique_ptr<ShaderBinary> ShaderBinary::Open(const char* _filename)
+{
+    if (!_filename)
+        return nullptr;
+
+    std::unique_ptr<ShaderBinary> result(new ShaderBinary());
+    if (!result->Init(_filename))
+        return nullptr;
+
+    return result;
+}
+
+std::unique_ptr<ShaderBinary> ShaderBinary::Create(std::vector<uint8_t>&& _bytecode)
+{
+    std::unique_ptr<ShaderBinary> result(new ShaderBinary());
+    result->storage = std::move(_bytecode);
+    result->data    = result->storage.data();
+    result->size    = result->storage.size();
+    return result;
+}
+
+bool ShaderBinary::Init(const char* _filename)
+{
+    file = util::MappedFile::Open(_filename);
+    if (file)
+    {
+        data = file->GetData();
+        size = file->GetSize();
+        return true;
+    }
+
+    // マップに失敗した場合(空のファイル、マップをサポートしないファイルシステム等)はサイズを取得してから一度に読み込みます。
+    std::ifstream ifs(std::filesystem::u8path(_filename), std::ios::in | std::ios::binary | std::ios::ate);
+    if (!ifs.is_open())
+        return false;
+
+    auto file_size = static_cast<size_t>(ifs.tellg());
+    if (file_size == 0)
+        return false;
+
+    ifs.seekg(0, std::ios::beg);
+    storage.resize(file_size);
+    ifs.read(reinterpret_cast<char*>(storage.data()), static_cast<std::streamsize>(file_size));
+    if (ifs.fail())
+        return false;
+
+    data = storage.data();
+    size = storage.size();
+    return true;
+}
+
+
+}// namespace shader
+}// namespace buma
@@ -0,0 +1,346 @@
+#include <ShaderTools/ShaderCache.h>
+#include <ShaderTools/ShaderBinary.h>
+#include "./ShaderSource.h"
+
+#include <Utils/Logger.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace buma
+{
+namespace shader
+{
+
+namespace /*anonymous*/
+{
+
+constexpr const char* INDEX_FILENAME = "index.bin";
+
+// インデックスの各要素の最小サイズです。 破損したインデックスの要素数や長さを、ファイルの残りのサイズで検証するために使用します。
+constexpr uint64_t MIN_INDEX_ENTRY_SIZE      = sizeof(uint64_t/*key*/) + sizeof(uint64_t/*blob_hash*/) + sizeof(uint64_t/*blob_size*/) + sizeof(uint32_t/*num_dependencies*/);
+constexpr uint64_t MIN_INDEX_DEPENDENCY_SIZE = sizeof(uint32_t/*path_length*/) + sizeof(uint64_t/*content_hash*/);
+
+template<typename T>
+inline void WriteValue(std::ofstream& _ofs, const T& _val)
+{
+    _ofs.write(reinterpret_cast<const char*>(&_val), sizeof(T));
+}
+
+template<typename T>
+inline bool ReadValue(std::ifstream& _ifs, T* _val)
+{
+    _ifs.read(reinterpret_cast<char*>(_val), sizeof(T));
+    return !_ifs.fail();
+}
+
+inline uint64_t GetRemainingSize(std::ifstream& _ifs, uint64_t _file_size)
+{
+    auto pos = static_cast<uint64_t>(_ifs.tellg());
+    return pos < _file_size ? _file_size - pos : 0;
+}
+
+inline bool ReadBinaryFile(const std::filesystem::path& _path, std::vector<uint8_t>* _dst)
+{
+    std::ifstream ifs(_path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!ifs.is_open())
+        return false;
+
+    auto size = static_cast<size_t>(ifs.tellg());
+    ifs.seekg(0, std::ios::beg);
+    _dst->resize(size);
+    ifs.read(reinterpret_cast<char*>(_dst->data()), static_cast<std::streamsize>(size));
+    return !ifs.fail();
+}
+
+
+}// namespace /*anonymous*/
+
+
+ShaderCache::ShaderCache(const char* _cache_dir)
+    : dir       { _cache_dir }
+    , mutex     {}
+    , entries   {}
+    , is_dirty  {}
+{
+}
+
+ShaderCache::~ShaderCache()
+{
+    Flush();
+}
+
+std::unique_ptr<ShaderCache> ShaderCache::Open(const char* _cache_dir)
+{
+    if (!_cache_dir)
+        return nullptr;
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::u8path(_cache_dir), ec);
+    if (!std::filesystem::is_directory(std::filesystem::u8path(_cache_dir)))
+    {
+        BUMA_LOGE("Failed to create shader cache directory {}", _cache_dir);
+        return nullptr;
+    }
+
+    std::unique_ptr<ShaderCache> result(new ShaderCache(_cache_dir));
+    if (!result->LoadIndex())
+    {
+        BUMA_LOGW("Shader cache index in {} is invalid, starting with an empty cache", _cache_dir);
+        result->entries.clear();
+    }
+
+    return result;
+}
+
+bool ShaderCache::LoadIndex()
+{
+    std::ifstream ifs(std::filesystem::u8path(dir) / INDEX_FILENAME, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!ifs.is_open())
+        return true;
+
+    auto file_size = static_cast<uint64_t>(ifs.tellg());
+    ifs.seekg(0, std::ios::beg);
+
+    SHADER_CACHE_INDEX_HEADER header{};
+    if (!ReadValue(ifs, &header))
+        return false;
+
+    if (header.magic != SHADER_CACHE_MAGIC || header.version != SHADER_CACHE_VERSION)
+        return false;
+
+    if (header.num_entries > GetRemainingSize(ifs, file_size) / MIN_INDEX_ENTRY_SIZE)
+        return false;
+
+    entries.reserve(static_cast<size_t>(header.num_entries));
+    for (uint64_t i = 0; i < header.num_entries; i++)
+    {
+        uint64_t key{};
+        uint32_t num_dependencies{};
+        ENTRY entry{};
+        if (!ReadValue(ifs, &key) || !ReadValue(ifs, &entry.blob_hash) || !ReadValue(ifs, &entry.blob_size) || !ReadValue(ifs, &num_dependencies))
+            return false;
+
+        if (num_dependencies > GetRemainingSize(ifs, file_size) / MIN_INDEX_DEPENDENCY_SIZE)
+            return false;
+
+        entry.dependencies.resize(num_dependencies);
+        for (auto&& d : entry.dependencies)
+        {
+            uint32_t path_length{};
+            if (!ReadValue(ifs, &path_length))
+                return false;
+
+            if (path_length > GetRemainingSize(ifs, file_size))
+                return false;
+
+            d.path.resize(path_length);
+            ifs.read(d.path.data(), path_length);
+            if (ifs.fail() || !ReadValue(ifs, &d.content_hash))
+                return false;
+        }
+
+        entries[key] = std::move(entry);
+    }
+
+    return true;
+}
+
+bool ShaderCache::Flush()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!is_dirty)
+        return true;
+
+    // 書き込み中に中断されてもインデックスが破損しないよう、一時ファイルに書き込んでから置き換えます。
+    auto index_path = std::filesystem::u8path(dir) / INDEX_FILENAME;
+    auto temp_path  = index_path;
+    temp_path += ".tmp";
+    {
+        std::ofstream ofs(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open())
+            return false;
+
+        WriteValue(ofs, SHADER_CACHE_INDEX_HEADER{ SHADER_CACHE_MAGIC, SHADER_CACHE_VERSION, entries.size() });
+        for (auto&& [key, entry] : entries)
+        {
+            WriteValue(ofs, key);
+            WriteValue(ofs, entry.blob_hash);
+            WriteValue(ofs, entry.blob_size);
+            WriteValue(ofs, static_cast<uint32_t>(entry.dependencies.size()));
+            for (auto&& d : entry.dependencies)
+            {
+                WriteValue(ofs, static_cast<uint32_t>(d.path.size()));
+                ofs.write(d.path.data(), d.path.size());
+                WriteValue(ofs, d.content_hash);
+            }
+        }
+        if (ofs.fail())
+            return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, index_path, ec);
+    if (ec)
+        return false;
+
+    is_dirty = false;
+    return true;
+}
+
+void ShaderCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::error_code ec;
+    for (auto&& [key, entry] : entries)
+    {
+        std::filesystem::remove(std::filesystem::u8path(GetBlobPath(entry.blob_hash)), ec);
+        std::filesystem::remove(std::filesystem::u8path(GetBlobPath(entry.blob_hash, "refl")), ec);
+    }
+
+    entries.clear();
+    is_dirty = true;
+}
+
+size_t ShaderCache::GetNumEntries() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+bool ShaderCache::Find(uint64_t _key, std::vector<uint8_t>* _dst, std::vector<SHADER_DEPENDENCY>* _dependencies)
+{
+    ENTRY entry{};
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(_key);
+        if (it == entries.end())
+            return false;
+        entry = it->second;
+    }
+
+    if (!IsUpToDate(entry))
+        return false;
+
+    std::vector<uint8_t> blob;
+    if (!ReadBinaryFile(std::filesystem::u8path(GetBlobPath(entry.blob_hash)), &blob))
+        return false;
+
+    // バイナリが外部から変更、または切り詰められている場合はミスとして扱います。
+    if (blob.size() != entry.blob_size || Hash(blob.data(), blob.size()) != entry.blob_hash)
+        return false;
+
+    *_dst = std::move(blob);
+    if (_dependencies)
+        *_dependencies = std::move(entry.dependencies);
+
+    return true;
+}
+
+bool ShaderCache::Store(uint64_t _key, const std::vector<SHADER_DEPENDENCY>& _dependencies, const std::vector<uint8_t>& _blob)
+{
+    if (_blob.empty())
+        return false;
+
+    ENTRY entry{};
+    entry.blob_hash     = Hash(_blob.data(), _blob.size());
+    entry.blob_size     = _blob.size();
+    entry.dependencies  = _dependencies;
+
+    auto blob_path = GetBlobPath(entry.blob_hash);
+    std::error_code ec;
+    if (!std::filesystem::exists(std::filesystem::u8path(blob_path), ec) || std::filesystem::file_size(std::filesystem::u8path(blob_path), ec) != _blob.size())
+    {
+        if (!WriteFileAtomic(blob_path, _blob, _key))
+            return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[_key] = std::move(entry);
+    is_dirty = true;
+    return true;
+}
+
+bool ShaderCache::StoreReflection(const std::vector<uint8_t>& _blob, const std::vector<uint8_t>& _reflection)
+{
+    if (_blob.empty() || _reflection.empty())
+        return false;
+
+    auto blob_hash = Hash(_blob.data(), _blob.size());
+    return WriteFileAtomic(GetBlobPath(blob_hash, "refl"), _reflection, std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+
+std::unique_ptr<ShaderBinary> ShaderCache::OpenReflection(const std::vector<uint8_t>& _blob) const
+{
+    if (_blob.empty())
+        return nullptr;
+
+    return ShaderBinary::Open(GetBlobPath(Hash(_blob.data(), _blob.size()), "refl").c_str());
+}
+
+bool ShaderCache::WriteFileAtomic(const std::string& _path, const std::vector<uint8_t>& _data, uint64_t _temp_suffix)
+{
+    // 同じファイルを並列に書き込む場合に備え、一時ファイルを経由します。
+    auto path      = std::filesystem::u8path(_path);
+    auto temp_path = path;
+    temp_path += "." + std::to_string(_temp_suffix) + ".tmp";
+    {
+        std::ofstream ofs(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open())
+            return false;
+        ofs.write(reinterpret_cast<const char*>(_data.data()), _data.size());
+        if (ofs.fail())
+            return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+bool ShaderCache::IsUpToDate(const ENTRY& _entry) const
+{
+    std::string source;
+    for (auto&& d : _entry.dependencies)
+    {
+        if (!ReadSourceFile(std::filesystem::u8path(d.path), &source))
+            return false;
+
+        if (HashSource(source) != d.content_hash)
+            return false;
+    }
+
+    return true;
+}
+
+std::string ShaderCache::GetBlobPath(uint64_t _blob_hash, const char* _extension) const
+{
+    char name[32]{};
+    std::snprintf(name, sizeof(name), "%016llx.%s", static_cast<unsigned long long>(_blob_hash), _extension);
+    return (std::filesystem::u8path(dir) / name).u8string();
+}
+
+uint64_t ShaderCache::Hash(const void* _data, size_t _size, uint64_t _seed)
+{
+    constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+    auto data = static_cast<const uint8_t*>(_data);
+    auto hash = _seed;
+    for (size_t i = 0; i < _size; i++)
+    {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+
+}// namespace shader
+}// namespace buma
@@ -0,0 +1,247 @@
+#include <ShaderTools/ShaderHotReloader.h>
+#include "./ShaderSource.h"
+
+#include <Utils/Logger.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace buma
+{
+namespace shader
+{
+
+ShaderHotReloader::ShaderHotReloader(COMPILE_TARGET _target, uint32_t _poll_interval_ms)
+    : target            { _target }
+    , poll_interval_ms  { _poll_interval_ms }
+    , include_cache     {}
+    , mutex             {}
+    , next_id           { 1 }
+    , shaders           {}
+    , files             {}
+    , results           {}
+    , exit_cv           {}
+    , should_exit       {}
+    , worker            {}
+{
+}
+
+ShaderHotReloader::~ShaderHotReloader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        should_exit = true;
+    }
+    exit_cv.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+std::unique_ptr<ShaderHotReloader> ShaderHotReloader::Create(COMPILE_TARGET _target, uint32_t _poll_interval_ms)
+{
+    std::unique_ptr<ShaderHotReloader> result(new ShaderHotReloader(_target, _poll_interval_ms));
+    result->worker = std::thread([reloader = result.get()]() { reloader->WorkerMain(); });
+    return result;
+}
+
+SHADER_HOT_RELOAD_ID ShaderHotReloader::Register(const LOAD_SHADER_DESC& _desc, const std::vector<SHADER_DEPENDENCY>& _dependencies)
+{
+    if (!_desc.filename)
+    {
+        BUMA_LOGE("ShaderHotReloader: only shaders compiled from files can be registered");
+        return 0;
+    }
+
+    auto shader = std::make_shared<SHADER>();
+    shader->desc.Assign(_desc);
+
+    // ソース自体は依存ファイルに含まれないため、ここで内容のハッシュを取得します。
+    auto source = include_cache.Load(IncludeCache::NormalizePath(_desc.filename));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    shader->id = next_id++;
+    LinkFiles(*shader, _dependencies, source ? source->content_hash : 0);
+    shaders.emplace(shader->id, shader);
+    return shader->id;
+}
+
+void ShaderHotReloader::Unregister(SHADER_HOT_RELOAD_ID _id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = shaders.find(_id);
+    if (it == shaders.end())
+        return;
+
+    UnlinkFiles(*it->second);
+    shaders.erase(it);
+}
+
+bool ShaderHotReloader::PopResults(std::vector<SHADER_HOT_RELOAD_RESULT>* _results)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (results.empty())
+        return false;
+
+    *_results = std::move(results);
+    results.clear();
+    return true;
+}
+
+void ShaderHotReloader::LinkFiles(SHADER& _shader, const std::vector<SHADER_DEPENDENCY>& _dependencies, uint64_t _source_hash)
+{
+    auto AddFile = [&](const std::string& _path, uint64_t _content_hash)
+    {
+        if (std::find(_shader.files.begin(), _shader.files.end(), _path) != _shader.files.end())
+            return;
+
+        auto [it, inserted] = files.try_emplace(_path);
+        if (inserted)
+        {
+            // 次のポーリングで必ず内容を比較させ、コンパイルから登録までの間の変更も検出します。
+            it->second.last_write_time  = std::filesystem::file_time_type::min();
+            it->second.content_hash     = _content_hash;
+        }
+        it->second.shaders.push_back(_shader.id);
+        _shader.files.push_back(_path);
+    };
+
+    AddFile(IncludeCache::NormalizePath(_shader.desc.Get().filename), _source_hash);
+    for (auto& i : _dependencies)
+        AddFile(i.path, i.content_hash);
+}
+
+void ShaderHotReloader::UnlinkFiles(SHADER& _shader)
+{
+    for (auto& path : _shader.files)
+    {
+        auto it = files.find(path);
+        if (it == files.end())
+            continue;
+
+        auto&& dependents = it->second.shaders;
+        dependents.erase(std::remove(dependents.begin(), dependents.end(), _shader.id), dependents.end());
+        if (dependents.empty())
+            files.erase(it);
+    }
+    _shader.files.clear();
+}
+
+void ShaderHotReloader::DetectChangedFiles(std::vector<std::string>* _changed_files)
+{
+    std::vector<std::pair<std::string, std::filesystem::file_time_type>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        snapshot.reserve(files.size());
+        for (auto& [path, file] : files)
+            snapshot.emplace_back(path, file.last_write_time);
+    }
+
+    // 更新日時の取得と内容の読み込みはロックの外で行います。
+    std::string content;
+    for (auto& [path, last_write_time] : snapshot)
+    {
+        std::error_code ec;
+        auto time = std::filesystem::last_write_time(std::filesystem::u8path(path), ec);
+        if (ec || time == last_write_time) // エディタによっては保存中に一時的にファイルが存在しなくなります。
+            continue;
+
+        uint64_t content_hash = ReadSourceFile(std::filesystem::u8path(path), &content) ? HashSource(content) : 0;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = files.find(path);
+        if (it == files.end())
+            continue;
+
+        it->second.last_write_time = time;
+        if (it->second.content_hash != content_hash)
+        {
+            it->second.content_hash = content_hash;
+            _changed_files->push_back(path);
+        }
+    }
+}
+
+void ShaderHotReloader::Recompile(const std::vector<std::string>& _changed_files)
+{
+    std::vector<std::shared_ptr<SHADER>> targets;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& path : _changed_files)
+        {
+            BUMA_LOGI("Shader file changed: {}", path);
+            include_cache.Invalidate(path);
+
+            auto it = files.find(path);
+            if (it == files.end())
+                continue;
+
+            for (auto id : it->second.shaders)
+            {
+                auto&& shader = shaders.at(id);
+                if (std::find(targets.begin(), targets.end(), shader) == targets.end())
+                    targets.push_back(shader);
+            }
+        }
+    }
+    if (targets.empty())
+        return;
+
+    // 変更されていないファイルは include_cache に残っているため、読み込み直されません。
+    std::vector<LOAD_SHADER_DESC>       descs;
+    std::vector<SHADER_COMPILE_RESULT>  compile_results(targets.size());
+    descs.reserve(targets.size());
+    for (auto& i : targets)
+        descs.emplace_back(i->desc.Get());
+
+    COMPILE_BATCH_DESC batch{};
+    batch.num_shaders   = descs.size();
+    batch.descs         = descs.data();
+    batch.include_cache = &include_cache;
+    ShaderLoader::CompileBatch(target, batch, compile_results.data());
+
+    std::vector<uint64_t> source_hashes(targets.size());
+    for (size_t i = 0; i < targets.size(); i++)
+    {
+        auto source = include_cache.Load(IncludeCache::NormalizePath(targets[i]->desc.Get().filename));
+        source_hashes[i] = source ? source->content_hash : 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < targets.size(); i++)
+    {
+        auto&& shader = *targets[i];
+        auto&& result = compile_results[i];
+        if (shaders.find(shader.id) == shaders.end()) // 再コンパイル中に登録解除されました。
+            continue;
+
+        // 成功した場合は依存関係を置き換えます。 失敗した場合はいずれかのファイルの修正で再度コンパイルされるよう、以前の依存関係を残したまま追加します。
+        if (result.succeeded)
+            UnlinkFiles(shader);
+        LinkFiles(shader, result.dependencies, source_hashes[i]);
+
+        results.push_back({ shader.id, std::move(result) });
+    }
+    BUMA_LOGI("Recompiled {} shader(s)", targets.size());
+}
+
+void ShaderHotReloader::WorkerMain()
+{
+    std::vector<std::string> changed_files;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (exit_cv.wait_for(lock, std::chrono::milliseconds(poll_interval_ms), [this]() { return should_exit; }))
+                break;
+        }
+
+        changed_files.clear();
+        DetectChangedFiles(&changed_files);
+        if (!changed_files.empty())
+            Recompile(changed_files);
+    }
+}
+
+
+}// namespace shader
+}// namespace buma
@@ -1,26 +1,22 @@
 #include <ShaderTools/ShaderLoader.h>
+#include <ShaderTools/ShaderCache.h>
+#include <ShaderTools/ShaderBinary.h>
+#include "./DxcModule.h"
 
 #include <Utils/Definitions.h>
 #include <Utils/Utils.h>
 #include <Utils/Logger.h>
 
-#include <d3d12shader.h>
-#include <dxcapi.h>
-
-#ifdef _WIN32
-#include <wrl.h>
-#else
-#error support non-Windows
-#endif // _WIN32
-
 #include <cassert>
+#include <cstring>
+#include <algorithm>
 #include <fstream>
 #include <memory>
 #include <map>
+#include <unordered_map>
 #include <filesystem>
-
-template <typename T>
-using ComPtr = Microsoft::WRL::ComPtr<T>;
+#include <thread>
+#include <atomic>
 
 namespace buma
 {
@@ -33,22 +29,31 @@ namespace /*anonymous*/
 class IncludeHandler : public IDxcIncludeHandler
 {
 public:
-    explicit IncludeHandler(IDxcUtils* _utl)
-        : ref{ 0 }
-        , utl{ _utl }
+    IncludeHandler(IDxcUtils* _utl, IncludeCache* _include_cache)
+        : ref           { 0 }
+        , utl           { _utl }
+        , include_cache { _include_cache }
+        , files         {}
+        , dependencies  {}
     {
     }
 
     HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR pFilename, IDxcBlob** ppIncludeSource) override
     {
-        if (!std::filesystem::exists(pFilename))
+        // LPCWSTR は Windows では UTF-16 、それ以外では UTF-32 です。 std::filesystem::path を介してUTF-8に変換します。
+        auto path = IncludeCache::NormalizePath(std::filesystem::path(pFilename).u8string());
+        auto file = include_cache->Load(path);
+        if (!file)
             return E_FAIL;
 
-        std::ifstream file(pFilename, std::ios::in);
-        std::string source = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        // キャッシュのエントリは、ここで読み込まれた全てのファイルが変更されていない場合にのみ有効です。
+        if (std::none_of(dependencies.begin(), dependencies.end(), [&path](const SHADER_DEPENDENCY& _dep) { return _dep.path == path; }))
+            dependencies.push_back({ path, file->content_hash });
 
+        // 内容はこのハンドラが破棄されるまで files が保持するため、コピーせずに参照させます。
+        files.push_back(file);
         *ppIncludeSource = nullptr;
-        return utl->CreateBlob(source.c_str(), source.size(), DXC_CP_UTF8, reinterpret_cast<IDxcBlobEncoding**>(ppIncludeSource));
+        return utl->CreateBlobFromPinned(file->content.data(), static_cast<UINT32>(file->content.size()), DXC_CP_UTF8, reinterpret_cast<IDxcBlobEncoding**>(ppIncludeSource));
     }
 
     ULONG STDMETHODCALLTYPE AddRef() override
@@ -88,64 +93,47 @@ public:
         }
     }
 
+    const std::vector<SHADER_DEPENDENCY>& GetDependencies() const { return dependencies; }
+
 private:
     std::atomic_uint32_t ref;
     IDxcUtils* utl;
+    IncludeCache* include_cache;
+    std::vector<std::shared_ptr<const IncludeCache::FILE>> files;
+    std::vector<SHADER_DEPENDENCY> dependencies;
 
 };
 
-std::string BlobToUtf8(IDxcBlob* _blob)
+std::string BlobToUtf8(IDxcUtils* _utl, IDxcBlob* _blob)
 {
     if (!_blob)
         return std::string();
 
+    // UTF-16/32等の他のエンコーディングの変換は、プラットフォームのワイド文字の幅に依存しないよう IDxcUtils に任せます。
     ComPtr<IDxcBlobUtf8> blobu8;
-    if (SUCCEEDED(_blob->QueryInterface(IID_PPV_ARGS(&blobu8))))
-        return std::string(blobu8->GetStringPointer(), blobu8->GetStringLength());
-
-    ComPtr<IDxcBlobEncoding> enc;
-    _blob->QueryInterface(IID_PPV_ARGS(&enc));
-    BOOL known; UINT32 cp;
-    enc->GetEncoding(&known, &cp);
-    if (!known)
-        BUMA_ASSERT(false && "unknown codepage for blob.");
-
-    std::string result;
-    if (cp == DXC_CP_UTF16)
+    if (FAILED(_blob->QueryInterface(IID_PPV_ARGS(&blobu8))))
     {
-        const wchar_t* text = (const wchar_t*)_blob->GetBufferPointer();
-        size_t length = _blob->GetBufferSize() / sizeof(wchar_t);
-        if (length >= 1 && text[length - 1] == L'\0')
-            length -= 1;  // Exclude null-terminator
-
-        result = util::ConvertWideToUtf8(text);
-        return result;
+        if (FAILED(_utl->GetBlobAsUtf8(_blob, &blobu8)))
+        {
+            BUMA_ASSERT(false && "Unsupported codepage.");
+            return std::string();
+        }
     }
-    else if (cp == CP_UTF8)
-    {
-        const char* text = (const char*)_blob->GetBufferPointer();
-        size_t length = _blob->GetBufferSize();
-        if (length >= 1 && text[length - 1] == '\0')
-            length -= 1;  // Exclude null-terminator
 
-        result.resize(length);
-        memcpy(result.data(), text, length);
-        return result;
-    }
-    else
-    {
-        BUMA_ASSERT(false && "Unsupported codepage.");
-        return std::string();
-    }
+    return std::string(blobu8->GetStringPointer(), blobu8->GetStringLength());
 }
 
 void PrepareDefines(const buma::shader::LOAD_SHADER_DESC& _desc, IDxcCompilerArgs* _args)
 {
+    // 引数はUTF-8のまま渡します。 値が指定されない場合、DXCはマクロを1として定義します。
     for (auto& i : _desc.defines)
     {
-        auto&& n = util::ConvertAnsiToWide(i.def_name);
-        auto&& v = util::ConvertAnsiToWide(i.def_value);
-        _args->AddDefines(&DxcDefine({ n.c_str(), v.c_str() }), 1);
+        std::string define = i.def_name;
+        if (i.def_value)
+            define.append("=").append(i.def_value);
+
+        const char* args[2] = { "-D", define.c_str() };
+        _args->AddArgumentsUTF8(args, 2);
     }
 }
 
@@ -273,11 +261,187 @@ void PrepareOptions(  const buma::shader::OPTIONS&  _opt
     }
 
     size_t cnt = 0;
-    std::vector<LPCSTR> tmp(args.size());
+    std::vector<const char*> tmp(args.size());
     for (auto& i : args) tmp.data()[cnt++] = i.c_str();
     _args->AddArgumentsUTF8(tmp.data(), (uint32_t)tmp.size());
 }
 
+// シェーダキャッシュのキーです。 コンパイラに渡される引数に影響する全ての値とソースを含みます。
+uint64_t CalcCacheKey(COMPILE_TARGET _type, const LOAD_SHADER_DESC& _desc, const char* _src)
+{
+    uint64_t key = ShaderCache::Hash(&SHADER_CACHE_VERSION, sizeof(SHADER_CACHE_VERSION));
+    auto Add = [&key](const void* _data, size_t _size) { key = ShaderCache::Hash(_data, _size, key); };
+    auto AddValue = [&Add](auto _val) { Add(&_val, sizeof(_val)); };
+    auto AddString = [&Add, &AddValue](const char* _str)
+    {
+        // nullptrと空文字列を区別するため、長さを先に加えます。
+        auto length = _str ? std::strlen(_str) : SIZE_MAX;
+        AddValue(static_cast<uint64_t>(length));
+        if (_str)
+            Add(_str, length);
+    };
+
+    AddValue(static_cast<uint32_t>(_type));
+    AddValue(static_cast<uint32_t>(_desc.stage));
+    AddString(_desc.entry_point ? _desc.entry_point : "main");
+    AddString(_desc.filename); // インクルードの解決に影響します。
+
+    AddValue(static_cast<uint64_t>(_desc.defines.size()));
+    for (auto& i : _desc.defines)
+    {
+        AddString(i.def_name);
+        AddString(i.def_value);
+    }
+
+    auto&& opt = _desc.options;
+    AddValue(opt.pack_matrices_in_row_major);
+    AddValue(opt.enable_16bit_types);
+    AddValue(opt.enable_debug_info);
+    AddValue(opt.disable_optimizations);
+    AddValue(opt.optimization_level);
+    AddValue(opt.shader_model.FullVersion());
+    AddValue(opt.shift_all_tex_bindings);
+    AddValue(opt.shift_all_samp_bindings);
+    AddValue(opt.shift_all_cbuf_bindings);
+    AddValue(opt.shift_all_ubuf_bindings);
+    AddValue(static_cast<uint64_t>(opt.register_shifts ? opt.register_shifts->size() : 0));
+    if (opt.register_shifts)
+    {
+        for (auto& i : *opt.register_shifts)
+        {
+            AddValue(i.space);
+            AddValue(i.shift_tex_bindings);
+            AddValue(i.shift_samp_bindings);
+            AddValue(i.shift_cbuf_bindings);
+            AddValue(i.shift_ubuf_bindings);
+        }
+    }
+
+    AddString(_src);
+    return key;
+}
+
+// dxcompilerのモジュールとインスタンスです。 IDxcCompiler3 はスレッドセーフではないため、スレッド毎に作成します。
+class DxcInstance
+{
+public:
+    DxcInstance()
+        : dxc   { DxcModule::Get() }
+        , utl   {}
+        , comp  {}
+    {
+        if (!dxc.IsValid())
+            return;
+
+        // IDxcUtils は、コンパイラに渡すBlobや引数バッファ等のユーティリティオブジェクトを作成することができます。
+        dxc.CreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&utl));
+        dxc.CreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&comp));
+    }
+
+    bool IsValid() const { return utl && comp; }
+
+    void Compile(COMPILE_TARGET _type, const LOAD_SHADER_DESC& _desc, const char* _src, IncludeCache* _include_cache, SHADER_COMPILE_RESULT* _result)
+    {
+        // コンパイル引数を設定
+        ComPtr<IDxcCompilerArgs> args;
+        dxc.CreateInstance(CLSID_DxcCompilerArgs, IID_PPV_ARGS(&args));
+        {
+            PrepareDefines(_desc, args.Get());
+
+            PrepareTargetDesc(_desc.stage, _type, args.Get());
+
+            PrepareOptions(_desc.options, _type, _desc.stage, args.Get());
+
+            const char* entry_point[2] = { "-E", _desc.entry_point ? _desc.entry_point : "main" };
+            args->AddArgumentsUTF8(entry_point, 2);
+
+            if (_desc.filename)
+            {
+                const char* filename = _desc.filename;
+                args->AddArgumentsUTF8(&filename, 1);
+            }
+        }
+
+        // コンパイル
+        ComPtr<IDxcResult> result;
+        ComPtr<IncludeHandler> handler = new IncludeHandler(utl.Get(), _include_cache);
+        {
+            DxcBuffer src{};
+            src.Ptr      = _src;
+            src.Size     = std::strlen(_src);
+            src.Encoding = DXC_CP_UTF8;
+
+            comp->Compile(&src, args->GetArguments(), args->GetCount(), handler.Get(), IID_PPV_ARGS(&result));
+        }
+
+        // コンパイル結果を処理
+        if (result->HasOutput(DXC_OUT_ERRORS))
+        {
+            ComPtr<IDxcBlobEncoding> err;
+            result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&err), nullptr);
+            if (auto s = BlobToUtf8(utl.Get(), err.Get()); !s.empty())
+            {
+                if (s.find_first_of("warning:") != std::string::npos)
+                    BUMA_LOGW(s);
+                else
+                    BUMA_LOGE(s);
+
+                _result->diagnostics = std::move(s);
+            }
+        }
+
+        HRESULT status{};
+        result->GetStatus(&status);
+        if (SUCCEEDED(status) && result->HasOutput(DXC_OUT_OBJECT))
+        {
+            ComPtr<IDxcBlob> obj;
+            result->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&obj), nullptr);
+
+            _result->bytecode = std::vector<uint8_t>(  reinterpret_cast<const uint8_t*>(obj->GetBufferPointer())
+                                                     , reinterpret_cast<const uint8_t*>(obj->GetBufferPointer()) + obj->GetBufferSize());
+            _result->succeeded = !_result->bytecode.empty();
+        }
+        _result->dependencies = handler->GetDependencies();
+    }
+
+private:
+    const DxcModule&        dxc;
+    ComPtr<IDxcUtils>       utl;
+    ComPtr<IDxcCompiler3>   comp;
+
+};
+
+// キャッシュを検索し、ミスした場合はコンパイラを作成してコンパイルします。 ヒットした場合コンパイラは作成されません。
+void CompileShader(COMPILE_TARGET _type, const LOAD_SHADER_DESC& _desc, const char* _src, IncludeCache* _include_cache, std::unique_ptr<DxcInstance>* _dxc, SHADER_COMPILE_RESULT* _result)
+{
+    uint64_t cache_key{};
+    if (_desc.cache)
+    {
+        cache_key = CalcCacheKey(_type, _desc, _src);
+        if (_desc.cache->Find(cache_key, &_result->bytecode, &_result->dependencies))
+        {
+            _result->succeeded    = true;
+            _result->is_cache_hit = true;
+            return;
+        }
+    }
+
+    if (!*_dxc)
+        *_dxc = std::make_unique<DxcInstance>();
+
+    if (!(*_dxc)->IsValid())
+    {
+        BUMA_LOGE("Failed to load dxcompiler");
+        _result->diagnostics = "failed to load dxcompiler";
+        return;
+    }
+
+    (*_dxc)->Compile(_type, _desc, _src, _include_cache, _result);
+
+    if (_desc.cache && _result->succeeded)
+        _desc.cache->Store(cache_key, _result->dependencies, _result->bytecode);
+}
+
 //void PrepareModules(std::vector<ShaderConductor::Compiler::ModuleDesc>& _modules, std::vector<const ShaderConductor::Compiler::ModuleDesc*>& _pmodules, const buma::shader::LIBRARY_LINK_DESC& _desc)
 //{
 //    _modules.reserve(_desc.link.modules.size());
@@ -306,6 +470,52 @@ void PrepareOptions(  const buma::shader::OPTIONS&  _opt
 }// namespace /*anonymous*/
 
 
+LoadShaderDescStorage::LoadShaderDescStorage()
+    : filename          {}
+    , entry_point       {}
+    , define_strings    {}
+    , register_shifts   {}
+    , desc              {}
+{
+}
+
+LoadShaderDescStorage::LoadShaderDescStorage(const LOAD_SHADER_DESC& _desc)
+    : LoadShaderDescStorage()
+{
+    Assign(_desc);
+}
+
+void LoadShaderDescStorage::Assign(const LOAD_SHADER_DESC& _desc)
+{
+    desc = _desc;
+    filename    = _desc.filename    ? _desc.filename    : "";
+    entry_point = _desc.entry_point ? _desc.entry_point : "";
+    desc.filename    = _desc.filename    ? filename.c_str()    : nullptr;
+    desc.entry_point = _desc.entry_point ? entry_point.c_str() : nullptr;
+
+    // 文字列のアドレスが変わらないよう、全て格納してからポインタを設定します。
+    define_strings.clear();
+    define_strings.reserve(_desc.defines.size() * 2);
+    for (auto& i : _desc.defines)
+    {
+        define_strings.emplace_back(i.def_name  ? i.def_name  : "");
+        define_strings.emplace_back(i.def_value ? i.def_value : "");
+    }
+    for (size_t i = 0; i < desc.defines.size(); i++)
+    {
+        auto&& def = desc.defines[i];
+        def.def_name  = def.def_name  ? define_strings[i * 2    ].c_str() : nullptr;
+        def.def_value = def.def_value ? define_strings[i * 2 + 1].c_str() : nullptr;
+    }
+
+    register_shifts.clear();
+    if (_desc.options.register_shifts)
+    {
+        register_shifts = *_desc.options.register_shifts;
+        desc.options.register_shifts = &register_shifts;
+    }
+}
+
 ShaderLoader::ShaderLoader(COMPILE_TARGET _type)
     : type{ _type }
 {
@@ -314,17 +524,14 @@ ShaderLoader::ShaderLoader(COMPILE_TARGET _type)
 
 void ShaderLoader::LoadShaderFromBinary(const char* _filename, std::vector<uint8_t>* _dst)
 {
-    if (!std::filesystem::exists(_filename))
+    // 所有するバッファが必要な場合のみ、マップされた内容を一度だけコピーします。 コピーが不要な場合は ShaderBinary を直接使用します。
+    auto binary = ShaderBinary::Open(_filename);
+    if (!binary)
     {
         BUMA_LOGE("{} not found", _filename);
         return;
     }
-    std::ifstream file(_filename, std::ios::in | std::ios::binary);
-    std::string source;
-    source = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
-
-    *_dst = std::vector<uint8_t>(  reinterpret_cast<const uint8_t*>(source.data())
-                                 , reinterpret_cast<const uint8_t*>(source.data()) + source.size());
+    _dst->assign(binary->GetData(), binary->GetData() + binary->GetSize());
 }
 
 void ShaderLoader::LoadShaderFromHLSL(const LOAD_SHADER_DESC& _desc, std::vector<uint8_t>* _dst)
@@ -357,73 +564,101 @@ void ShaderLoader::LoadShaderFromHLSL(COMPILE_TARGET _type, const LOAD_SHADER_DE
 
 void ShaderLoader::LoadShaderFromHLSL(COMPILE_TARGET _type, const LOAD_SHADER_DESC& _desc, const char* _src, std::vector<uint8_t>* _dst)
 {
-    // OPTIMIZE: モジュールインスタンスを保持すべき
-    auto dxc = LoadLibraryA("dxcompiler.dll");
-    {
-        auto DxcCreateInstance2 = (DxcCreateInstance2Proc)GetProcAddress(dxc, "DxcCreateInstance2");
-
-        // IDxcUtils は、コンパイラに渡すBlobや引数バッファ等のユーティリティオブジェクトを作成することができます。
-        ComPtr<IDxcUtils> utl;
-        DxcCreateInstance2(nullptr, CLSID_DxcUtils, IID_PPV_ARGS(&utl));
-
-        // コンパイル引数を設定
-        ComPtr<IDxcCompilerArgs> args;
-        DxcCreateInstance2(nullptr, CLSID_DxcCompilerArgs, IID_PPV_ARGS(&args));
-        {
-            PrepareDefines(_desc, args.Get());
+    std::unique_ptr<DxcInstance> dxc;
+    IncludeCache include_cache;
+    SHADER_COMPILE_RESULT result{};
+    CompileShader(_type, _desc, _src, &include_cache, &dxc, &result);
+    if (result.succeeded)
+        *_dst = std::move(result.bytecode);
+}
 
-            PrepareTargetDesc(_desc.stage, _type, args.Get());
+void ShaderLoader::CompileBatch(const COMPILE_BATCH_DESC& _desc, SHADER_COMPILE_RESULT* _results)
+{
+    CompileBatch(type, _desc, _results);
+}
 
-            PrepareOptions(_desc.options, _type, _desc.stage, args.Get());
+void ShaderLoader::CompileBatch(COMPILE_TARGET _type, const COMPILE_BATCH_DESC& _desc, SHADER_COMPILE_RESULT* _results)
+{
+    if (_desc.num_shaders == 0)
+        return;
 
-            const char* entry_point[2] = { "-E", _desc.entry_point ? _desc.entry_point : "main" };
-            args->AddArgumentsUTF8(entry_point, 2);
+    // ソースとインクルードファイルはキャッシュを介して読み込まれるため、同じファイルはバッチ内で一度だけ読み込まれます。
+    IncludeCache local_include_cache;
+    auto include_cache = _desc.include_cache ? _desc.include_cache : &local_include_cache;
 
-            if (_desc.filename)
-            {
-                const char* filename = _desc.filename;
-                args->AddArgumentsUTF8(&filename, 1);
-            }
+    std::vector<std::shared_ptr<const IncludeCache::FILE>>  file_sources(_desc.num_shaders);
+    std::vector<const char*>                                sources(_desc.num_shaders);
+    for (size_t i = 0; i < _desc.num_shaders; i++)
+    {
+        auto&& d = _desc.descs[i];
+        _results[i] = {};
+        if (_desc.sources && _desc.sources[i])
+        {
+            sources[i] = _desc.sources[i];
+            continue;
+        }
+        if (!d.filename)
+        {
+            _results[i].diagnostics = "no source or filename specified";
+            continue;
         }
 
-        // コンパイル
-        ComPtr<IDxcResult> result;
+        file_sources[i] = include_cache->Load(IncludeCache::NormalizePath(d.filename));
+        if (!file_sources[i])
         {
-            ComPtr<IDxcCompiler3> comp;
-            DxcCreateInstance2(nullptr, CLSID_DxcCompiler, IID_PPV_ARGS(&comp));
+            BUMA_LOGE("{} not found", d.filename);
+            _results[i].diagnostics = std::string(d.filename) + " not found";
+            continue;
+        }
+        sources[i] = file_sources[i]->content.c_str();
+    }
 
-            DxcBuffer src{};
-            src.Ptr      = _src;
-            src.Size     = std::strlen(_src);
-            src.Encoding = DXC_CP_UTF8;
+    // 重複の除去: 同じキーを持つ要求は最初の1つのみコンパイルし、結果をコピーします。
+    std::vector<size_t>                     jobs;
+    std::vector<size_t>                     duplicate_of(_desc.num_shaders, SIZE_MAX);
+    std::unordered_map<uint64_t, size_t>    unique_indices;
+    jobs.reserve(_desc.num_shaders);
+    for (size_t i = 0; i < _desc.num_shaders; i++)
+    {
+        if (!sources[i])
+            continue;
 
-            ComPtr<IncludeHandler> handler = new IncludeHandler(utl.Get());
-            comp->Compile(&src, args->GetArguments(), args->GetCount(), handler.Get(), IID_PPV_ARGS(&result));
-        }
+        auto [it, inserted] = unique_indices.emplace(CalcCacheKey(_type, _desc.descs[i], sources[i]), i);
+        if (inserted)
+            jobs.push_back(i);
+        else
+            duplicate_of[i] = it->second;
+    }
 
-        // コンパイル結果を処理
-        if (result->HasOutput(DXC_OUT_ERRORS))
+    // コンパイル: IDxcCompiler3 等のインスタンスはスレッド間で共有せず、ワーカー毎に最初のキャッシュミス時に作成します。
+    std::atomic_size_t next_job{};
+    auto Worker = [&]()
+    {
+        std::unique_ptr<DxcInstance> dxc;
+        for (size_t job = next_job++; job < jobs.size(); job = next_job++)
         {
-            ComPtr<IDxcBlobEncoding> err;
-            result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&err), nullptr);
-            if (auto s = BlobToUtf8(err.Get()); !s.empty())
-            {
-                if (s.find_first_of("warning:") != std::string::npos)
-                    BUMA_LOGW(s);
-                else
-                    BUMA_LOGE(s);
-            }
+            auto i = jobs[job];
+            CompileShader(_type, _desc.descs[i], sources[i], include_cache, &dxc, &_results[i]);
         }
-        if (result->HasOutput(DXC_OUT_OBJECT))
-        {
-            ComPtr<IDxcBlob> obj;
-            result->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&obj), nullptr);
+    };
 
-            *_dst = std::vector<uint8_t>(  reinterpret_cast<const uint8_t*>(obj->GetBufferPointer())
-                                         , reinterpret_cast<const uint8_t*>(obj->GetBufferPointer()) + obj->GetBufferSize());
-        }
+    auto num_threads = _desc.num_threads != 0 ? _desc.num_threads : static_cast<size_t>(std::thread::hardware_concurrency());
+    num_threads = (std::min)((std::max)(num_threads, size_t(1)), jobs.size());
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (size_t i = 1; i < num_threads; i++)
+        threads.emplace_back(Worker);
+
+    Worker();
+    for (auto& i : threads)
+        i.join();
+
+    for (size_t i = 0; i < _desc.num_shaders; i++)
+    {
+        if (duplicate_of[i] != SIZE_MAX)
+            _results[i] = _results[duplicate_of[i]];
     }
-    FreeLibrary(dxc);
 }
 
 //void ShaderLoader::LinkLibrary(COMPILE_TARGET _type, const LIBRARY_LINK_DESC& _desc, std::vector<uint8_t>* _dst)
@@ -1,33 +1,48 @@
 #define _SILENCE_CXX17_ITERATOR_BASE_CLASS_DEPRECATION_WARNING
 
 #include <ShaderTools/ShaderReflection.h>
+#include <ShaderTools/ShaderReflectionData.h>
 
 #include <Utils/Utils.h>
 
-#ifdef _WIN32
-#include <wrl.h>
-template <typename T>
-using ComPtr = Microsoft::WRL::ComPtr<T>;
-#endif // !_WIN32
+#include "./DxcModule.h"
 
 #include <d3d12shader.h>
-#include <dxcapi.h>
+
+#include <cstring>
+#include <unordered_map>
 
 #define ASSERT_HR(hr) assert(SUCCEEDED(hr))
 
+using buma::shader::ComPtr;
+
 namespace /* anonimous */
 {
+
+// Windows以外の環境では d3d12shader.h のインターフェイスに __uuidof が対応していないため、IIDを明示的に指定します。
+inline const GUID& GetReflectionIID(const ID3D12ShaderReflection*)
+{
+    static const GUID iid = { 0x5a58797d, 0xa72c, 0x478d, { 0x8b, 0xa2, 0xef, 0xc6, 0xb0, 0xef, 0xe8, 0x8e } };
+    return iid;
+}
+inline const GUID& GetReflectionIID(const ID3D12LibraryReflection*)
+{
+    static const GUID iid = { 0x8e349d19, 0x54db, 0x4a56, { 0x9d, 0xc9, 0x11, 0x9d, 0x87, 0xbd, 0xb8, 0x04 } };
+    return iid;
+}
+
 template <typename T>
 static void CreateDxcReflectionFromBlob(const std::vector<uint8_t>& _buffer, ComPtr<T>& _out_reflection)
 {
-    auto dxc_module = LoadLibraryA("dxcompiler.dll");
-    assert(dxc_module != NULL);
-    DxcCreateInstanceProc DxcCreateInstance = (DxcCreateInstanceProc)GetProcAddress(dxc_module, "DxcCreateInstance");
+    // 作成したリフレクションはdxcompilerのコードを参照するため、モジュールはプロセス終了まで解放されません。
+    auto&& dxc = buma::shader::DxcModule::Get();
+    if (!dxc.IsValid())
+        return;
 
     HRESULT hr{};
 
     ComPtr<IDxcLibrary> lib;
-    hr = DxcCreateInstance(CLSID_DxcLibrary, IID_PPV_ARGS(&lib));
+    hr = dxc.CreateInstance(CLSID_DxcLibrary, IID_PPV_ARGS(&lib));
     ASSERT_HR(hr);
 
     ComPtr<IDxcBlobEncoding> dxil_blob;
@@ -35,7 +50,7 @@ static void CreateDxcReflectionFromBlob(const std::vector<uint8_t>& _buffer, Com
     ASSERT_HR(hr);
 
     ComPtr<IDxcContainerReflection> container_reflection;
-    hr = DxcCreateInstance(CLSID_DxcContainerReflection, IID_PPV_ARGS(&container_reflection));
+    hr = dxc.CreateInstance(CLSID_DxcContainerReflection, IID_PPV_ARGS(&container_reflection));
     ASSERT_HR(hr);
 
     hr = container_reflection->Load(dxil_blob.Get());
@@ -44,11 +59,8 @@ static void CreateDxcReflectionFromBlob(const std::vector<uint8_t>& _buffer, Com
     uint32_t dxil_part_index = ~0u;
     hr = container_reflection->FindFirstPartKind(DXC_PART_DXIL, &dxil_part_index);
     ASSERT_HR(hr);
-    hr = container_reflection->GetPartReflection(dxil_part_index, IID_PPV_ARGS(&_out_reflection));
+    hr = container_reflection->GetPartReflection(dxil_part_index, GetReflectionIID(static_cast<const T*>(nullptr)), reinterpret_cast<void**>(&_out_reflection));
     ASSERT_HR(hr);
-
-    FreeLibrary(dxc_module);
-    dxc_module = NULL;
 }
 
 //static const buma3d::RESOURCE_FORMAT FORMAT_TABLE[4][buma::shader::REGISTER_COMPONENT_TYPE_FLOAT32] =
@@ -707,6 +719,365 @@ void InitParameterDesc(PARAMETER_DESC& _dst, const D3D12_PARAMETER_DESC& _desc)
     _dst.first_out_component    = _desc.FirstOutComponent;
 }
 
+void InitReflectionShaderDesc(REFLECTION_SHADER_DESC& _dst, const D3D12_SHADER_DESC& _desc)
+{
+    _dst.version                        = _desc.Version;
+    _dst.flags                          = _desc.Flags;
+    _dst.constant_buffers               = _desc.ConstantBuffers;
+    _dst.bound_resources                = _desc.BoundResources;
+    _dst.input_parameters               = _desc.InputParameters;
+    _dst.output_parameters              = _desc.OutputParameters;
+    _dst.instruction_count              = _desc.InstructionCount;
+    _dst.temp_register_count            = _desc.TempRegisterCount;
+    _dst.temp_array_count               = _desc.TempArrayCount;
+    _dst.def_count                      = _desc.DefCount;
+    _dst.dcl_count                      = _desc.DclCount;
+    _dst.texture_normal_instructions    = _desc.TextureNormalInstructions;
+    _dst.texture_load_instructions      = _desc.TextureLoadInstructions;
+    _dst.texture_comp_instructions      = _desc.TextureCompInstructions;
+    _dst.texture_bias_instructions      = _desc.TextureBiasInstructions;
+    _dst.texture_gradient_instructions  = _desc.TextureGradientInstructions;
+    _dst.float_instruction_count        = _desc.FloatInstructionCount;
+    _dst.int_instruction_count          = _desc.IntInstructionCount;
+    _dst.uint_instruction_count         = _desc.UintInstructionCount;
+    _dst.static_flow_control_count      = _desc.StaticFlowControlCount;
+    _dst.dynamic_flow_control_count     = _desc.DynamicFlowControlCount;
+    _dst.macro_instruction_count        = _desc.MacroInstructionCount;
+    _dst.array_instruction_count        = _desc.ArrayInstructionCount;
+    _dst.cut_instruction_count          = _desc.CutInstructionCount;
+    _dst.emit_instruction_count         = _desc.EmitInstructionCount;
+    _dst.gs_output_topology             = ConvertPrimitiveTopology(_desc.GSOutputTopology);
+    _dst.gs_max_output_vertex_count     = _desc.GSMaxOutputVertexCount;
+    _dst.input_primitive                = ConvertPrimitiveType(_desc.InputPrimitive);
+    _dst.patch_constant_parameters      = _desc.PatchConstantParameters;
+    _dst.gs_instance_count              = _desc.cGSInstanceCount;
+    _dst.control_points                 = _desc.cControlPoints;
+    _dst.hs_output_primitive            = ConvertTessellatorOutputPrimitive(_desc.HSOutputPrimitive);
+    _dst.hs_partitioning                = ConvertTessellatorPartitioning(_desc.HSPartitioning);
+    _dst.tessellator_domain             = ConvertTessellatorDomain(_desc.TessellatorDomain);
+    _dst.barrier_instructions           = _desc.cBarrierInstructions;
+    _dst.interlocked_instructions       = _desc.cInterlockedInstructions;
+    _dst.texture_store_instructions     = _desc.cTextureStoreInstructions;
+}
+
+void InitShaderDesc(SHADER_DESC& _dst, const ShaderReflectionData& _data)
+{
+    auto&& desc = _data.GetShaderDesc();
+    _dst.version                        = desc.version;
+    _dst.creator                        = _data.GetString(desc.creator);
+    _dst.flags                          = desc.flags;
+    _dst.constant_buffers               = desc.constant_buffers;
+    _dst.bound_resources                = desc.bound_resources;
+    _dst.input_parameters               = desc.input_parameters;
+    _dst.output_parameters              = desc.output_parameters;
+    _dst.instruction_count              = desc.instruction_count;
+    _dst.temp_register_count            = desc.temp_register_count;
+    _dst.temp_array_count               = desc.temp_array_count;
+    _dst.def_count                      = desc.def_count;
+    _dst.dcl_count                      = desc.dcl_count;
+    _dst.texture_normal_instructions    = desc.texture_normal_instructions;
+    _dst.texture_load_instructions      = desc.texture_load_instructions;
+    _dst.texture_comp_instructions      = desc.texture_comp_instructions;
+    _dst.texture_bias_instructions      = desc.texture_bias_instructions;
+    _dst.texture_gradient_instructions  = desc.texture_gradient_instructions;
+    _dst.float_instruction_count        = desc.float_instruction_count;
+    _dst.int_instruction_count          = desc.int_instruction_count;
+    _dst.uint_instruction_count         = desc.uint_instruction_count;
+    _dst.static_flow_control_count      = desc.static_flow_control_count;
+    _dst.dynamic_flow_control_count     = desc.dynamic_flow_control_count;
+    _dst.macro_instruction_count        = desc.macro_instruction_count;
+    _dst.array_instruction_count        = desc.array_instruction_count;
+    _dst.cut_instruction_count          = desc.cut_instruction_count;
+    _dst.emit_instruction_count         = desc.emit_instruction_count;
+    _dst.gs_output_topology             = desc.gs_output_topology;
+    _dst.gs_max_output_vertex_count     = desc.gs_max_output_vertex_count;
+    _dst.input_primitive                = desc.input_primitive;
+    _dst.patch_constant_parameters      = desc.patch_constant_parameters;
+    _dst.gs_instance_count              = desc.gs_instance_count;
+    _dst.control_points                 = desc.control_points;
+    _dst.hs_output_primitive            = desc.hs_output_primitive;
+    _dst.hs_partitioning                = desc.hs_partitioning;
+    _dst.tessellator_domain             = desc.tessellator_domain;
+    _dst.barrier_instructions           = desc.barrier_instructions;
+    _dst.interlocked_instructions       = desc.interlocked_instructions;
+    _dst.texture_store_instructions     = desc.texture_store_instructions;
+}
+
+void InitShaderInputBindDesc(SHADER_INPUT_BIND_DESC& _dst, const ShaderReflectionData& _data, const REFLECTION_INPUT_BIND_DESC& _desc)
+{
+    _dst.name               = _data.GetString(_desc.name);
+    _dst.shader_input_type  = _desc.shader_input_type;
+    _dst.start_bind_point   = _desc.start_bind_point;
+    _dst.bind_count         = _desc.bind_count;
+    _dst.binding_flags      = _desc.binding_flags;
+    _dst.return_type        = _desc.return_type;
+    _dst.dimension          = _desc.dimension;
+    _dst.num_samples        = _desc.num_samples;
+    _dst.register_space     = _desc.register_space;
+    _dst.range_id           = _desc.range_id;
+}
+
+void InitSignatureParameterDesc(SIGNATURE_PARAMETER_DESC& _dst, const ShaderReflectionData& _data, const REFLECTION_SIGNATURE_PARAMETER_DESC& _desc)
+{
+    _dst.semantic_name      = _data.GetString(_desc.semantic_name);
+    _dst.semantic_index     = _desc.semantic_index;
+    _dst.num_register       = _desc.num_register;
+    _dst.system_value_type  = _desc.system_value_type;
+    _dst.component_type     = _desc.component_type;
+    _dst.mask               = _desc.mask;
+    _dst.read_write_mask    = _desc.read_write_mask;
+    _dst.stream_index       = _desc.stream_index;
+    _dst.min_precision      = _desc.min_precision;
+}
+
+// ID3D12ShaderReflection を ShaderReflectionData の形式にシリアライズします。
+// 文字列は重複を除いて文字列テーブルに格納し、型のツリーはインデックスで参照する配列に展開します。
+class ReflectionDataWriter
+{
+public:
+    ReflectionDataWriter()
+        : strings           {}
+        , string_offsets    {}
+        , cbufs             {}
+        , variables         {}
+        , types             {}
+        , members           {}
+        , input_bindings    {}
+        , parameters        {}
+        , default_values    {}
+    {
+    }
+
+    void Write(ID3D12ShaderReflection* _reflection, std::vector<uint8_t>* _dst)
+    {
+        HRESULT hr{};
+        D3D12_SHADER_DESC d3d_shader_desc{};
+        hr = _reflection->GetDesc(&d3d_shader_desc);
+        ASSERT_HR(hr);
+
+        SHADER_REFLECTION_DATA_HEADER header{};
+        header.magic    = SHADER_REFLECTION_DATA_MAGIC;
+        header.version  = SHADER_REFLECTION_DATA_VERSION;
+
+        auto&& desc = header.shader_desc;
+        InitReflectionShaderDesc(desc, d3d_shader_desc);
+        desc.creator                        = AddString(d3d_shader_desc.Creator);
+        desc.require_flags                  = ConvertShaderRequireFlags(_reflection->GetRequiresFlags());
+        desc.thread_group_total_size        = _reflection->GetThreadGroupSize(&desc.thread_group_sizes[0], &desc.thread_group_sizes[1], &desc.thread_group_sizes[2]);
+        desc.mov_instruction_count          = _reflection->GetMovInstructionCount();
+        desc.movc_instruction_count         = _reflection->GetMovcInstructionCount();
+        desc.conversion_instruction_count   = _reflection->GetConversionInstructionCount();
+        desc.bitwise_instruction_count      = _reflection->GetBitwiseInstructionCount();
+        desc.gs_input_primitive             = ConvertPrimitiveType(_reflection->GetGSInputPrimitive());
+        desc.is_sample_frequency_shader     = _reflection->IsSampleFrequencyShader();
+        desc.num_interface_slots            = _reflection->GetNumInterfaceSlots();
+
+        D3D_FEATURE_LEVEL fl{};
+        hr = _reflection->GetMinFeatureLevel(&fl);
+        ASSERT_HR(hr);
+        desc.feature_level = ConvertFeatureLevel(fl);
+
+        for (uint32_t i = 0; i < d3d_shader_desc.ConstantBuffers; i++)
+            AddConstantBuffer(_reflection->GetConstantBufferByIndex(i));
+
+        for (uint32_t i = 0; i < d3d_shader_desc.BoundResources; i++)
+        {
+            D3D12_SHADER_INPUT_BIND_DESC bind_desc{};
+            hr = _reflection->GetResourceBindingDesc(i, &bind_desc);
+            ASSERT_HR(hr);
+            AddInputBinding(bind_desc);
+        }
+
+        D3D12_SIGNATURE_PARAMETER_DESC sigparam_desc{};
+        for (uint32_t i = 0; i < d3d_shader_desc.InputParameters; i++)
+        {
+            hr = _reflection->GetInputParameterDesc(i, &sigparam_desc);
+            ASSERT_HR(hr);
+            AddParameter(REFLECTION_SECTION_INPUT_PARAMETERS, sigparam_desc);
+        }
+        for (uint32_t i = 0; i < d3d_shader_desc.OutputParameters; i++)
+        {
+            hr = _reflection->GetOutputParameterDesc(i, &sigparam_desc);
+            ASSERT_HR(hr);
+            AddParameter(REFLECTION_SECTION_OUTPUT_PARAMETERS, sigparam_desc);
+        }
+        for (uint32_t i = 0; i < d3d_shader_desc.PatchConstantParameters; i++)
+        {
+            hr = _reflection->GetPatchConstantParameterDesc(i, &sigparam_desc);
+            ASSERT_HR(hr);
+            AddParameter(REFLECTION_SECTION_PATCH_CONSTANT_PARAMETERS, sigparam_desc);
+        }
+
+        struct SECTION_DATA { const void* data; size_t count; size_t stride; };
+        SECTION_DATA sections[REFLECTION_SECTION_NUM_SECTIONS]{};
+        sections[REFLECTION_SECTION_STRINGS]                    = { strings.data(),          strings.size(),          1 };
+        sections[REFLECTION_SECTION_CONSTANT_BUFFERS]           = { cbufs.data(),            cbufs.size(),            sizeof(REFLECTION_BUFFER_DESC) };
+        sections[REFLECTION_SECTION_VARIABLES]                  = { variables.data(),        variables.size(),        sizeof(REFLECTION_VARIABLE_DESC) };
+        sections[REFLECTION_SECTION_TYPES]                      = { types.data(),            types.size(),            sizeof(REFLECTION_TYPE_DESC) };
+        sections[REFLECTION_SECTION_TYPE_MEMBERS]               = { members.data(),          members.size(),          sizeof(REFLECTION_TYPE_MEMBER) };
+        sections[REFLECTION_SECTION_INPUT_BINDINGS]             = { input_bindings.data(),   input_bindings.size(),   sizeof(REFLECTION_INPUT_BIND_DESC) };
+        sections[REFLECTION_SECTION_INPUT_PARAMETERS]           = { parameters[0].data(),    parameters[0].size(),    sizeof(REFLECTION_SIGNATURE_PARAMETER_DESC) };
+        sections[REFLECTION_SECTION_OUTPUT_PARAMETERS]          = { parameters[1].data(),    parameters[1].size(),    sizeof(REFLECTION_SIGNATURE_PARAMETER_DESC) };
+        sections[REFLECTION_SECTION_PATCH_CONSTANT_PARAMETERS]  = { parameters[2].data(),    parameters[2].size(),    sizeof(REFLECTION_SIGNATURE_PARAMETER_DESC) };
+        sections[REFLECTION_SECTION_DEFAULT_VALUES]             = { default_values.data(),   default_values.size(),   1 };
+
+        size_t total_size = util::AlignUp(sizeof(SHADER_REFLECTION_DATA_HEADER), 8);
+        for (uint32_t i = 0; i < REFLECTION_SECTION_NUM_SECTIONS; i++)
+        {
+            header.sections[i].offset = static_cast<uint32_t>(total_size);
+            header.sections[i].count  = static_cast<uint32_t>(sections[i].count);
+            total_size = util::AlignUp(total_size + sections[i].count * sections[i].stride, 8);
+        }
+        header.total_size = static_cast<uint32_t>(total_size);
+
+        _dst->assign(total_size, 0);
+        memcpy(_dst->data(), &header, sizeof(header));
+        for (uint32_t i = 0; i < REFLECTION_SECTION_NUM_SECTIONS; i++)
+        {
+            if (sections[i].count != 0)
+                memcpy(_dst->data() + header.sections[i].offset, sections[i].data, sections[i].count * sections[i].stride);
+        }
+    }
+
+private:
+    uint32_t AddString(const char* _str)
+    {
+        std::string str = _str ? _str : "";
+        auto [it, inserted] = string_offsets.try_emplace(str, static_cast<uint32_t>(strings.size()));
+        if (inserted)
+            strings.insert(strings.end(), str.c_str(), str.c_str() + str.size() + 1);
+        return it->second;
+    }
+
+    uint32_t AddType(ID3D12ShaderReflectionType* _type)
+    {
+        D3D12_SHADER_TYPE_DESC type_desc{};
+        auto hr = _type->GetDesc(&type_desc);
+        ASSERT_HR(hr);
+
+        // メンバーの型の追加で types が再割り当てされるため、インデックスで参照します。
+        auto index = static_cast<uint32_t>(types.size());
+        types.emplace_back();
+
+        REFLECTION_TYPE_DESC t{};
+        t.variable_class    = ConvertShaderVariableClass(type_desc.Class);
+        t.variable_type     = ConvertShaderVariableType(type_desc.Type);
+        t.num_rows          = type_desc.Rows;
+        t.num_columns       = type_desc.Columns;
+        t.num_elements      = type_desc.Elements;
+        t.num_members       = type_desc.Members;
+        t.structure_offset  = type_desc.Offset;
+        t.type_name         = AddString(type_desc.Name);
+
+        // メンバーは連続して配置します。
+        t.first_member = static_cast<uint32_t>(members.size());
+        members.resize(members.size() + type_desc.Members);
+        for (uint32_t i = 0; i < type_desc.Members; i++)
+        {
+            auto name = AddString(_type->GetMemberTypeName(i));
+            auto type = AddType(_type->GetMemberTypeByIndex(i));
+            members[t.first_member + i] = { name, type };
+        }
+
+        auto sub_type   = _type->GetSubType();
+        auto base_class = _type->GetBaseClass();
+        t.sub_type      = sub_type   ? AddType(sub_type)   : REFLECTION_NULL_INDEX;
+        t.base_class    = base_class ? AddType(base_class) : REFLECTION_NULL_INDEX;
+
+        types[index] = t;
+        return index;
+    }
+
+    void AddConstantBuffer(ID3D12ShaderReflectionConstantBuffer* _cbuf)
+    {
+        D3D12_SHADER_BUFFER_DESC buffer_desc{};
+        auto hr = _cbuf->GetDesc(&buffer_desc);
+        ASSERT_HR(hr);
+
+        REFLECTION_BUFFER_DESC b{};
+        b.name              = AddString(buffer_desc.Name);
+        b.cb_type           = ConvertCbufferType(buffer_desc.Type);
+        b.size_of_cb        = buffer_desc.Size;
+        b.buffer_desc_flags = buffer_desc.uFlags;
+        b.first_variable    = static_cast<uint32_t>(variables.size());
+        b.num_variables     = buffer_desc.Variables;
+        cbufs.push_back(b);
+
+        // 変数の型は types に追加されるため、変数は連続して配置されます。
+        for (uint32_t i = 0; i < buffer_desc.Variables; i++)
+            AddVariable(_cbuf->GetVariableByIndex(i));
+    }
+
+    void AddVariable(ID3D12ShaderReflectionVariable* _variable)
+    {
+        D3D12_SHADER_VARIABLE_DESC sv_desc{};
+        auto hr = _variable->GetDesc(&sv_desc);
+        ASSERT_HR(hr);
+
+        REFLECTION_VARIABLE_DESC v{};
+        v.name              = AddString(sv_desc.Name);
+        v.start_offset      = sv_desc.StartOffset;
+        v.variable_size     = sv_desc.Size;
+        v.variable_flags    = ConvertShaderVariableFlags(sv_desc.uFlags);
+        v.start_texture     = sv_desc.StartTexture;
+        v.texture_size      = sv_desc.TextureSize;
+        v.start_sampler     = sv_desc.StartSampler;
+        v.sampler_size      = sv_desc.SamplerSize;
+        v.default_value     = REFLECTION_NULL_INDEX;
+        if (sv_desc.DefaultValue && sv_desc.Size != 0)
+        {
+            v.default_value = static_cast<uint32_t>(default_values.size());
+            auto src = static_cast<const uint8_t*>(sv_desc.DefaultValue);
+            default_values.insert(default_values.end(), src, src + sv_desc.Size);
+        }
+
+        auto index = variables.size();
+        variables.push_back(v);
+        variables[index].type = AddType(_variable->GetType());
+    }
+
+    void AddInputBinding(const D3D12_SHADER_INPUT_BIND_DESC& _desc)
+    {
+        auto&& b = input_bindings.emplace_back();
+        b.name              = AddString(_desc.Name);
+        b.shader_input_type = ConvertShaderInputType(_desc.Type);
+        b.start_bind_point  = _desc.BindPoint;
+        b.bind_count        = _desc.BindCount;
+        b.binding_flags     = ConvertShaderInputFlags(static_cast<D3D_SHADER_INPUT_FLAGS>(_desc.uFlags));
+        b.return_type       = ConvertResourceReturnType(_desc.ReturnType);
+        b.dimension         = ConvertSrvDimension(_desc.Dimension);
+        b.num_samples       = _desc.NumSamples;
+        b.register_space    = _desc.Space;
+        b.range_id          = _desc.uID;
+    }
+
+    void AddParameter(REFLECTION_SECTION _section, const D3D12_SIGNATURE_PARAMETER_DESC& _desc)
+    {
+        auto&& p = parameters[_section - REFLECTION_SECTION_INPUT_PARAMETERS].emplace_back();
+        p.semantic_name     = AddString(_desc.SemanticName);
+        p.semantic_index    = _desc.SemanticIndex;
+        p.num_register      = _desc.Register;
+        p.system_value_type = ConvertSystemValueName(_desc.SystemValueType);
+        p.component_type    = ConvertRegisterComponentType(_desc.ComponentType);
+        p.stream_index      = _desc.Stream;
+        p.min_precision     = ConvertMinPrecision(_desc.MinPrecision);
+        p.mask              = _desc.Mask;
+        p.read_write_mask   = _desc.ReadWriteMask;
+    }
+
+private:
+    std::vector<char>                                   strings;
+    std::unordered_map<std::string, uint32_t>           string_offsets;
+    std::vector<REFLECTION_BUFFER_DESC>                 cbufs;
+    std::vector<REFLECTION_VARIABLE_DESC>               variables;
+    std::vector<REFLECTION_TYPE_DESC>                   types;
+    std::vector<REFLECTION_TYPE_MEMBER>                 members;
+    std::vector<REFLECTION_INPUT_BIND_DESC>             input_bindings;
+    std::vector<REFLECTION_SIGNATURE_PARAMETER_DESC>    parameters[3]; // input, output, patch constant
+    std::vector<uint8_t>                                default_values;
+
+};
+
 
 }// namespace /*anonymous*/
 
@@ -792,6 +1163,16 @@ public:
         _dst.desc->size_of_cb           = shader_buffer_desc.Size;
         _dst.desc->buffer_desc_flags    = shader_buffer_desc.uFlags;
     }
+
+    static void Init(ShaderReflectionConstantBuffer& _dst, const ShaderReflectionData& _data, const REFLECTION_BUFFER_DESC& _desc)
+    {
+        _dst.desc = std::make_shared<SHADER_BUFFER_DESC>();
+        _dst.desc->name                 = _data.GetString(_desc.name);
+        _dst.desc->cb_type              = _desc.cb_type;
+        _dst.desc->num_variables        = _desc.num_variables;
+        _dst.desc->size_of_cb           = _desc.size_of_cb;
+        _dst.desc->buffer_desc_flags    = _desc.buffer_desc_flags;
+    }
 };
 
 class ShaderReflectionVariable::Initialize
@@ -914,6 +1295,26 @@ public:
             }
         }
     }
+
+    static void Init(ShaderDescData& _dst, const ShaderReflectionData& _data)
+    {
+        for (auto&& i : _data.GetConstantBuffers())
+        {
+            auto&& c = _dst.reflection_cbufs.emplace_back(std::make_shared<ShaderReflectionConstantBuffer>());
+            ShaderReflectionConstantBuffer::Initialize::Init(*c, _data, i);
+        }
+        for (auto&& i : _data.GetInputBindings())
+            InitShaderInputBindDesc(*_dst.input_bind_descs.emplace_back(std::make_shared<SHADER_INPUT_BIND_DESC>()), _data, i);
+
+        for (auto&& i : _data.GetInputParameters())
+            InitSignatureParameterDesc(*_dst.input_sig_param_descs.emplace_back(std::make_shared<SIGNATURE_PARAMETER_DESC>()), _data, i);
+
+        for (auto&& i : _data.GetOutputParameters())
+            InitSignatureParameterDesc(*_dst.output_sig_param_descs.emplace_back(std::make_shared<SIGNATURE_PARAMETER_DESC>()), _data, i);
+
+        for (auto&& i : _data.GetPatchConstantParameters())
+            InitSignatureParameterDesc(*_dst.patch_constant_sig_param_descs.emplace_back(std::make_shared<SIGNATURE_PARAMETER_DESC>()), _data, i);
+    }
 };
 
 ShaderDescData::ShaderDescData()
@@ -979,6 +1380,44 @@ bool ShaderReflection::ReflectFromBlob(const std::vector<uint8_t>& _blob)
     return true;
 }
 
+bool ShaderReflection::ReflectFromData(const ShaderReflectionData& _data)
+{
+    if (!_data.GetData())
+        return false;
+
+    shader_desc = std::make_shared<SHADER_DESC>();
+    shader_desc_data = std::make_shared<ShaderDescData>();
+    InitShaderDesc(*shader_desc, _data);
+    ShaderDescData::Initialize::Init(*shader_desc_data, _data);
+
+    auto&& desc = _data.GetShaderDesc();
+    mov_instruction_count              = desc.mov_instruction_count;
+    movc_instruction_count             = desc.movc_instruction_count;
+    conversion_instruction_count       = desc.conversion_instruction_count;
+    bitwise_instruction_count          = desc.bitwise_instruction_count;
+    gs_input_primitive                 = desc.gs_input_primitive;
+    is_sample_frequency_shader         = desc.is_sample_frequency_shader != 0;
+    num_interface_slots                = desc.num_interface_slots;
+    feature_level                      = desc.feature_level;
+    thread_group_sizes                 = { desc.thread_group_sizes[0], desc.thread_group_sizes[1], desc.thread_group_sizes[2] };
+    thread_group_total_size            = desc.thread_group_total_size;
+    require_flags                      = desc.require_flags;
+
+    return true;
+}
+
+bool ShaderReflection::SerializeFromBlob(const std::vector<uint8_t>& _blob, std::vector<uint8_t>* _dst)
+{
+    ComPtr<ID3D12ShaderReflection> reflection;
+    CreateDxcReflectionFromBlob(_blob, reflection);
+    if (!reflection)
+        return false;
+
+    ReflectionDataWriter writer;
+    writer.Write(reflection.Get(), _dst);
+    return true;
+}
+
 class FunctionParameterReflection::Initialize
 {
 public:
@@ -0,0 +1,204 @@
+#include <ShaderTools/ShaderReflectionData.h>
+#include <ShaderTools/ShaderBinary.h>
+#include <ShaderTools/ShaderCache.h>
+
+#include <Utils/Logger.h>
+
+#include <cstring>
+
+namespace buma
+{
+namespace shader
+{
+
+namespace /*anonymous*/
+{
+
+constexpr size_t SECTION_STRIDES[REFLECTION_SECTION_NUM_SECTIONS] = {
+      1                                             // REFLECTION_SECTION_STRINGS
+    , sizeof(REFLECTION_BUFFER_DESC)                // REFLECTION_SECTION_CONSTANT_BUFFERS
+    , sizeof(REFLECTION_VARIABLE_DESC)              // REFLECTION_SECTION_VARIABLES
+    , sizeof(REFLECTION_TYPE_DESC)                  // REFLECTION_SECTION_TYPES
+    , sizeof(REFLECTION_TYPE_MEMBER)                // REFLECTION_SECTION_TYPE_MEMBERS
+    , sizeof(REFLECTION_INPUT_BIND_DESC)            // REFLECTION_SECTION_INPUT_BINDINGS
+    , sizeof(REFLECTION_SIGNATURE_PARAMETER_DESC)   // REFLECTION_SECTION_INPUT_PARAMETERS
+    , sizeof(REFLECTION_SIGNATURE_PARAMETER_DESC)   // REFLECTION_SECTION_OUTPUT_PARAMETERS
+    , sizeof(REFLECTION_SIGNATURE_PARAMETER_DESC)   // REFLECTION_SECTION_PATCH_CONSTANT_PARAMETERS
+    , 1                                             // REFLECTION_SECTION_DEFAULT_VALUES
+};
+
+inline bool IsValidRange(uint64_t _offset, uint64_t _count, uint64_t _limit)
+{
+    return _offset <= _limit && _count <= _limit - _offset;
+}
+
+
+}// namespace /*anonymous*/
+
+
+ShaderReflectionData::ShaderReflectionData()
+    : storage   {}
+    , data      {}
+    , size      {}
+    , header    {}
+    , strings   {}
+{
+}
+
+ShaderReflectionData::~ShaderReflectionData()
+{
+}
+
+std::unique_ptr<ShaderReflectionData> ShaderReflectionData::Reflect(const std::vector<uint8_t>& _bytecode, ShaderCache* _cache)
+{
+    if (_cache)
+    {
+        if (auto cached = _cache->OpenReflection(_bytecode))
+        {
+            if (auto result = Create(std::move(cached)))
+                return result;
+        }
+    }
+
+    std::vector<uint8_t> serialized;
+    if (!ShaderReflection::SerializeFromBlob(_bytecode, &serialized))
+        return nullptr;
+
+    if (_cache)
+        _cache->StoreReflection(_bytecode, serialized);
+
+    return Create(ShaderBinary::Create(std::move(serialized)));
+}
+
+std::unique_ptr<ShaderReflectionData> ShaderReflectionData::Create(std::unique_ptr<ShaderBinary> _data)
+{
+    if (!_data)
+        return nullptr;
+
+    std::unique_ptr<ShaderReflectionData> result(new ShaderReflectionData());
+    if (!result->Init(_data->GetData(), _data->GetSize()))
+        return nullptr;
+
+    result->storage = std::move(_data);
+    return result;
+}
+
+bool ShaderReflectionData::Init(const void* _data, size_t _size)
+{
+    data    = _data;
+    size    = _size;
+    header  = static_cast<const SHADER_REFLECTION_DATA_HEADER*>(_data);
+    if (!Validate())
+    {
+        BUMA_LOGW("ShaderReflectionData: invalid or incompatible reflection data");
+        data    = nullptr;
+        size    = 0;
+        header  = nullptr;
+        strings = nullptr;
+        return false;
+    }
+
+    strings = GetSection<char>(REFLECTION_SECTION_STRINGS).data;
+    return true;
+}
+
+bool ShaderReflectionData::Validate() const
+{
+    // 参照時の範囲チェックを省略するため、全てのオフセットとインデックスをここで検証します。
+    if (!data || size < sizeof(SHADER_REFLECTION_DATA_HEADER) || reinterpret_cast<uintptr_t>(data) % alignof(SHADER_REFLECTION_DATA_HEADER) != 0)
+        return false;
+
+    if (header->magic != SHADER_REFLECTION_DATA_MAGIC || header->version != SHADER_REFLECTION_DATA_VERSION || header->total_size > size)
+        return false;
+
+    for (uint32_t i = 0; i < REFLECTION_SECTION_NUM_SECTIONS; i++)
+    {
+        auto&& s = header->sections[i];
+        if (s.offset % 8 != 0 || !IsValidRange(s.offset, uint64_t(s.count) * SECTION_STRIDES[i], header->total_size))
+            return false;
+    }
+
+    auto num_strings = header->sections[REFLECTION_SECTION_STRINGS].count;
+    auto str         = static_cast<const char*>(data) + header->sections[REFLECTION_SECTION_STRINGS].offset;
+    if (num_strings == 0 || str[num_strings - 1] != '\0')
+        return false;
+
+    auto IsValidString = [&](uint32_t _offset) { return _offset < num_strings; };
+    auto types   = GetTypes();
+    auto members = GetTypeMembers();
+    auto IsValidType = [&](uint32_t _index) { return _index < types.size(); };
+
+    if (!IsValidString(header->shader_desc.creator))
+        return false;
+
+    for (auto&& i : GetConstantBuffers())
+    {
+        if (!IsValidString(i.name) || !IsValidRange(i.first_variable, i.num_variables, GetVariables().size()))
+            return false;
+    }
+    for (auto&& i : GetVariables())
+    {
+        if (!IsValidString(i.name) || !IsValidType(i.type))
+            return false;
+        if (i.default_value != REFLECTION_NULL_INDEX && !IsValidRange(i.default_value, i.variable_size, header->sections[REFLECTION_SECTION_DEFAULT_VALUES].count))
+            return false;
+    }
+    for (auto&& i : types)
+    {
+        if (!IsValidString(i.type_name) || !IsValidRange(i.first_member, i.num_members, members.size()))
+            return false;
+        if ((i.sub_type != REFLECTION_NULL_INDEX && !IsValidType(i.sub_type)) || (i.base_class != REFLECTION_NULL_INDEX && !IsValidType(i.base_class)))
+            return false;
+    }
+    for (auto&& i : members)
+    {
+        if (!IsValidString(i.name) || !IsValidType(i.type))
+            return false;
+    }
+    for (auto&& i : GetInputBindings())
+    {
+        if (!IsValidString(i.name))
+            return false;
+    }
+    for (auto section : { REFLECTION_SECTION_INPUT_PARAMETERS, REFLECTION_SECTION_OUTPUT_PARAMETERS, REFLECTION_SECTION_PATCH_CONSTANT_PARAMETERS })
+    {
+        for (auto&& i : GetSection<REFLECTION_SIGNATURE_PARAMETER_DESC>(section))
+        {
+            if (!IsValidString(i.semantic_name))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+const void* ShaderReflectionData::GetDefaultValue(const REFLECTION_VARIABLE_DESC& _variable) const
+{
+    if (_variable.default_value == REFLECTION_NULL_INDEX)
+        return nullptr;
+    return GetSection<uint8_t>(REFLECTION_SECTION_DEFAULT_VALUES).data + _variable.default_value;
+}
+
+const REFLECTION_BUFFER_DESC* ShaderReflectionData::FindConstantBuffer(const char* _name) const
+{
+    for (auto&& i : GetConstantBuffers())
+    {
+        if (std::strcmp(GetString(i.name), _name) == 0)
+            return &i;
+    }
+    return nullptr;
+}
+
+const REFLECTION_INPUT_BIND_DESC* ShaderReflectionData::FindInputBinding(const char* _name) const
+{
+    for (auto&& i : GetInputBindings())
+    {
+        if (std::strcmp(GetString(i.name), _name) == 0)
+            return &i;
+    }
+    return nullptr;
+}
+
+
+}// namespace shader
+}// namespace buma
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <ShaderTools/ShaderCache.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace buma
+{
+namespace shader
+{
+
+// IncludeHandler とキャッシュの依存関係の検証は、同じ方法で読み込まれた内容のハッシュを比較します。
+inline bool ReadSourceFile(const std::filesystem::path& _path, std::string* _dst)
+{
+    if (!std::filesystem::exists(_path))
+        return false;
+
+    std::ifstream file(_path, std::ios::in);
+    if (!file.is_open())
+        return false;
+
+    *_dst = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+inline uint64_t HashSource(const std::string& _source)
+{
+    return ShaderCache::Hash(_source.data(), _source.size());
+}
+
+
+}// namespace shader
+}// namespace buma
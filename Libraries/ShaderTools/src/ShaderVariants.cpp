@@ -0,0 +1,280 @@
+#include <ShaderTools/ShaderVariants.h>
+
+#include <Utils/Definitions.h>
+#include <Utils/Logger.h>
+
+namespace buma
+{
+namespace shader
+{
+
+ShaderVariants::ShaderVariants()
+    : target                { COMPILE_TARGET_D3D12 }
+    , base_desc             {}
+    , name                  {}
+    , source                {}
+    , has_source            {}
+    , keywords              {}
+    , num_key_bits          {}
+    , num_threads           {}
+    , slots                 {}
+    , fallback              {}
+    , queue_mutex           {}
+    , queue_cv              {}
+    , idle_cv               {}
+    , queue                 {}
+    , num_in_flight         {}
+    , should_exit           {}
+    , worker                {}
+{
+}
+
+ShaderVariants::~ShaderVariants()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        should_exit = true;
+    }
+    queue_cv.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+std::unique_ptr<ShaderVariants> ShaderVariants::Create(const SHADER_VARIANTS_DESC& _desc)
+{
+    std::unique_ptr<ShaderVariants> result(new ShaderVariants());
+    if (!result->Init(_desc))
+        return nullptr;
+    return result;
+}
+
+bool ShaderVariants::Init(const SHADER_VARIANTS_DESC& _desc)
+{
+    // 呼び出し元の文字列はバックグラウンドのコンパイルまで保持されないため、全てコピーします。
+    target          = _desc.target;
+    num_threads     = _desc.num_threads;
+    has_source      = _desc.source != nullptr;
+    if (has_source)
+        source = _desc.source;
+
+    if (!_desc.base_desc.filename && !has_source)
+    {
+        BUMA_LOGE("ShaderVariants: no source or filename specified");
+        return false;
+    }
+    base_desc.Assign(_desc.base_desc);
+    name = _desc.base_desc.filename ? _desc.base_desc.filename : "<source>";
+
+    // キーワード毎のビットフィールドを割り当てます。
+    keywords.resize(_desc.num_keywords);
+    for (uint32_t i = 0; i < _desc.num_keywords; i++)
+    {
+        auto&& src = _desc.keywords[i];
+        auto&& kw = keywords[i];
+        if (!src.name || src.num_values < 2)
+        {
+            BUMA_LOGE("ShaderVariants: keyword {} requires a name and at least 2 values", i);
+            return false;
+        }
+
+        kw.name = src.name;
+        kw.values.resize(src.num_values);
+        for (uint32_t v = 0; v < src.num_values; v++)
+            kw.values[v] = src.value_names ? src.value_names[v] : std::to_string(v);
+
+        kw.bit_offset = num_key_bits;
+        kw.bit_count  = 0;
+        while ((1u << kw.bit_count) < src.num_values)
+            kw.bit_count++;
+
+        num_key_bits += kw.bit_count;
+        if (num_key_bits > MAX_SHADER_VARIANT_KEY_BITS)
+        {
+            BUMA_LOGE("ShaderVariants: variant key of {} exceeds {} bits", name, MAX_SHADER_VARIANT_KEY_BITS);
+            return false;
+        }
+    }
+
+    slots = std::make_unique<VARIANT_SLOT[]>(size_t(1) << num_key_bits);
+
+    // フォールバックは常に利用可能である必要があるため、同期的にコンパイルします。
+    if (!IsValidKey(_desc.fallback_key))
+    {
+        BUMA_LOGE("ShaderVariants: invalid fallback key {:#x}", _desc.fallback_key);
+        return false;
+    }
+    auto&& fallback_slot = slots[_desc.fallback_key];
+    fallback_slot.state.store(VARIANT_STATE_QUEUED, std::memory_order_relaxed);
+    CompileVariants({ _desc.fallback_key });
+    if (fallback_slot.state.load(std::memory_order_acquire) != VARIANT_STATE_READY)
+        return false;
+
+    fallback = fallback_slot.variant.get();
+
+    worker = std::thread([this]() { WorkerMain(); });
+    return true;
+}
+
+uint32_t ShaderVariants::FindKeyword(const char* _name) const
+{
+    for (size_t i = 0; i < keywords.size(); i++)
+    {
+        if (keywords[i].name == _name)
+            return static_cast<uint32_t>(i);
+    }
+    return UINT32_MAX;
+}
+
+SHADER_VARIANT_KEY ShaderVariants::SetKeywordValue(SHADER_VARIANT_KEY _key, uint32_t _keyword_index, uint32_t _value) const
+{
+    BUMA_ASSERT(_keyword_index < keywords.size());
+    auto&& kw = keywords[_keyword_index];
+    BUMA_ASSERT(_value < kw.values.size());
+
+    auto mask = ((1u << kw.bit_count) - 1) << kw.bit_offset;
+    return (_key & ~mask) | ((_value << kw.bit_offset) & mask);
+}
+
+uint32_t ShaderVariants::GetKeywordValue(SHADER_VARIANT_KEY _key, uint32_t _keyword_index) const
+{
+    BUMA_ASSERT(_keyword_index < keywords.size());
+    auto&& kw = keywords[_keyword_index];
+    return (_key >> kw.bit_offset) & ((1u << kw.bit_count) - 1);
+}
+
+bool ShaderVariants::IsValidKey(SHADER_VARIANT_KEY _key) const
+{
+    if ((_key >> num_key_bits) != 0)
+        return false;
+
+    // 値の数が2の累乗でないキーワードは、ビットフィールドに範囲外の値を表現できます。
+    for (uint32_t i = 0; i < keywords.size(); i++)
+    {
+        if (GetKeywordValue(_key, i) >= keywords[i].values.size())
+            return false;
+    }
+    return true;
+}
+
+const SHADER_VARIANT* ShaderVariants::GetVariant(SHADER_VARIANT_KEY _key, bool* _is_fallback)
+{
+    if ((_key >> num_key_bits) == 0)
+    {
+        auto&& slot = slots[_key];
+        auto state = slot.state.load(std::memory_order_acquire);
+        if (state == VARIANT_STATE_READY)
+        {
+            if (_is_fallback)
+                *_is_fallback = false;
+            return slot.variant.get();
+        }
+
+        if (state == VARIANT_STATE_NONE)
+            Request(_key);
+    }
+
+    if (_is_fallback)
+        *_is_fallback = true;
+    return fallback;
+}
+
+void ShaderVariants::Request(SHADER_VARIANT_KEY _key)
+{
+    if ((_key >> num_key_bits) != 0)
+        return;
+
+    auto&& slot = slots[_key];
+    auto expected = VARIANT_STATE_NONE;
+    if (!slot.state.compare_exchange_strong(expected, VARIANT_STATE_QUEUED, std::memory_order_acq_rel))
+        return;
+
+    if (!IsValidKey(_key))
+    {
+        BUMA_LOGW("ShaderVariants: invalid variant key {:#x} for {}", _key, name);
+        slot.state.store(VARIANT_STATE_FAILED, std::memory_order_release);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        queue.push_back(_key);
+    }
+    queue_cv.notify_one();
+}
+
+void ShaderVariants::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    idle_cv.wait(lock, [this]() { return queue.empty() && num_in_flight == 0; });
+}
+
+void ShaderVariants::PrepareVariantDesc(SHADER_VARIANT_KEY _key, LOAD_SHADER_DESC* _desc) const
+{
+    *_desc = base_desc.Get();
+    _desc->defines.reserve(_desc->defines.size() + keywords.size());
+    for (uint32_t i = 0; i < keywords.size(); i++)
+        _desc->defines.push_back({ keywords[i].name.c_str(), keywords[i].values[GetKeywordValue(_key, i)].c_str() });
+}
+
+void ShaderVariants::CompileVariants(const std::vector<SHADER_VARIANT_KEY>& _keys)
+{
+    auto num_variants = _keys.size();
+    std::vector<LOAD_SHADER_DESC>       descs(num_variants);
+    std::vector<const char*>            sources(num_variants, has_source ? source.c_str() : nullptr);
+    std::vector<SHADER_COMPILE_RESULT>  results(num_variants);
+    for (size_t i = 0; i < num_variants; i++)
+        PrepareVariantDesc(_keys[i], &descs[i]);
+
+    COMPILE_BATCH_DESC batch{};
+    batch.num_shaders   = num_variants;
+    batch.descs         = descs.data();
+    batch.sources       = has_source ? sources.data() : nullptr;
+    batch.num_threads   = num_threads;
+    ShaderLoader::CompileBatch(target, batch, results.data());
+
+    for (size_t i = 0; i < num_variants; i++)
+    {
+        auto&& slot = slots[_keys[i]];
+        auto&& result = results[i];
+        if (!result.succeeded)
+        {
+            BUMA_LOGE("ShaderVariants: failed to compile variant {:#x} of {}", _keys[i], name);
+            slot.state.store(VARIANT_STATE_FAILED, std::memory_order_release);
+            continue;
+        }
+
+        slot.variant = std::make_unique<SHADER_VARIANT>();
+        slot.variant->key           = _keys[i];
+        slot.variant->bytecode      = std::move(result.bytecode);
+        slot.variant->diagnostics   = std::move(result.diagnostics);
+        slot.state.store(VARIANT_STATE_READY, std::memory_order_release);
+    }
+}
+
+void ShaderVariants::WorkerMain()
+{
+    // 要求を溜めてからまとめてコンパイルすることで、CompileBatch による並列化と重複の除去を利用します。
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    while (true)
+    {
+        queue_cv.wait(lock, [this]() { return should_exit || !queue.empty(); });
+        if (should_exit)
+            break;
+
+        std::vector<SHADER_VARIANT_KEY> keys;
+        keys.swap(queue);
+        num_in_flight = keys.size();
+        lock.unlock();
+
+        CompileVariants(keys);
+
+        lock.lock();
+        num_in_flight = 0;
+        if (queue.empty())
+            idle_cv.notify_all();
+    }
+}
+
+
+}// namespace shader
+}// namespace buma
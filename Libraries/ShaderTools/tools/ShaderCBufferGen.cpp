@@ -0,0 +1,234 @@
+#include <ShaderTools/ShaderLoader.h>
+#include <ShaderTools/ShaderReflectionData.h>
+#include <ShaderTools/ConstantBufferLayout.h>
+
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace /*anonymous*/
+{
+
+void PrintUsage()
+{
+    std::cout <<
+R"(Usage: ShaderCBufferGen <output> <shader>... [options]
+    <shader> の定数バッファのレイアウトから、パディングされたC++の構造体とオフセットテーブルを定義するヘッダを <output> に出力します。
+    複数のシェーダで同じ名前の定数バッファは1度だけ出力されます。
+
+<shader>
+    <stage>:<file>[:<entry point>] の形式で指定します。 <stage> は vs, ps, gs, hs, ds, cs のいずれかです。 <entry point> のデフォルトは main です。
+    (例: vs:shader/VertexShader.hlsl ps:shader/PixelShader.hlsl:PSMain)
+
+--namespace <name>
+    出力する構造体を囲う名前空間を指定します。
+
+--define <name>[=<value>]
+    マクロを定義します。 複数回指定できます。
+
+--row-major
+    行列を行優先でパックします。 指定しない場合は列優先です。
+
+--shader-model <major>.<minor>
+    シェーダモデルを指定します。 デフォルトは 6.4 です。
+)";
+}
+
+// <major>.<minor> の形式のシェーダモデルを変換します。 数値以外の文字を含む場合や範囲外の場合falseを返します。
+bool ParseShaderModel(const std::string& _arg, buma::shader::SHADER_MODEL* _dst)
+{
+    auto dot = _arg.find('.');
+    if (dot == std::string::npos)
+        return false;
+
+    auto begin = _arg.data();
+    auto end   = _arg.data() + _arg.size();
+    auto [major_end, major_ec] = std::from_chars(begin, begin + dot, _dst->major_ver);
+    auto [minor_end, minor_ec] = std::from_chars(begin + dot + 1, end, _dst->minor_ver);
+    return major_ec == std::errc() && major_end == begin + dot
+        && minor_ec == std::errc() && minor_end == end;
+}
+
+bool ParseStage(const std::string& _stage, buma::shader::SHADER_STAGE* _dst)
+{
+         if (_stage == "vs") *_dst = buma::shader::SHADER_STAGE_VERTEX;
+    else if (_stage == "ps") *_dst = buma::shader::SHADER_STAGE_PIXEL;
+    else if (_stage == "gs") *_dst = buma::shader::SHADER_STAGE_GEOMETRY;
+    else if (_stage == "hs") *_dst = buma::shader::SHADER_STAGE_HULL;
+    else if (_stage == "ds") *_dst = buma::shader::SHADER_STAGE_DOMAIN;
+    else if (_stage == "cs") *_dst = buma::shader::SHADER_STAGE_COMPUTE;
+    else return false;
+    return true;
+}
+
+struct SHADER_ARG
+{
+    buma::shader::SHADER_STAGE  stage;
+    std::string                 filename;
+    std::string                 entry_point;
+};
+
+bool ParseShader(const std::string& _arg, SHADER_ARG* _dst)
+{
+    auto first = _arg.find(':');
+    if (first == std::string::npos || !ParseStage(_arg.substr(0, first), &_dst->stage))
+        return false;
+
+    // ドライブレター(C:\)の ':' はエントリポイントの区切りとして扱いません。
+    auto rest = _arg.substr(first + 1);
+    auto last = rest.rfind(':');
+    if (last != std::string::npos && last != 1 && rest.find_first_of("/\\", last) == std::string::npos)
+    {
+        _dst->filename    = rest.substr(0, last);
+        _dst->entry_point = rest.substr(last + 1);
+    }
+    else
+    {
+        _dst->filename    = rest;
+        _dst->entry_point = "main";
+    }
+    return !_dst->filename.empty();
+}
+
+
+}// namespace /*anonymous*/
+
+int main(int _argc, char* _argv[])
+{
+    namespace fs = std::filesystem;
+    namespace sh = buma::shader;
+
+    if (_argc < 3)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    fs::path output = _argv[1];
+
+    std::vector<SHADER_ARG>                 shaders;
+    std::vector<std::string>                define_strings;
+    std::string                             namespace_name;
+    sh::OPTIONS                             options{};
+    options.pack_matrices_in_row_major  = false;
+    options.shader_model                = { 6, 4 };
+    for (int i = 2; i < _argc; i++)
+    {
+        std::string arg = _argv[i];
+             if (arg == "--namespace" && i + 1 < _argc)     namespace_name = _argv[++i];
+        else if (arg == "--define" && i + 1 < _argc)        define_strings.emplace_back(_argv[++i]);
+        else if (arg == "--row-major")                      options.pack_matrices_in_row_major = true;
+        else if (arg == "--shader-model" && i + 1 < _argc)
+        {
+            if (!ParseShaderModel(_argv[++i], &options.shader_model))
+            {
+                PrintUsage();
+                return 1;
+            }
+        }
+        else
+        {
+            SHADER_ARG shader{};
+            if (!ParseShader(arg, &shader))
+            {
+                PrintUsage();
+                return 1;
+            }
+            shaders.emplace_back(std::move(shader));
+        }
+    }
+    if (shaders.empty())
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // "name=value" を名前と値に分割します。 SHADER_DEFINES は define_strings を参照します。
+    std::vector<std::string> define_values(define_strings.size());
+    std::vector<sh::SHADER_DEFINES> defines;
+    for (size_t i = 0; i < define_strings.size(); i++)
+    {
+        auto eq = define_strings[i].find('=');
+        if (eq != std::string::npos)
+        {
+            define_values[i] = define_strings[i].substr(eq + 1);
+            define_strings[i].resize(eq);
+        }
+        defines.push_back({ define_strings[i].c_str(), define_values[i].empty() ? nullptr : define_values[i].c_str() });
+    }
+
+    // リフレクションはDXILからのみ取得できるため、D3D12向けにコンパイルします。
+    std::vector<sh::LOAD_SHADER_DESC>       descs(shaders.size());
+    std::vector<sh::SHADER_COMPILE_RESULT>  results(shaders.size());
+    for (size_t i = 0; i < shaders.size(); i++)
+    {
+        descs[i].filename    = shaders[i].filename.c_str();
+        descs[i].entry_point = shaders[i].entry_point.c_str();
+        descs[i].stage       = shaders[i].stage;
+        descs[i].defines     = defines;
+        descs[i].options     = options;
+        descs[i].cache       = nullptr;
+    }
+    sh::COMPILE_BATCH_DESC batch{};
+    batch.num_shaders = descs.size();
+    batch.descs       = descs.data();
+    sh::ShaderLoader::CompileBatch(sh::COMPILE_TARGET_D3D12, batch, results.data());
+
+    std::vector<std::unique_ptr<sh::ShaderReflectionData>>  reflections;
+    std::vector<const sh::ShaderReflectionData*>            reflection_ptrs;
+    std::string                                             source_name;
+    for (size_t i = 0; i < shaders.size(); i++)
+    {
+        if (!results[i].succeeded)
+        {
+            std::cerr << "failed to compile " << shaders[i].filename << std::endl << results[i].diagnostics << std::endl;
+            return 1;
+        }
+        auto&& reflection = reflections.emplace_back(sh::ShaderReflectionData::Reflect(results[i].bytecode));
+        if (!reflection)
+        {
+            std::cerr << "failed to reflect " << shaders[i].filename << std::endl;
+            return 1;
+        }
+        reflection_ptrs.emplace_back(reflection.get());
+        source_name += (source_name.empty() ? "" : ", ") + fs::path(shaders[i].filename).generic_string();
+    }
+
+    sh::CONSTANT_BUFFER_HEADER_DESC desc{};
+    desc.num_reflections    = static_cast<uint32_t>(reflection_ptrs.size());
+    desc.reflections        = reflection_ptrs.data();
+    desc.namespace_name     = namespace_name.empty() ? nullptr : namespace_name.c_str();
+    desc.source_name        = source_name.c_str();
+    std::string header;
+    if (!sh::GenerateConstantBufferHeader(desc, &header))
+    {
+        std::cerr << "failed to generate " << output.string() << std::endl;
+        return 1;
+    }
+
+    // 内容が変わらない場合は書き込まず、依存するソースの再ビルドを避けます。
+    {
+        std::ifstream ifs(output, std::ios::in | std::ios::binary);
+        std::string current((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        if (ifs.is_open() && current == header)
+        {
+            std::cout << output.string() << " is up to date" << std::endl;
+            return 0;
+        }
+    }
+    std::ofstream ofs(output, std::ios::out | std::ios::binary | std::ios::trunc);
+    ofs.write(header.data(), static_cast<std::streamsize>(header.size()));
+    if (ofs.fail())
+    {
+        std::cerr << "failed to write " << output.string() << std::endl;
+        return 1;
+    }
+
+    std::cout << "generated " << output.string() << std::endl;
+    return 0;
+}
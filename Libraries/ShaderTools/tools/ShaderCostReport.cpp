@@ -0,0 +1,927 @@
+#include <ShaderTools/ShaderLoader.h>
+#include <ShaderTools/ShaderReflection.h>
+
+#include <nlohmann/json.hpp>
+
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <tuple>
+#include <algorithm>
+
+namespace /*anonymous*/
+{
+
+namespace sh = buma::shader;
+
+void PrintUsage()
+{
+    std::cout <<
+R"(Usage: ShaderCostReport <shader>... [options]
+    <shader> をコンパイルしてリフレクションを取得し、命令数の内訳、バインドされたリソースの数、定数バッファのサイズをバリアントごとに出力します。
+    ベースラインを指定した場合、各値の差分を出力し、閾値を超えて増加したシェーダがある場合は終了コード 2 を返します。
+
+<shader>
+    <stage>:<file>[:<entry point>] の形式で指定します。 <stage> は vs, ps, gs, hs, ds, cs, lib のいずれかです。 <entry point> のデフォルトは main です。
+    lib の場合、エクスポートされた全ての関数が出力されます。
+    (例: vs:shader/VertexShader.hlsl ps:shader/PixelShader.hlsl:PSMain lib:shader/RayTracing.hlsl)
+
+--output <file>
+    出力先のファイルを指定します。 指定しない場合は標準出力に出力します。
+
+--format <csv|json>
+    出力形式を指定します。 指定しない場合 <file> の拡張子が .json であれば json 、それ以外は csv です。
+
+--define <name>[=<value>]
+    全てのバリアントに共通のマクロを定義します。 複数回指定できます。
+
+--keyword <name>=<number of values>
+--keyword <name>=<value>|<value>|...
+    バリアントのキーワードを指定します。 複数回指定できます。 全てのシェーダについて、全てのキーワードの値の組み合わせがコンパイルされます。
+    値の数を指定した場合マクロは 0 から (値の数 - 1) の数値として、値を列挙した場合は各値として定義されます。
+
+--shader-model <major>.<minor>
+    シェーダモデルを指定します。 デフォルトは 6.4 です。
+
+--sort <column>
+    指定した列でソートします。 name, stage, variant と各値の列(差分の列 <column>_delta を含む)を指定できます。 デフォルトは name です。
+    値の列は降順、それ以外は昇順にソートされます。
+
+--ascending
+    値の列を昇順にソートします。
+
+--baseline <file>
+    以前にこのツールが出力したレポート(csv または json)と比較します。 行は name と variant で対応付けられます。
+
+--max-increase <column>=<percent>
+    --baseline の値から <column> が <percent> パーセントを超えて増加した場合、終了コード 2 を返します。 複数回指定できます。
+    (例: --max-increase instruction_count=5 --max-increase temp_register_count=0)
+)";
+}
+
+#pragma region metrics
+
+enum METRIC
+{
+      METRIC_INSTRUCTION_COUNT
+    , METRIC_TEMP_REGISTER_COUNT
+    , METRIC_TEMP_ARRAY_COUNT
+    , METRIC_FLOAT_INSTRUCTIONS
+    , METRIC_INT_INSTRUCTIONS
+    , METRIC_UINT_INSTRUCTIONS
+    , METRIC_MOV_INSTRUCTIONS
+    , METRIC_MOVC_INSTRUCTIONS
+    , METRIC_CONVERSION_INSTRUCTIONS
+    , METRIC_BITWISE_INSTRUCTIONS
+    , METRIC_ARRAY_INSTRUCTIONS
+    , METRIC_STATIC_FLOW_CONTROL
+    , METRIC_DYNAMIC_FLOW_CONTROL
+    , METRIC_TEXTURE_NORMAL_INSTRUCTIONS
+    , METRIC_TEXTURE_LOAD_INSTRUCTIONS
+    , METRIC_TEXTURE_COMP_INSTRUCTIONS
+    , METRIC_TEXTURE_BIAS_INSTRUCTIONS
+    , METRIC_TEXTURE_GRADIENT_INSTRUCTIONS
+    , METRIC_TEXTURE_STORE_INSTRUCTIONS
+    , METRIC_BARRIER_INSTRUCTIONS
+    , METRIC_INTERLOCKED_INSTRUCTIONS
+    , METRIC_BOUND_RESOURCES
+    , METRIC_CBV_COUNT
+    , METRIC_SRV_COUNT
+    , METRIC_UAV_COUNT
+    , METRIC_SAMPLER_COUNT
+    , METRIC_CONSTANT_BUFFER_BYTES
+    , METRIC_THREAD_GROUP_SIZE
+
+    , METRIC_NUM
+};
+
+constexpr const char* METRIC_NAMES[METRIC_NUM] = {
+      "instruction_count"
+    , "temp_register_count"
+    , "temp_array_count"
+    , "float_instructions"
+    , "int_instructions"
+    , "uint_instructions"
+    , "mov_instructions"
+    , "movc_instructions"
+    , "conversion_instructions"
+    , "bitwise_instructions"
+    , "array_instructions"
+    , "static_flow_control"
+    , "dynamic_flow_control"
+    , "texture_normal_instructions"
+    , "texture_load_instructions"
+    , "texture_comp_instructions"
+    , "texture_bias_instructions"
+    , "texture_gradient_instructions"
+    , "texture_store_instructions"
+    , "barrier_instructions"
+    , "interlocked_instructions"
+    , "bound_resources"
+    , "cbv_count"
+    , "srv_count"
+    , "uav_count"
+    , "sampler_count"
+    , "constant_buffer_bytes"
+    , "thread_group_size"
+};
+
+// 比較の結果です。 ベースラインを指定しない場合は使用されません。
+enum ROW_STATUS
+{
+      ROW_STATUS_UNCHANGED
+    , ROW_STATUS_CHANGED
+    , ROW_STATUS_ADDED
+    , ROW_STATUS_REMOVED
+};
+
+constexpr const char* ROW_STATUS_NAMES[] = { "unchanged", "changed", "added", "removed" };
+
+struct REPORT_ROW
+{
+    std::string     name;       // <file>:<entry point> 、ライブラリの場合 <file>:<function name>
+    std::string     stage;
+    std::string     variant;    // キーワードの値 (例: USE_NORMAL_MAP=1 LIGHT_COUNT=2)
+    int64_t         values[METRIC_NUM];
+    ROW_STATUS      status;
+    int64_t         deltas[METRIC_NUM];
+};
+
+std::string GetRowKey(const REPORT_ROW& _row)
+{
+    return _row.name + '\n' + _row.variant;
+}
+
+int FindMetric(const std::string& _name)
+{
+    for (int i = 0; i < METRIC_NUM; i++)
+    {
+        if (_name == METRIC_NAMES[i])
+            return i;
+    }
+    return -1;
+}
+
+// SHADER_DESC と FUNCTION_DESC で共通のメンバを設定します。
+template<typename T>
+void SetInstructionCounts(const T& _desc, REPORT_ROW* _row)
+{
+    auto&& v = _row->values;
+    v[METRIC_INSTRUCTION_COUNT]             = _desc.instruction_count;
+    v[METRIC_TEMP_REGISTER_COUNT]           = _desc.temp_register_count;
+    v[METRIC_TEMP_ARRAY_COUNT]              = _desc.temp_array_count;
+    v[METRIC_FLOAT_INSTRUCTIONS]            = _desc.float_instruction_count;
+    v[METRIC_INT_INSTRUCTIONS]              = _desc.int_instruction_count;
+    v[METRIC_UINT_INSTRUCTIONS]             = _desc.uint_instruction_count;
+    v[METRIC_ARRAY_INSTRUCTIONS]            = _desc.array_instruction_count;
+    v[METRIC_STATIC_FLOW_CONTROL]           = _desc.static_flow_control_count;
+    v[METRIC_DYNAMIC_FLOW_CONTROL]          = _desc.dynamic_flow_control_count;
+    v[METRIC_TEXTURE_NORMAL_INSTRUCTIONS]   = _desc.texture_normal_instructions;
+    v[METRIC_TEXTURE_LOAD_INSTRUCTIONS]     = _desc.texture_load_instructions;
+    v[METRIC_TEXTURE_COMP_INSTRUCTIONS]     = _desc.texture_comp_instructions;
+    v[METRIC_TEXTURE_BIAS_INSTRUCTIONS]     = _desc.texture_bias_instructions;
+    v[METRIC_TEXTURE_GRADIENT_INSTRUCTIONS] = _desc.texture_gradient_instructions;
+}
+
+void SetResourceCounts(const std::vector<std::shared_ptr<sh::SHADER_INPUT_BIND_DESC>>&          _bind_descs
+                       , const std::vector<std::shared_ptr<sh::ShaderReflectionConstantBuffer>>& _cbufs
+                       , REPORT_ROW*                                                             _row)
+{
+    auto&& v = _row->values;
+    v[METRIC_BOUND_RESOURCES] = static_cast<int64_t>(_bind_descs.size());
+    for (auto&& b : _bind_descs)
+    {
+        // 境界のない配列(bind_count == 0)は1つとして数えます。
+        int64_t count = std::max(b->bind_count, 1u);
+        switch (b->shader_input_type)
+        {
+        case sh::SHADER_INPUT_TYPE_CBUFFER:
+            v[METRIC_CBV_COUNT] += count;
+            break;
+
+        case sh::SHADER_INPUT_TYPE_SAMPLER:
+            v[METRIC_SAMPLER_COUNT] += count;
+            break;
+
+        case sh::SHADER_INPUT_TYPE_UAV_RWTYPED:
+        case sh::SHADER_INPUT_TYPE_UAV_RWSTRUCTURED:
+        case sh::SHADER_INPUT_TYPE_UAV_RWBYTEADDRESS:
+        case sh::SHADER_INPUT_TYPE_UAV_APPEND_STRUCTURED:
+        case sh::SHADER_INPUT_TYPE_UAV_CONSUME_STRUCTURED:
+        case sh::SHADER_INPUT_TYPE_UAV_RWSTRUCTURED_WITH_COUNTER:
+        case sh::SHADER_INPUT_TYPE_UAV_FEEDBACKTEXTURE:
+            v[METRIC_UAV_COUNT] += count;
+            break;
+
+        default:
+            v[METRIC_SRV_COUNT] += count;
+            break;
+        }
+    }
+
+    for (auto&& cb : _cbufs)
+    {
+        auto&& desc = cb->GetShaderBUfferDesc();
+        if (desc && desc->cb_type == sh::CBUFFER_TYPE_CBUFFER)
+            v[METRIC_CONSTANT_BUFFER_BYTES] += desc->size_of_cb;
+    }
+}
+
+#pragma endregion metrics
+
+#pragma region arguments
+
+// 文字列全体を数値に変換します。 数値以外の文字を含む場合や範囲外の場合falseを返します。
+template<typename T>
+bool ParseNumber(std::string_view _str, T* _dst)
+{
+    auto end = _str.data() + _str.size();
+    auto [ptr, ec] = std::from_chars(_str.data(), end, *_dst);
+    return ec == std::errc() && ptr == end;
+}
+
+// <major>.<minor> の形式のシェーダモデルを変換します。
+bool ParseShaderModel(const std::string& _arg, sh::SHADER_MODEL* _dst)
+{
+    auto dot = _arg.find('.');
+    if (dot == std::string::npos)
+        return false;
+    return ParseNumber(std::string_view(_arg).substr(0, dot), &_dst->major_ver)
+        && ParseNumber(std::string_view(_arg).substr(dot + 1), &_dst->minor_ver);
+}
+
+bool ParseStage(const std::string& _stage, sh::SHADER_STAGE* _dst)
+{
+         if (_stage == "vs")  *_dst = sh::SHADER_STAGE_VERTEX;
+    else if (_stage == "ps")  *_dst = sh::SHADER_STAGE_PIXEL;
+    else if (_stage == "gs")  *_dst = sh::SHADER_STAGE_GEOMETRY;
+    else if (_stage == "hs")  *_dst = sh::SHADER_STAGE_HULL;
+    else if (_stage == "ds")  *_dst = sh::SHADER_STAGE_DOMAIN;
+    else if (_stage == "cs")  *_dst = sh::SHADER_STAGE_COMPUTE;
+    else if (_stage == "lib") *_dst = sh::SHADER_STAGE_LIBRARY;
+    else return false;
+    return true;
+}
+
+struct SHADER_ARG
+{
+    std::string                 stage_name;
+    sh::SHADER_STAGE            stage;
+    std::string                 filename;
+    std::string                 entry_point;
+};
+
+bool ParseShader(const std::string& _arg, SHADER_ARG* _dst)
+{
+    auto first = _arg.find(':');
+    if (first == std::string::npos)
+        return false;
+    _dst->stage_name = _arg.substr(0, first);
+    if (!ParseStage(_dst->stage_name, &_dst->stage))
+        return false;
+
+    // ドライブレター(C:\)の ':' はエントリポイントの区切りとして扱いません。
+    auto rest = _arg.substr(first + 1);
+    auto last = rest.rfind(':');
+    if (last != std::string::npos && last != 1 && rest.find_first_of("/\\", last) == std::string::npos)
+    {
+        _dst->filename    = rest.substr(0, last);
+        _dst->entry_point = rest.substr(last + 1);
+    }
+    else
+    {
+        _dst->filename    = rest;
+        _dst->entry_point = "main";
+    }
+    return !_dst->filename.empty();
+}
+
+struct KEYWORD_ARG
+{
+    std::string                 name;
+    std::vector<std::string>    values;
+};
+
+bool ParseKeyword(const std::string& _arg, KEYWORD_ARG* _dst)
+{
+    auto eq = _arg.find('=');
+    if (eq == std::string::npos || eq == 0 || eq + 1 == _arg.size())
+        return false;
+    _dst->name = _arg.substr(0, eq);
+
+    auto values = _arg.substr(eq + 1);
+    if (values.find('|') == std::string::npos && std::all_of(values.begin(), values.end(), [](char _c) { return _c >= '0' && _c <= '9'; }))
+    {
+        uint32_t num_values = 0;
+        if (!ParseNumber(values, &num_values))
+            return false;
+        for (uint32_t i = 0; i < num_values; i++)
+            _dst->values.emplace_back(std::to_string(i));
+    }
+    else
+    {
+        std::stringstream ss(values);
+        for (std::string v; std::getline(ss, v, '|');)
+            _dst->values.emplace_back(v);
+    }
+    return _dst->values.size() >= 2;
+}
+
+struct THRESHOLD_ARG
+{
+    int         metric;
+    double      percent;
+};
+
+bool ParseThreshold(const std::string& _arg, THRESHOLD_ARG* _dst)
+{
+    auto eq = _arg.find('=');
+    if (eq == std::string::npos)
+        return false;
+    _dst->metric = FindMetric(_arg.substr(0, eq));
+    if (_dst->metric == -1)
+        return false;
+    return ParseNumber(std::string_view(_arg).substr(eq + 1), &_dst->percent);
+}
+
+#pragma endregion arguments
+
+#pragma region report io
+
+std::string EscapeCsv(const std::string& _str)
+{
+    if (_str.find_first_of(",\"\n") == std::string::npos)
+        return _str;
+
+    std::string result = "\"";
+    for (auto c : _str)
+    {
+        if (c == '"')
+            result += '"';
+        result += c;
+    }
+    return result + '"';
+}
+
+std::vector<std::string> SplitCsvLine(const std::string& _line)
+{
+    std::vector<std::string> fields(1);
+    bool is_quoted = false;
+    for (size_t i = 0; i < _line.size(); i++)
+    {
+        auto c = _line[i];
+        if (is_quoted)
+        {
+            if (c != '"')                                       fields.back() += c;
+            else if (i + 1 < _line.size() && _line[i + 1] == '"') fields.back() += _line[++i];
+            else                                                is_quoted = false;
+        }
+        else if (c == '"')  is_quoted = true;
+        else if (c == ',')  fields.emplace_back();
+        else if (c != '\r') fields.back() += c;
+    }
+    return fields;
+}
+
+std::vector<std::string> GetColumns(bool _has_baseline)
+{
+    std::vector<std::string> columns = { "name", "stage", "variant" };
+    for (auto&& m : METRIC_NAMES)
+        columns.emplace_back(m);
+    if (_has_baseline)
+    {
+        columns.emplace_back("status");
+        for (auto&& m : METRIC_NAMES)
+            columns.emplace_back(std::string(m) + "_delta");
+    }
+    return columns;
+}
+
+void WriteCsv(const std::vector<REPORT_ROW>& _rows, bool _has_baseline, std::ostream& _os)
+{
+    auto columns = GetColumns(_has_baseline);
+    for (size_t i = 0; i < columns.size(); i++)
+        _os << (i ? "," : "") << columns[i];
+    _os << "\n";
+
+    for (auto&& r : _rows)
+    {
+        _os << EscapeCsv(r.name) << "," << r.stage << "," << EscapeCsv(r.variant);
+        for (auto v : r.values)
+            _os << "," << v;
+        if (_has_baseline)
+        {
+            _os << "," << ROW_STATUS_NAMES[r.status];
+            for (auto d : r.deltas)
+                _os << "," << d;
+        }
+        _os << "\n";
+    }
+}
+
+void WriteJson(const std::vector<REPORT_ROW>& _rows, bool _has_baseline, std::ostream& _os)
+{
+    auto json = nlohmann::json::array();
+    for (auto&& r : _rows)
+    {
+        nlohmann::json o;
+        o["name"]    = r.name;
+        o["stage"]   = r.stage;
+        o["variant"] = r.variant;
+        for (int i = 0; i < METRIC_NUM; i++)
+            o[METRIC_NAMES[i]] = r.values[i];
+        if (_has_baseline)
+        {
+            o["status"] = ROW_STATUS_NAMES[r.status];
+            for (int i = 0; i < METRIC_NUM; i++)
+                o[std::string(METRIC_NAMES[i]) + "_delta"] = r.deltas[i];
+        }
+        json.push_back(std::move(o));
+    }
+    _os << json.dump(2) << "\n";
+}
+
+// 10進数の整数に変換します。 前後の空白以外の文字が含まれる場合falseを返します。
+bool ParseInt64(const std::string& _str, int64_t* _dst)
+{
+    auto first = _str.find_first_not_of(" \t");
+    auto last  = _str.find_last_not_of(" \t");
+    if (first == std::string::npos)
+        return false;
+    return ParseNumber(std::string_view(_str).substr(first, last + 1 - first), _dst);
+}
+
+// このツールが出力したレポートを読み込みます。 差分の列は無視されます。
+// 形式が不正な場合、行(CSV)または要素(JSON)の位置を含む理由を _error に設定してfalseを返します。
+bool ReadBaseline(const std::filesystem::path& _path, std::vector<REPORT_ROW>* _dst, std::string* _error)
+{
+    std::ifstream ifs(_path, std::ios::in | std::ios::binary);
+    if (ifs.fail())
+    {
+        *_error = "cannot open file";
+        return false;
+    }
+    std::string s((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    auto first = s.find_first_not_of(" \t\r\n");
+    if (first != std::string::npos && s[first] == '[')
+    {
+        auto json = nlohmann::json::parse(s, nullptr, false);
+        if (!json.is_array())
+        {
+            *_error = "invalid JSON";
+            return false;
+        }
+
+        // json::value() は型が異なる場合に例外を送出するため、型を確認してから取得します。
+        for (size_t i = 0; i < json.size(); i++)
+        {
+            auto&& o = json[i];
+            auto element = "element " + std::to_string(i) + ": ";
+            if (!o.is_object())
+            {
+                *_error = element + "expected an object";
+                return false;
+            }
+
+            auto&& r = _dst->emplace_back(REPORT_ROW{});
+            std::string* strings[] = { &r.name, &r.stage, &r.variant };
+            const char*  keys[]    = { "name", "stage", "variant" };
+            for (int k = 0; k < 3; k++)
+            {
+                auto it = o.find(keys[k]);
+                if (it == o.end() && k == 0)
+                {
+                    *_error = element + "missing \"name\"";
+                    return false;
+                }
+                if (it == o.end())
+                    continue;
+                if (!it->is_string())
+                {
+                    *_error = element + "\"" + keys[k] + "\" is not a string";
+                    return false;
+                }
+                *strings[k] = it->get<std::string>();
+            }
+
+            for (int m = 0; m < METRIC_NUM; m++)
+            {
+                auto it = o.find(METRIC_NAMES[m]);
+                if (it == o.end())
+                    continue;
+                if (!it->is_number_integer())
+                {
+                    *_error = element + "\"" + METRIC_NAMES[m] + "\" is not an integer";
+                    return false;
+                }
+                r.values[m] = it->get<int64_t>();
+            }
+        }
+        return true;
+    }
+
+    std::stringstream ss(s);
+    std::string line;
+    if (!std::getline(ss, line))
+    {
+        *_error = "empty file";
+        return false;
+    }
+    auto header = SplitCsvLine(line);
+
+    // 列の順序に依存しないよう、ヘッダから列を対応付けます。 ベースラインに存在しない値は0として扱います。
+    std::vector<int> metric_indices(header.size(), -1);
+    int name_index = -1, stage_index = -1, variant_index = -1;
+    for (int i = 0; i < (int)header.size(); i++)
+    {
+             if (header[i] == "name")    name_index    = i;
+        else if (header[i] == "stage")   stage_index   = i;
+        else if (header[i] == "variant") variant_index = i;
+        else                             metric_indices[i] = FindMetric(header[i]);
+    }
+    if (name_index == -1)
+    {
+        *_error = "line 1: missing \"name\" column";
+        return false;
+    }
+
+    for (size_t line_number = 2; std::getline(ss, line); line_number++)
+    {
+        if (line.empty() || line == "\r")
+            continue;
+        auto fields = SplitCsvLine(line);
+        if (fields.size() > header.size())
+        {
+            *_error = "line " + std::to_string(line_number) + ": " + std::to_string(fields.size()) + " fields, but the header has " + std::to_string(header.size());
+            return false;
+        }
+        fields.resize(header.size());
+
+        auto&& r = _dst->emplace_back(REPORT_ROW{});
+        r.name    = fields[name_index];
+        r.stage   = stage_index   == -1 ? "" : fields[stage_index];
+        r.variant = variant_index == -1 ? "" : fields[variant_index];
+        for (size_t i = 0; i < header.size(); i++)
+        {
+            if (metric_indices[i] == -1 || fields[i].empty())
+                continue;
+            if (!ParseInt64(fields[i], &r.values[metric_indices[i]]))
+            {
+                *_error = "line " + std::to_string(line_number) + ": invalid value \"" + fields[i] + "\" in column \"" + header[i] + "\"";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+#pragma endregion report io
+
+// ベースラインと比較して差分を設定し、ベースラインのみに存在する行を追加します。
+void DiffWithBaseline(const std::vector<REPORT_ROW>& _baseline, std::vector<REPORT_ROW>* _rows)
+{
+    std::unordered_map<std::string, const REPORT_ROW*> baseline_rows;
+    for (auto&& b : _baseline)
+        baseline_rows[GetRowKey(b)] = &b;
+
+    for (auto&& r : *_rows)
+    {
+        auto it = baseline_rows.find(GetRowKey(r));
+        if (it == baseline_rows.end())
+        {
+            r.status = ROW_STATUS_ADDED;
+            std::copy(std::begin(r.values), std::end(r.values), r.deltas);
+            continue;
+        }
+
+        r.status = ROW_STATUS_UNCHANGED;
+        for (int i = 0; i < METRIC_NUM; i++)
+        {
+            r.deltas[i] = r.values[i] - it->second->values[i];
+            if (r.deltas[i] != 0)
+                r.status = ROW_STATUS_CHANGED;
+        }
+        baseline_rows.erase(it);
+    }
+
+    for (auto&& b : _baseline)
+    {
+        if (baseline_rows.find(GetRowKey(b)) == baseline_rows.end())
+            continue;
+        auto&& r = _rows->emplace_back(b);
+        r.status = ROW_STATUS_REMOVED;
+        for (int i = 0; i < METRIC_NUM; i++)
+            r.deltas[i] = -b.values[i];
+    }
+}
+
+// 閾値を超えて増加した値を標準エラーに出力し、1つ以上ある場合falseを返します。 追加、削除された行は対象外です。
+bool CheckThresholds(const std::vector<REPORT_ROW>& _rows, const std::vector<THRESHOLD_ARG>& _thresholds)
+{
+    bool passed = true;
+    for (auto&& r : _rows)
+    {
+        if (r.status != ROW_STATUS_CHANGED)
+            continue;
+        for (auto&& t : _thresholds)
+        {
+            auto delta = r.deltas[t.metric];
+            if (delta <= 0)
+                continue;
+            auto base = r.values[t.metric] - delta;
+            if (base != 0 && double(delta) * 100.0 <= double(base) * t.percent)
+                continue;
+
+            std::cerr << "regression: " << r.name << (r.variant.empty() ? "" : " [" + r.variant + "]")
+                      << " " << METRIC_NAMES[t.metric] << " " << base << " -> " << r.values[t.metric] << std::endl;
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+// 列が見つからない場合falseを返します。
+bool SortRows(const std::string& _column, bool _is_ascending, bool _has_baseline, std::vector<REPORT_ROW>* _rows)
+{
+    auto get_text = [&](const REPORT_ROW& _r) -> const std::string& {
+        return _column == "stage" ? _r.stage : _column == "variant" ? _r.variant : _r.name;
+    };
+    auto is_delta = _has_baseline && _column.size() > 6 && _column.compare(_column.size() - 6, 6, "_delta") == 0;
+    auto metric   = FindMetric(is_delta ? _column.substr(0, _column.size() - 6) : _column);
+    if (metric == -1 && _column != "name" && _column != "stage" && _column != "variant")
+        return false;
+
+    // 同じ値の行は name 、 variant の順に並べ、出力を安定させます。
+    std::stable_sort(_rows->begin(), _rows->end(), [&](const REPORT_ROW& _a, const REPORT_ROW& _b) {
+        if (metric == -1)
+        {
+            auto c = get_text(_a).compare(get_text(_b));
+            if (c != 0)
+                return c < 0;
+        }
+        else
+        {
+            auto a = is_delta ? _a.deltas[metric] : _a.values[metric];
+            auto b = is_delta ? _b.deltas[metric] : _b.values[metric];
+            if (a != b)
+                return _is_ascending ? a < b : a > b;
+        }
+        return std::tie(_a.name, _a.variant) < std::tie(_b.name, _b.variant);
+    });
+    return true;
+}
+
+
+}// namespace /*anonymous*/
+
+int main(int _argc, char* _argv[])
+{
+    namespace fs = std::filesystem;
+
+    if (_argc < 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    std::vector<SHADER_ARG>     shaders;
+    std::vector<KEYWORD_ARG>    keywords;
+    std::vector<THRESHOLD_ARG>  thresholds;
+    std::vector<std::string>    define_strings;
+    fs::path                    output;
+    fs::path                    baseline_path;
+    std::string                 format;
+    std::string                 sort_column = "name";
+    bool                        is_ascending = false;
+    sh::OPTIONS                 options{};
+    options.shader_model = { 6, 4 };
+    for (int i = 1; i < _argc; i++)
+    {
+        std::string arg = _argv[i];
+             if (arg == "--output" && i + 1 < _argc)        output = _argv[++i];
+        else if (arg == "--format" && i + 1 < _argc)        format = _argv[++i];
+        else if (arg == "--define" && i + 1 < _argc)        define_strings.emplace_back(_argv[++i]);
+        else if (arg == "--sort" && i + 1 < _argc)          sort_column = _argv[++i];
+        else if (arg == "--ascending")                      is_ascending = true;
+        else if (arg == "--baseline" && i + 1 < _argc)      baseline_path = _argv[++i];
+        else if (arg == "--shader-model" && i + 1 < _argc)
+        {
+            if (!ParseShaderModel(_argv[++i], &options.shader_model))
+            {
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--keyword" && i + 1 < _argc)
+        {
+            KEYWORD_ARG keyword{};
+            if (!ParseKeyword(_argv[++i], &keyword))
+            {
+                PrintUsage();
+                return 1;
+            }
+            keywords.emplace_back(std::move(keyword));
+        }
+        else if (arg == "--max-increase" && i + 1 < _argc)
+        {
+            THRESHOLD_ARG threshold{};
+            if (!ParseThreshold(_argv[++i], &threshold))
+            {
+                PrintUsage();
+                return 1;
+            }
+            thresholds.emplace_back(threshold);
+        }
+        else
+        {
+            SHADER_ARG shader{};
+            if (!ParseShader(arg, &shader))
+            {
+                PrintUsage();
+                return 1;
+            }
+            shaders.emplace_back(std::move(shader));
+        }
+    }
+    if (format.empty())
+        format = output.extension() == ".json" ? "json" : "csv";
+    if (shaders.empty() || (format != "csv" && format != "json") || (!thresholds.empty() && baseline_path.empty()))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // "name=value" を名前と値に分割します。 SHADER_DEFINES は define_strings を参照します。
+    std::vector<std::string> define_values(define_strings.size());
+    std::vector<sh::SHADER_DEFINES> defines;
+    for (size_t i = 0; i < define_strings.size(); i++)
+    {
+        auto eq = define_strings[i].find('=');
+        if (eq != std::string::npos)
+        {
+            define_values[i] = define_strings[i].substr(eq + 1);
+            define_strings[i].resize(eq);
+        }
+        defines.push_back({ define_strings[i].c_str(), define_values[i].empty() ? nullptr : define_values[i].c_str() });
+    }
+
+    // キーワードの値の全ての組み合わせを列挙します。 variant_values[v][k] はバリアント v のキーワード k の値のインデックスです。
+    std::vector<std::vector<size_t>> variant_values(1, std::vector<size_t>(keywords.size()));
+    for (size_t k = 0; k < keywords.size(); k++)
+    {
+        auto num_variants = variant_values.size();
+        for (size_t value = 1; value < keywords[k].values.size(); value++)
+        {
+            for (size_t v = 0; v < num_variants; v++)
+            {
+                auto values = variant_values[v];
+                values[k] = value;
+                variant_values.emplace_back(std::move(values));
+            }
+        }
+    }
+
+    std::vector<std::string> variant_names;
+    for (auto&& values : variant_values)
+    {
+        std::string name;
+        for (size_t k = 0; k < keywords.size(); k++)
+            name += (k ? " " : "") + keywords[k].name + "=" + keywords[k].values[values[k]];
+        variant_names.emplace_back(std::move(name));
+    }
+
+    // リフレクションはDXILからのみ取得できるため、D3D12向けにコンパイルします。
+    auto num_variants = variant_values.size();
+    std::vector<sh::LOAD_SHADER_DESC>       descs(shaders.size() * num_variants);
+    std::vector<sh::SHADER_COMPILE_RESULT>  results(descs.size());
+    for (size_t s = 0; s < shaders.size(); s++)
+    {
+        for (size_t v = 0; v < num_variants; v++)
+        {
+            auto&& desc = descs[s * num_variants + v];
+            desc.filename    = shaders[s].filename.c_str();
+            desc.entry_point = shaders[s].entry_point.c_str();
+            desc.stage       = shaders[s].stage;
+            desc.defines     = defines;
+            desc.options     = options;
+            desc.cache       = nullptr;
+            for (size_t k = 0; k < keywords.size(); k++)
+                desc.defines.push_back({ keywords[k].name.c_str(), keywords[k].values[variant_values[v][k]].c_str() });
+        }
+    }
+    sh::COMPILE_BATCH_DESC batch{};
+    batch.num_shaders = descs.size();
+    batch.descs       = descs.data();
+    sh::ShaderLoader::CompileBatch(sh::COMPILE_TARGET_D3D12, batch, results.data());
+
+    std::vector<REPORT_ROW> rows;
+    for (size_t i = 0; i < descs.size(); i++)
+    {
+        auto&& shader  = shaders[i / num_variants];
+        auto&& variant = variant_names[i % num_variants];
+        auto   name    = fs::path(shader.filename).generic_string();
+        if (!results[i].succeeded)
+        {
+            std::cerr << "failed to compile " << name << (variant.empty() ? "" : " [" + variant + "]") << std::endl << results[i].diagnostics << std::endl;
+            return 1;
+        }
+
+        if (shader.stage == sh::SHADER_STAGE_LIBRARY)
+        {
+            sh::LibraryReflection reflection;
+            if (!reflection.ReflectFromBlob(results[i].bytecode))
+            {
+                std::cerr << "failed to reflect " << name << std::endl;
+                return 1;
+            }
+            for (auto&& func : reflection.GetFunctionReflections())
+            {
+                auto&& desc = *func->GetFunctionDesc();
+                auto&& r    = rows.emplace_back(REPORT_ROW{});
+                r.name      = name + ":" + desc.name;
+                r.stage     = shader.stage_name;
+                r.variant   = variant;
+                SetInstructionCounts(desc, &r);
+                r.values[METRIC_MOV_INSTRUCTIONS]           = desc.mov_instruction_count;
+                r.values[METRIC_MOVC_INSTRUCTIONS]          = desc.movc_instruction_count;
+                r.values[METRIC_CONVERSION_INSTRUCTIONS]    = desc.conversion_instruction_count;
+                r.values[METRIC_BITWISE_INSTRUCTIONS]       = desc.bitwise_instruction_count;
+                SetResourceCounts(func->GetInputBindDescs(), func->GetReflectionConstantBuffers(), &r);
+            }
+        }
+        else
+        {
+            sh::ShaderReflection reflection;
+            if (!reflection.ReflectFromBlob(results[i].bytecode))
+            {
+                std::cerr << "failed to reflect " << name << std::endl;
+                return 1;
+            }
+            auto&& desc = reflection.GetShaderDesc();
+            auto&& r    = rows.emplace_back(REPORT_ROW{});
+            r.name      = name + ":" + shader.entry_point;
+            r.stage     = shader.stage_name;
+            r.variant   = variant;
+            SetInstructionCounts(desc, &r);
+            r.values[METRIC_MOV_INSTRUCTIONS]               = reflection.GetMovInstructionCount();
+            r.values[METRIC_MOVC_INSTRUCTIONS]              = reflection.GetMovcInstructionCount();
+            r.values[METRIC_CONVERSION_INSTRUCTIONS]        = reflection.GetConversionInstructionCount();
+            r.values[METRIC_BITWISE_INSTRUCTIONS]           = reflection.GetBitwiseInstructionCount();
+            r.values[METRIC_TEXTURE_STORE_INSTRUCTIONS]     = desc.texture_store_instructions;
+            r.values[METRIC_BARRIER_INSTRUCTIONS]           = desc.barrier_instructions;
+            r.values[METRIC_INTERLOCKED_INSTRUCTIONS]       = desc.interlocked_instructions;
+            r.values[METRIC_THREAD_GROUP_SIZE]              = reflection.GetThreadGroupTotalSize();
+            SetResourceCounts(reflection.GetShaderDescData().GetInputBindDescs(), reflection.GetShaderDescData().GetReflectionCbufs(), &r);
+        }
+    }
+
+    auto has_baseline = !baseline_path.empty();
+    if (has_baseline)
+    {
+        std::vector<REPORT_ROW> baseline;
+        std::string error;
+        if (!ReadBaseline(baseline_path, &baseline, &error))
+        {
+            std::cerr << "failed to read baseline " << baseline_path.string() << ": " << error << std::endl;
+            return 1;
+        }
+        DiffWithBaseline(baseline, &rows);
+    }
+
+    if (!SortRows(sort_column, is_ascending, has_baseline, &rows))
+    {
+        std::cerr << "unknown column " << sort_column << std::endl;
+        return 1;
+    }
+
+    std::stringstream ss;
+    if (format == "json")
+        WriteJson(rows, has_baseline, ss);
+    else
+        WriteCsv(rows, has_baseline, ss);
+
+    if (output.empty())
+    {
+        std::cout << ss.str();
+    }
+    else
+    {
+        std::ofstream ofs(output, std::ios::out | std::ios::binary | std::ios::trunc);
+        ofs << ss.str();
+        if (ofs.fail())
+        {
+            std::cerr << "failed to write " << output.string() << std::endl;
+            return 1;
+        }
+    }
+
+    return CheckThresholds(rows, thresholds) ? 0 : 2;
+}
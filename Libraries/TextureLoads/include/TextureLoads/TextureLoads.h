@@ -2,6 +2,7 @@
 
 #include <string>
 #include <memory>
+#include <cstdint>
 
 namespace buma
 {
@@ -31,6 +32,68 @@ enum TEXTURE_FORMAT
     , TEXTURE_FORMAT_SFLOAT
 };
 
+enum TEXTURE_COMPRESSION_FORMAT
+{
+      TEXTURE_COMPRESSION_FORMAT_NONE
+    , TEXTURE_COMPRESSION_FORMAT_BC1 // RGB  (8 bytes per 4x4 block)
+    , TEXTURE_COMPRESSION_FORMAT_BC3 // RGBA (16 bytes per 4x4 block)
+    , TEXTURE_COMPRESSION_FORMAT_BC4 // R    (8 bytes per 4x4 block)
+    , TEXTURE_COMPRESSION_FORMAT_BC5 // RG   (16 bytes per 4x4 block)
+    , TEXTURE_COMPRESSION_FORMAT_BC7 // RGBA (16 bytes per 4x4 block)
+};
+
+enum TEXTURE_COMPRESSION_QUALITY
+{
+      TEXTURE_COMPRESSION_QUALITY_NORMAL
+    , TEXTURE_COMPRESSION_QUALITY_FAST
+    , TEXTURE_COMPRESSION_QUALITY_HIGH
+};
+
+enum TEXTURE_CONVERSION_FLAG : uint32_t
+{
+      TEXTURE_CONVERSION_FLAG_NONE              = 0x0
+    , TEXTURE_CONVERSION_FLAG_EXPAND_TO_RGBA    = 0x1  // 1, 2チャンネルの画像を4チャンネルに展開します。 (3チャンネルの画像は常に4チャンネルに展開されます。)
+    , TEXTURE_CONVERSION_FLAG_FLOAT_TO_HALF     = 0x2  // 浮動小数点の画像(.hdr)を16ビット浮動小数点に変換します。
+    , TEXTURE_CONVERSION_FLAG_PREMULTIPLY_ALPHA = 0x4  // RGBにアルファを乗算します。 4チャンネルの画像のみ有効です。
+    , TEXTURE_CONVERSION_FLAG_SRGB_TO_LINEAR    = 0x8  // RGBをsRGBからリニアに変換します。
+    , TEXTURE_CONVERSION_FLAG_LINEAR_TO_SRGB    = 0x10 // RGBをリニアからsRGBに変換します。 TEXTURE_DESC::is_srgb がtrueになります。
+};
+using TEXTURE_CONVERSION_FLAGS = uint32_t;
+
+enum TEXTURE_COMPONENT_SWIZZLE
+{
+      TEXTURE_COMPONENT_SWIZZLE_IDENTITY
+    , TEXTURE_COMPONENT_SWIZZLE_R
+    , TEXTURE_COMPONENT_SWIZZLE_G
+    , TEXTURE_COMPONENT_SWIZZLE_B
+    , TEXTURE_COMPONENT_SWIZZLE_A
+    , TEXTURE_COMPONENT_SWIZZLE_ZERO
+    , TEXTURE_COMPONENT_SWIZZLE_ONE
+};
+
+struct TEXTURE_COMPONENT_MAPPING
+{
+    TEXTURE_COMPONENT_SWIZZLE r;
+    TEXTURE_COMPONENT_SWIZZLE g;
+    TEXTURE_COMPONENT_SWIZZLE b;
+    TEXTURE_COMPONENT_SWIZZLE a;
+};
+
+enum TEXTURE_TYPE
+{
+      TEXTURE_TYPE_2D   // TEXTURE_DESC::depth は配列要素数です。
+    , TEXTURE_TYPE_CUBE // TEXTURE_DESC::depth は配列要素数(6の倍数)です。 面の順序は +X, -X, +Y, -Y, +Z, -Z です。
+    , TEXTURE_TYPE_3D   // TEXTURE_DESC::depth はボリュームの深さで、ミップ毎に縮小されます。
+};
+
+enum TEXTURE_CUBE_LAYOUT
+{
+      TEXTURE_CUBE_LAYOUT_FACES             // 1つのソースが1つの面です。
+    , TEXTURE_CUBE_LAYOUT_HORIZONTAL_CROSS  // 4x3: 1行目に+Y、2行目に -X, +Z, +X, -Z、3行目に-Y
+    , TEXTURE_CUBE_LAYOUT_VERTICAL_CROSS    // 3x4: 1行目に+Y、2行目に -X, +Z, +X、3行目に-Y、4行目に180度回転した-Z
+    , TEXTURE_CUBE_LAYOUT_HORIZONTAL_STRIP  // 6x1: +X, -X, +Y, -Y, +Z, -Z
+};
+
 struct EXTENT3D
 {
     size_t w;
@@ -42,18 +105,22 @@ struct TEXTURE_DESC
 {
     size_t          width;
     size_t          height;
-    size_t          depth;              // (array size)
+    size_t          depth;              // (array size) TEXTURE_TYPE_3D の場合はボリュームの深さ
     size_t          num_mips;
     TEXTURE_FORMAT  format;
     size_t          component_count;    // 4 := xyzw
     size_t          component_size;     // in bytes
+
+    TEXTURE_COMPRESSION_FORMAT compression_format; // NONE以外の場合、各ミップのデータは4x4ブロック単位で格納されます。
+    bool                       is_srgb;            // TEXTURE_CONVERSION_FLAG_LINEAR_TO_SRGB によってsRGBにエンコードされた場合true
+    TEXTURE_TYPE               type;
 };
 
 struct TEXTURE_LAYOUT
 {
-    size_t texel_size;  // component_count * component_size
-    size_t row_pitch;   // texel_size * width
-    size_t slice_pitch; // row_pitch * height
+    size_t texel_size;  // component_count * component_size (圧縮時は1ブロックのサイズ)
+    size_t row_pitch;   // texel_size * width               (圧縮時は1ブロック行のサイズ)
+    size_t slice_pitch; // row_pitch * height               (圧縮時は row_pitch * ブロック行数) 配列要素、ボリュームのスライスはこの間隔で連続して格納されます。
 };
 
 struct TEXTURE_DATA
@@ -64,9 +131,9 @@ struct TEXTURE_DATA
     EXTENT3D        extent;
 
     template<typename T>
-    const T* Get(size_t _depth_index = 0)
+    const T* Get(size_t _depth_index = 0) const
     {
-        uint8_t* d = reinterpret_cast<const uint8_t*>(data);
+        auto d = reinterpret_cast<const uint8_t*>(data);
         d += layout.slice_pitch * _depth_index;
 
         return reinterpret_cast<const T*>(d);
@@ -87,16 +154,70 @@ struct ITextures
 struct TEXTURE_CREATE_DESC
 {
     TEXTURE_CREATE_DESC() = default;
-    TEXTURE_CREATE_DESC(const char* _filename, size_t _mip_count = 1, size_t _row_pitch_alignment = 0, size_t _slice_pitch_alignment = 0)
-        : filename{ _filename }, mip_count{ _mip_count }, row_pitch_alignment{ _row_pitch_alignment }, slice_pitch_alignment{ _slice_pitch_alignment } {}
+    TEXTURE_CREATE_DESC(const char* _filename, size_t _mip_count = 1, size_t _row_pitch_alignment = 0, size_t _slice_pitch_alignment = 0
+                        , TEXTURE_COMPRESSION_FORMAT _compression_format = TEXTURE_COMPRESSION_FORMAT_NONE, TEXTURE_COMPRESSION_QUALITY _compression_quality = TEXTURE_COMPRESSION_QUALITY_NORMAL)
+        : filename{ _filename }, mip_count{ _mip_count }, row_pitch_alignment{ _row_pitch_alignment }, slice_pitch_alignment{ _slice_pitch_alignment }
+        , compression_format{ _compression_format }, compression_quality{ _compression_quality }, num_compression_threads{}
+        , conversion_flags{}, component_mapping{} {}
 
     const char*    filename;
     size_t         mip_count;               // set 0 to generate all mips
     size_t         row_pitch_alignment;     // set 0 to follows the texture resolution
     size_t         slice_pitch_alignment;   // set 0 to follows the texture resolution
+
+    // ブロック圧縮は8ビットのテクスチャで、かつミップ0の幅と高さが4の倍数の場合にのみ適用されます。
+    // 適用されなかった場合 TEXTURE_DESC::compression_format は TEXTURE_COMPRESSION_FORMAT_NONE になります。
+    TEXTURE_COMPRESSION_FORMAT  compression_format;
+    TEXTURE_COMPRESSION_QUALITY compression_quality;
+    size_t                      num_compression_threads; // set 0 to use std::thread::hardware_concurrency()
+
+    // 変換はミップの生成前に スウィズル -> sRGBからリニア -> アルファの乗算 -> リニアからsRGB の順で適用され、
+    // FLOAT_TO_HALF はミップの生成後に適用されます。
+    TEXTURE_CONVERSION_FLAGS    conversion_flags;
+    TEXTURE_COMPONENT_MAPPING   component_mapping;
+};
+
+// stbi_io_callbacks と同じシグネチャのコールバックです。
+struct TEXTURE_IO_CALLBACKS
+{
+    int  (*read)(void* _user, char* _data, int _size);  // _data に最大 _size バイト読み込み、読み込んだバイト数を返します。
+    void (*skip)(void* _user, int _n);                  // _n バイト読み飛ばします。
+    int  (*eof) (void* _user);                          // 終端に達している場合0以外を返します。
+};
+
+// ファイル名、またはメモリ上のファイルイメージのいずれかを指定します。
+struct TEXTURE_SOURCE
+{
+    const char* filename;       // data がnullptrの場合、このファイルから読み込まれます。
+    const void* data;
+    size_t      size_in_bytes;
+};
+
+struct TEXTURE_ARRAY_CREATE_DESC
+{
+    TEXTURE_TYPE            type;
+    TEXTURE_CUBE_LAYOUT     cube_layout;    // TEXTURE_TYPE_CUBE の場合のみ使用されます。
+    size_t                  num_sources;    // 2D: 配列要素数, CUBE: FACESの場合は面の数(6の倍数)、それ以外はキューブの数, 3D: 深さ
+    const TEXTURE_SOURCE*   sources;
+    size_t                  num_threads;    // set 0 to use std::thread::hardware_concurrency()
+
+    // filename は無視されます。 全てのソースは同じ解像度とフォーマットを持つ必要があります。
+    TEXTURE_CREATE_DESC     texture_desc;
 };
+
 std::unique_ptr<ITextures> CreateTexturesFromFile(const TEXTURE_CREATE_DESC& _desc);
 
+// メモリ上のファイルイメージからテクスチャを作成します。 _desc.filename は省略可能で、指定された場合は名前と拡張子の判定に使用されます。
+// 省略された場合、ファイル形式はデータのシグネチャから判定されます。
+std::unique_ptr<ITextures> CreateTexturesFromMemory(const void* _data, size_t _size_in_bytes, const TEXTURE_CREATE_DESC& _desc);
+
+// コールバックからファイルイメージを一度だけ読み込み、テクスチャを作成します。 _desc.filename の扱いは CreateTexturesFromMemory と同様です。
+std::unique_ptr<ITextures> CreateTexturesFromCallbacks(const TEXTURE_IO_CALLBACKS& _callbacks, void* _user, const TEXTURE_CREATE_DESC& _desc);
+
+// 複数の画像(またはキューブマップの展開図)から、配列、キューブ、ボリュームテクスチャを作成します。
+// デコードとミップの生成はソース毎に並列に行われ、各ミップの全スライスは TEXTURE_LAYOUT::slice_pitch 間隔で1つのメモリに格納されます。
+std::unique_ptr<ITextures> CreateTexturesFromSources(const TEXTURE_ARRAY_CREATE_DESC& _desc);
+
 
 }// namespace tex
 }// namespace buma
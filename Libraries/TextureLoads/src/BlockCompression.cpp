@@ -0,0 +1,489 @@
+#include "./BlockCompression.h"
+
+#ifndef STB_DXT_IMPLEMENTATION
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+#endif
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+
+namespace buma
+{
+namespace tex
+{
+
+namespace /*anonymous*/
+{
+
+// 4x4ブロックをRGBA8として取り出します。 テクスチャ端からはみ出すテクセルは端のテクセルで埋めます。
+// 不足するコンポーネントは非圧縮時のフォーマット(R8, R8G8)と同様に、RGBは0、Aは255で補完します。
+inline void FetchBlockRGBA8(const BLOCK_COMPRESSION_DESC& _desc, size_t _slice, size_t _bx, size_t _by, uint8_t _rgba[64])
+{
+    auto cc = _desc.component_count;
+    auto slice_data = _desc.src + _desc.src_slice_pitch * _slice;
+    for (size_t y = 0; y < BLOCK_EXTENT; y++)
+    {
+        auto sy  = (std::min)(_by * BLOCK_EXTENT + y, _desc.extent.h - 1);
+        auto row = slice_data + _desc.src_row_pitch * sy;
+        for (size_t x = 0; x < BLOCK_EXTENT; x++)
+        {
+            auto sx  = (std::min)(_bx * BLOCK_EXTENT + x, _desc.extent.w - 1);
+            auto src = row + sx * cc;
+            auto dst = _rgba + (y * BLOCK_EXTENT + x) * 4;
+            dst[0] =           src[0];
+            dst[1] = cc > 1 ? src[1] : 0;
+            dst[2] = cc > 2 ? src[2] : 0;
+            dst[3] = cc > 3 ? src[3] : 255;
+        }
+    }
+}
+
+#pragma region BC7
+
+// BC7はモード6(単一サブセット、RGBA 7.7.7.7 + Pビット、4ビットインデックス)のみを使用します。
+constexpr int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BC7_MODE6_ENDPOINTS
+{
+    int q[2][4]; // 7ビット
+    int p[2];    // Pビット
+};
+
+class BitWriter
+{
+public:
+    BitWriter(uint8_t* _dst)
+        : dst { _dst }
+        , pos {}
+    {
+        std::memset(dst, 0, 16);
+    }
+
+    void Write(uint32_t _value, size_t _num_bits)
+    {
+        for (size_t i = 0; i < _num_bits; i++, pos++)
+        {
+            if ((_value >> i) & 1)
+                dst[pos >> 3] |= static_cast<uint8_t>(1 << (pos & 7));
+        }
+    }
+
+private:
+    uint8_t*    dst;
+    size_t      pos;
+
+};
+
+inline void Bc7Unquantize(const BC7_MODE6_ENDPOINTS& _ep, int _dst[2][4])
+{
+    for (int e = 0; e < 2; e++)
+        for (int c = 0; c < 4; c++)
+            _dst[e][c] = (_ep.q[e][c] << 1) | _ep.p[e];
+}
+
+inline void Bc7QuantizeEndpoint(const float _ep[4], int _pbit, int _dst_q[4])
+{
+    for (int c = 0; c < 4; c++)
+    {
+        auto q = static_cast<int>(std::floor((_ep[c] - static_cast<float>(_pbit)) * 0.5f + 0.5f));
+        _dst_q[c] = (std::min)((std::max)(q, 0), 127);
+    }
+}
+
+inline int Bc7QuantizeError(const float _ep[4], int _pbit, int _dst_q[4])
+{
+    Bc7QuantizeEndpoint(_ep, _pbit, _dst_q);
+    float err = 0.f;
+    for (int c = 0; c < 4; c++)
+    {
+        auto d = _ep[c] - static_cast<float>((_dst_q[c] << 1) | _pbit);
+        err += d * d;
+    }
+    return static_cast<int>(err);
+}
+
+// 各テクセルに最も近いパレットのインデックスを割り当て、ブロック全体の二乗誤差を返します。
+inline uint32_t Bc7FindIndices(const BC7_MODE6_ENDPOINTS& _ep, const uint8_t _rgba[64], uint8_t _indices[16])
+{
+    int e[2][4];
+    Bc7Unquantize(_ep, e);
+
+    int palette[16][4];
+    for (int i = 0; i < 16; i++)
+    {
+        auto w = BC7_WEIGHTS4[i];
+        for (int c = 0; c < 4; c++)
+            palette[i][c] = ((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6;
+    }
+
+    uint32_t total_err = 0;
+    for (int t = 0; t < 16; t++)
+    {
+        auto px = _rgba + t * 4;
+        uint32_t best_err = UINT32_MAX;
+        uint8_t  best_idx = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            uint32_t err = 0;
+            for (int c = 0; c < 4; c++)
+            {
+                int d = static_cast<int>(px[c]) - palette[i][c];
+                err += static_cast<uint32_t>(d * d);
+            }
+            if (err < best_err)
+            {
+                best_err = err;
+                best_idx = static_cast<uint8_t>(i);
+            }
+        }
+        _indices[t] = best_idx;
+        total_err += best_err;
+    }
+    return total_err;
+}
+
+// 主成分軸に沿った端点を求めます。 FASTの場合はAABBの対角を使用します。
+inline void Bc7ComputeEndpoints(const uint8_t _rgba[64], TEXTURE_COMPRESSION_QUALITY _quality, float _ep[2][4])
+{
+    float mn[4] = { 255.f, 255.f, 255.f, 255.f };
+    float mx[4] = {   0.f,   0.f,   0.f,   0.f };
+    float mean[4] = {};
+    for (int t = 0; t < 16; t++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            auto v = static_cast<float>(_rgba[t * 4 + c]);
+            mn[c] = (std::min)(mn[c], v);
+            mx[c] = (std::max)(mx[c], v);
+            mean[c] += v;
+        }
+    }
+
+    if (_quality == TEXTURE_COMPRESSION_QUALITY_FAST)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            _ep[0][c] = mn[c];
+            _ep[1][c] = mx[c];
+        }
+        return;
+    }
+
+    for (int c = 0; c < 4; c++)
+        mean[c] *= 1.f / 16.f;
+
+    float cov[4][4] = {};
+    for (int t = 0; t < 16; t++)
+    {
+        float d[4];
+        for (int c = 0; c < 4; c++)
+            d[c] = static_cast<float>(_rgba[t * 4 + c]) - mean[c];
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++)
+                cov[i][j] += d[i] * d[j];
+    }
+
+    // べき乗法
+    float axis[4];
+    for (int c = 0; c < 4; c++)
+        axis[c] = mx[c] - mn[c];
+    for (int iter = 0; iter < 8; iter++)
+    {
+        float next[4] = {};
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++)
+                next[i] += cov[i][j] * axis[j];
+
+        float len = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+        if (len < 1e-6f)
+            break;
+        for (int c = 0; c < 4; c++)
+            axis[c] = next[c] / len;
+    }
+
+    float len = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3]);
+    if (len < 1e-6f)
+    {
+        for (int c = 0; c < 4; c++)
+            _ep[0][c] = _ep[1][c] = mean[c];
+        return;
+    }
+    for (int c = 0; c < 4; c++)
+        axis[c] /= len;
+
+    float tmin = FLT_MAX;
+    float tmax = -FLT_MAX;
+    for (int t = 0; t < 16; t++)
+    {
+        float proj = 0.f;
+        for (int c = 0; c < 4; c++)
+            proj += (static_cast<float>(_rgba[t * 4 + c]) - mean[c]) * axis[c];
+        tmin = (std::min)(tmin, proj);
+        tmax = (std::max)(tmax, proj);
+    }
+    for (int c = 0; c < 4; c++)
+    {
+        _ep[0][c] = (std::min)((std::max)(mean[c] + axis[c] * tmin, 0.f), 255.f);
+        _ep[1][c] = (std::min)((std::max)(mean[c] + axis[c] * tmax, 0.f), 255.f);
+    }
+}
+
+// 割り当て済みのインデックスから最小二乗法で端点を再計算します。
+inline bool Bc7RefineEndpoints(const uint8_t _rgba[64], const uint8_t _indices[16], float _ep[2][4])
+{
+    float a = 0.f, b = 0.f, c = 0.f;
+    float rhs0[4] = {}, rhs1[4] = {};
+    for (int t = 0; t < 16; t++)
+    {
+        auto w1 = static_cast<float>(BC7_WEIGHTS4[_indices[t]]) / 64.f;
+        auto w0 = 1.f - w1;
+        a += w0 * w0;
+        b += w0 * w1;
+        c += w1 * w1;
+        for (int ch = 0; ch < 4; ch++)
+        {
+            auto v = static_cast<float>(_rgba[t * 4 + ch]);
+            rhs0[ch] += w0 * v;
+            rhs1[ch] += w1 * v;
+        }
+    }
+
+    auto det = a * c - b * b;
+    if (std::fabs(det) < 1e-6f)
+        return false;
+
+    auto inv_det = 1.f / det;
+    for (int ch = 0; ch < 4; ch++)
+    {
+        _ep[0][ch] = (std::min)((std::max)((c * rhs0[ch] - b * rhs1[ch]) * inv_det, 0.f), 255.f);
+        _ep[1][ch] = (std::min)((std::max)((a * rhs1[ch] - b * rhs0[ch]) * inv_det, 0.f), 255.f);
+    }
+    return true;
+}
+
+// 端点を量子化してインデックスを求めます。 HIGHの場合は全てのPビットの組み合わせを試行します。
+inline uint32_t Bc7QuantizeAndFit(const uint8_t _rgba[64], TEXTURE_COMPRESSION_QUALITY _quality, const float _ep[2][4], BC7_MODE6_ENDPOINTS* _dst_ep, uint8_t _dst_indices[16])
+{
+    if (_quality != TEXTURE_COMPRESSION_QUALITY_HIGH)
+    {
+        for (int e = 0; e < 2; e++)
+        {
+            int q0[4], q1[4];
+            auto err0 = Bc7QuantizeError(_ep[e], 0, q0);
+            auto err1 = Bc7QuantizeError(_ep[e], 1, q1);
+            _dst_ep->p[e] = err1 < err0 ? 1 : 0;
+            std::memcpy(_dst_ep->q[e], err1 < err0 ? q1 : q0, sizeof(q0));
+        }
+        return Bc7FindIndices(*_dst_ep, _rgba, _dst_indices);
+    }
+
+    uint32_t best_err = UINT32_MAX;
+    for (int pbits = 0; pbits < 4; pbits++)
+    {
+        BC7_MODE6_ENDPOINTS ep{};
+        uint8_t             indices[16];
+        ep.p[0] = pbits & 1;
+        ep.p[1] = pbits >> 1;
+        Bc7QuantizeEndpoint(_ep[0], ep.p[0], ep.q[0]);
+        Bc7QuantizeEndpoint(_ep[1], ep.p[1], ep.q[1]);
+        auto err = Bc7FindIndices(ep, _rgba, indices);
+        if (err < best_err)
+        {
+            best_err = err;
+            *_dst_ep = ep;
+            std::memcpy(_dst_indices, indices, sizeof(indices));
+        }
+    }
+    return best_err;
+}
+
+inline void CompressBC7Block(uint8_t* _dst, const uint8_t _rgba[64], TEXTURE_COMPRESSION_QUALITY _quality)
+{
+    float               ep[2][4];
+    BC7_MODE6_ENDPOINTS qep{};
+    uint8_t             indices[16];
+    Bc7ComputeEndpoints(_rgba, _quality, ep);
+    auto err = Bc7QuantizeAndFit(_rgba, _quality, ep, &qep, indices);
+
+    if (_quality != TEXTURE_COMPRESSION_QUALITY_FAST)
+    {
+        const int num_iterations = _quality == TEXTURE_COMPRESSION_QUALITY_HIGH ? 3 : 1;
+        for (int i = 0; i < num_iterations && err != 0; i++)
+        {
+            float               refined_ep[2][4];
+            BC7_MODE6_ENDPOINTS refined_qep{};
+            uint8_t             refined_indices[16];
+            if (!Bc7RefineEndpoints(_rgba, indices, refined_ep))
+                break;
+
+            auto refined_err = Bc7QuantizeAndFit(_rgba, _quality, refined_ep, &refined_qep, refined_indices);
+            if (refined_err >= err)
+                break;
+
+            err = refined_err;
+            qep = refined_qep;
+            std::memcpy(indices, refined_indices, sizeof(indices));
+        }
+    }
+
+    // アンカーインデックス(テクセル0)の最上位ビットは0である必要があるため、必要に応じて端点を入れ替えます。
+    if (indices[0] & 0x8)
+    {
+        std::swap(qep.q[0], qep.q[1]);
+        std::swap(qep.p[0], qep.p[1]);
+        for (auto& i : indices)
+            i = static_cast<uint8_t>(15 - i);
+    }
+
+    BitWriter bw(_dst);
+    bw.Write(1 << 6, 7); // mode 6
+    for (int c = 0; c < 4; c++)
+    {
+        bw.Write(static_cast<uint32_t>(qep.q[0][c]), 7);
+        bw.Write(static_cast<uint32_t>(qep.q[1][c]), 7);
+    }
+    bw.Write(static_cast<uint32_t>(qep.p[0]), 1);
+    bw.Write(static_cast<uint32_t>(qep.p[1]), 1);
+    bw.Write(indices[0], 3);
+    for (int t = 1; t < 16; t++)
+        bw.Write(indices[t], 4);
+}
+
+#pragma endregion BC7
+
+inline void CompressBlock(TEXTURE_COMPRESSION_FORMAT _format, TEXTURE_COMPRESSION_QUALITY _quality, uint8_t* _dst, const uint8_t _rgba[64])
+{
+    int stb_mode = _quality == TEXTURE_COMPRESSION_QUALITY_FAST ? STB_DXT_NORMAL : STB_DXT_HIGHQUAL;
+    switch (_format)
+    {
+    case TEXTURE_COMPRESSION_FORMAT_BC1:
+        stb_compress_dxt_block(_dst, _rgba, 0, stb_mode);
+        break;
+
+    case TEXTURE_COMPRESSION_FORMAT_BC3:
+        stb_compress_dxt_block(_dst, _rgba, 1, stb_mode);
+        break;
+
+    case TEXTURE_COMPRESSION_FORMAT_BC4:
+    {
+        uint8_t r[16];
+        for (int t = 0; t < 16; t++)
+            r[t] = _rgba[t * 4];
+        stb_compress_bc4_block(_dst, r);
+        break;
+    }
+
+    case TEXTURE_COMPRESSION_FORMAT_BC5:
+    {
+        uint8_t rg[32];
+        for (int t = 0; t < 16; t++)
+        {
+            rg[t * 2 + 0] = _rgba[t * 4 + 0];
+            rg[t * 2 + 1] = _rgba[t * 4 + 1];
+        }
+        stb_compress_bc5_block(_dst, rg);
+        break;
+    }
+
+    case TEXTURE_COMPRESSION_FORMAT_BC7:
+        CompressBC7Block(_dst, _rgba, _quality);
+        break;
+
+    default:
+        break;
+    }
+}
+
+inline void CompressBlockRow(TEXTURE_COMPRESSION_FORMAT _format, TEXTURE_COMPRESSION_QUALITY _quality, const BLOCK_COMPRESSION_DESC& _desc, size_t _slice, size_t _by)
+{
+    auto block_size = GetCompressedBlockSize(_format);
+    auto num_blocks_w = CalcNumBlocks(_desc.extent.w);
+    auto dst = _desc.dst + _desc.dst_slice_pitch * _slice + _desc.dst_row_pitch * _by;
+
+    uint8_t rgba[64];
+    for (size_t bx = 0; bx < num_blocks_w; bx++)
+    {
+        FetchBlockRGBA8(_desc, _slice, bx, _by, rgba);
+        CompressBlock(_format, _quality, dst + block_size * bx, rgba);
+    }
+}
+
+
+}// namespace /*anonymous*/
+
+size_t GetCompressedBlockSize(TEXTURE_COMPRESSION_FORMAT _format)
+{
+    switch (_format)
+    {
+    case TEXTURE_COMPRESSION_FORMAT_BC1: return 8;
+    case TEXTURE_COMPRESSION_FORMAT_BC3: return 16;
+    case TEXTURE_COMPRESSION_FORMAT_BC4: return 8;
+    case TEXTURE_COMPRESSION_FORMAT_BC5: return 16;
+    case TEXTURE_COMPRESSION_FORMAT_BC7: return 16;
+
+    default:
+        return 0;
+    }
+}
+
+bool CompressBlocks(  TEXTURE_COMPRESSION_FORMAT    _format
+                    , TEXTURE_COMPRESSION_QUALITY   _quality
+                    , size_t                        _num_threads
+                    , size_t                        _num_descs
+                    , const BLOCK_COMPRESSION_DESC* _descs)
+{
+    if (GetCompressedBlockSize(_format) == 0)
+        return false;
+
+    // ジョブはブロック行単位です。 (ミップ, スライス, ブロック行)をフラットなインデックスに展開します。
+    std::vector<size_t> job_offsets(_num_descs + 1);
+    for (size_t i = 0; i < _num_descs; i++)
+    {
+        auto&& d = _descs[i];
+        if (d.component_count == 0 || d.component_count > 4)
+            return false;
+        job_offsets[i + 1] = job_offsets[i] + CalcNumBlocks(d.extent.h) * d.extent.d;
+    }
+
+    auto num_jobs = job_offsets.back();
+    std::atomic_size_t next_job{};
+    auto Worker = [&]()
+    {
+        size_t desc_index = 0;
+        for (size_t job = next_job++; job < num_jobs; job = next_job++)
+        {
+            while (job >= job_offsets[desc_index + 1])
+                desc_index++;
+
+            auto&& d = _descs[desc_index];
+            auto local = job - job_offsets[desc_index];
+            auto num_blocks_h = CalcNumBlocks(d.extent.h);
+            CompressBlockRow(_format, _quality, d, local / num_blocks_h, local % num_blocks_h);
+        }
+    };
+
+    auto num_threads = _num_threads != 0 ? _num_threads : static_cast<size_t>(std::thread::hardware_concurrency());
+    num_threads = (std::min)((std::max)(num_threads, size_t(1)), num_jobs);
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (size_t i = 1; i < num_threads; i++)
+        threads.emplace_back(Worker);
+
+    Worker();
+    for (auto& i : threads)
+        i.join();
+
+    return true;
+}
+
+
+}// namespace tex
+}// namespace buma
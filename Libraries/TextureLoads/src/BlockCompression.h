@@ -0,0 +1,47 @@
+#pragma once
+
+#include <TextureLoads/TextureLoads.h>
+
+#include <cstdint>
+
+namespace buma
+{
+namespace tex
+{
+
+// 1ミップ分の圧縮元(RGBA8等の非圧縮データ)と圧縮先(4x4ブロック)の記述です。
+struct BLOCK_COMPRESSION_DESC
+{
+    EXTENT3D        extent;             // in texels
+    size_t          component_count;    // 圧縮元のコンポーネント数(1~4, 8ビット)
+
+    const uint8_t*  src;
+    size_t          src_row_pitch;
+    size_t          src_slice_pitch;
+
+    uint8_t*        dst;
+    size_t          dst_row_pitch;      // 1ブロック行のサイズ
+    size_t          dst_slice_pitch;
+};
+
+constexpr size_t BLOCK_EXTENT = 4;
+
+inline size_t CalcNumBlocks(size_t _texels)
+{
+    return (_texels + (BLOCK_EXTENT - 1)) / BLOCK_EXTENT;
+}
+
+// 4x4ブロックのバイトサイズを返します。 TEXTURE_COMPRESSION_FORMAT_NONE の場合0を返します。
+size_t GetCompressedBlockSize(TEXTURE_COMPRESSION_FORMAT _format);
+
+// _descs に指定された全てのミップを _num_threads 個のスレッドでブロック行単位に分割して圧縮します。
+// _num_threads が0の場合 std::thread::hardware_concurrency() を使用します。
+bool CompressBlocks(  TEXTURE_COMPRESSION_FORMAT    _format
+                    , TEXTURE_COMPRESSION_QUALITY   _quality
+                    , size_t                        _num_threads
+                    , size_t                        _num_descs
+                    , const BLOCK_COMPRESSION_DESC* _descs);
+
+
+}// namespace tex
+}// namespace buma
@@ -0,0 +1,225 @@
+#include "./FormatConversion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// GCC/Clang は -mavx2 のみでは F16C を有効にしないため、 __F16C__ で判定します。 MSVC は __F16C__ を定義しませんが、 /arch:AVX2 で F16C 命令を使用できます。
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#include <immintrin.h>
+#define BUMA_TEX_USE_F16C
+#endif
+
+namespace buma
+{
+namespace tex
+{
+
+namespace /*anonymous*/
+{
+
+inline float SrgbToLinear(float _c)
+{
+    return _c <= 0.04045f ? _c / 12.92f : std::pow((_c + 0.055f) / 1.055f, 2.4f);
+}
+
+inline float LinearToSrgb(float _c)
+{
+    return _c <= 0.0031308f ? _c * 12.92f : 1.055f * std::pow(_c, 1.f / 2.4f) - 0.055f;
+}
+
+// 8ビットのsRGB値からリニア値へのテーブルと、12ビットに量子化したリニア値から8ビットのsRGB値へのテーブルです。
+struct SRGB_TABLES
+{
+    static constexpr size_t ENCODE_TABLE_SIZE = 4096;
+
+    SRGB_TABLES()
+    {
+        for (size_t i = 0; i < 256; i++)
+            decode[i] = SrgbToLinear(static_cast<float>(i) / 255.f);
+
+        for (size_t i = 0; i < ENCODE_TABLE_SIZE; i++)
+            encode[i] = static_cast<uint8_t>(LinearToSrgb(static_cast<float>(i) / static_cast<float>(ENCODE_TABLE_SIZE - 1)) * 255.f + 0.5f);
+    }
+
+    float   decode[256];
+    uint8_t encode[ENCODE_TABLE_SIZE];
+};
+
+const SRGB_TABLES& GetSrgbTables()
+{
+    static const SRGB_TABLES tables;
+    return tables;
+}
+
+inline bool IsIdentityMapping(const TEXTURE_COMPONENT_MAPPING& _mapping)
+{
+    return (_mapping.r == TEXTURE_COMPONENT_SWIZZLE_IDENTITY || _mapping.r == TEXTURE_COMPONENT_SWIZZLE_R) &&
+           (_mapping.g == TEXTURE_COMPONENT_SWIZZLE_IDENTITY || _mapping.g == TEXTURE_COMPONENT_SWIZZLE_G) &&
+           (_mapping.b == TEXTURE_COMPONENT_SWIZZLE_IDENTITY || _mapping.b == TEXTURE_COMPONENT_SWIZZLE_B) &&
+           (_mapping.a == TEXTURE_COMPONENT_SWIZZLE_IDENTITY || _mapping.a == TEXTURE_COMPONENT_SWIZZLE_A);
+}
+
+template<typename T>
+inline void Swizzle(const TEXEL_CONVERSION_DESC& _desc, T* _data, T _one)
+{
+    const TEXTURE_COMPONENT_SWIZZLE swizzles[4] = { _desc.mapping.r, _desc.mapping.g, _desc.mapping.b, _desc.mapping.a };
+    auto cc = _desc.component_count;
+    for (size_t i = 0; i < _desc.num_texels; i++)
+    {
+        auto texel = _data + i * cc;
+
+        // 存在しないコンポーネントはRGBを0、Aを1として扱います。
+        T src[4] = { T(0), T(0), T(0), _one };
+        for (size_t c = 0; c < cc; c++)
+            src[c] = texel[c];
+
+        for (size_t c = 0; c < cc; c++)
+        {
+            switch (swizzles[c])
+            {
+            case TEXTURE_COMPONENT_SWIZZLE_R    : texel[c] = src[0]; break;
+            case TEXTURE_COMPONENT_SWIZZLE_G    : texel[c] = src[1]; break;
+            case TEXTURE_COMPONENT_SWIZZLE_B    : texel[c] = src[2]; break;
+            case TEXTURE_COMPONENT_SWIZZLE_A    : texel[c] = src[3]; break;
+            case TEXTURE_COMPONENT_SWIZZLE_ZERO : texel[c] = T(0);   break;
+            case TEXTURE_COMPONENT_SWIZZLE_ONE  : texel[c] = _one;   break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+inline uint16_t FloatToHalfScalar(float _f)
+{
+    // 最近接偶数丸め
+    uint32_t u{};
+    std::memcpy(&u, &_f, sizeof(u));
+
+    const uint32_t sign = u & 0x80000000u;
+    u ^= sign;
+
+    uint16_t result{};
+    if (u >= (127u + 16u) << 23) // Inf, NaN またはオーバーフロー
+    {
+        result = u > (255u << 23) ? 0x7e00 : 0x7c00;
+    }
+    else if (u < (113u << 23)) // 非正規化数またはゼロ
+    {
+        constexpr uint32_t DENORM_MAGIC = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+        float f{}, magic{};
+        std::memcpy(&f, &u, sizeof(f));
+        std::memcpy(&magic, &DENORM_MAGIC, sizeof(magic));
+        f += magic;
+        std::memcpy(&u, &f, sizeof(u));
+        result = static_cast<uint16_t>(u - DENORM_MAGIC);
+    }
+    else
+    {
+        uint32_t mant_odd = (u >> 13) & 1;
+        u += (static_cast<uint32_t>(15 - 127) << 23) + 0xfff;
+        u += mant_odd;
+        result = static_cast<uint16_t>(u >> 13);
+    }
+
+    return static_cast<uint16_t>(result | (sign >> 16));
+}
+
+
+}// namespace /*anonymous*/
+
+bool RequiresTexelConversion(const TEXEL_CONVERSION_DESC& _desc)
+{
+    constexpr TEXTURE_CONVERSION_FLAGS TEXEL_FLAGS = TEXTURE_CONVERSION_FLAG_PREMULTIPLY_ALPHA | TEXTURE_CONVERSION_FLAG_SRGB_TO_LINEAR | TEXTURE_CONVERSION_FLAG_LINEAR_TO_SRGB;
+    return (_desc.flags & TEXEL_FLAGS) || !IsIdentityMapping(_desc.mapping);
+}
+
+bool ConvertTexels(const TEXEL_CONVERSION_DESC& _desc, uint8_t* _data)
+{
+    if ((_desc.flags & TEXTURE_CONVERSION_FLAG_SRGB_TO_LINEAR) && (_desc.flags & TEXTURE_CONVERSION_FLAG_LINEAR_TO_SRGB))
+        return false;
+
+    if (!IsIdentityMapping(_desc.mapping))
+        Swizzle<uint8_t>(_desc, _data, 255);
+
+    auto cc            = _desc.component_count;
+    auto num_rgb       = (std::min)(cc, size_t(3));
+    auto to_linear     = (_desc.flags & TEXTURE_CONVERSION_FLAG_SRGB_TO_LINEAR)    != 0;
+    auto to_srgb       = (_desc.flags & TEXTURE_CONVERSION_FLAG_LINEAR_TO_SRGB)    != 0;
+    auto premultiply   = (_desc.flags & TEXTURE_CONVERSION_FLAG_PREMULTIPLY_ALPHA) != 0 && cc == 4;
+    if (!to_linear && !to_srgb && !premultiply)
+        return true;
+
+    // 8ビットのまま中間値を丸めると精度が落ちるため、テクセル毎に浮動小数点で処理します。
+    auto&& tables = GetSrgbTables();
+    constexpr float ENCODE_SCALE = static_cast<float>(SRGB_TABLES::ENCODE_TABLE_SIZE - 1);
+    for (size_t i = 0; i < _desc.num_texels; i++)
+    {
+        auto texel = _data + i * cc;
+        float alpha = premultiply ? static_cast<float>(texel[3]) / 255.f : 1.f;
+        for (size_t c = 0; c < num_rgb; c++)
+        {
+            float v = to_linear ? tables.decode[texel[c]] : static_cast<float>(texel[c]) / 255.f;
+            v *= alpha;
+            if (to_srgb)
+                texel[c] = tables.encode[static_cast<size_t>(v * ENCODE_SCALE + 0.5f)];
+            else
+                texel[c] = static_cast<uint8_t>(v * 255.f + 0.5f);
+        }
+    }
+
+    return true;
+}
+
+bool ConvertTexels(const TEXEL_CONVERSION_DESC& _desc, float* _data)
+{
+    if ((_desc.flags & TEXTURE_CONVERSION_FLAG_SRGB_TO_LINEAR) && (_desc.flags & TEXTURE_CONVERSION_FLAG_LINEAR_TO_SRGB))
+        return false;
+
+    if (!IsIdentityMapping(_desc.mapping))
+        Swizzle<float>(_desc, _data, 1.f);
+
+    auto cc            = _desc.component_count;
+    auto num_rgb       = (std::min)(cc, size_t(3));
+    auto to_linear     = (_desc.flags & TEXTURE_CONVERSION_FLAG_SRGB_TO_LINEAR)    != 0;
+    auto to_srgb       = (_desc.flags & TEXTURE_CONVERSION_FLAG_LINEAR_TO_SRGB)    != 0;
+    auto premultiply   = (_desc.flags & TEXTURE_CONVERSION_FLAG_PREMULTIPLY_ALPHA) != 0 && cc == 4;
+    if (!to_linear && !to_srgb && !premultiply)
+        return true;
+
+    for (size_t i = 0; i < _desc.num_texels; i++)
+    {
+        auto texel = _data + i * cc;
+        float alpha = premultiply ? texel[3] : 1.f;
+        for (size_t c = 0; c < num_rgb; c++)
+        {
+            float v = to_linear ? SrgbToLinear(texel[c]) : texel[c];
+            v *= alpha;
+            texel[c] = to_srgb ? LinearToSrgb((std::max)(v, 0.f)) : v;
+        }
+    }
+
+    return true;
+}
+
+void ConvertFloatToHalf(const float* _src, uint16_t* _dst, size_t _count)
+{
+    size_t i = 0;
+
+#ifdef BUMA_TEX_USE_F16C
+    for (; i + 8 <= _count; i += 8)
+    {
+        auto v = _mm256_loadu_ps(_src + i);
+        auto h = _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + i), h);
+    }
+#endif // BUMA_TEX_USE_F16C
+
+    for (; i < _count; i++)
+        _dst[i] = FloatToHalfScalar(_src[i]);
+}
+
+
+}// namespace tex
+}// namespace buma
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <TextureLoads/TextureLoads.h>
+
+#include <cstdint>
+
+namespace buma
+{
+namespace tex
+{
+
+struct TEXEL_CONVERSION_DESC
+{
+    TEXTURE_CONVERSION_FLAGS    flags;
+    TEXTURE_COMPONENT_MAPPING   mapping;
+    size_t                      component_count;
+    size_t                      num_texels;
+};
+
+// ミップ生成前にテクセル単位で適用される変換(スウィズル、色空間、アルファの乗算)が必要かどうかを返します。
+bool RequiresTexelConversion(const TEXEL_CONVERSION_DESC& _desc);
+
+// 密にパックされたテクセル配列を、その場で変換します。
+bool ConvertTexels(const TEXEL_CONVERSION_DESC& _desc, uint8_t* _data);
+bool ConvertTexels(const TEXEL_CONVERSION_DESC& _desc, float*   _data);
+
+// F16Cが利用可能な場合は8要素単位で変換します。
+void ConvertFloatToHalf(const float* _src, uint16_t* _dst, size_t _count);
+
+
+}// namespace tex
+}// namespace buma
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace buma
+{
+namespace tex
+{
+
+// [0, _count) の各インデックスについて _func を呼び出します。 インデックスは最大 _num_threads 個のスレッドに動的に分配されます。
+// _num_threads が0の場合 std::thread::hardware_concurrency() を使用し、ジョブが1つの場合は呼び出し元のスレッドのみで処理します。
+template<typename Func>
+inline void ParallelFor(size_t _num_threads, size_t _count, Func&& _func)
+{
+    std::atomic_size_t next{};
+    auto Worker = [&]()
+    {
+        for (size_t i = next++; i < _count; i = next++)
+            _func(i);
+    };
+
+    auto num_threads = _num_threads != 0 ? _num_threads : static_cast<size_t>(std::thread::hardware_concurrency());
+    num_threads = (std::min)((std::max)(num_threads, size_t(1)), (std::max)(_count, size_t(1)));
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t i = 1; i < num_threads; i++)
+        threads.emplace_back(Worker);
+
+    Worker();
+    for (auto& i : threads)
+        i.join();
+}
+
+
+}// namespace tex
+}// namespace buma
@@ -1,4 +1,7 @@
 #include <TextureLoads/TextureLoads.h>
+#include "./BlockCompression.h"
+#include "./FormatConversion.h"
+#include "./ParallelFor.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -14,6 +17,10 @@
 
 #include <vector>
 #include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <climits>
+#include <atomic>
 
 
 namespace buma
@@ -34,11 +41,12 @@ inline size_t CalcMipLevels(const EXTENT3D& _extent)
     return 1ull + static_cast<size_t>(floorf(log2f(static_cast<float>((std::max)({ _extent.w, _extent.h, _extent.d })))));
 }
 
+// 配列、キューブの場合depthは配列要素数のため縮小されません。
 inline EXTENT3D CalcMipExtents(size_t _mip_slice, const TEXTURE_DESC& _extent_mip0)
 {
     return EXTENT3D{ (std::max)(_extent_mip0.width  >> _mip_slice, 1ull)
                    , (std::max)(_extent_mip0.height >> _mip_slice, 1ull)
-                   , (std::max)(_extent_mip0.depth  >> _mip_slice, 1ull) };
+                   , _extent_mip0.type == TEXTURE_TYPE_3D ? (std::max)(_extent_mip0.depth >> _mip_slice, 1ull) : _extent_mip0.depth };
 }
 
 inline size_t AlignUp(size_t _val, size_t _alignment)
@@ -46,6 +54,69 @@ inline size_t AlignUp(size_t _val, size_t _alignment)
     return (_val + (_alignment - 1)) & ~(_alignment - 1);
 }
 
+inline bool GetFileFormatFromExtension(const std::filesystem::path& _file_path, TEXTURE_FILE_FORMAT* _dst_format)
+{
+    auto&& ext = _file_path.extension();
+         if (ext == ".jpg")   *_dst_format = TEXTURE_FILE_FORMAT_JPG;
+    else if (ext == ".jpeg")  *_dst_format = TEXTURE_FILE_FORMAT_JPG;
+    else if (ext == ".png")   *_dst_format = TEXTURE_FILE_FORMAT_PNG;
+    else if (ext == ".tga")   *_dst_format = TEXTURE_FILE_FORMAT_TGA;
+    else if (ext == ".bmp")   *_dst_format = TEXTURE_FILE_FORMAT_BMP;
+    else if (ext == ".hdr")   *_dst_format = TEXTURE_FILE_FORMAT_HDR;
+    else return false;
+
+    return true;
+}
+
+// TGAはシグネチャを持たないため、他の形式に一致しない場合にTGAとして扱います。(最終的な判定はstbによるデコードで行われます。)
+inline bool GetFileFormatFromSignature(const uint8_t* _data, size_t _size, TEXTURE_FILE_FORMAT* _dst_format)
+{
+    auto Match = [_data, _size](const char* _sig, size_t _sig_size)
+    { return _size >= _sig_size && std::memcmp(_data, _sig, _sig_size) == 0; };
+
+         if (Match("\x89PNG\r\n\x1a\n", 8))   *_dst_format = TEXTURE_FILE_FORMAT_PNG;
+    else if (Match("\xff\xd8\xff", 3))        *_dst_format = TEXTURE_FILE_FORMAT_JPG;
+    else if (Match("BM", 2))                  *_dst_format = TEXTURE_FILE_FORMAT_BMP;
+    else if (Match("#?RADIANCE", 10))         *_dst_format = TEXTURE_FILE_FORMAT_HDR;
+    else if (Match("#?RGBE", 6))              *_dst_format = TEXTURE_FILE_FORMAT_HDR;
+    else if (_size != 0)                      *_dst_format = TEXTURE_FILE_FORMAT_TGA;
+    else return false;
+
+    return true;
+}
+
+inline bool ReadFile(const char* _filename, std::vector<uint8_t>* _dst)
+{
+    std::ifstream ifs(_filename, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!ifs.is_open())
+        return false;
+
+    auto size = static_cast<size_t>(ifs.tellg());
+    ifs.seekg(0, std::ios::beg);
+    _dst->resize(size);
+    ifs.read(reinterpret_cast<char*>(_dst->data()), static_cast<std::streamsize>(size));
+    return !ifs.fail();
+}
+
+inline bool ReadCallbacks(const TEXTURE_IO_CALLBACKS& _callbacks, void* _user, std::vector<uint8_t>* _dst)
+{
+    if (!_callbacks.read || !_callbacks.eof)
+        return false;
+
+    constexpr int CHUNK_SIZE = 64 * 1024;
+    size_t size = 0;
+    while (!_callbacks.eof(_user))
+    {
+        _dst->resize(size + CHUNK_SIZE);
+        auto num_read = _callbacks.read(_user, reinterpret_cast<char*>(_dst->data() + size), CHUNK_SIZE);
+        if (num_read <= 0)
+            break;
+        size += static_cast<size_t>(num_read);
+    }
+    _dst->resize(size);
+    return size != 0;
+}
+
 class RawData
 {
 public:
@@ -85,6 +156,144 @@ public:
 
 };
 
+// stbによってデコードされた画像です。
+struct DECODED_IMAGE
+{
+    DECODED_IMAGE()
+        : data              {}
+        , width             {}
+        , height            {}
+        , format            {}
+        , component_count   {}
+        , component_size    {}
+    {
+    }
+    ~DECODED_IMAGE()
+    {
+        if (data)
+            stbi_image_free(data);
+    }
+    DECODED_IMAGE(const DECODED_IMAGE&) = delete;
+    DECODED_IMAGE& operator=(const DECODED_IMAGE&) = delete;
+
+    size_t GetRowPitch() const { return width * component_count * component_size; }
+
+    void*           data;
+    size_t          width;
+    size_t          height;
+    TEXTURE_FORMAT  format;
+    size_t          component_count;
+    size_t          component_size;
+};
+
+inline bool DecodeImage(const TEXTURE_CREATE_DESC& _desc, const uint8_t* _file_data, size_t _file_size, DECODED_IMAGE* _dst)
+{
+    int x           {};
+    int y           {};
+    int chs_in_file {};
+    int req_comp    = STBI_default;
+
+    if (_file_size > static_cast<size_t>(INT_MAX))
+        return false;
+
+    auto len = static_cast<int>(_file_size);
+    if (stbi_info_from_memory(_file_data, len, &x, &y, &req_comp) == 0)
+        return false;
+
+    if (req_comp == STBI_rgb || (_desc.conversion_flags & TEXTURE_CONVERSION_FLAG_EXPAND_TO_RGBA))
+        req_comp = STBI_rgb_alpha;
+
+    if (stbi_is_hdr_from_memory(_file_data, len))
+    {
+        _dst->data              = stbi_loadf_from_memory(_file_data, len, &x, &y, &chs_in_file, req_comp);
+        _dst->component_size    = sizeof(float);
+        _dst->format            = TEXTURE_FORMAT_SFLOAT;
+    }
+    else
+    {
+        _dst->data              = stbi_load_from_memory(_file_data, len, &x, &y, &chs_in_file, req_comp);
+        _dst->component_size    = sizeof(stbi_uc);
+        _dst->format            = TEXTURE_FORMAT_UINT;
+    }
+
+    if (!_dst->data)
+        return false;
+
+    _dst->width             = static_cast<size_t>(x);
+    _dst->height            = static_cast<size_t>(y);
+    _dst->component_count   = static_cast<size_t>(req_comp == STBI_default ? chs_in_file : req_comp);
+    return true;
+}
+
+inline bool ConvertImage(const TEXTURE_CREATE_DESC& _desc, DECODED_IMAGE* _image)
+{
+    TEXEL_CONVERSION_DESC cd{};
+    cd.flags            = _desc.conversion_flags;
+    cd.mapping          = _desc.component_mapping;
+    cd.component_count  = _image->component_count;
+    cd.num_texels       = _image->width * _image->height;
+    if (!RequiresTexelConversion(cd))
+        return true;
+
+    if (_image->format == TEXTURE_FORMAT_SFLOAT)
+        return ConvertTexels(cd, static_cast<float*>(_image->data));
+    else
+        return ConvertTexels(cd, static_cast<uint8_t*>(_image->data));
+}
+
+// ミップ0の1スライス分のコピー元です。 キューブマップの展開図の場合は画像内の1面を指します。
+struct SLICE_SOURCE
+{
+    const uint8_t*  data;
+    size_t          row_pitch;
+    bool            rotate_180;
+};
+
+inline void CopySlice(const SLICE_SOURCE& _src, const EXTENT3D& _extent, size_t _texel_size, size_t _dst_row_pitch, uint8_t* _dst)
+{
+    auto row_size = _texel_size * _extent.w;
+    if (!_src.rotate_180)
+    {
+        for (size_t y = 0; y < _extent.h; y++)
+            memcpy(_dst + (_dst_row_pitch * y), _src.data + (_src.row_pitch * y), row_size);
+        return;
+    }
+
+    for (size_t y = 0; y < _extent.h; y++)
+    {
+        auto src_row = _src.data + (_src.row_pitch * (_extent.h - 1 - y));
+        auto dst_row = _dst + (_dst_row_pitch * y);
+        for (size_t x = 0; x < _extent.w; x++)
+            memcpy(dst_row + (_texel_size * x), src_row + (_texel_size * (_extent.w - 1 - x)), _texel_size);
+    }
+}
+
+// TEXTURE_CUBE_LAYOUT の展開図における各面の位置です。 (面の単位)
+struct CUBE_FACE_PLACEMENT
+{
+    size_t  x;
+    size_t  y;
+    bool    rotate_180;
+};
+
+inline bool GetCubeLayoutPlacements(TEXTURE_CUBE_LAYOUT _layout, size_t* _num_faces_x, size_t* _num_faces_y, const CUBE_FACE_PLACEMENT** _placements)
+{
+    static const CUBE_FACE_PLACEMENT HORIZONTAL_CROSS[6] = { { 2,1,false }, { 0,1,false }, { 1,0,false }, { 1,2,false }, { 1,1,false }, { 3,1,false } };
+    static const CUBE_FACE_PLACEMENT VERTICAL_CROSS[6]   = { { 2,1,false }, { 0,1,false }, { 1,0,false }, { 1,2,false }, { 1,1,false }, { 1,3,true  } };
+    static const CUBE_FACE_PLACEMENT HORIZONTAL_STRIP[6] = { { 0,0,false }, { 1,0,false }, { 2,0,false }, { 3,0,false }, { 4,0,false }, { 5,0,false } };
+
+    switch (_layout)
+    {
+    case TEXTURE_CUBE_LAYOUT_HORIZONTAL_CROSS : *_num_faces_x = 4; *_num_faces_y = 3; *_placements = HORIZONTAL_CROSS; break;
+    case TEXTURE_CUBE_LAYOUT_VERTICAL_CROSS   : *_num_faces_x = 3; *_num_faces_y = 4; *_placements = VERTICAL_CROSS;   break;
+    case TEXTURE_CUBE_LAYOUT_HORIZONTAL_STRIP : *_num_faces_x = 6; *_num_faces_y = 1; *_placements = HORIZONTAL_STRIP; break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
 
 }// namespace /*anonymous*/
 
@@ -106,32 +315,50 @@ public:
     }
 
     static std::unique_ptr<ITextures> Create(const TEXTURE_CREATE_DESC& _desc);
+    static std::unique_ptr<ITextures> CreateFromMemory(const void* _data, size_t _size_in_bytes, const TEXTURE_CREATE_DESC& _desc);
+    static std::unique_ptr<ITextures> CreateFromCallbacks(const TEXTURE_IO_CALLBACKS& _callbacks, void* _user, const TEXTURE_CREATE_DESC& _desc);
+    static std::unique_ptr<ITextures> CreateFromSources(const TEXTURE_ARRAY_CREATE_DESC& _desc);
 
     const TEXTURE_DATA*         Get(size_t _mip_slice = 0)  const override;
     const TEXTURE_DESC&         GetDesc()                   const override;
     const TEXTURE_FILE_DESC&    GetFileDesc()               const override;
 
 private:
-    bool Init(const TEXTURE_CREATE_DESC& _desc)
+    // ヘッダの読み取りとデコードは共にメモリ上のファイルイメージから行われます。
+    bool Init(const TEXTURE_CREATE_DESC& _desc, const uint8_t* _file_data, size_t _file_size)
     {
-        if (!PrepareFileDesc(_desc))
+        if (!PrepareFileDesc(_desc, _file_data, _file_size))
             return false;
 
-        void* stbi_data{};
-        if (!LoadFromFile(_desc, &stbi_data))
-            return false;
+        {
+            DECODED_IMAGE image{};
+            if (!DecodeImage(_desc, _file_data, _file_size, &image))
+                return false;
+
+            if (!ConvertImage(_desc, &image))
+                return false;
+
+            PrepareDesc(_desc, TEXTURE_TYPE_2D, EXTENT3D{ image.width, image.height, 1 }, image);
+            SLICE_SOURCE slice{ static_cast<const uint8_t*>(image.data), image.GetRowPitch(), false };
+            if (!CreateData(_desc, 1, &slice, 1))
+                return false;
+        }
 
-        if (!CreateData(_desc, stbi_data))
+        if (!ConvertToHalf(_desc))
             return false;
 
-        stbi_image_free(stbi_data);
-        stbi_data = nullptr;
+        if (!CompressData(_desc))
+            return false;
 
         return true;
     }
-    bool PrepareFileDesc(const TEXTURE_CREATE_DESC& _desc);
-    bool LoadFromFile(const TEXTURE_CREATE_DESC& _desc, void** _stbi_data);
-    bool CreateData(const TEXTURE_CREATE_DESC& _desc, void* _stbi_data);
+    bool InitFromSources(const TEXTURE_ARRAY_CREATE_DESC& _desc);
+    bool PrepareFileDesc(const TEXTURE_CREATE_DESC& _desc, const uint8_t* _file_data, size_t _file_size);
+    void PrepareDesc(const TEXTURE_CREATE_DESC& _desc, TEXTURE_TYPE _type, const EXTENT3D& _extent, const DECODED_IMAGE& _image);
+    bool CreateData(const TEXTURE_CREATE_DESC& _desc, size_t _num_slices, const SLICE_SOURCE* _slices, size_t _num_threads);
+    bool ConvertToHalf(const TEXTURE_CREATE_DESC& _desc);
+    bool IsCompressible(const TEXTURE_CREATE_DESC& _desc) const;
+    bool CompressData(const TEXTURE_CREATE_DESC& _desc);
 
     void Term()
     {
@@ -154,8 +381,41 @@ std::unique_ptr<ITextures> Textures::Create(const TEXTURE_CREATE_DESC& _desc)
     if (!_desc.filename)
         return nullptr;
 
+    std::vector<uint8_t> file_data;
+    if (!ReadFile(_desc.filename, &file_data))
+        return nullptr;
+
+    return CreateFromMemory(file_data.data(), file_data.size(), _desc);
+}
+
+std::unique_ptr<ITextures> Textures::CreateFromMemory(const void* _data, size_t _size_in_bytes, const TEXTURE_CREATE_DESC& _desc)
+{
+    if (!_data || _size_in_bytes == 0)
+        return nullptr;
+
+    auto result = std::make_unique<Textures>();
+    if (!result->Init(_desc, static_cast<const uint8_t*>(_data), _size_in_bytes))
+        return nullptr;
+
+    return result;
+}
+
+std::unique_ptr<ITextures> Textures::CreateFromCallbacks(const TEXTURE_IO_CALLBACKS& _callbacks, void* _user, const TEXTURE_CREATE_DESC& _desc)
+{
+    std::vector<uint8_t> file_data;
+    if (!ReadCallbacks(_callbacks, _user, &file_data))
+        return nullptr;
+
+    return CreateFromMemory(file_data.data(), file_data.size(), _desc);
+}
+
+std::unique_ptr<ITextures> Textures::CreateFromSources(const TEXTURE_ARRAY_CREATE_DESC& _desc)
+{
+    if (!_desc.sources || _desc.num_sources == 0)
+        return nullptr;
+
     auto result = std::make_unique<Textures>();
-    if (!result->Init(_desc))
+    if (!result->InitFromSources(_desc))
         return nullptr;
 
     return result;
@@ -184,72 +444,159 @@ std::unique_ptr<ITextures> CreateTexturesFromFile(const TEXTURE_CREATE_DESC& _de
     return Textures::Create(_desc);
 }
 
-bool Textures::PrepareFileDesc(const TEXTURE_CREATE_DESC& _desc)
+std::unique_ptr<ITextures> CreateTexturesFromMemory(const void* _data, size_t _size_in_bytes, const TEXTURE_CREATE_DESC& _desc)
 {
-    file_desc.name = _desc.filename;
-    std::filesystem::path file_path(file_desc.name);
-    if (!std::filesystem::exists(file_path))
-        return false;
+    return Textures::CreateFromMemory(_data, _size_in_bytes, _desc);
+}
 
-         if (file_path.extension() == ".jpg")   file_desc.format = TEXTURE_FILE_FORMAT_JPG;
-    else if (file_path.extension() == ".jpeg")  file_desc.format = TEXTURE_FILE_FORMAT_JPG;
-    else if (file_path.extension() == ".png")   file_desc.format = TEXTURE_FILE_FORMAT_PNG;
-    else if (file_path.extension() == ".tga")   file_desc.format = TEXTURE_FILE_FORMAT_TGA;
-    else if (file_path.extension() == ".bmp")   file_desc.format = TEXTURE_FILE_FORMAT_BMP;
-    else if (file_path.extension() == ".hdr")   file_desc.format = TEXTURE_FILE_FORMAT_HDR;
-    else return false;
+std::unique_ptr<ITextures> CreateTexturesFromCallbacks(const TEXTURE_IO_CALLBACKS& _callbacks, void* _user, const TEXTURE_CREATE_DESC& _desc)
+{
+    return Textures::CreateFromCallbacks(_callbacks, _user, _desc);
+}
 
-    return true;
+std::unique_ptr<ITextures> CreateTexturesFromSources(const TEXTURE_ARRAY_CREATE_DESC& _desc)
+{
+    return Textures::CreateFromSources(_desc);
 }
-bool Textures::LoadFromFile(const TEXTURE_CREATE_DESC& _desc, void** _stbi_data)
+
+bool Textures::InitFromSources(const TEXTURE_ARRAY_CREATE_DESC& _desc)
 {
-    TEXTURE_FORMAT  format          {};
-    int             x               {};
-    int             y               {};
-    int             chs_in_file     {};
-    int             component_size  {};
-    int             req_comp        = STBI_default;
+    auto&& create_desc = _desc.texture_desc;
+    auto   num_sources = _desc.num_sources;
+    auto   use_layout  = _desc.type == TEXTURE_TYPE_CUBE && _desc.cube_layout != TEXTURE_CUBE_LAYOUT_FACES;
+    if (_desc.type == TEXTURE_TYPE_CUBE && !use_layout && num_sources % 6 != 0)
+        return false;
 
-    // load
+    // 読み込みとデコード
+    std::vector<std::vector<uint8_t>>   file_storages(num_sources);
+    std::vector<const uint8_t*>         file_data(num_sources);
+    std::vector<size_t>                 file_sizes(num_sources);
+    std::vector<DECODED_IMAGE>          images(num_sources);
+    std::atomic_bool                    has_failed{};
+    ParallelFor(_desc.num_threads, num_sources, [&](size_t _i)
     {
-        if (stbi_info(_desc.filename, &x, &y, &req_comp) == 0)
-            return false;
-
-        if (req_comp == STBI_rgb)
-            req_comp = STBI_rgb_alpha;
-
-        if (stbi_is_hdr(_desc.filename))
+        auto&& src = _desc.sources[_i];
+        file_data [_i] = static_cast<const uint8_t*>(src.data);
+        file_sizes[_i] = src.size_in_bytes;
+        if (!src.data)
         {
-            *_stbi_data     = stbi_loadf(_desc.filename, &x, &y, &chs_in_file, req_comp);
-            component_size  = sizeof(float);
-            format          = TEXTURE_FORMAT_SFLOAT;
-        }
-        else
-        {
-            *_stbi_data     = stbi_load(_desc.filename, &x, &y, &chs_in_file, req_comp);
-            component_size  = sizeof(stbi_uc);
-            format          = TEXTURE_FORMAT_UINT;
+            if (!src.filename || !ReadFile(src.filename, &file_storages[_i]))
+            {
+                has_failed = true;
+                return;
+            }
+            file_data [_i] = file_storages[_i].data();
+            file_sizes[_i] = file_storages[_i].size();
         }
 
-        if (!(*_stbi_data))
+        if (!DecodeImage(create_desc, file_data[_i], file_sizes[_i], &images[_i]) || !ConvertImage(create_desc, &images[_i]))
+            has_failed = true;
+    });
+    if (has_failed)
+        return false;
+
+    // 名前とファイル形式は最初のソースのものを使用します。
+    auto file_create_desc = create_desc;
+    file_create_desc.filename = _desc.sources[0].filename;
+    if (!PrepareFileDesc(file_create_desc, file_data[0], file_sizes[0]))
+        return false;
+
+    // 全てのソースは同じ解像度、フォーマットである必要があります。
+    auto&& first = images[0];
+    for (auto&& i : images)
+    {
+        if (i.width           != first.width           ||
+            i.height          != first.height          ||
+            i.format          != first.format          ||
+            i.component_count != first.component_count ||
+            i.component_size  != first.component_size)
             return false;
     }
 
-    // desc
+    auto texel_size = first.component_count * first.component_size;
+    EXTENT3D extent{ first.width, first.height, 1 };
+    std::vector<SLICE_SOURCE> slices;
+    if (use_layout)
+    {
+        size_t                      num_faces_x{};
+        size_t                      num_faces_y{};
+        const CUBE_FACE_PLACEMENT*  placements{};
+        if (!GetCubeLayoutPlacements(_desc.cube_layout, &num_faces_x, &num_faces_y, &placements))
+            return false;
+
+        if (first.width % num_faces_x != 0 || first.height % num_faces_y != 0)
+            return false;
+
+        extent.w = first.width  / num_faces_x;
+        extent.h = first.height / num_faces_y;
+        slices.reserve(num_sources * 6);
+        for (auto&& i : images)
+        {
+            auto row_pitch = i.GetRowPitch();
+            auto data      = static_cast<const uint8_t*>(i.data);
+            for (size_t face = 0; face < 6; face++)
+            {
+                auto&& p = placements[face];
+                slices.push_back({ data + (row_pitch * extent.h * p.y) + (texel_size * extent.w * p.x), row_pitch, p.rotate_180 });
+            }
+        }
+    }
+    else
     {
-        desc.width           = x;
-        desc.height          = y;
-        desc.depth           = 1;  // 現状1固定
-        desc.num_mips        = _desc.mip_count == 0 ? CalcMipLevels(desc.width, desc.height, desc.depth) : _desc.mip_count;
-        desc.format          = format;
-        desc.component_size  = component_size;
-        desc.component_count = static_cast<size_t>(req_comp == STBI_default ? chs_in_file : req_comp);
+        slices.reserve(num_sources);
+        for (auto&& i : images)
+            slices.push_back({ static_cast<const uint8_t*>(i.data), i.GetRowPitch(), false });
     }
 
+    if (_desc.type == TEXTURE_TYPE_CUBE && extent.w != extent.h)
+        return false;
+
+    extent.d = slices.size();
+    PrepareDesc(create_desc, _desc.type, extent, first);
+    if (!CreateData(create_desc, slices.size(), slices.data(), _desc.num_threads))
+        return false;
+
+    slices.clear();
+    images.clear();
+    file_storages.clear();
+
+    if (!ConvertToHalf(create_desc))
+        return false;
+
+    if (!CompressData(create_desc))
+        return false;
+
     return true;
 }
-bool Textures::CreateData(const TEXTURE_CREATE_DESC& _desc, void* _stbi_data)
+
+bool Textures::PrepareFileDesc(const TEXTURE_CREATE_DESC& _desc, const uint8_t* _file_data, size_t _file_size)
+{
+    if (_desc.filename)
+    {
+        file_desc.name = _desc.filename;
+        return GetFileFormatFromExtension(std::filesystem::path(file_desc.name), &file_desc.format);
+    }
+
+    file_desc.name.clear();
+    return GetFileFormatFromSignature(_file_data, _file_size, &file_desc.format);
+}
+void Textures::PrepareDesc(const TEXTURE_CREATE_DESC& _desc, TEXTURE_TYPE _type, const EXTENT3D& _extent, const DECODED_IMAGE& _image)
 {
+    desc.width           = _extent.w;
+    desc.height          = _extent.h;
+    desc.depth           = _extent.d;
+    desc.type            = _type;
+    desc.num_mips        = _desc.mip_count == 0 ? CalcMipLevels(desc.width, desc.height, _type == TEXTURE_TYPE_3D ? desc.depth : 1) : _desc.mip_count;
+    desc.format          = _image.format;
+    desc.component_size  = _image.component_size;
+    desc.component_count = _image.component_count;
+    desc.is_srgb         = (_desc.conversion_flags & TEXTURE_CONVERSION_FLAG_LINEAR_TO_SRGB) != 0;
+}
+bool Textures::CreateData(const TEXTURE_CREATE_DESC& _desc, size_t _num_slices, const SLICE_SOURCE* _slices, size_t _num_threads)
+{
+    if (_num_slices != desc.depth)
+        return false;
+
     raw_data     .resize(desc.num_mips);
     textures_data.resize(desc.num_mips);
     auto tds = textures_data.data();
@@ -277,33 +624,214 @@ bool Textures::CreateData(const TEXTURE_CREATE_DESC& _desc, void* _stbi_data)
         r.Allocate(l.slice_pitch * td.extent.d);
         td.total_size = r.size_in_bytes;
         td.data       = r.memory;
+    }
+
+    // 1つ前のミップの1スライスを縮小します。
+    auto Resize = [&](size_t _mip, const uint8_t* _src_slice, uint8_t* _dst_slice, size_t _dst_row_pitch)
+    {
+        auto&& prev_td = tds[_mip - 1];
+        auto&& td      = tds[_mip];
+        if (desc.format == TEXTURE_FORMAT_SFLOAT)
+            return stbir_resize_float(  reinterpret_cast<const float*>(_src_slice), static_cast<int>(prev_td.extent.w), static_cast<int>(prev_td.extent.h), static_cast<int>(prev_td.layout.row_pitch)
+                                      , reinterpret_cast<float*>(_dst_slice)      , static_cast<int>(td.extent.w)     , static_cast<int>(td.extent.h)     , static_cast<int>(_dst_row_pitch)
+                                      , static_cast<int>(desc.component_count)) != 0;
+        else
+            return stbir_resize_uint8(  _src_slice, static_cast<int>(prev_td.extent.w), static_cast<int>(prev_td.extent.h), static_cast<int>(prev_td.layout.row_pitch)
+                                      , _dst_slice, static_cast<int>(td.extent.w)     , static_cast<int>(td.extent.h)     , static_cast<int>(_dst_row_pitch)
+                                      , static_cast<int>(desc.component_count)) != 0;
+    };
 
-        if (i == 0)
+    std::atomic_bool has_failed{};
+    if (desc.type != TEXTURE_TYPE_3D)
+    {
+        // 配列要素毎のミップチェーンは独立しているため、スライス単位で並列に生成します。
+        ParallelFor(_num_threads, _num_slices, [&](size_t _z)
         {
+            CopySlice(_slices[_z], tds[0].extent, tds[0].layout.texel_size, tds[0].layout.row_pitch, rds[0].ui8 + (tds[0].layout.slice_pitch * _z));
+            for (size_t i = 1; i < desc.num_mips; i++)
+            {
+                if (!Resize(i, rds[i-1].ui8 + (tds[i-1].layout.slice_pitch * _z), rds[i].ui8 + (tds[i].layout.slice_pitch * _z), tds[i].layout.row_pitch))
+                {
+                    has_failed = true;
+                    return;
+                }
+            }
+        });
+        return !has_failed;
+    }
+
+    ParallelFor(_num_threads, _num_slices, [&](size_t _z)
+    {
+        CopySlice(_slices[_z], tds[0].extent, tds[0].layout.texel_size, tds[0].layout.row_pitch, rds[0].ui8 + (tds[0].layout.slice_pitch * _z));
+    });
+
+    // ボリュームの場合、各スライスは1つ前のミップの2スライスを縮小した平均です。
+    for (size_t i = 1; i < desc.num_mips && !has_failed; i++)
+    {
+        auto&& prev_td = tds[i-1];
+        auto&& td      = tds[i];
+        ParallelFor(_num_threads, td.extent.d, [&](size_t _z)
+        {
+            auto src0 = rds[i-1].ui8 + (prev_td.layout.slice_pitch * (_z * 2));
+            auto dst  = rds[i]  .ui8 + (td.layout.slice_pitch * _z);
+            if (!Resize(i, src0, dst, td.layout.row_pitch))
+            {
+                has_failed = true;
+                return;
+            }
+            if (_z * 2 + 1 >= prev_td.extent.d)
+                return;
+
+            auto row_size = td.layout.texel_size * td.extent.w;
+            std::vector<uint8_t> src1_resized(row_size * td.extent.h);
+            if (!Resize(i, src0 + prev_td.layout.slice_pitch, src1_resized.data(), row_size))
+            {
+                has_failed = true;
+                return;
+            }
+
+            auto num_components = desc.component_count * td.extent.w;
             for (size_t y = 0; y < td.extent.h; y++)
             {
-                memcpy(r.memory + (td.layout.row_pitch * y), (uint8_t*)(_stbi_data)+(row_pitch * y), row_pitch);
+                auto d = dst + (td.layout.row_pitch * y);
+                auto s = src1_resized.data() + (row_size * y);
+                if (desc.format == TEXTURE_FORMAT_SFLOAT)
+                {
+                    auto df = reinterpret_cast<float*>(d);
+                    auto sf = reinterpret_cast<const float*>(s);
+                    for (size_t c = 0; c < num_components; c++)
+                        df[c] = (df[c] + sf[c]) * 0.5f;
+                }
+                else
+                {
+                    for (size_t c = 0; c < num_components; c++)
+                        d[c] = static_cast<uint8_t>((d[c] + s[c] + 1) >> 1);
+                }
             }
-        }
-        else
+        });
+    }
+
+    return !has_failed;
+}
+bool Textures::ConvertToHalf(const TEXTURE_CREATE_DESC& _desc)
+{
+    if (!(_desc.conversion_flags & TEXTURE_CONVERSION_FLAG_FLOAT_TO_HALF))
+        return true;
+
+    if (desc.format != TEXTURE_FORMAT_SFLOAT || desc.component_size != sizeof(float))
+        return true;
+
+    constexpr size_t HALF_SIZE = sizeof(uint16_t);
+
+    std::vector<TEXTURE_DATA>   half_data(desc.num_mips);
+    std::vector<RawData>        half_raw_data(desc.num_mips);
+    for (size_t i = 0; i < desc.num_mips; i++)
+    {
+        auto&& src = textures_data[i];
+        auto&& td  = half_data[i];
+        td.extent = src.extent;
+
+        auto&& l = td.layout;
+        l.texel_size = desc.component_count * HALF_SIZE;
+
+        auto row_pitch = l.texel_size * td.extent.w;
+
+        l.row_pitch = row_pitch;
+        if (_desc.row_pitch_alignment != 0)
+            l.row_pitch = AlignUp(l.row_pitch, _desc.row_pitch_alignment);
+
+        l.slice_pitch = l.row_pitch * td.extent.h;
+        if (_desc.slice_pitch_alignment != 0)
+            l.slice_pitch = AlignUp(l.slice_pitch, _desc.slice_pitch_alignment);
+
+        auto&& r = half_raw_data[i];
+        r.Allocate(l.slice_pitch * td.extent.d);
+        td.total_size = r.size_in_bytes;
+        td.data       = r.memory;
+
+        auto num_components = desc.component_count * td.extent.w;
+        for (size_t z = 0; z < td.extent.d; z++)
         {
-            int result = 0;
-            auto&& prev_td = tds[i-1];
-            if (desc.format == TEXTURE_FORMAT_SFLOAT)
-                result = stbir_resize_float(  rds[i-1].flt, static_cast<int>(prev_td.extent.w), static_cast<int>(prev_td.extent.h), static_cast<int>(prev_td.layout.row_pitch)
-                                            , rds[i]  .flt, static_cast<int>(td.extent.w)     , static_cast<int>(td.extent.h)     , static_cast<int>(td.layout.row_pitch)
-                                            , static_cast<int>(desc.component_count));
-            else
-                result = stbir_resize_uint8(  rds[i-1].ui8, static_cast<int>(prev_td.extent.w), static_cast<int>(prev_td.extent.h), static_cast<int>(prev_td.layout.row_pitch)
-                                            , rds[i]  .ui8, static_cast<int>(td.extent.w)     , static_cast<int>(td.extent.h)     , static_cast<int>(td.layout.row_pitch)
-                                            , static_cast<int>(desc.component_count));
-
-            if (result == 0)
-                return false;
+            for (size_t y = 0; y < td.extent.h; y++)
+            {
+                auto s = static_cast<const uint8_t*>(src.data) + src.layout.slice_pitch * z + src.layout.row_pitch * y;
+                auto d = r.memory                             + l.slice_pitch           * z + l.row_pitch           * y;
+                ConvertFloatToHalf(reinterpret_cast<const float*>(s), reinterpret_cast<uint16_t*>(d), num_components);
+            }
         }
+    }
+
+    textures_data.swap(half_data);
+    raw_data     .swap(half_raw_data);
+    desc.component_size = HALF_SIZE;
+
+    return true;
+}
+bool Textures::IsCompressible(const TEXTURE_CREATE_DESC& _desc) const
+{
+    if (GetCompressedBlockSize(_desc.compression_format) == 0)
+        return false;
+
+    // BC6H等の浮動小数点フォーマットは未対応です。
+    if (desc.format != TEXTURE_FORMAT_UINT || desc.component_size != sizeof(uint8_t))
+        return false;
+
+    // ブロック圧縮フォーマットのリソースはミップ0の幅と高さが4の倍数である必要があります。
+    if (desc.width % BLOCK_EXTENT != 0 || desc.height % BLOCK_EXTENT != 0)
+        return false;
+
+    return true;
+}
+bool Textures::CompressData(const TEXTURE_CREATE_DESC& _desc)
+{
+    if (!IsCompressible(_desc))
+        return true;
+
+    auto block_size = GetCompressedBlockSize(_desc.compression_format);
+
+    std::vector<TEXTURE_DATA>           compressed_data(desc.num_mips);
+    std::vector<RawData>                compressed_raw_data(desc.num_mips);
+    std::vector<BLOCK_COMPRESSION_DESC> bc_descs(desc.num_mips);
+    for (size_t i = 0; i < desc.num_mips; i++)
+    {
+        auto&& src = textures_data[i];
+        auto&& td  = compressed_data[i];
+        td.extent = src.extent;
 
+        auto&& l = td.layout;
+        l.texel_size = block_size;
+
+        l.row_pitch = block_size * CalcNumBlocks(td.extent.w);
+        if (_desc.row_pitch_alignment != 0)
+            l.row_pitch = AlignUp(l.row_pitch, _desc.row_pitch_alignment);
+
+        l.slice_pitch = l.row_pitch * CalcNumBlocks(td.extent.h);
+        if (_desc.slice_pitch_alignment != 0)
+            l.slice_pitch = AlignUp(l.slice_pitch, _desc.slice_pitch_alignment);
+
+        auto&& r = compressed_raw_data[i];
+        r.Allocate(l.slice_pitch * td.extent.d);
+        td.total_size = r.size_in_bytes;
+        td.data       = r.memory;
+
+        auto&& bc = bc_descs[i];
+        bc.extent           = src.extent;
+        bc.component_count  = desc.component_count;
+        bc.src              = static_cast<const uint8_t*>(src.data);
+        bc.src_row_pitch    = src.layout.row_pitch;
+        bc.src_slice_pitch  = src.layout.slice_pitch;
+        bc.dst              = r.memory;
+        bc.dst_row_pitch    = l.row_pitch;
+        bc.dst_slice_pitch  = l.slice_pitch;
     }
 
+    if (!CompressBlocks(_desc.compression_format, _desc.compression_quality, _desc.num_compression_threads, bc_descs.size(), bc_descs.data()))
+        return false;
+
+    textures_data.swap(compressed_data);
+    raw_data     .swap(compressed_raw_data);
+    desc.compression_format = _desc.compression_format;
+
     return true;
 }
 
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Utils/NonCopyable.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace buma
+{
+namespace util
+{
+
+// 読み取り専用でファイル全体をメモリにマップします。
+class MappedFile : public NonCopyable
+{
+public:
+    ~MappedFile();
+
+    static std::unique_ptr<MappedFile> Open(const char* _filename);
+
+    const uint8_t*  GetData() const { return data; }
+    size_t          GetSize() const { return size; }
+
+private:
+    MappedFile();
+    bool Init(const char* _filename);
+    void Term();
+
+private:
+    const uint8_t*  data;
+    size_t          size;
+#ifdef _WIN32
+    void*           file_handle;
+    void*           mapping_handle;
+#else
+    int             fd;
+#endif // _WIN32
+
+};
+
+
+}// namespace util
+}// namespace buma
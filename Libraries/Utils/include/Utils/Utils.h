@@ -39,7 +39,7 @@ inline uint32_t SafeRelease(T*& _p)
 template<typename T>
 inline T* SafeAddRef(T*& _p)
 {
-    if (!_p) return;
+    if (!_p) return nullptr;
     _p->AddRef();
     return _p;
 }
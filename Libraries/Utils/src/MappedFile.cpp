@@ -0,0 +1,116 @@
+#include <Utils/MappedFile.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace buma
+{
+namespace util
+{
+
+MappedFile::MappedFile()
+    : data              {}
+    , size              {}
+#ifdef _WIN32
+    , file_handle       { INVALID_HANDLE_VALUE }
+    , mapping_handle    {}
+#else
+    , fd                { -1 }
+#endif // _WIN32
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Term();
+}
+
+std::unique_ptr<MappedFile> MappedFile::Open(const char* _filename)
+{
+    if (!_filename)
+        return nullptr;
+
+    std::unique_ptr<MappedFile> result(new MappedFile());
+    if (!result->Init(_filename))
+        return nullptr;
+
+    return result;
+}
+
+bool MappedFile::Init(const char* _filename)
+{
+#ifdef _WIN32
+    file_handle = CreateFileA(_filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0)
+        return false;
+
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_handle)
+        return false;
+
+    data = static_cast<const uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if (!data)
+        return false;
+
+    size = static_cast<size_t>(file_size.QuadPart);
+
+#else
+    fd = open(_filename, O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+        return false;
+
+    auto ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ptr == MAP_FAILED)
+        return false;
+
+    data = static_cast<const uint8_t*>(ptr);
+    size = static_cast<size_t>(st.st_size);
+
+#endif // _WIN32
+
+    return true;
+}
+
+void MappedFile::Term()
+{
+#ifdef _WIN32
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping_handle)
+        CloseHandle(mapping_handle);
+    if (file_handle != INVALID_HANDLE_VALUE)
+        CloseHandle(file_handle);
+    mapping_handle = nullptr;
+    file_handle    = INVALID_HANDLE_VALUE;
+
+#else
+    if (data)
+        munmap(const_cast<uint8_t*>(data), size);
+    if (fd != -1)
+        close(fd);
+    fd = -1;
+
+#endif // _WIN32
+
+    data = nullptr;
+    size = 0;
+}
+
+
+}// namespace util
+}// namespace buma
@@ -4,22 +4,113 @@
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 #else
-#error TODO: Support non-Windows enviroment
+#include <cstring>
+#include <cwchar>
 #endif // _WIN32
 
+#include <climits>
+
 
 namespace buma
 {
 namespace util
 {
 
+#ifndef _WIN32
+namespace /*anonymous*/
+{
+
+// Windows以外では、コードページに関わらずマルチバイト文字列をUTF-8、ワイド文字列をUTF-32として扱います。
+constexpr wchar_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+std::string EncodeUtf8(const wchar_t* _wstr, size_t _len)
+{
+    std::string str;
+    str.reserve(_len);
+    for (size_t i = 0; i < _len; i++)
+    {
+        auto c = static_cast<uint32_t>(_wstr[i]);
+        if (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+            c = REPLACEMENT_CHARACTER;
+
+        if (c < 0x80)
+        {
+            str += static_cast<char>(c);
+        }
+        else if (c < 0x800)
+        {
+            str += static_cast<char>(0xC0 | (c >> 6));
+            str += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000)
+        {
+            str += static_cast<char>(0xE0 | (c >> 12));
+            str += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            str += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else
+        {
+            str += static_cast<char>(0xF0 | (c >> 18));
+            str += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            str += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            str += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    return str;
+}
+
+std::wstring DecodeUtf8(const char* _str, size_t _len)
+{
+    std::wstring str;
+    str.reserve(_len);
+    for (size_t i = 0; i < _len;)
+    {
+        auto c = static_cast<uint8_t>(_str[i]);
+        size_t num_trail = c < 0x80 ? 0 : (c & 0xE0) == 0xC0 ? 1 : (c & 0xF0) == 0xE0 ? 2 : (c & 0xF8) == 0xF0 ? 3 : SIZE_MAX;
+        if (num_trail == SIZE_MAX || i + num_trail >= _len)
+        {
+            str += REPLACEMENT_CHARACTER;
+            i++;
+            continue;
+        }
+
+        uint32_t code_point = c & (0x7F >> num_trail);
+        bool is_valid = true;
+        for (size_t j = 1; j <= num_trail && is_valid; j++)
+        {
+            auto trail = static_cast<uint8_t>(_str[i + j]);
+            is_valid = (trail & 0xC0) == 0x80;
+            code_point = (code_point << 6) | (trail & 0x3F);
+        }
+        if (!is_valid)
+        {
+            str += REPLACEMENT_CHARACTER;
+            i++;
+            continue;
+        }
+
+        str += static_cast<wchar_t>(code_point);
+        i += num_trail + 1;
+    }
+    return str;
+}
+
+// Windows APIと同様に、-1の場合はnull終端までの長さを使用します。 返される長さはnull終端文字を含みません。
+template <typename T, typename FuncLength>
+size_t GetLengthWithoutNullTerm(int _len_with_null_term, const T* _str, FuncLength _length)
+{
+    if (_len_with_null_term < 0)
+        return _length(_str);
+    return _len_with_null_term == 0 ? 0 : static_cast<size_t>(_len_with_null_term - 1);
+}
+
+}// namespace /*anonymous*/
+#endif // !_WIN32
+
 std::string ConvertWideToCp(CODEPAGE _code_page, int _len_with_null_term, const wchar_t* _wstr)
 {
 #ifdef _WIN32
     auto l = WideCharToMultiByte(_code_page, 0, _wstr, _len_with_null_term, nullptr, 0, nullptr, FALSE);
-#else
-
-#endif // _WIN32
     if (l == 0)
         return std::string();
 
@@ -28,15 +119,16 @@ std::string ConvertWideToCp(CODEPAGE _code_page, int _len_with_null_term, const
         return std::string();
 
     return str;
+#else
+    (void)_code_page;
+    return EncodeUtf8(_wstr, GetLengthWithoutNullTerm(_len_with_null_term, _wstr, std::wcslen));
+#endif // _WIN32
 }
 
 std::wstring ConvertCpToWide(CODEPAGE _code_page, int _len_with_null_term, const char* _str)
 {
 #ifdef _WIN32
     auto l = MultiByteToWideChar(_code_page, 0, _str, _len_with_null_term, nullptr, 0);
-#else
-
-#endif // _WIN32
     if (l == 0)
         return std::wstring();
 
@@ -45,6 +137,10 @@ std::wstring ConvertCpToWide(CODEPAGE _code_page, int _len_with_null_term, const
         return std::wstring();
 
     return str;
+#else
+    (void)_code_page;
+    return DecodeUtf8(_str, GetLengthWithoutNullTerm(_len_with_null_term, _str, std::strlen));
+#endif // _WIN32
 }
 
 
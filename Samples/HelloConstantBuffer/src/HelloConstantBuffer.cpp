@@ -9,6 +9,7 @@
 
 #include <DeviceResources/DeviceResources.h>
 #include <DeviceResources/CommandQueue.h>
+#include <DeviceResources/PipelineStateCache.h>
 #include <DeviceResources/SwapChain.h>
 #include <DeviceResources/CopyContext.h>
 
@@ -336,9 +337,9 @@ bool HelloConstantBuffer::CreatePipeline()
     pso_desc.BlendState().Reset().SetNumAttachmemns(1).Finalize();
     pso_desc.Finalize();
 
-    auto bmr = device->CreateGraphicsPipelineState(pso_desc.GetAsGraphics(), &pipeline);
-    BMR_RET_IF_FAILED(bmr);
-    pipeline->SetName("HelloConstantBuffer::pipeline");
+    pipeline = dr->GetPipelineStateCache()->GetOrCreate(pso_desc, "HelloConstantBuffer::pipeline");
+    if (!pipeline)
+        return false;
 
     return true;
 }
@@ -515,10 +516,8 @@ bool HelloConstantBuffer::CreateConstantBufferView()
 }
 bool HelloConstantBuffer::CreateShaderModules()
 {
-    shader_modules["VS"].Attach(CreateShaderModule("HelloConstantBuffer/shader/VertexShader.hlsl", buma3d::SHADER_STAGE_FLAG_VERTEX, "main"));
-    shader_modules["PS"].Attach(CreateShaderModule("HelloConstantBuffer/shader/PixelShader.hlsl", buma3d::SHADER_STAGE_FLAG_PIXEL, "main"));
-
-    return true;
+    return CompileShaderModules({ { "VS", "HelloConstantBuffer/shader/VertexShader.hlsl", buma3d::SHADER_STAGE_FLAG_VERTEX, "main" }
+                               , { "PS", "HelloConstantBuffer/shader/PixelShader.hlsl" , buma3d::SHADER_STAGE_FLAG_PIXEL , "main" } });
 }
 bool HelloConstantBuffer::CreateBuffers()
 {
@@ -607,6 +606,13 @@ void HelloConstantBuffer::Update(float _deltatime)
     if (window->GetWindowState() == WINDOW_STATE_MINIMIZE)
         return std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
+    // 再コンパイルされたシェーダでパイプラインが作成し直された場合、コマンドを記録し直します。
+    if (ProcessShaderHotReload())
+    {
+        for (uint32_t i = 0; i < buffer_count; i++)
+            PrepareFrame(i, 0.f);
+    }
+
     // 次のバックバッファを取得
     MoveToNextFrame();
     
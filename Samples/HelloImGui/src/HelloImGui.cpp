@@ -13,6 +13,7 @@
 
 #include <DeviceResources/DeviceResources.h>
 #include <DeviceResources/CommandQueue.h>
+#include <DeviceResources/PipelineStateCache.h>
 #include <DeviceResources/ResourceBuffer.h>
 #include <DeviceResources/ResourceTexture.h>
 #include <DeviceResources/SwapChain.h>
@@ -64,16 +65,28 @@ namespace buma::tex
 {
 buma3d::RESOURCE_FORMAT GetDefaultFormat(const tex::TEXTURE_DESC& _tex_desc)
 {
-    static const buma3d::RESOURCE_FORMAT FORMAT_TABLE[3][4] = {
+    switch (_tex_desc.compression_format)
+    {
+    case TEXTURE_COMPRESSION_FORMAT_BC1 : return _tex_desc.is_srgb ? buma3d::RESOURCE_FORMAT_BC1_UNORM_SRGB : buma3d::RESOURCE_FORMAT_BC1_UNORM;
+    case TEXTURE_COMPRESSION_FORMAT_BC3 : return _tex_desc.is_srgb ? buma3d::RESOURCE_FORMAT_BC3_UNORM_SRGB : buma3d::RESOURCE_FORMAT_BC3_UNORM;
+    case TEXTURE_COMPRESSION_FORMAT_BC4 : return buma3d::RESOURCE_FORMAT_BC4_UNORM;
+    case TEXTURE_COMPRESSION_FORMAT_BC5 : return buma3d::RESOURCE_FORMAT_BC5_UNORM;
+    case TEXTURE_COMPRESSION_FORMAT_BC7 : return _tex_desc.is_srgb ? buma3d::RESOURCE_FORMAT_BC7_UNORM_SRGB : buma3d::RESOURCE_FORMAT_BC7_UNORM;
+    default:
+        break;
+    }
+
+    static const buma3d::RESOURCE_FORMAT FORMAT_TABLE[4][4] = {
         { buma3d::RESOURCE_FORMAT_R8_SNORM  , buma3d::RESOURCE_FORMAT_R8G8_SNORM    , buma3d::RESOURCE_FORMAT_R8G8B8A8_SNORM     , buma3d::RESOURCE_FORMAT_R8G8B8A8_SNORM },
         { buma3d::RESOURCE_FORMAT_R8_UNORM  , buma3d::RESOURCE_FORMAT_R8G8_UNORM    , buma3d::RESOURCE_FORMAT_R8G8B8A8_UNORM     , buma3d::RESOURCE_FORMAT_R8G8B8A8_UNORM },
-        { buma3d::RESOURCE_FORMAT_R16_FLOAT , buma3d::RESOURCE_FORMAT_R16G16_FLOAT  , buma3d::RESOURCE_FORMAT_R16G16B16A16_FLOAT , buma3d::RESOURCE_FORMAT_R16G16B16A16_FLOAT }, };
+        { buma3d::RESOURCE_FORMAT_R16_FLOAT , buma3d::RESOURCE_FORMAT_R16G16_FLOAT  , buma3d::RESOURCE_FORMAT_R16G16B16A16_FLOAT , buma3d::RESOURCE_FORMAT_R16G16B16A16_FLOAT },
+        { buma3d::RESOURCE_FORMAT_R32_FLOAT , buma3d::RESOURCE_FORMAT_R32G32_FLOAT  , buma3d::RESOURCE_FORMAT_R32G32B32_FLOAT    , buma3d::RESOURCE_FORMAT_R32G32B32A32_FLOAT }, };
 
     switch (_tex_desc.format)
     {
     case TEXTURE_FORMAT_SINT   : return FORMAT_TABLE[0][_tex_desc.component_count-1];
-    case TEXTURE_FORMAT_UINT   : return FORMAT_TABLE[1][_tex_desc.component_count-1];
-    case TEXTURE_FORMAT_SFLOAT : return FORMAT_TABLE[2][_tex_desc.component_count-1];
+    case TEXTURE_FORMAT_UINT   : return _tex_desc.is_srgb && _tex_desc.component_count == 4 ? buma3d::RESOURCE_FORMAT_R8G8B8A8_UNORM_SRGB : FORMAT_TABLE[1][_tex_desc.component_count-1];
+    case TEXTURE_FORMAT_SFLOAT : return FORMAT_TABLE[_tex_desc.component_size == sizeof(float) ? 3 : 2][_tex_desc.component_count-1];
 
     default:
         return buma3d::RESOURCE_FORMAT_UNKNOWN;
@@ -387,7 +400,14 @@ bool HelloImGui::LoadTextureData()
     texdesc.mip_count   = 0;
     texdesc.row_pitch_alignment   = dr->GetDeviceAdapterLimits().buffer_copy_row_pitch_alignment;
     texdesc.slice_pitch_alignment = dr->GetDeviceAdapterLimits().buffer_copy_offset_alignment;
-    texture.data = tex::CreateTexturesFromFile(texdesc);
+
+    std::vector<uint8_t> packed_storage;
+    const void*          packed_data{};
+    size_t               packed_size{};
+    if (GetPackedAsset("Assets/texture/UV_Grid_Sm.jpg", &packed_storage, &packed_data, &packed_size))
+        texture.data = tex::CreateTexturesFromMemory(packed_data, packed_size, texdesc);
+    else
+        texture.data = tex::CreateTexturesFromFile(texdesc);
     RET_IF_FAILED(texture.data);
 
     return true;
@@ -451,10 +471,8 @@ bool HelloImGui::CreatePipelineLayout()
 }
 bool HelloImGui::CreateShaderModules()
 {
-    shader_modules["VS"].Attach(CreateShaderModule("HelloImGui/shader/VertexShader.hlsl", buma3d::SHADER_STAGE_FLAG_VERTEX, "main"));
-    shader_modules["PS"].Attach(CreateShaderModule("HelloImGui/shader/PixelShader.hlsl", buma3d::SHADER_STAGE_FLAG_PIXEL, "main"));
-
-    return true;
+    return CompileShaderModules({ { "VS", "HelloImGui/shader/VertexShader.hlsl", buma3d::SHADER_STAGE_FLAG_VERTEX, "main" }
+                               , { "PS", "HelloImGui/shader/PixelShader.hlsl" , buma3d::SHADER_STAGE_FLAG_PIXEL , "main" } });
 }
 bool HelloImGui::CreatePipeline()
 {
@@ -488,9 +506,9 @@ bool HelloImGui::CreatePipeline()
     pso_desc.BlendState().Reset().SetNumAttachmemns(1).Finalize();
     pso_desc.Finalize();
 
-    auto bmr = device->CreateGraphicsPipelineState(pso_desc.GetAsGraphics(), &pipeline);
-    BMR_RET_IF_FAILED(bmr);
-    pipeline->SetName("HelloImGui::pipeline");
+    pipeline = dr->GetPipelineStateCache()->GetOrCreate(pso_desc, "HelloImGui::pipeline");
+    if (!pipeline)
+        return false;
 
     return true;
 }
@@ -644,8 +662,9 @@ bool HelloImGui::CopyDataToTexture()
     for (size_t i = 0; i < data_desc.num_mips; i++)
     {
         auto&& tex_data = texture.data->Get(i);
-        ctx.CopyDataToTexture(texture.texture->GetB3DTexture().Get(), (uint32_t)i, 0
+        ctx.CopyDataToTexture(texture.texture->GetB3DTexture().Get(), (uint32_t)i, 0, (uint32_t)tex_data->extent.d
                                    , tex_data->layout.row_pitch
+                                   , tex_data->layout.slice_pitch
                                    , tex_data->extent.h
                                    , tex_data->total_size, tex_data->data);
     }
@@ -753,6 +772,17 @@ bool HelloImGui::InitMyImGui()
 
     gui_cd.config_flags           = ImGuiConfigFlags_DockingEnable | ImGuiConfigFlags_ViewportsEnable | ImGuiConfigFlags_NavEnableKeyboard | ImGuiConfigFlags_NavEnableSetMousePos;
     gui_cd.framebuffer_format     = swapchain->GetBuffers()[0].tex->GetDesc().texture.format_desc.format;
+
+    // フォントはマップされたデータを直接参照するため、圧縮されていない場合のみパックから読み込みます。
+    if (asset_pack)
+    {
+        auto font_entry = asset_pack->Find("Assets/font/NotoSansJP-Regular.otf");
+        if (auto font_data = asset_pack->GetMappedData(font_entry))
+        {
+            gui_cd.font_data      = font_data;
+            gui_cd.font_data_size = (size_t)font_entry->original_size;
+        }
+    }
     auto result = myimgui->Init(gui_cd);
     RET_IF_FAILED(result);
 
@@ -776,6 +806,13 @@ void HelloImGui::Update(float _deltatime)
     if (window->GetWindowState() == WINDOW_STATE_MINIMIZE)
         return std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
+    // 再コンパイルされたシェーダでパイプラインが作成し直された場合、コマンドを記録し直します。
+    if (ProcessShaderHotReload())
+    {
+        for (uint32_t i = 0; i < buffer_count; i++)
+            PrepareFrame(i, 0.f);
+    }
+
     // 次のバックバッファを取得
     MoveToNextFrame();
 
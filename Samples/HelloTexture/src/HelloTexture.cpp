@@ -11,6 +11,7 @@
 
 #include <DeviceResources/DeviceResources.h>
 #include <DeviceResources/CommandQueue.h>
+#include <DeviceResources/PipelineStateCache.h>
 #include <DeviceResources/ResourceBuffer.h>
 #include <DeviceResources/ResourceTexture.h>
 #include <DeviceResources/SwapChain.h>
@@ -62,16 +63,28 @@ namespace buma::tex
 {
 buma3d::RESOURCE_FORMAT GetDefaultFormat(const tex::TEXTURE_DESC& _tex_desc)
 {
-    static const buma3d::RESOURCE_FORMAT FORMAT_TABLE[3][4] = {
+    switch (_tex_desc.compression_format)
+    {
+    case TEXTURE_COMPRESSION_FORMAT_BC1 : return _tex_desc.is_srgb ? buma3d::RESOURCE_FORMAT_BC1_UNORM_SRGB : buma3d::RESOURCE_FORMAT_BC1_UNORM;
+    case TEXTURE_COMPRESSION_FORMAT_BC3 : return _tex_desc.is_srgb ? buma3d::RESOURCE_FORMAT_BC3_UNORM_SRGB : buma3d::RESOURCE_FORMAT_BC3_UNORM;
+    case TEXTURE_COMPRESSION_FORMAT_BC4 : return buma3d::RESOURCE_FORMAT_BC4_UNORM;
+    case TEXTURE_COMPRESSION_FORMAT_BC5 : return buma3d::RESOURCE_FORMAT_BC5_UNORM;
+    case TEXTURE_COMPRESSION_FORMAT_BC7 : return _tex_desc.is_srgb ? buma3d::RESOURCE_FORMAT_BC7_UNORM_SRGB : buma3d::RESOURCE_FORMAT_BC7_UNORM;
+    default:
+        break;
+    }
+
+    static const buma3d::RESOURCE_FORMAT FORMAT_TABLE[4][4] = {
         { buma3d::RESOURCE_FORMAT_R8_SNORM  , buma3d::RESOURCE_FORMAT_R8G8_SNORM    , buma3d::RESOURCE_FORMAT_R8G8B8A8_SNORM     , buma3d::RESOURCE_FORMAT_R8G8B8A8_SNORM },
         { buma3d::RESOURCE_FORMAT_R8_UNORM  , buma3d::RESOURCE_FORMAT_R8G8_UNORM    , buma3d::RESOURCE_FORMAT_R8G8B8A8_UNORM     , buma3d::RESOURCE_FORMAT_R8G8B8A8_UNORM },
-        { buma3d::RESOURCE_FORMAT_R16_FLOAT , buma3d::RESOURCE_FORMAT_R16G16_FLOAT  , buma3d::RESOURCE_FORMAT_R16G16B16A16_FLOAT , buma3d::RESOURCE_FORMAT_R16G16B16A16_FLOAT }, };
+        { buma3d::RESOURCE_FORMAT_R16_FLOAT , buma3d::RESOURCE_FORMAT_R16G16_FLOAT  , buma3d::RESOURCE_FORMAT_R16G16B16A16_FLOAT , buma3d::RESOURCE_FORMAT_R16G16B16A16_FLOAT },
+        { buma3d::RESOURCE_FORMAT_R32_FLOAT , buma3d::RESOURCE_FORMAT_R32G32_FLOAT  , buma3d::RESOURCE_FORMAT_R32G32B32_FLOAT    , buma3d::RESOURCE_FORMAT_R32G32B32A32_FLOAT }, };
 
     switch (_tex_desc.format)
     {
     case TEXTURE_FORMAT_SINT   : return FORMAT_TABLE[0][_tex_desc.component_count-1];
-    case TEXTURE_FORMAT_UINT   : return FORMAT_TABLE[1][_tex_desc.component_count-1];
-    case TEXTURE_FORMAT_SFLOAT : return FORMAT_TABLE[2][_tex_desc.component_count-1];
+    case TEXTURE_FORMAT_UINT   : return _tex_desc.is_srgb && _tex_desc.component_count == 4 ? buma3d::RESOURCE_FORMAT_R8G8B8A8_UNORM_SRGB : FORMAT_TABLE[1][_tex_desc.component_count-1];
+    case TEXTURE_FORMAT_SFLOAT : return FORMAT_TABLE[_tex_desc.component_size == sizeof(float) ? 3 : 2][_tex_desc.component_count-1];
 
     default:
         return buma3d::RESOURCE_FORMAT_UNKNOWN;
@@ -101,6 +114,8 @@ HelloTexture::HelloTexture(PlatformBase& _platform)
 R"(========== HelloTexture Options ==========
 --use-host-writable
     ホスト可視ヒープに定数を書き込みます。
+--use-block-compression
+    テクスチャをBC7形式に圧縮してアップロードします。
 
 )");
 }
@@ -351,7 +366,16 @@ bool HelloTexture::LoadTextureData()
     texdesc.mip_count   = 0;
     texdesc.row_pitch_alignment   = dr->GetDeviceAdapterLimits().buffer_copy_row_pitch_alignment;
     texdesc.slice_pitch_alignment = dr->GetDeviceAdapterLimits().buffer_copy_offset_alignment;
-    texture.data = tex::CreateTexturesFromFile(texdesc);
+    if (platform.HasArgument("--use-block-compression"))
+        texdesc.compression_format = tex::TEXTURE_COMPRESSION_FORMAT_BC7;
+
+    std::vector<uint8_t> packed_storage;
+    const void*          packed_data{};
+    size_t               packed_size{};
+    if (GetPackedAsset("Assets/texture/UV_Grid_Sm.jpg", &packed_storage, &packed_data, &packed_size))
+        texture.data = tex::CreateTexturesFromMemory(packed_data, packed_size, texdesc);
+    else
+        texture.data = tex::CreateTexturesFromFile(texdesc);
     RET_IF_FAILED(texture.data);
 
     return true;
@@ -401,10 +425,8 @@ bool HelloTexture::CreatePipelineLayout()
 }
 bool HelloTexture::CreateShaderModules()
 {
-    shader_modules["VS"].Attach(CreateShaderModule("HelloTexture/shader/VertexShader.hlsl", buma3d::SHADER_STAGE_FLAG_VERTEX, "main"));
-    shader_modules["PS"].Attach(CreateShaderModule("HelloTexture/shader/PixelShader.hlsl", buma3d::SHADER_STAGE_FLAG_PIXEL, "main"));
-
-    return true;
+    return CompileShaderModules({ { "VS", "HelloTexture/shader/VertexShader.hlsl", buma3d::SHADER_STAGE_FLAG_VERTEX, "main" }
+                               , { "PS", "HelloTexture/shader/PixelShader.hlsl" , buma3d::SHADER_STAGE_FLAG_PIXEL , "main" } });
 }
 bool HelloTexture::CreatePipeline()
 {
@@ -438,9 +460,10 @@ bool HelloTexture::CreatePipeline()
     pso_desc.BlendState().Reset().SetNumAttachmemns(1).Finalize();
     pso_desc.Finalize();
 
-    auto bmr = device->CreateGraphicsPipelineState(pso_desc.GetAsGraphics(), &pipeline);
-    BMR_RET_IF_FAILED(bmr);
-    pipeline->SetName("HelloTexture::pipeline");
+    // 同じ記述のパイプライン(シェーダのホットリロードで内容が変化しなかった場合等)はキャッシュから再利用されます。
+    pipeline = dr->GetPipelineStateCache()->GetOrCreate(pso_desc, "HelloTexture::pipeline");
+    if (!pipeline)
+        return false;
 
     return true;
 }
@@ -613,8 +636,9 @@ bool HelloTexture::CopyDataToTexture()
     for (size_t i = 0; i < data_desc.num_mips; i++)
     {
         auto&& tex_data = texture.data->Get(i);
-        ctx.CopyDataToTexture(texture.texture->GetB3DTexture().Get(), (uint32_t)i, 0
+        ctx.CopyDataToTexture(texture.texture->GetB3DTexture().Get(), (uint32_t)i, 0, (uint32_t)tex_data->extent.d
                                    , tex_data->layout.row_pitch
+                                   , tex_data->layout.slice_pitch
                                    , tex_data->extent.h
                                    , tex_data->total_size, tex_data->data);
     }
@@ -739,6 +763,13 @@ void HelloTexture::Update(float _deltatime)
     if (window->GetWindowState() == WINDOW_STATE_MINIMIZE)
         return std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
+    // 再コンパイルされたシェーダでパイプラインが作成し直された場合、コマンドを記録し直します。
+    if (ProcessShaderHotReload())
+    {
+        for (uint32_t i = 0; i < buffer_count; i++)
+            PrepareFrame(i, 0.f);
+    }
+
     // 次のバックバッファを取得
     MoveToNextFrame();
     
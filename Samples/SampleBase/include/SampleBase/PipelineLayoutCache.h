@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Buma3D/Buma3D.h>
+#include <Buma3D/Util/Buma3DPtr.h>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace buma
+{
+
+namespace shader
+{
+class ShaderReflectionData;
+}
+
+struct PIPELINE_LAYOUT_SHADER_DESC
+{
+    buma3d::SHADER_STAGE_FLAG           stage;
+    const shader::ShaderReflectionData* reflection;
+};
+
+struct REFLECTED_PIPELINE_LAYOUT
+{
+    std::vector<buma3d::util::Ptr<buma3d::IDescriptorSetLayout>>    set_layouts;        // インデックスはシェーダの register space に対応します。
+    buma3d::util::Ptr<buma3d::IPipelineLayout>                      pipeline_layout;
+};
+
+// パイプラインの全ステージのリフレクションからディスクリプタセットレイアウトとパイプラインレイアウトを作成します。
+// 同じ register space 、同じレジスタのバインディングはステージ間で1つに統合され、異なるステージから参照される場合は SHADER_VISIBILITY_ALL_GRAPHICS_COMPUTE になります。
+// 作成したレイアウトはバインディングの内容をキーとしてキャッシュされ、同一のレイアウトを持つパイプライン間で同じオブジェクトが共有されます。
+class PipelineLayoutCache
+{
+public:
+    PipelineLayoutCache(buma3d::IDevice* _device);
+    ~PipelineLayoutCache();
+
+    // バインディングが競合する(同じレジスタで型が異なる)場合、またはサポートされないバインディングが含まれる場合falseを返します。
+    bool GetOrCreate(const PIPELINE_LAYOUT_SHADER_DESC* _shaders, uint32_t _num_shaders, REFLECTED_PIPELINE_LAYOUT* _result);
+
+    size_t GetNumSetLayouts()       const;
+    size_t GetNumPipelineLayouts()  const;
+
+    // キャッシュが保持する参照を解放します。 作成済みのレイアウトは呼び出し元の参照が残る限り有効です。
+    void Clear();
+
+private:
+    struct BINDING
+    {
+        buma3d::DESCRIPTOR_TYPE     descriptor_type;
+        uint32_t                    base_shader_register;
+        uint32_t                    num_descriptors;
+        buma3d::SHADER_VISIBILITY   shader_visibility;
+
+        bool operator==(const BINDING& _b) const;
+    };
+    struct SET_LAYOUT_KEY
+    {
+        std::vector<BINDING> bindings; // base_shader_register、descriptor_type の順にソートされます。
+
+        bool operator==(const SET_LAYOUT_KEY& _k) const { return bindings == _k.bindings; }
+    };
+    struct PIPELINE_LAYOUT_KEY
+    {
+        std::vector<buma3d::IDescriptorSetLayout*> set_layouts; // キャッシュ済みのセットレイアウトは内容ごとに一意のため、ポインタで比較します。
+
+        bool operator==(const PIPELINE_LAYOUT_KEY& _k) const { return set_layouts == _k.set_layouts; }
+    };
+    struct SET_LAYOUT_KEY_HASH      { size_t operator()(const SET_LAYOUT_KEY& _key)      const; };
+    struct PIPELINE_LAYOUT_KEY_HASH { size_t operator()(const PIPELINE_LAYOUT_KEY& _key) const; };
+
+    bool MergeBindings(const PIPELINE_LAYOUT_SHADER_DESC* _shaders, uint32_t _num_shaders, std::vector<SET_LAYOUT_KEY>* _sets) const;
+    buma3d::IDescriptorSetLayout*   GetOrCreateSetLayout(const SET_LAYOUT_KEY& _key);
+    buma3d::IPipelineLayout*        GetOrCreatePipelineLayout(const PIPELINE_LAYOUT_KEY& _key);
+
+private:
+    buma3d::util::Ptr<buma3d::IDevice>                                                                          device;
+    mutable std::mutex                                                                                          mutex;
+    std::unordered_map<SET_LAYOUT_KEY, buma3d::util::Ptr<buma3d::IDescriptorSetLayout>, SET_LAYOUT_KEY_HASH>    set_layouts;
+    std::unordered_map<PIPELINE_LAYOUT_KEY, buma3d::util::Ptr<buma3d::IPipelineLayout>, PIPELINE_LAYOUT_KEY_HASH> pipeline_layouts;
+
+};
+
+
+} // namespace buma
@@ -3,12 +3,23 @@
 #include <AppFramework/Application.h>
 
 #include <DeviceResources/DeviceResources.h>
+#include <DeviceResources/AsyncPipelineCompiler.h>
+
+#include <SampleBase/PipelineLayoutCache.h>
+
+#include <PackFile/PackFile.h>
+
+#include <ShaderTools/ShaderCache.h>
+#include <ShaderTools/ShaderVariants.h>
+#include <ShaderTools/ShaderHotReloader.h>
 
 #include <Buma3DHelpers/B3DDescHelpers.h>
 
 #include <vector>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <string>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -301,6 +312,19 @@ public:
 namespace buma
 {
 
+namespace shader
+{
+struct LOAD_SHADER_DESC;
+}
+
+struct SHADER_MODULE_SOURCE
+{
+    const char*                 name;           // shader_modules のキー
+    const char*                 path;
+    buma3d::SHADER_STAGE_FLAG   stage;
+    const char*                 entry_point;
+};
+
 class SampleBase : public ApplicationBase
 {
 public:
@@ -308,6 +332,7 @@ public:
     virtual ~SampleBase();
 
 protected:
+    bool PrepareSettings() override;
     virtual bool CreateWindow(uint32_t _w, uint32_t _h, const char* _title = "SampleBase");
     virtual bool CreateDeviceResources(const char* _library_dir = nullptr);
     virtual bool CreateSwapChain(const buma3d::SWAP_CHAIN_BUFFER_DESC& _buffer_desc, buma3d::SWAP_CHAIN_FLAGS _flags);
@@ -329,12 +354,59 @@ protected:
 
     buma3d::IShaderModule* CreateShaderModule(const char* _path, buma3d::SHADER_STAGE_FLAG _stage, const char* _entry_point = "main");
 
+    // 全てのシェーダをワーカースレッドで並列にコンパイルし、shader_modules[name] に格納します。
+    bool CompileShaderModules(const std::vector<SHADER_MODULE_SOURCE>& _sources);
+
+    // パイプラインの全ステージのシェーダのリフレクションから set_layouts と pipeline_layout を作成します。 set_layouts のインデックスは register space に対応します。
+    // 同一のレイアウトは layout_cache により複数のパイプライン間で共有されます。 CreateDescriptorSetLayouts() 、 CreatePipelineLayout() の代わりに使用できます。
+    // リフレクションはDXILからのみ取得できるため、 Vulkan の場合もDXILへコンパイルします(shader_cache によりキャッシュされます)。
+    bool CreateLayoutsFromReflection(const std::vector<SHADER_MODULE_SOURCE>& _sources);
+
+    // キーワードを持つシェーダのバリアントを作成します。 _fallback_key のバリアントのみ同期的にコンパイルされ、
+    // 他のバリアントは ShaderVariants::GetVariant() で最初に要求された時点でバックグラウンドでコンパイルされます。
+    // 返されたバイトコードからのシェーダモジュールの作成には CreateShaderModuleFromBytecode を使用します。
+    std::unique_ptr<shader::ShaderVariants> CreateShaderVariants(const SHADER_MODULE_SOURCE& _source, const std::vector<shader::SHADER_KEYWORD_DESC>& _keywords, shader::SHADER_VARIANT_KEY _fallback_key = 0);
+    buma3d::IShaderModule* CreateShaderModuleFromBytecode(const char* _path, const std::vector<uint8_t>& _bytecode);
+    buma3d::IShaderModule* CreateShaderModuleFromBytecode(const char* _path, const void* _bytecode, size_t _bytecode_length);
+
+    // コンパイル済みのシェーダバイナリからシェーダモジュールを作成します。 アセットパックに含まれる場合はパックから読み込みます。
+    // ファイル、パック内の非圧縮のエントリはマップされたデータを直接参照するため、コピーされません。
+    buma3d::IShaderModule* CreateShaderModuleFromBinary(const char* _path);
+
+    // アセットパックから _path のデータを取得します。 パックが開かれていない、または _path が含まれない場合falseを返します。
+    // 非圧縮のエントリはマップされたデータを直接参照し、圧縮されている場合は _storage に展開します。
+    bool GetPackedAsset(const char* _path, std::vector<uint8_t>* _storage, const void** _data, size_t* _size) const;
+
+    // --enable-shader-hot-reload が指定された場合、CompileShaderModules でコンパイルされたシェーダのソースとインクルードファイルの変更を監視します。
+    // 再コンパイルが完了したシェーダの shader_modules を置き換え、CreatePipeline() でパイプラインを作成し直します。
+    // 置き換えた場合trueを返します。 呼び出し元は記録済みのコマンドリストを記録し直す必要があります。
+    bool ProcessShaderHotReload();
+
+    // 作成を待たずに描画を開始するパイプラインの作成に使用します。 ワーカースレッドを使用するため、最初の呼び出しで作成されます。
+    AsyncPipelineCompiler* GetPipelineCompiler();
+
     void DestroySampleBaseObjects();
 
+private:
+    struct HOT_RELOAD_MODULE
+    {
+        std::string name;   // shader_modules のキー
+        std::string path;
+    };
+
+    void PrepareLoadShaderDesc(const char* _path, buma3d::SHADER_STAGE_FLAG _stage, const char* _entry_point, shader::LOAD_SHADER_DESC* _desc) const;
+
 protected:
+    std::unique_ptr<pack::PackFileReader>                           asset_pack;
+    std::unique_ptr<shader::ShaderCache>                            shader_cache;
+    bool                                                            use_shader_hot_reload;
+    std::unique_ptr<shader::ShaderHotReloader>                      shader_hot_reloader; // 再コンパイルで shader_cache を使用するため、shader_cache より先に破棄します。
     WindowBase*                                                     window;
 
     std::unique_ptr<DeviceResources>                                dr;
+    std::string                                                     warmup_list_path;
+    std::once_flag                                                  pipeline_compiler_once;
+    std::unique_ptr<AsyncPipelineCompiler>                          pipeline_compiler; // GetPipelineCompiler() の最初の呼び出しで作成されます。 dr より先に破棄します。
     buma3d::util::Ptr<buma3d::IDeviceAdapter>                       adapter;
     buma3d::util::Ptr<buma3d::IDevice>                              device;
 
@@ -360,6 +432,7 @@ protected:
     buma3d::util::Ptr<buma3d::IRenderPass>                          render_pass;
     std::vector<buma3d::util::Ptr<buma3d::IFramebuffer>>            framebuffers;
 
+    std::unique_ptr<PipelineLayoutCache>                            layout_cache;
     std::vector<buma3d::util::Ptr<buma3d::IDescriptorSetLayout>>    set_layouts;
     buma3d::util::Ptr<buma3d::IPipelineLayout>                      pipeline_layout;
 
@@ -375,6 +448,9 @@ protected:
 
     buma3d::util::Ptr<buma3d::IDescriptorUpdate>                    descriptor_update;
 
+private:
+    std::map<shader::SHADER_HOT_RELOAD_ID, HOT_RELOAD_MODULE>       hot_reload_modules;
+
 };
 
 
@@ -0,0 +1,283 @@
+#include <SampleBase/PipelineLayoutCache.h>
+
+#include <ShaderTools/ShaderReflectionData.h>
+
+#include <Buma3DHelpers/Buma3DHelpers.h>
+#include <Buma3DHelpers/B3DDescHelpers.h>
+#include <Buma3DHelpers/B3DDescHash.h>
+
+#include <Utils/Logger.h>
+
+#include <algorithm>
+#include <tuple>
+
+namespace buma
+{
+
+namespace /*anonymous*/
+{
+
+// HLSLのレジスタの種類です。 種類の異なるレジスタは番号が同じでも別のバインディングです。
+enum REGISTER_CLASS { REGISTER_CLASS_B, REGISTER_CLASS_T, REGISTER_CLASS_U, REGISTER_CLASS_S };
+
+bool ConvertDescriptorType(const shader::REFLECTION_INPUT_BIND_DESC& _bind, buma3d::DESCRIPTOR_TYPE* _type)
+{
+    // UAVの dimension には D3D_UAV_DIMENSION の値が格納されますが、 D3D_UAV_DIMENSION_BUFFER は SRV_DIMENSION_BUFFER と同じ値です。
+    bool is_buffer = _bind.dimension == shader::SRV_DIMENSION_BUFFER;
+    switch (_bind.shader_input_type)
+    {
+    case shader::SHADER_INPUT_TYPE_CBUFFER                       : *_type = buma3d::DESCRIPTOR_TYPE_CBV; return true;
+    case shader::SHADER_INPUT_TYPE_TBUFFER                       : *_type = buma3d::DESCRIPTOR_TYPE_SRV_BUFFER; return true;
+    case shader::SHADER_INPUT_TYPE_TEXTURE                       : *_type = is_buffer ? buma3d::DESCRIPTOR_TYPE_SRV_TYPED_BUFFER : buma3d::DESCRIPTOR_TYPE_SRV_TEXTURE; return true;
+    case shader::SHADER_INPUT_TYPE_SAMPLER                       : *_type = buma3d::DESCRIPTOR_TYPE_SAMPLER; return true;
+    case shader::SHADER_INPUT_TYPE_UAV_RWTYPED                   : *_type = is_buffer ? buma3d::DESCRIPTOR_TYPE_UAV_TYPED_BUFFER : buma3d::DESCRIPTOR_TYPE_UAV_TEXTURE; return true;
+    case shader::SHADER_INPUT_TYPE_STRUCTURED                    : *_type = buma3d::DESCRIPTOR_TYPE_SRV_BUFFER; return true;
+    case shader::SHADER_INPUT_TYPE_BYTEADDRESS                   : *_type = buma3d::DESCRIPTOR_TYPE_SRV_BUFFER; return true;
+    case shader::SHADER_INPUT_TYPE_UAV_RWSTRUCTURED              : *_type = buma3d::DESCRIPTOR_TYPE_UAV_BUFFER; return true;
+    case shader::SHADER_INPUT_TYPE_UAV_RWBYTEADDRESS             : *_type = buma3d::DESCRIPTOR_TYPE_UAV_BUFFER; return true;
+    case shader::SHADER_INPUT_TYPE_UAV_APPEND_STRUCTURED         : *_type = buma3d::DESCRIPTOR_TYPE_UAV_BUFFER; return true;
+    case shader::SHADER_INPUT_TYPE_UAV_CONSUME_STRUCTURED        : *_type = buma3d::DESCRIPTOR_TYPE_UAV_BUFFER; return true;
+    case shader::SHADER_INPUT_TYPE_UAV_RWSTRUCTURED_WITH_COUNTER : *_type = buma3d::DESCRIPTOR_TYPE_UAV_BUFFER; return true;
+    case shader::SHADER_INPUT_TYPE_RTACCELERATIONSTRUCTURE       : *_type = buma3d::DESCRIPTOR_TYPE_SRV_ACCELERATION_STRUCTURE; return true;
+
+    // サンプラーフィードバックテクスチャは未対応です。
+    case shader::SHADER_INPUT_TYPE_UAV_FEEDBACKTEXTURE:
+        BUMA_LOGE("PipelineLayoutCache: SHADER_INPUT_TYPE_UAV_FEEDBACKTEXTURE (sampler feedback) is not supported");
+        return false;
+
+    default:
+        return false;
+    }
+}
+
+REGISTER_CLASS GetRegisterClass(buma3d::DESCRIPTOR_TYPE _type)
+{
+    switch (_type)
+    {
+    case buma3d::DESCRIPTOR_TYPE_CBV              : return REGISTER_CLASS_B;
+    case buma3d::DESCRIPTOR_TYPE_SAMPLER          : return REGISTER_CLASS_S;
+    case buma3d::DESCRIPTOR_TYPE_UAV_TEXTURE      :
+    case buma3d::DESCRIPTOR_TYPE_UAV_BUFFER       :
+    case buma3d::DESCRIPTOR_TYPE_UAV_TYPED_BUFFER : return REGISTER_CLASS_U;
+    default:
+        return REGISTER_CLASS_T;
+    }
+}
+
+buma3d::SHADER_VISIBILITY ConvertShaderVisibility(buma3d::SHADER_STAGE_FLAG _stage)
+{
+    switch (_stage)
+    {
+    case buma3d::SHADER_STAGE_FLAG_VERTEX   : return buma3d::SHADER_VISIBILITY_VERTEX;
+    case buma3d::SHADER_STAGE_FLAG_HULL     : return buma3d::SHADER_VISIBILITY_HULL;
+    case buma3d::SHADER_STAGE_FLAG_DOMAIN   : return buma3d::SHADER_VISIBILITY_DOMAIN;
+    case buma3d::SHADER_STAGE_FLAG_GEOMETRY : return buma3d::SHADER_VISIBILITY_GEOMETRY;
+    case buma3d::SHADER_STAGE_FLAG_PIXEL    : return buma3d::SHADER_VISIBILITY_PIXEL;
+    default:
+        return buma3d::SHADER_VISIBILITY_ALL_GRAPHICS_COMPUTE;
+    }
+}
+
+
+}// namespace /*anonymous*/
+
+
+bool PipelineLayoutCache::BINDING::operator==(const BINDING& _b) const
+{
+    return
+        descriptor_type      == _b.descriptor_type      &&
+        base_shader_register == _b.base_shader_register &&
+        num_descriptors      == _b.num_descriptors      &&
+        shader_visibility    == _b.shader_visibility    ;
+}
+
+size_t PipelineLayoutCache::SET_LAYOUT_KEY_HASH::operator()(const SET_LAYOUT_KEY& _key) const
+{
+    size_t seed = _key.bindings.size();
+    for (auto& i : _key.bindings)
+    {
+        util::hash_combine(seed, (uint32_t)i.descriptor_type);
+        util::hash_combine(seed, i.base_shader_register);
+        util::hash_combine(seed, i.num_descriptors);
+        util::hash_combine(seed, (uint32_t)i.shader_visibility);
+    }
+    return seed;
+}
+
+size_t PipelineLayoutCache::PIPELINE_LAYOUT_KEY_HASH::operator()(const PIPELINE_LAYOUT_KEY& _key) const
+{
+    size_t seed = _key.set_layouts.size();
+    for (auto& i : _key.set_layouts)
+        util::hash_combine(seed, i);
+    return seed;
+}
+
+PipelineLayoutCache::PipelineLayoutCache(buma3d::IDevice* _device)
+    : device            { _device }
+    , mutex             {}
+    , set_layouts       {}
+    , pipeline_layouts  {}
+{
+}
+
+PipelineLayoutCache::~PipelineLayoutCache()
+{
+    Clear();
+}
+
+bool PipelineLayoutCache::GetOrCreate(const PIPELINE_LAYOUT_SHADER_DESC* _shaders, uint32_t _num_shaders, REFLECTED_PIPELINE_LAYOUT* _result)
+{
+    std::vector<SET_LAYOUT_KEY> sets;
+    if (!MergeBindings(_shaders, _num_shaders, &sets))
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    PIPELINE_LAYOUT_KEY pipeline_key{};
+    pipeline_key.set_layouts.reserve(sets.size());
+    for (auto& i : sets)
+    {
+        // 使用されない register space にはバインディングを持たないレイアウトが設定されます。 これも他のレイアウトと同様に共有されます。
+        auto set_layout = GetOrCreateSetLayout(i);
+        if (!set_layout)
+            return false;
+        pipeline_key.set_layouts.emplace_back(set_layout);
+    }
+
+    auto pipeline_layout = GetOrCreatePipelineLayout(pipeline_key);
+    if (!pipeline_layout)
+        return false;
+
+    _result->set_layouts.assign(pipeline_key.set_layouts.begin(), pipeline_key.set_layouts.end());
+    _result->pipeline_layout = pipeline_layout;
+    return true;
+}
+
+size_t PipelineLayoutCache::GetNumSetLayouts() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return set_layouts.size();
+}
+
+size_t PipelineLayoutCache::GetNumPipelineLayouts() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return pipeline_layouts.size();
+}
+
+void PipelineLayoutCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pipeline_layouts.clear();
+    set_layouts.clear();
+}
+
+bool PipelineLayoutCache::MergeBindings(const PIPELINE_LAYOUT_SHADER_DESC* _shaders, uint32_t _num_shaders, std::vector<SET_LAYOUT_KEY>* _sets) const
+{
+    auto&& sets = *_sets;
+    for (uint32_t i_shader = 0; i_shader < _num_shaders; i_shader++)
+    {
+        auto&& shader     = _shaders[i_shader];
+        auto   visibility = ConvertShaderVisibility(shader.stage);
+        for (auto&& bind : shader.reflection->GetInputBindings())
+        {
+            auto name = shader.reflection->GetString(bind.name);
+            BINDING b{};
+            if (!ConvertDescriptorType(bind, &b.descriptor_type))
+            {
+                BUMA_LOGE("PipelineLayoutCache: unsupported shader input type of \"{}\"", name);
+                return false;
+            }
+            if (bind.bind_count == 0)
+            {
+                BUMA_LOGE("PipelineLayoutCache: unbounded descriptor array \"{}\" is not supported", name);
+                return false;
+            }
+            b.base_shader_register = bind.start_bind_point;
+            b.num_descriptors      = bind.bind_count;
+            b.shader_visibility    = visibility;
+
+            if (bind.register_space >= sets.size())
+                sets.resize(bind.register_space + 1);
+
+            auto&& bindings = sets[bind.register_space].bindings;
+            auto it = std::find_if(bindings.begin(), bindings.end(), [&](const BINDING& _b) {
+                return _b.base_shader_register == b.base_shader_register && GetRegisterClass(_b.descriptor_type) == GetRegisterClass(b.descriptor_type); });
+            if (it == bindings.end())
+            {
+                bindings.emplace_back(b);
+                continue;
+            }
+
+            // 他のステージと同じレジスタを使用します。
+            if (it->descriptor_type != b.descriptor_type)
+            {
+                BUMA_LOGE("PipelineLayoutCache: \"{}\" (register {}, space {}) is declared with different types between stages", name, bind.start_bind_point, bind.register_space);
+                return false;
+            }
+            it->num_descriptors = std::max(it->num_descriptors, b.num_descriptors);
+            if (it->shader_visibility != b.shader_visibility)
+                it->shader_visibility = buma3d::SHADER_VISIBILITY_ALL_GRAPHICS_COMPUTE;
+        }
+    }
+
+    // ステージの順序に関わらず同じキーになるよう、ソートします。
+    for (auto& i : sets)
+    {
+        std::sort(i.bindings.begin(), i.bindings.end(), [](const BINDING& _a, const BINDING& _b) {
+            return std::tie(_a.base_shader_register, _a.descriptor_type) < std::tie(_b.base_shader_register, _b.descriptor_type); });
+    }
+
+    return true;
+}
+
+buma3d::IDescriptorSetLayout* PipelineLayoutCache::GetOrCreateSetLayout(const SET_LAYOUT_KEY& _key)
+{
+    auto it = set_layouts.find(_key);
+    if (it != set_layouts.end())
+        return it->second.Get();
+
+    util::DescriptorSetLayoutDesc desc((uint32_t)_key.bindings.size());
+    for (auto& i : _key.bindings)
+        desc.AddNewBinding(i.descriptor_type, i.base_shader_register, i.num_descriptors, i.shader_visibility, buma3d::DESCRIPTOR_FLAG_NONE);
+    desc.SetFlags(buma3d::DESCRIPTOR_SET_LAYOUT_FLAG_NONE)
+        .Finalize();
+
+    buma3d::util::Ptr<buma3d::IDescriptorSetLayout> set_layout;
+    auto bmr = device->CreateDescriptorSetLayout(desc.Get(), &set_layout);
+    if (util::IsFailed(bmr))
+    {
+        BUMA_LOGE("PipelineLayoutCache: failed to create descriptor set layout");
+        return nullptr;
+    }
+    set_layout->SetName(("PipelineLayoutCache::set_layouts " + std::to_string(set_layouts.size())).c_str());
+
+    return set_layouts.emplace(_key, set_layout).first->second.Get();
+}
+
+buma3d::IPipelineLayout* PipelineLayoutCache::GetOrCreatePipelineLayout(const PIPELINE_LAYOUT_KEY& _key)
+{
+    auto it = pipeline_layouts.find(_key);
+    if (it != pipeline_layouts.end())
+        return it->second.Get();
+
+    auto num_set_layouts = (uint32_t)_key.set_layouts.size();
+    util::PipelineLayoutDesc desc(num_set_layouts, 0);
+    desc.SetNumLayouts(num_set_layouts)
+        .SetLayouts(0, _key.set_layouts)
+        .SetFlags(buma3d::PIPELINE_LAYOUT_FLAG_NONE)
+        .Finalize();
+
+    buma3d::util::Ptr<buma3d::IPipelineLayout> pipeline_layout;
+    auto bmr = device->CreatePipelineLayout(desc.Get(), &pipeline_layout);
+    if (util::IsFailed(bmr))
+    {
+        BUMA_LOGE("PipelineLayoutCache: failed to create pipeline layout");
+        return nullptr;
+    }
+    pipeline_layout->SetName(("PipelineLayoutCache::pipeline_layouts " + std::to_string(pipeline_layouts.size())).c_str());
+
+    return pipeline_layouts.emplace(_key, pipeline_layout).first->second.Get();
+}
+
+
+} // namespace buma
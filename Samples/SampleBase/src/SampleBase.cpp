@@ -2,6 +2,7 @@
 
 #include <DeviceResources/SwapChain.h>
 #include <DeviceResources/CommandQueue.h>
+#include <DeviceResources/PipelineStateCache.h>
 
 #include <Buma3DHelpers/Buma3DHelpers.h>
 #include <Buma3DHelpers/B3DDescHelpers.h>
@@ -16,6 +17,8 @@
 #include <Utils/Logger.h>
 
 #include <ShaderTools/ShaderLoader.h>
+#include <ShaderTools/ShaderBinary.h>
+#include <ShaderTools/ShaderReflectionData.h>
 #include <DeviceResources/ShaderToolsConv.h>
 
 #include <SDL.h>
@@ -32,8 +35,15 @@ namespace buma
 
 SampleBase::SampleBase(PlatformBase& _platform)
     : ApplicationBase(_platform)
+    , asset_pack              {}
+    , shader_cache            {}
+    , use_shader_hot_reload   {}
+    , shader_hot_reloader     {}
     , window                  {}
     , dr                      {}
+    , warmup_list_path        {}
+    , pipeline_compiler_once  {}
+    , pipeline_compiler       {}
     , adapter                 {}
     , device                  {}
     , swapchain               {}
@@ -53,6 +63,7 @@ SampleBase::SampleBase(PlatformBase& _platform)
     , sampler_aniso           {}
     , render_pass             {}
     , framebuffers            {}
+    , layout_cache            {}
     , set_layouts             {}
     , pipeline_layout         {}
     , descriptor_heap         {}
@@ -63,6 +74,7 @@ SampleBase::SampleBase(PlatformBase& _platform)
     , command_allocators      {}
     , command_lists           {}
     , descriptor_update       {}
+    , hot_reload_modules      {}
 {
     platform.AddHelpMessage(
 R"(========== SampleBase Options ========== 
@@ -78,6 +90,26 @@ R"(========== SampleBase Options ==========
 --debug-b3d
     Buma3Dのデバッグを有効にします。
 
+--asset-pack <file>
+    アセットの読み込みに使用するパックファイルを指定します。 パックに含まれないアセットはファイルから読み込まれます。
+    デフォルトは ASSET_PATH 直下の Assets.pack が存在する場合にそれを使用します。
+
+--shader-cache <directory>
+    コンパイル済みシェーダのキャッシュを保存するディレクトリを指定します。
+    デフォルトは カレントディレクトリ直下の ShaderCache です。
+
+--disable-shader-cache
+    シェーダキャッシュを使用せず、常にシェーダをコンパイルします。
+
+--enable-shader-hot-reload
+    シェーダのソースとインクルードファイルの変更を監視し、変更されたファイルに依存するシェーダのみを再コンパイルして置き換えます。
+    アセットパックから読み込まれたシェーダは対象外です。
+
+--pipeline-warmup-list <file>
+    pipeline_compiler で非同期に作成するパイプラインの、前回のセッションで使用された順序を記録するファイルを指定します。
+    リストに含まれるパイプラインは記録された順に優先して作成されます。
+    デフォルトは カレントディレクトリ直下の PipelineWarmup.txt です。
+
 )");
 }
 
@@ -85,6 +117,66 @@ SampleBase::~SampleBase()
 {
 }
 
+bool SampleBase::PrepareSettings()
+{
+    auto result = ApplicationBase::PrepareSettings();
+
+    std::string pack_path = AssetPath("Assets.pack");
+    if (platform.HasArgument("--asset-pack"))
+        pack_path = *(++platform.FindArgument("--asset-pack"));
+
+    if (std::filesystem::exists(pack_path))
+    {
+        asset_pack = pack::PackFileReader::Open(pack_path.c_str());
+        if (asset_pack)
+            BUMA_LOGI("Opened asset pack {} ({} entries)", pack_path.c_str(), asset_pack->GetNumEntries());
+        else
+            BUMA_LOGW("Failed to open asset pack {}", pack_path.c_str());
+    }
+
+    if (!platform.HasArgument("--disable-shader-cache"))
+    {
+        std::string cache_dir = "./ShaderCache";
+        if (platform.HasArgument("--shader-cache"))
+            cache_dir = *(++platform.FindArgument("--shader-cache"));
+
+        shader_cache = shader::ShaderCache::Open(cache_dir.c_str());
+        if (shader_cache)
+            BUMA_LOGI("Opened shader cache {} ({} entries)", cache_dir.c_str(), shader_cache->GetNumEntries());
+        else
+            BUMA_LOGW("Failed to open shader cache {}", cache_dir.c_str());
+    }
+
+    // レンダリングAPIが決定するデバイスの作成後、CompileShaderModules で作成します。
+    use_shader_hot_reload = platform.HasArgument("--enable-shader-hot-reload");
+
+    return result;
+}
+
+bool SampleBase::GetPackedAsset(const char* _path, std::vector<uint8_t>* _storage, const void** _data, size_t* _size) const
+{
+    if (!asset_pack)
+        return false;
+
+    auto entry = asset_pack->Find(_path);
+    if (!entry)
+        return false;
+
+    if (auto mapped = asset_pack->GetMappedData(entry))
+    {
+        *_data = mapped;
+        *_size = (size_t)entry->original_size;
+        return true;
+    }
+
+    if (!asset_pack->Read(entry, _storage))
+        return false;
+
+    *_data = _storage->data();
+    *_size = _storage->size();
+    return true;
+}
+
 bool SampleBase::CreateWindow(uint32_t _w, uint32_t _h, const char* _title)
 {
     BUMA_ASSERT(window == nullptr);
@@ -135,9 +227,27 @@ bool SampleBase::CreateDeviceResources(const char* _library_dir)
     adapter = dr->GetAdapter();
     device  = dr->GetDevice();
 
+    // pipeline_compiler は GetPipelineCompiler() で使用されるまで作成しません。
+    warmup_list_path = "./PipelineWarmup.txt";
+    if (platform.HasArgument("--pipeline-warmup-list"))
+        warmup_list_path = *(++platform.FindArgument("--pipeline-warmup-list"));
+
     return true;
 }
 
+AsyncPipelineCompiler* SampleBase::GetPipelineCompiler()
+{
+    BUMA_ASSERT(dr != nullptr);
+    std::call_once(pipeline_compiler_once, [this]()
+    {
+        ASYNC_PIPELINE_COMPILER_DESC compiler_desc{};
+        compiler_desc.num_threads       = 0;
+        compiler_desc.warmup_list_path  = warmup_list_path.c_str();
+        pipeline_compiler = std::make_unique<AsyncPipelineCompiler>(*dr->GetPipelineStateCache(), compiler_desc);
+    });
+    return pipeline_compiler.get();
+}
+
 bool SampleBase::CreateSwapChain(const buma3d::SWAP_CHAIN_BUFFER_DESC& _buffer_desc, buma3d::SWAP_CHAIN_FLAGS _flags)
 {
     BUMA_ASSERT(window != nullptr);
@@ -419,14 +529,14 @@ bool SampleBase::CreateCommandLists()
     return true;
 }
 
-buma3d::IShaderModule* SampleBase::CreateShaderModule(const char* _path, buma3d::SHADER_STAGE_FLAG _stage, const char* _entry_point)
+void SampleBase::PrepareLoadShaderDesc(const char* _path, buma3d::SHADER_STAGE_FLAG _stage, const char* _entry_point, shader::LOAD_SHADER_DESC* _desc) const
 {
-    // シェーダをコンパイル
-    shader::LOAD_SHADER_DESC desc{};
+    auto&& desc = *_desc;
     desc.filename    = _path;
     desc.entry_point = _entry_point;
     desc.defines     = {};
     desc.stage       = shader::ConvertShaderStage(_stage);
+    desc.cache       = shader_cache.get();
 
     desc.options.pack_matrices_in_row_major = false;
     desc.options.enable_16bit_types         = false;
@@ -434,21 +544,28 @@ buma3d::IShaderModule* SampleBase::CreateShaderModule(const char* _path, buma3d:
     desc.options.disable_optimizations      = false;
     desc.options.optimization_level         = 3; // 0 to 3, no optimization to most optimization
     desc.options.shader_model               = { 6, 4 };
+}
 
-    std::vector<uint8_t> bytecode;
-    shader::ShaderLoader::LoadShaderFromHLSL(shader::ConvertApiType(dr->GetApiType()), desc, &bytecode);
-    BUMA_ASSERT(!bytecode.empty());
+buma3d::IShaderModule* SampleBase::CreateShaderModuleFromBytecode(const char* _path, const std::vector<uint8_t>& _bytecode)
+{
+    return CreateShaderModuleFromBytecode(_path, _bytecode.data(), _bytecode.size());
+}
 
+buma3d::IShaderModule* SampleBase::CreateShaderModuleFromBytecode(const char* _path, const void* _bytecode, size_t _bytecode_length)
+{
     // シェーダモジュールを作成
     buma3d::SHADER_MODULE_DESC module_desc{};
     module_desc.flags                    = buma3d::SHADER_MODULE_FLAG_NONE;
-    module_desc.bytecode.bytecode_length = bytecode.size();
-    module_desc.bytecode.shader_bytecode = bytecode.data();
+    module_desc.bytecode.bytecode_length = _bytecode_length;
+    module_desc.bytecode.shader_bytecode = _bytecode;
 
     buma3d::IShaderModule* result{};
     auto bmr = dr->GetDevice()->CreateShaderModule(module_desc, &result);
     BMR_ASSERT(bmr);
 
+    // 同じバイトコードから作成し直したモジュールのパイプラインを PipelineStateCache で再利用できるようにします。
+    dr->GetPipelineStateCache()->RegisterShaderModule(result, _bytecode, _bytecode_length);
+
     auto&& s = std::filesystem::path(_path).filename().string();
     result->SetName(s.c_str());
     BUMA_LOGI("Created shader module {}", s.c_str());
@@ -456,8 +573,259 @@ buma3d::IShaderModule* SampleBase::CreateShaderModule(const char* _path, buma3d:
     return result;
 }
 
+buma3d::IShaderModule* SampleBase::CreateShaderModuleFromBinary(const char* _path)
+{
+    std::vector<uint8_t> storage;
+    const void* data{};
+    size_t      size{};
+    if (GetPackedAsset(_path, &storage, &data, &size))
+        return CreateShaderModuleFromBytecode(_path, data, size);
+
+    auto binary = shader::ShaderBinary::Open(_path);
+    if (!binary)
+    {
+        BUMA_LOGE("Failed to open shader binary {}", _path);
+        return nullptr;
+    }
+    return CreateShaderModuleFromBytecode(_path, binary->GetData(), binary->GetSize());
+}
+
+buma3d::IShaderModule* SampleBase::CreateShaderModule(const char* _path, buma3d::SHADER_STAGE_FLAG _stage, const char* _entry_point)
+{
+    // シェーダをコンパイル
+    shader::LOAD_SHADER_DESC desc{};
+    PrepareLoadShaderDesc(_path, _stage, _entry_point, &desc);
+
+    std::vector<uint8_t> bytecode;
+    std::vector<uint8_t> packed_source;
+    if (asset_pack && asset_pack->Read(_path, &packed_source))
+    {
+        // NOTE: パック内のソースからの#includeは未対応です。
+        packed_source.push_back('\0');
+        shader::ShaderLoader::LoadShaderFromHLSL(shader::ConvertApiType(dr->GetApiType()), desc, reinterpret_cast<const char*>(packed_source.data()), &bytecode);
+    }
+    else
+    {
+        shader::ShaderLoader::LoadShaderFromHLSL(shader::ConvertApiType(dr->GetApiType()), desc, &bytecode);
+    }
+    BUMA_ASSERT(!bytecode.empty());
+
+    return CreateShaderModuleFromBytecode(_path, bytecode);
+}
+
+bool SampleBase::CompileShaderModules(const std::vector<SHADER_MODULE_SOURCE>& _sources)
+{
+    auto num_shaders = _sources.size();
+    std::vector<shader::LOAD_SHADER_DESC>       descs(num_shaders);
+    std::vector<std::vector<uint8_t>>           packed_sources(num_shaders);
+    std::vector<const char*>                    sources(num_shaders);
+    std::vector<shader::SHADER_COMPILE_RESULT>  results(num_shaders);
+    for (size_t i = 0; i < num_shaders; i++)
+    {
+        auto&& src = _sources[i];
+        PrepareLoadShaderDesc(src.path, src.stage, src.entry_point, &descs[i]);
+
+        // NOTE: パック内のソースからの#includeは未対応です。
+        if (asset_pack && asset_pack->Read(src.path, &packed_sources[i]))
+        {
+            packed_sources[i].push_back('\0');
+            sources[i] = reinterpret_cast<const char*>(packed_sources[i].data());
+        }
+    }
+
+    // シェーダをワーカースレッドで並列にコンパイル
+    shader::COMPILE_BATCH_DESC batch{};
+    batch.num_shaders = num_shaders;
+    batch.descs       = descs.data();
+    batch.sources     = sources.data();
+    shader::ShaderLoader::CompileBatch(shader::ConvertApiType(dr->GetApiType()), batch, results.data());
+
+    for (size_t i = 0; i < num_shaders; i++)
+    {
+        if (!results[i].succeeded)
+        {
+            BUMA_LOGE("Failed to compile {}", _sources[i].path);
+            return false;
+        }
+        shader_modules[_sources[i].name].Attach(CreateShaderModuleFromBytecode(_sources[i].path, results[i].bytecode));
+    }
+
+    if (use_shader_hot_reload)
+    {
+        if (!shader_hot_reloader)
+            shader_hot_reloader = shader::ShaderHotReloader::Create(shader::ConvertApiType(dr->GetApiType()));
+
+        for (size_t i = 0; i < num_shaders; i++)
+        {
+            // パック内のソースは監視できません。
+            if (sources[i])
+                continue;
+
+            // 同じモジュールが再度コンパイルされた場合、以前の登録を解除します。
+            for (auto it = hot_reload_modules.begin(); it != hot_reload_modules.end();)
+            {
+                if (it->second.name != _sources[i].name)
+                {
+                    ++it;
+                    continue;
+                }
+                shader_hot_reloader->Unregister(it->first);
+                it = hot_reload_modules.erase(it);
+            }
+
+            auto id = shader_hot_reloader->Register(descs[i], results[i].dependencies);
+            if (id != 0)
+                hot_reload_modules[id] = { _sources[i].name, _sources[i].path };
+        }
+    }
+
+    return true;
+}
+
+bool SampleBase::CreateLayoutsFromReflection(const std::vector<SHADER_MODULE_SOURCE>& _sources)
+{
+    auto num_shaders = _sources.size();
+    std::vector<shader::LOAD_SHADER_DESC>       descs(num_shaders);
+    std::vector<std::vector<uint8_t>>           packed_sources(num_shaders);
+    std::vector<const char*>                    sources(num_shaders);
+    std::vector<shader::SHADER_COMPILE_RESULT>  results(num_shaders);
+    for (size_t i = 0; i < num_shaders; i++)
+    {
+        auto&& src = _sources[i];
+        PrepareLoadShaderDesc(src.path, src.stage, src.entry_point, &descs[i]);
+
+        // NOTE: パック内のソースからの#includeは未対応です。
+        if (asset_pack && asset_pack->Read(src.path, &packed_sources[i]))
+        {
+            packed_sources[i].push_back('\0');
+            sources[i] = reinterpret_cast<const char*>(packed_sources[i].data());
+        }
+    }
+
+    shader::COMPILE_BATCH_DESC batch{};
+    batch.num_shaders = num_shaders;
+    batch.descs       = descs.data();
+    batch.sources     = sources.data();
+    shader::ShaderLoader::CompileBatch(shader::COMPILE_TARGET_D3D12, batch, results.data());
+
+    std::vector<std::unique_ptr<shader::ShaderReflectionData>>  reflections(num_shaders);
+    std::vector<PIPELINE_LAYOUT_SHADER_DESC>                    shaders(num_shaders);
+    for (size_t i = 0; i < num_shaders; i++)
+    {
+        if (results[i].succeeded)
+            reflections[i] = shader::ShaderReflectionData::Reflect(results[i].bytecode, shader_cache.get());
+        if (!reflections[i])
+        {
+            BUMA_LOGE("Failed to reflect {}", _sources[i].path);
+            return false;
+        }
+        shaders[i].stage      = _sources[i].stage;
+        shaders[i].reflection = reflections[i].get();
+    }
+
+    if (!layout_cache)
+        layout_cache = std::make_unique<PipelineLayoutCache>(dr->GetDevice().Get());
+
+    REFLECTED_PIPELINE_LAYOUT layout{};
+    if (!layout_cache->GetOrCreate(shaders.data(), (uint32_t)num_shaders, &layout))
+        return false;
+
+    set_layouts     = std::move(layout.set_layouts);
+    pipeline_layout = std::move(layout.pipeline_layout);
+    return true;
+}
+
+bool SampleBase::ProcessShaderHotReload()
+{
+    if (!shader_hot_reloader)
+        return false;
+
+    std::vector<shader::SHADER_HOT_RELOAD_RESULT> results;
+    if (!shader_hot_reloader->PopResults(&results))
+        return false;
+
+    // 置き換え前のモジュールとパイプラインは、パイプラインの作成に失敗した場合に元に戻すために保持します。
+    std::map<std::string, buma3d::util::Ptr<buma3d::IShaderModule>> prev_modules;
+    for (auto& i : results)
+    {
+        auto it = hot_reload_modules.find(i.id);
+        if (it == hot_reload_modules.end())
+            continue;
+
+        auto&& module = it->second;
+        if (!i.result.succeeded)
+        {
+            BUMA_LOGE("Failed to recompile {}\n{}", module.path.c_str(), i.result.diagnostics.c_str());
+            continue;
+        }
+
+        // 実行中のコマンドリストが以前のパイプラインを参照している可能性があります。
+        if (prev_modules.empty())
+            present_queue->WaitIdle();
+
+        prev_modules.emplace(module.name, shader_modules[module.name]);
+        shader_modules[module.name].Attach(CreateShaderModuleFromBytecode(module.path.c_str(), i.result.bytecode));
+    }
+    if (prev_modules.empty())
+        return false;
+
+    auto prev_pipeline = pipeline;
+    if (!CreatePipeline())
+    {
+        BUMA_LOGE("Failed to recreate pipeline with reloaded shaders");
+        for (auto& [name, module] : prev_modules)
+            shader_modules[name] = module;
+        pipeline = prev_pipeline;
+        return false;
+    }
+
+    // 置き換えたモジュールと、それらから作成され使用されなくなったパイプラインをキャッシュから解放します。 キューは上記で待機済みです。
+    auto cache = dr->GetPipelineStateCache();
+    for (auto& [name, module] : prev_modules)
+        cache->UnregisterShaderModule(module.Get());
+    prev_pipeline.Reset();
+    auto num_released = cache->ReleaseUnusedPipelines();
+
+    BUMA_LOGI("Reloaded {} shader module(s), released {} unused pipeline(s)", prev_modules.size(), num_released);
+    return true;
+}
+
+std::unique_ptr<shader::ShaderVariants> SampleBase::CreateShaderVariants(const SHADER_MODULE_SOURCE& _source, const std::vector<shader::SHADER_KEYWORD_DESC>& _keywords, shader::SHADER_VARIANT_KEY _fallback_key)
+{
+    shader::SHADER_VARIANTS_DESC desc{};
+    desc.target         = shader::ConvertApiType(dr->GetApiType());
+    desc.num_keywords   = static_cast<uint32_t>(_keywords.size());
+    desc.keywords       = _keywords.data();
+    desc.fallback_key   = _fallback_key;
+    PrepareLoadShaderDesc(_source.path, _source.stage, _source.entry_point, &desc.base_desc);
+
+    // NOTE: パック内のソースからの#includeは未対応です。
+    std::vector<uint8_t> packed_source;
+    if (asset_pack && asset_pack->Read(_source.path, &packed_source))
+    {
+        packed_source.push_back('\0');
+        desc.source = reinterpret_cast<const char*>(packed_source.data());
+    }
+
+    auto result = shader::ShaderVariants::Create(desc);
+    if (!result)
+        BUMA_LOGE("Failed to create shader variants of {}", _source.path);
+
+    return result;
+}
+
 void SampleBase::DestroySampleBaseObjects()
 {
+    // 次回の起動時に、このセッションで使用されたパイプラインから作成されるようにします。 pipeline_compiler を使用しなかったサンプルはリストを書き込みません。
+    if (pipeline_compiler)
+    {
+        pipeline_compiler->SaveWarmupList();
+        pipeline_compiler.reset();
+    }
+
+    hot_reload_modules.clear();
+    shader_hot_reloader.reset();
+
     command_lists.clear();
     command_allocators.clear();
 
@@ -469,6 +837,7 @@ void SampleBase::DestroySampleBaseObjects()
 
     pipeline_layout.Reset();
     set_layouts.clear();
+    layout_cache.reset();
 
     descriptor_update.Reset();
     descriptor_sets.clear();